@@ -15,6 +15,9 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include "nerobench.h"
+#include "nerodaemon.h"
+#include "nerodedup.h"
 #include "neromanager.h"
 #include "nerofs.h"
 #include "neroonetimedialog.h"
@@ -22,34 +25,82 @@
 
 #include <QApplication>
 #include <QLocale>
+#include <QScopedPointer>
 #include <QTranslator>
 
 void PrintHelp()
 {
     printf(
-        "usage: nero-umu [--prefix \"Prefix Name\" [--list] [--shortcut \"Shortcut Name\"]] executable [arg1] [arg2] [...]\n\n"
+        "usage: nero-umu [--daemon | --dedup [--hardlink] [--dry-run]] [--prefix \"Prefix Name\" [--list] [--shortcut \"Shortcut Name\" [--dump-profile | --stop | --bench [bench options]]]] executable [arg1] [arg2] [...]\n\n"
         "Nero-umu CLI: Launch Windows executables within a Nero-managed Prefix\n\n"
         "options:\n"
         "  --prefix \"Prefix Name\"        Run executable within \"Prefix Name\"\n"
         "  --list                        List contents of prefix specified with --prefix\n"
         "  --shortcut \"Shortcut Name\"    Launch a specific shortcut from specified --prefix, according to the prefix's current settings.\n"
+        "  --dump-profile                Print the resolved launch profile of --shortcut instead of launching it.\n"
+        "  --stop                        Stop --shortcut, if it was launched through the Nero daemon.\n"
+        "  --bench                       Benchmark --shortcut: launch it repeatedly, timing each launch and capturing frametimes with MangoHud.\n"
+        "  --dedup                       Share identical system files (system32, syswow64, .NET...) between every prefix to save space.\n"
+        "  --hardlink                    With --dedup, hardlink duplicates (read-only) instead of sharing extents, for filesystems without reflinks.\n"
+        "  --dry-run                     With --dedup, only report how much space would be reclaimed.\n"
+        "  --daemon                      Stay resident in the background, so later launches/lists from the CLI start faster.\n"
         "  -h, --help                    Show this help. Helpful, huh? c:\n"
+        "\nbench options:\n"
+        "  --runs N                      Launch each variant N times (default 3).\n"
+        "  --warmup S --duration S       Capture S seconds of frametimes (default 60), after the game's had S seconds to settle (default 10).\n"
+        "  --vary setting[=a,b,...]      Also run every combination of sync, scaling, wined3d and/or wayland values (can be repeated).\n"
+        "  --output results.json         Where to write the machine-readable results (default: the prefix's .logs/bench folder).\n"
         );
 }
 
+// only the manager, and CLI calls that might have to ask the user something, need a full QApplication.
+static bool NeedsGui(int argc, char *argv[])
+{
+    if(argc < 2) return true;
+
+    QStringList arguments;
+    for(int i = 1; i < argc; ++i)
+        arguments.append(argv[i]);
+
+    if(arguments.contains("-h") || arguments.contains("--help")) return false;
+    // without a prefix, the one-time runner has to prompt for one
+    if(!arguments.contains("--prefix") && !arguments.contains("--dedup")) return true;
+    // or first-time setup of the home dir/umu
+    if(NeroFS::GetManagerValue("Home").toString().isEmpty() || !NeroFS::UmuIsVerified()) return true;
+
+    return false;
+}
+
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
+    // a resident daemon has all the setup below done already, so let it take CLI calls if there is one.
+    if(argc > 3) {
+        int result;
+        if(NeroDaemonClient::RunCli(argc, argv, result)) return result;
+    }
+
+    if(argc == 2 && QString(argv[1]) == "--daemon") {
+        // headless, so no display connection or translators needed.
+        QCoreApplication a(argc, argv);
+        QCoreApplication::setApplicationName("Nero-UMU");
+        return NeroDaemon::Exec();
+    }
+
+    // plain CLI launches skip connecting to the display and loading translators.
+    const bool gui = NeedsGui(argc, argv);
+    QScopedPointer<QCoreApplication> a(gui ? new QApplication(argc, argv) : new QCoreApplication(argc, argv));
 
     QCoreApplication::setApplicationName("Nero-UMU");
 
     QTranslator translator;
-    const QStringList uiLanguages = QLocale::system().uiLanguages();
-    for (const QString &locale : uiLanguages) {
-        const QString baseName = "Nero-Launcher_" + QLocale(locale).name();
-        if (translator.load(":/i18n/" + baseName)) {
-            a.installTranslator(&translator);
-            break;
+    if(gui) {
+        const QStringList uiLanguages = QLocale::system().uiLanguages();
+        for (const QString &locale : uiLanguages) {
+            const QString baseName = "Nero-Launcher_" + QLocale(locale).name();
+            if (translator.load(":/i18n/" + baseName)) {
+                a->installTranslator(&translator);
+                break;
+            }
         }
     }
 
@@ -99,16 +150,38 @@ int main(int argc, char *argv[])
                 printf("Nero cannot run without a home directory set! Aborting...\n");
                 return 1;
             }
+        // Stopping only works for what the daemon launched, which would've answered already
+        } else if(argc > 5 && arguments.contains("--prefix") && arguments.contains("--shortcut") && arguments.contains("--stop")) {
+            printf("No Nero daemon is running that could stop this shortcut.\n");
+            return 1;
         // One-time runner using prefix with provided preset shortcut
         } else if(argc > 4 && arguments.contains("--prefix") && arguments.contains("--shortcut")) {
             if(NeroFS::InitPaths()) {
+                const bool dumpProfile = arguments.removeAll("--dump-profile");
+                const bool bench = arguments.contains("--bench");
                 NeroFS::SetCurrentPrefix(arguments.takeAt(arguments.indexOf("--prefix")+1));
                 arguments.removeAt(arguments.indexOf("--prefix"));
 
-                QString shortcutHash = NeroFS::GetCurrentShortcutsMap().value(arguments.takeLast());
+                const QString shortcutName = arguments.takeAt(arguments.indexOf("--shortcut")+1);
+                const QString prefixPath = NeroFS::GetPrefixesPath()->path() + '/' + NeroFS::GetCurrentPrefix();
+
+                // cached launch profiles know their shortcut's name, so this can skip reading the ini entirely.
+                QString shortcutHash = NeroLaunchProfile::FindCachedHash(prefixPath, shortcutName);
+                if(shortcutHash.isEmpty())
+                    shortcutHash = NeroFS::GetCurrentShortcutsMap().value(shortcutName);
+
                 if(shortcutHash.isEmpty()) {
                     printf("Shortcut not found in prefix! Check that the spelling is correct, or run Nero Manager to create this shortcut if it doesn't exist.\n");
                     return 1;
+                } else if(bench) {
+                    NeroBench benchmark(NeroFS::GetCurrentPrefix(), shortcutHash);
+                    arguments.removeAt(arguments.indexOf("--shortcut"));
+                    if(!benchmark.ParseOptions(arguments)) return 1;
+                    return benchmark.Run();
+                } else if(dumpProfile) {
+                    NeroRunner runner;
+                    printf("%s", runner.GetProfile(shortcutHash).Dump().toLocal8Bit().constData());
+                    return 0;
                 } else {
                     NeroRunner runner;
                     return runner.StartShortcut(shortcutHash);
@@ -139,6 +212,22 @@ int main(int argc, char *argv[])
                 printf("Nero cannot run without a home directory set! Aborting...\n");
                 return 1;
             }
+        // Deduplicate every prefix's system files
+        } else if(argc < 5 && arguments.first() == "--dedup") {
+            if(NeroFS::InitPaths()) {
+                const bool dryRun = arguments.contains("--dry-run");
+                NeroDedup dedup(arguments.contains("--hardlink") ? NeroDedup::Hardlink : NeroDedup::Reflink, dryRun);
+                const NeroDedup::Stats stats = dedup.Run();
+
+                printf("%s %d duplicate files, %s %.1f MiB (%.1f MiB was already shared)\n",
+                       dryRun ? "Found" : "Shared", stats.shared, dryRun ? "could reclaim" : "reclaimed",
+                       stats.reclaimed / 1048576.0, stats.alreadyShared / 1048576.0);
+                if(stats.failed) printf("%d files couldn't be shared.\n", stats.failed);
+                return stats.failed ? 1 : 0;
+            } else {
+                printf("Nero cannot run without a home directory set! Aborting...\n");
+                return 1;
+            }
         // Help printout
         } else if(argc < 3 && (arguments.last() == "-h" || arguments.last() == "--help")) {
             PrintHelp();
@@ -152,6 +241,6 @@ int main(int argc, char *argv[])
     } else {
         NeroManagerWindow w;
         w.show();
-        return a.exec();
+        return a->exec();
     }
 }
@@ -0,0 +1,364 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Launch & Frametime Benchmarks.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerobench.h"
+#include "neroconstants.h"
+#include "nerofs.h"
+#include "nerorunner.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPair>
+#include <QSaveFile>
+#include <QTimer>
+
+#include <algorithm>
+
+// MangoHud only writes its log once log_duration's up, so the game gets a little longer than that before it's stopped.
+#define NERO_BENCH_GRACE 10
+
+// Everything a matrix can vary on, and what each of its values sets.
+struct BenchDimension {
+    QString name;
+    QString setting;
+    // plain ints, which read back as bools just as well
+    QList<QPair<QString, int>> values;
+    // what "--vary name" alone runs through; all of them if empty
+    QStringList defaults;
+    // other names a value can be picked by, which still run (and get reported) under the value's own name
+    QMap<QString, QString> aliases;
+};
+
+static const QList<BenchDimension> &BenchDimensions()
+{
+    static const QList<BenchDimension> dimensions = {
+        // the prefix's default mode only turns ntsync on when it's actually supported, and is fsync otherwise -
+        // so it's not labelled as ntsync, and each run records what it really got (see RunOnce).
+        { "sync", NeroConfig::fileSyncMode,
+          { { "default", NeroConstant::NTsync }, { "fsync", NeroConstant::Fsync },
+            { "esync", NeroConstant::Esync }, { "nosync", NeroConstant::NoSync }, { "auto", NeroConstant::AutoSync } },
+          { "default", "fsync", "esync", "nosync" }, { { "ntsync", "default" } } },
+        { "scaling", NeroConfig::Gamescope::scalingMode,
+          { { "normal", NeroConstant::ScalingNormal }, { "integer", NeroConstant::ScalingIntegerScale },
+            { "fsr-performance", NeroConstant::ScalingFSRperformance }, { "fsr-balanced", NeroConstant::ScalingFSRbalanced },
+            { "fsr-quality", NeroConstant::ScalingFSRquality }, { "fsr-highquality", NeroConstant::ScalingFSRhighquality },
+            { "fsr-higherquality", NeroConstant::ScalingFSRhigherquality }, { "fsr-highestquality", NeroConstant::ScalingFSRhighestquality },
+            { "gamescope-windowed", NeroConstant::ScalingGamescopeWindowed },
+            { "gamescope-borderless", NeroConstant::ScalingGamescopeBorderless },
+            { "gamescope-fullscreen", NeroConstant::ScalingGamescopeFullscreen } },
+          { "normal", "gamescope-fullscreen" } },
+        { "wined3d", NeroConfig::Proton::forceWineD3D, { { "dxvk", 0 }, { "wined3d", 1 } }, {} },
+        { "wayland", NeroConfig::Proton::useWayland, { { "x11", 0 }, { "wayland", 1 } }, {} },
+    };
+    return dimensions;
+}
+
+// nearest-rank, on an already sorted list
+template<typename T>
+static T NearestRank(const QList<T> &sorted, const int &permille)
+{
+    const int rank = static_cast<int>((static_cast<qint64>(sorted.count()) * permille + 999) / 1000);
+    return sorted.at(qBound(0, rank - 1, static_cast<int>(sorted.count()) - 1));
+}
+
+NeroBench::NeroBench(const QString &prefix, const QString &hash) : prefix(prefix), hash(hash) {}
+
+bool NeroBench::ParseOptions(const QStringList &arguments)
+{
+    for(int i = 0; i < arguments.count(); ++i) {
+        const QString &option = arguments.at(i);
+        const QString value = arguments.value(i+1);
+        bool ok = true;
+
+        if(option == "--bench") continue;
+        else if(option == "--runs")     runs = value.toInt(&ok), ++i;
+        else if(option == "--duration") duration = value.toInt(&ok), ++i;
+        else if(option == "--warmup")   warmup = value.toInt(&ok), ++i;
+        else if(option == "--output")   outputPath = value, ok = !value.isEmpty(), ++i;
+        else if(option == "--vary")     ok = AddDimension(value, variants), ++i;
+        else {
+            printf("Unknown benchmark option %s\n", option.toLocal8Bit().constData());
+            return false;
+        }
+
+        if(!ok || runs < 1 || duration < 1 || warmup < 0) {
+            printf("Invalid value for %s: %s\n", option.toLocal8Bit().constData(), value.toLocal8Bit().constData());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NeroBench::AddDimension(const QString &spec, QList<Variant> &variants)
+{
+    const QString name = spec.section('=', 0, 0);
+    const QStringList wanted = spec.section('=', 1).split(',', Qt::SkipEmptyParts);
+
+    const BenchDimension *dimension = nullptr;
+    QStringList names;
+    for(const auto &candidate : BenchDimensions()) {
+        if(candidate.name == name) dimension = &candidate;
+        names << candidate.name;
+    }
+    if(dimension == nullptr) {
+        printf("Can't vary %s, only %s\n", name.toLocal8Bit().constData(), names.join(", ").toLocal8Bit().constData());
+        return false;
+    }
+
+    // values can be named, or given as the setting's raw index
+    QList<QPair<QString, int>> values;
+    const QStringList picks = wanted.isEmpty() ? dimension->defaults : wanted;
+    if(picks.isEmpty()) values = dimension->values;
+    for(const auto &wantedPick : picks) {
+        const QString pick = dimension->aliases.value(wantedPick, wantedPick);
+        bool found = false;
+        for(const auto &value : dimension->values)
+            if(value.first == pick || QString::number(value.second) == pick) {
+                values << value;
+                found = true;
+            }
+        if(!found) {
+            printf("%s isn't a value %s can be set to\n", wantedPick.toLocal8Bit().constData(), name.toLocal8Bit().constData());
+            return false;
+        }
+    }
+
+    // every variant so far gets every one of these
+    const QList<Variant> base = variants.isEmpty() ? QList<Variant>{ Variant() } : variants;
+    variants.clear();
+    for(const auto &variant : base)
+        for(const auto &value : std::as_const(values)) {
+            Variant combined = variant;
+            combined.name += (combined.name.isEmpty() ? "" : " ") + name + '=' + value.first;
+            combined.settings.insert(dimension->setting, value.second);
+            variants << combined;
+        }
+    return true;
+}
+
+NeroBench::FrameStats NeroBench::ReadFrametimes(const QString &csvPath)
+{
+    FrameStats stats;
+    QFile csv(csvPath);
+    if(!csv.open(QIODevice::ReadOnly | QIODevice::Text)) return stats;
+
+    // system info comes first, then the metrics' own header row
+    QList<double> frametimes;
+    int column = -1;
+    while(!csv.atEnd()) {
+        const QList<QByteArray> fields = csv.readLine().trimmed().split(',');
+        if(column < 0) {
+            column = fields.indexOf("frametime");
+            continue;
+        }
+        bool ok = false;
+        const double frametime = fields.value(column).toDouble(&ok);
+        if(ok && frametime > 0) frametimes << frametime;
+    }
+    if(frametimes.isEmpty()) return stats;
+
+    double total = 0;
+    for(const double &frametime : std::as_const(frametimes))
+        total += frametime;
+    std::sort(frametimes.begin(), frametimes.end());
+
+    stats.frames = frametimes.count();
+    stats.avgFps = stats.frames * 1000.0 / total;
+    stats.low1 = 1000.0 / NearestRank(frametimes, 990);
+    stats.low01 = 1000.0 / NearestRank(frametimes, 999);
+    return stats;
+}
+
+NeroBench::RunResult NeroBench::RunOnce(const Variant &variant, const QString &outputDir)
+{
+    RunResult result;
+    QDir().mkpath(outputDir);
+
+    // hidden HUD, logging every frame of the window we care about.
+    qputenv(CliArgs::mangohudConfig.toLocal8Bit(),
+            QString("no_display,output_folder=%1,autostart_log=%2,log_duration=%3,log_interval=0")
+            .arg(outputDir).arg(warmup).arg(duration).toLocal8Bit());
+
+    NeroRunner runner(prefix);
+    runner.overrides = variant.settings;
+    runner.overrides.insert(NeroConfig::mangohud, true);
+
+    // the clock only starts once the game's up, however long getting there took.
+    QTimer stopTimer;
+    stopTimer.setSingleShot(true);
+    QObject::connect(&stopTimer, &QTimer::timeout, [&runner]() {
+        printf("Benchmark run's up, stopping...\n");
+        // wineserver too, so every run starts equally cold
+        runner.Halt(false);
+    });
+    QObject::connect(&runner, &NeroRunner::StatusUpdate, &stopTimer, [this, &stopTimer](int status) {
+        if(status == NeroRunner::RunnerProtonStarted) stopTimer.start((warmup + duration + NERO_BENCH_GRACE) * 1000);
+    });
+    stopTimer.start(launchTimeout * 1000);
+
+    result.exitCode = runner.StartShortcut(hash);
+    stopTimer.stop();
+    result.sync = runner.syncSummary;
+
+    for(int i = 0; i < NeroLaunchTimings::PhaseCount; ++i)
+        result.phases[i] = runner.timings.GetDuration(static_cast<NeroLaunchTimings::Phase>(i));
+    result.launch = runner.timings.GetTotal();
+
+    // newest log that isn't MangoHud's own summary of it
+    const QFileInfoList logs = QDir(outputDir).entryInfoList({ "*.csv" }, QDir::Files, QDir::Time);
+    for(const auto &log : logs)
+        if(!log.fileName().endsWith("_summary.csv")) {
+            result.frames = ReadFrametimes(log.filePath());
+            break;
+        }
+
+    if(result.frames.frames == 0)
+        printf("No frametimes were captured for this run - is MangoHud installed, and did the game stay up past the warmup?\n");
+    else printf("Launched in %.2fs; %d frames, %.1f FPS average, %.1f 1%% low, %.1f 0.1%% low\n",
+                result.launch / 1000.0, result.frames.frames, result.frames.avgFps, result.frames.low1, result.frames.low01);
+    return result;
+}
+
+QJsonObject NeroBench::Summarize(const Variant &variant, const QList<RunResult> &results) const
+{
+    QJsonArray runList;
+    QList<qint64> launches;
+    double avgFps = 0, low1 = 0, low01 = 0;
+    int framed = 0;
+
+    for(const auto &result : results) {
+        QJsonObject phases;
+        for(int i = 0; i < NeroLaunchTimings::PhaseCount; ++i)
+            phases.insert(NeroLaunchTimings::PhaseName(i), result.phases[i]);
+
+        runList.append(QJsonObject{ { "exitCode", result.exitCode },
+                                    { "sync", result.sync },
+                                    { "launchMs", result.launch },
+                                    { "phasesMs", phases },
+                                    { "frames", result.frames.frames },
+                                    { "avgFps", result.frames.avgFps },
+                                    { "low1Fps", result.frames.low1 },
+                                    { "low01Fps", result.frames.low01 } });
+
+        if(result.launch >= 0) launches << result.launch;
+        if(result.frames.frames > 0) {
+            avgFps += result.frames.avgFps;
+            low1 += result.frames.low1;
+            low01 += result.frames.low01;
+            ++framed;
+        }
+    }
+    std::sort(launches.begin(), launches.end());
+
+    // -1 for anything that never happened, same as the per-run numbers
+    return QJsonObject{ { "name", variant.name.isEmpty() ? "as configured" : variant.name },
+                        { "settings", QJsonObject::fromVariantMap(variant.settings) },
+                        { "launchP50Ms", launches.isEmpty() ? -1 : NearestRank(launches, 500) },
+                        { "launchP95Ms", launches.isEmpty() ? -1 : NearestRank(launches, 950) },
+                        { "avgFps", framed > 0 ? avgFps / framed : -1 },
+                        { "low1Fps", framed > 0 ? low1 / framed : -1 },
+                        { "low01Fps", framed > 0 ? low01 / framed : -1 },
+                        { "runs", runList } };
+}
+
+int NeroBench::Run()
+{
+    if(NeroFS::GetUmU().isEmpty()) return 1;
+
+    NeroRunner probe(prefix);
+    const NeroLaunchProfile profile = probe.GetProfile(hash);
+    if(!probe.CanLaunch(profile)) {
+        printf("The executable that %s links to currently doesn't exist.\n", profile.name.toLocal8Bit().constData());
+        return 1;
+    }
+    if(NeroFS::FindTool("mangohud").isEmpty())
+        printf("MangoHud isn't installed, so only launch times will be measured.\n");
+
+    if(variants.isEmpty()) variants << Variant();
+    const QDateTime started = QDateTime::currentDateTime();
+    const QString benchDir = QString("%1/%2/bench/%3-%4").arg(profile.prefixPath, Logs::logDirName, profile.hash,
+                                                              started.toString("yyyyMMdd-HHmmss"));
+    printf("Benchmarking %s with %s: %lld variant(s), %d run(s) each\n", profile.name.toLocal8Bit().constData(),
+           profile.runner.toLocal8Bit().constData(), static_cast<long long>(variants.count()), runs);
+
+    // runs get their MangoHud config through the environment, which goes back to how the user had it afterwards.
+    const bool hadConfig = qEnvironmentVariableIsSet(CliArgs::mangohudConfig.toLocal8Bit().constData());
+    const QByteArray userConfig = qgetenv(CliArgs::mangohudConfig.toLocal8Bit().constData());
+
+    QJsonArray summaries;
+    bool allLaunched = true;
+    for(int i = 0; i < variants.count(); ++i) {
+        QList<RunResult> results;
+        for(int run = 1; run <= runs; ++run) {
+            printf("\n=== %s: run %d of %d ===\n", variants.at(i).name.isEmpty() ? "As configured" : variants.at(i).name.toLocal8Bit().constData(),
+                   run, runs);
+            results << RunOnce(variants.at(i), QString("%1/%2-%3").arg(benchDir).arg(i).arg(run));
+            if(results.last().launch < 0) allLaunched = false;
+        }
+        summaries.append(Summarize(variants.at(i), results));
+    }
+
+    if(hadConfig) qputenv(CliArgs::mangohudConfig.toLocal8Bit().constData(), userConfig);
+    else qunsetenv(CliArgs::mangohudConfig.toLocal8Bit().constData());
+
+    auto seconds = [](const double &ms) { return ms < 0 ? QString("-") : QString::number(ms / 1000.0, 'f', 2) + 's'; };
+    auto fps = [](const double &value) { return value < 0 ? QString("-") : QString::number(value, 'f', 1); };
+
+    printf("\n%-40s %10s %10s %9s %9s %9s\n", "Variant", "Launch p50", "p95", "Avg FPS", "1% low", "0.1% low");
+    for(const auto &entry : std::as_const(summaries)) {
+        const QJsonObject summary = entry.toObject();
+        printf("%-40s %10s %10s %9s %9s %9s\n", summary.value("name").toString().toLocal8Bit().constData(),
+               seconds(summary.value("launchP50Ms").toDouble()).toLocal8Bit().constData(),
+               seconds(summary.value("launchP95Ms").toDouble()).toLocal8Bit().constData(),
+               fps(summary.value("avgFps").toDouble()).toLocal8Bit().constData(),
+               fps(summary.value("low1Fps").toDouble()).toLocal8Bit().constData(),
+               fps(summary.value("low01Fps").toDouble()).toLocal8Bit().constData());
+    }
+
+    const QJsonObject report = { { "prefix", prefix },
+                                 { "shortcut", profile.name },
+                                 { "hash", profile.hash },
+                                 { "runner", profile.runner },
+                                 { "started", started.toString(Qt::ISODate) },
+                                 { "runs", runs },
+                                 { "warmupSeconds", warmup },
+                                 { "durationSeconds", duration },
+                                 { "variants", summaries } };
+
+    const QString reportPath = outputPath.isEmpty() ? benchDir + "/results.json" : outputPath;
+    QDir().mkpath(QFileInfo(reportPath).path());
+    QSaveFile reportFile(reportPath);
+    if(!reportFile.open(QIODevice::WriteOnly)) {
+        printf("Couldn't write results to %s\n", reportPath.toLocal8Bit().constData());
+        return 1;
+    }
+    reportFile.write(QJsonDocument(report).toJson());
+    if(!reportFile.commit()) {
+        printf("Couldn't write results to %s\n", reportPath.toLocal8Bit().constData());
+        return 1;
+    }
+    printf("\nResults written to %s\n", reportPath.toLocal8Bit().constData());
+
+    // so scripts can tell a run that never got the game going apart from a slow one
+    return allLaunched ? 0 : 1;
+}
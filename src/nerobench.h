@@ -0,0 +1,87 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Launch & Frametime Benchmarks.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROBENCH_H
+#define NEROBENCH_H
+
+#include "nerotimings.h"
+
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+// Launches a shortcut over and over, optionally across a matrix of setting variants, timing each launch and
+// capturing its frametimes through MangoHud's own logging, so that settings (and runner updates) can be compared
+// by numbers instead of by feel. Variants only ever exist as NeroRunner overrides - the ini's never touched.
+class NeroBench
+{
+public:
+    struct FrameStats {
+        int frames = 0;
+        double avgFps = -1;
+        // as FPS, from the 99th/99.9th percentile frametimes
+        double low1 = -1;
+        double low01 = -1;
+    };
+
+    NeroBench(const QString &prefix, const QString &hash);
+
+    // METHODS
+    // takes whatever's left of the CLI's arguments: --runs, --duration, --warmup, --vary and --output
+    bool ParseOptions(const QStringList &);
+    int Run();
+
+    // MangoHud's per-frame log, i.e. <exe>_<date>.csv
+    static FrameStats ReadFrametimes(const QString &csvPath);
+
+private:
+    struct Variant {
+        QString name;
+        QMap<QString, QVariant> settings;
+    };
+
+    struct RunResult {
+        int exitCode = -1;
+        qint64 phases[NeroLaunchTimings::PhaseCount];
+        qint64 launch = -1;
+        FrameStats frames;
+        // the runner's own summary of the sync mode it resolved to, which isn't always the one that was asked for
+        QString sync;
+    };
+
+    RunResult RunOnce(const Variant &, const QString &outputDir);
+    QJsonObject Summarize(const Variant &, const QList<RunResult> &) const;
+    static bool AddDimension(const QString &, QList<Variant> &);
+
+    const QString prefix;
+    const QString hash;
+    int runs = 3;
+    // seconds of frametimes to capture, after warmup seconds of letting the game settle
+    int duration = 60;
+    int warmup = 10;
+    // how long the game gets to show up at all before a run's given up on
+    int launchTimeout = 180;
+    QString outputPath;
+    QList<Variant> variants;
+};
+
+#endif // NEROBENCH_H
@@ -92,7 +92,9 @@ public:
         NTsync = 0,
         Fsync,
         Esync,
-        NoSync
+        NoSync,
+        // picked at launch from whatever the kernel and runner support, see NeroSync
+        AutoSync
     } FileSyncModes_e;
 
     static enum {
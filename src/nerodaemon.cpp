@@ -0,0 +1,312 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Resident Launcher Daemon & CLI Client.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerodaemon.h"
+#include "nerofs.h"
+#include "neroprefixindex.h"
+#include "neroprofile.h"
+#include "nerosession.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcessEnvironment>
+#include <QStandardPaths>
+
+static QString FindShortcutHash(const QString &prefix, const QString &name)
+{
+    const QString prefixPath = NeroFS::GetPrefixesPath()->path() + '/' + prefix;
+
+    // same as the in-process CLI: cached profiles know their shortcut's name already.
+    QString hash = NeroLaunchProfile::FindCachedHash(prefixPath, name);
+    if(hash.isEmpty()) {
+        NeroPrefixCfg *prefixCfg = NeroFS::GetPrefixCfg(prefix);
+        if(prefixCfg != nullptr) {
+            const QMap<QString, QVariant> shortcuts = prefixCfg->GetGroup("Shortcuts");
+            for(auto i = shortcuts.constBegin(); i != shortcuts.constEnd(); ++i)
+                if(i.value().toString() == name) return i.key();
+        }
+    }
+    return hash;
+}
+
+/* Daemon */
+
+NeroDaemon::NeroDaemon(QObject *parent) : QObject(parent), server(this)
+{
+    connect(NeroSessionManager::Get(), &NeroSessionManager::SessionFinished, this, &NeroDaemon::FinishLaunch);
+}
+
+int NeroDaemon::Exec()
+{
+    // the daemon has no windows, so anything InitPaths/GetUmU would've asked the user has to be settled already.
+    if(NeroFS::GetManagerValue("Home").toString().isEmpty()) {
+        printf("Nero doesn't have a home directory set yet! Run Nero Manager once to set it up, then try again.\n");
+        return 1;
+    }
+    if(!QFile::exists(NeroFS::GetManagerValue("UMUpath").toString()) && NeroFS::FindTool("umu-run").isEmpty()) {
+        printf("No UMU instance found! Install umu-launcher or select a custom UMU path in Nero Manager first.\n");
+        return 1;
+    }
+
+    if(!NeroFS::InitPaths()) return 1;
+
+    if(NeroFS::GetUmU().isEmpty()) {
+        printf("UMU isn't usable, so there's nothing the daemon could launch. Aborting...\n");
+        return 1;
+    }
+    // warm up the prefix index too, it's what list requests and last played times go through.
+    NeroPrefixIndex::Get();
+
+    NeroDaemon daemon;
+    if(!daemon.Listen()) return 0;
+
+    printf("Nero daemon listening on %s\n", SocketPath().toLocal8Bit().constData());
+    return QCoreApplication::exec();
+}
+
+QString NeroDaemon::SocketPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + "/nero-umu.sock";
+}
+
+bool NeroDaemon::Listen()
+{
+    const QString path = SocketPath();
+
+    // someone's already answering here, no need for two of us.
+    NeroDaemonClient probe;
+    if(probe.Connect()) {
+        printf("A Nero daemon is already running on %s\n", path.toLocal8Bit().constData());
+        return false;
+    }
+
+    // otherwise it's left over from one that didn't get to clean up after itself.
+    QLocalServer::removeServer(path);
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    if(!server.listen(path)) {
+        printf("Couldn't listen on %s: %s\n", path.toLocal8Bit().constData(), server.errorString().toLocal8Bit().constData());
+        return false;
+    }
+
+    connect(&server, &QLocalServer::newConnection, this, &NeroDaemon::NewConnection);
+    return true;
+}
+
+void NeroDaemon::NewConnection()
+{
+    while(QLocalSocket *client = server.nextPendingConnection()) {
+        connect(client, &QLocalSocket::readyRead, this, [this, client]() { ReadRequests(client); });
+        connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+        // might've already sent something before we got to it
+        ReadRequests(client);
+    }
+}
+
+void NeroDaemon::ReadRequests(QLocalSocket *client)
+{
+    while(client->canReadLine()) {
+        QJsonParseError error;
+        const QJsonDocument request = QJsonDocument::fromJson(client->readLine(), &error);
+        if(error.error != QJsonParseError::NoError || !request.isObject())
+            ReplyError(client, "Malformed request: " + error.errorString());
+        else HandleRequest(client, request.object());
+    }
+}
+
+void NeroDaemon::HandleRequest(QLocalSocket *client, const QJsonObject &request)
+{
+    const QString cmd = request.value("cmd").toString();
+    const QString prefix = request.value("prefix").toString();
+    const QString shortcut = request.value("shortcut").toString();
+
+    if(cmd == "ping") {
+        Reply(client, { { "ok", true }, { "pid", QCoreApplication::applicationPid() } });
+    } else if(cmd == "list") {
+        if(!PrefixExists(prefix)) return ReplyError(client, "Prefix " + prefix + " doesn't exist!");
+
+        NeroPrefixCfg *prefixCfg = NeroFS::GetPrefixCfg(prefix);
+        QStringList names;
+        if(prefixCfg != nullptr) {
+            const QMap<QString, QVariant> shortcuts = prefixCfg->GetGroup("Shortcuts");
+            for(const auto &name : shortcuts)
+                names << name.toString();
+        }
+        names.sort();
+
+        Reply(client, { { "ok", true }, { "shortcuts", QJsonArray::fromStringList(names) } });
+    } else if(cmd == "launch") {
+        QStringList env;
+        const QJsonArray envArray = request.value("env").toArray();
+        for(const auto &var : envArray)
+            env << var.toString();
+        StartLaunch(client, prefix, shortcut, env);
+    } else if(cmd == "stop") {
+        const QList<NeroSessionContext> sessions = NeroSessionManager::Get()->GetSessions(prefix);
+        for(const auto &session : sessions)
+            if(session.name == shortcut) {
+                NeroSessionManager::Get()->Stop(session.id);
+                return Reply(client, { { "ok", true } });
+            }
+        ReplyError(client, shortcut + " isn't running in " + prefix + '.');
+    } else ReplyError(client, "Unknown command: " + cmd);
+}
+
+void NeroDaemon::StartLaunch(QLocalSocket *client, const QString &prefix, const QString &shortcut, const QStringList &env)
+{
+    if(!PrefixExists(prefix))
+        return ReplyError(client, "Prefix " + prefix + " doesn't exist!");
+
+    const QString hash = FindShortcutHash(prefix, shortcut);
+    if(hash.isEmpty())
+        return ReplyError(client, "Shortcut not found in prefix! Check that the spelling is correct, "
+                                  "or run Nero Manager to create this shortcut if it doesn't exist.");
+
+    // clients that didn't send theirs (or sent an empty one) just get the daemon's, same as before.
+    const int id = NeroSessionManager::Get()->StartShortcut(prefix, hash, env);
+    if(id < 0)
+        return ReplyError(client, "The executable that " + shortcut + " links to currently doesn't exist.");
+
+    clients.insert(id, client);
+    printf("Launching %s in %s\n", shortcut.toLocal8Bit().constData(), prefix.toLocal8Bit().constData());
+    Reply(client, { { "ok", true }, { "event", "started" } });
+}
+
+void NeroDaemon::FinishLaunch(const NeroSessionContext &session, const int &result)
+{
+    if(!clients.contains(session.id)) return;
+    const QPointer<QLocalSocket> client = clients.take(session.id);
+
+    printf("%s exited with code %d\n", session.name.toLocal8Bit().constData(), result);
+    // the client might've given up waiting (or been killed) in the meantime, that's fine.
+    if(!client.isNull())
+        Reply(client, { { "ok", true }, { "event", "exited" }, { "code", result } });
+}
+
+void NeroDaemon::Reply(QLocalSocket *client, const QJsonObject &reply)
+{
+    client->write(QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n');
+    client->flush();
+}
+
+void NeroDaemon::ReplyError(QLocalSocket *client, const QString &error, const bool &fallback)
+{
+    Reply(client, { { "ok", false }, { "error", error }, { "fallback", fallback } });
+}
+
+bool NeroDaemon::PrefixExists(const QString &prefix)
+{
+    return !prefix.isEmpty() && QFileInfo::exists(NeroFS::GetPrefixesPath()->path() + '/' + prefix + "/nero-settings.ini");
+}
+
+/* Client */
+
+bool NeroDaemonClient::RunCli(int &argc, char **argv, int &exitCode)
+{
+    QStringList arguments;
+    for(int i = 1; i < argc; ++i)
+        arguments.append(argv[i]);
+
+    const int prefixArg = arguments.indexOf("--prefix");
+    if(prefixArg < 0 || prefixArg+1 >= arguments.count()) return false;
+    const QString prefix = arguments.at(prefixArg+1);
+
+    QJsonObject request;
+    const int shortcutArg = arguments.indexOf("--shortcut");
+    if(shortcutArg >= 0 && shortcutArg+1 < arguments.count()) {
+        // profiles are dumped from the ini itself, no point asking the daemon about that.
+        // (and benchmarks drive their runs themselves, straight from the CLI)
+        if(arguments.contains("--dump-profile") || arguments.contains("--bench")) return false;
+        request = { { "cmd", arguments.contains("--stop") ? "stop" : "launch" },
+                    { "prefix", prefix },
+                    { "shortcut", arguments.at(shortcutArg+1) } };
+        // the daemon's own environment is whatever it was started from, which isn't necessarily ours -
+        // things like SteamAppId, overlay preloads, MangoHud/DXVK vars or even the display all come from the caller.
+        if(request.value("cmd").toString() == "launch")
+            request.insert("env", QJsonArray::fromStringList(QProcessEnvironment::systemEnvironment().toStringList()));
+    } else if(arguments.last() == "--list") {
+        request = { { "cmd", "list" }, { "prefix", prefix } };
+    } else return false;
+
+    // just enough of an app for the socket, without the display connection a QApplication needs.
+    QCoreApplication app(argc, argv);
+
+    NeroDaemonClient client;
+    if(!client.Connect()) return false;
+
+    QJsonObject reply = client.Send(request);
+    if(reply.isEmpty()) return false;
+
+    if(!reply.value("ok").toBool()) {
+        if(reply.value("fallback").toBool()) return false;
+        printf("%s\n", reply.value("error").toString().toLocal8Bit().constData());
+        exitCode = 1;
+        return true;
+    }
+
+    if(request.value("cmd").toString() == "list") {
+        const QJsonArray shortcuts = reply.value("shortcuts").toArray();
+        if(shortcuts.isEmpty()) {
+            printf("Prefix %s doesn't seem to contain any registered shortcuts.\n", prefix.toLocal8Bit().constData());
+        } else {
+            printf("\n - %s Shortcuts:\n", prefix.toLocal8Bit().constData());
+            for(const auto &shortcut : shortcuts)
+                printf("%s\n", shortcut.toString().toLocal8Bit().constData());
+        }
+        exitCode = 0;
+    } else if(request.value("cmd").toString() == "launch") {
+        printf("Launched through the Nero daemon, waiting for it to exit...\n");
+        reply = client.Next();
+        if(reply.value("event").toString() == "exited")
+            exitCode = reply.value("code").toInt();
+        else {
+            printf("Lost connection to the Nero daemon!\n");
+            exitCode = 1;
+        }
+    } else exitCode = 0;
+
+    return true;
+}
+
+bool NeroDaemonClient::Connect(const int &timeout)
+{
+    socket.connectToServer(NeroDaemon::SocketPath());
+    return socket.waitForConnected(timeout);
+}
+
+QJsonObject NeroDaemonClient::Send(const QJsonObject &request)
+{
+    socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+    if(!socket.waitForBytesWritten(1000)) return QJsonObject();
+
+    return Next();
+}
+
+QJsonObject NeroDaemonClient::Next()
+{
+    while(!socket.canReadLine()) {
+        if(socket.state() != QLocalSocket::ConnectedState || !socket.waitForReadyRead(-1))
+            // whatever's left might still be one last line
+            if(!socket.canReadLine()) return QJsonObject();
+    }
+
+    return QJsonDocument::fromJson(socket.readLine()).object();
+}
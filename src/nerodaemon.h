@@ -0,0 +1,92 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Resident Launcher Daemon & CLI Client.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NERODAEMON_H
+#define NERODAEMON_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+
+struct NeroSessionContext;
+
+// A headless Nero that stays resident with NeroFS, umu and the prefix/runner indexes already warmed up,
+// so CLI launches don't have to pay for any of that every time.
+// Talks one JSON object per line over a local socket in $XDG_RUNTIME_DIR:
+//   {"cmd":"ping"}                                   -> {"ok":true,"pid":...}
+//   {"cmd":"list","prefix":"..."}                    -> {"ok":true,"shortcuts":[...]}
+//   {"cmd":"launch","prefix":"...","shortcut":"..."} -> {"ok":true,"event":"started"}, then {"ok":true,"event":"exited","code":...}
+//   {"cmd":"stop","prefix":"...","shortcut":"..."}   -> {"ok":true}
+// Failures are {"ok":false,"error":"...","fallback":bool} - fallback meaning the client should just do it itself.
+// Launches are sessions like the manager's, so any number of them can be going at once, in any prefixes.
+class NeroDaemon : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NeroDaemon(QObject *parent = nullptr);
+
+    // runs the daemon in a QCoreApplication that's already been made, until it's quit.
+    static int Exec();
+    static QString SocketPath();
+
+    // false if another daemon already has the socket, or it couldn't be made.
+    bool Listen();
+
+private slots:
+    void NewConnection();
+
+private:
+    void ReadRequests(QLocalSocket *);
+    void HandleRequest(QLocalSocket *, const QJsonObject &);
+    void StartLaunch(QLocalSocket *, const QString &prefix, const QString &shortcut, const QStringList &env);
+    void FinishLaunch(const NeroSessionContext &, const int &result);
+    static void Reply(QLocalSocket *, const QJsonObject &);
+    static void ReplyError(QLocalSocket *, const QString &error, const bool &fallback = false);
+    static bool PrefixExists(const QString &);
+
+    QLocalServer server;
+    // session id -> whoever asked for it, to be told once it exits.
+    QMap<int, QPointer<QLocalSocket>> clients;
+};
+
+// CLI side of the above. Everything here blocks, since the CLI has nothing else to do in the meantime.
+class NeroDaemonClient
+{
+public:
+    // tries to serve a CLI call (shortcut launch/stop, --list) through a running daemon.
+    // false if there's no daemon, or it can't take this one - the caller should just handle it in-process then.
+    static bool RunCli(int &argc, char **argv, int &exitCode);
+
+    bool Connect(const int &timeout = 500);
+    // empty object if the daemon went away.
+    QJsonObject Send(const QJsonObject &);
+    // waits for the next reply line (i.e. a launch's exit), however long that takes.
+    QJsonObject Next();
+
+private:
+    QLocalSocket socket;
+};
+
+#endif // NERODAEMON_H
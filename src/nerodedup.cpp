@@ -0,0 +1,475 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Cross-Prefix File Deduplication.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerodedup.h"
+#include "nerofs.h"
+#include "nerowineserver.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QVector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/fs.h>
+
+#define NERO_DEDUP_INDEX_MAGIC 0x4E444450
+#define NERO_DEDUP_INDEX_VERSION 1
+
+// the parts of a prefix that are (nearly) the same everywhere - drive_c's apps and the registry are left well alone.
+static const QStringList dedupDirs = {
+    "drive_c/windows/system32",
+    "drive_c/windows/syswow64",
+    "drive_c/windows/Microsoft.NET",
+    "drive_c/windows/assembly",
+    "drive_c/windows/winsxs",
+};
+
+// anything smaller isn't worth the hashing, and mostly fits in one block anyway.
+static constexpr qint64 minimumSize = 16 * 1024;
+
+// FIDEDUPERANGE is capped per call on most filesystems, so bigger files go in chunks.
+static constexpr qint64 dedupeChunk = 16 * 1024 * 1024;
+
+NeroDedup::Stats NeroDedup::Run()
+{
+    Stats stats;
+    LoadIndex();
+
+    QList<File> files;
+    QStringList skipped;
+    const QString home = NeroFS::GetPrefixesPath()->path();
+    const QStringList prefixes = NeroFS::GetPrefixes();
+    for(const QString &prefix : prefixes) {
+        // whatever's running in there could be writing to its system files right now, which would write to every prefix's.
+        if(method == Hardlink && NeroWineserver::IsAlive(home + '/' + prefix)) {
+            printf("Skipping %s, since it's running right now\n", prefix.toLocal8Bit().constData());
+            skipped.append(home + '/' + prefix + '/');
+            continue;
+        }
+        Collect(prefix, home + '/' + prefix, files);
+    }
+    stats.scanned = files.count();
+
+    // only sizes that show up more than once can possibly have duplicates, so nothing else needs hashing.
+    QHash<qint64, QList<int>> bySize;
+    for(int i = 0; i < files.count(); ++i)
+        bySize[files.at(i).entry.size].append(i);
+
+    QList<int> candidates, toHash;
+    for(auto it = bySize.cbegin(); it != bySize.cend(); ++it) {
+        if(it.value().count() < 2) continue;
+        for(const int &i : it.value()) {
+            candidates.append(i);
+            File &file = files[i];
+            const Entry known = index.value(file.path);
+            if(!known.hash.isEmpty() && known.size == file.entry.size && known.mtime == file.entry.mtime &&
+               known.inode == file.entry.inode && known.device == file.entry.device) {
+                file.entry.hash = known.hash;
+                file.entry.shared = known.shared;
+            } else toHash.append(i);
+        }
+    }
+
+    printf("Scanned %d files across %d prefixes, hashing %d of them...\n",
+           stats.scanned, static_cast<int>(prefixes.count()), static_cast<int>(toHash.count()));
+
+    // every task writes to its own slot, so nothing here needs locking.
+    QVector<QByteArray> hashes(toHash.count());
+    QByteArray *results = hashes.data();
+    QThreadPool pool;
+    for(int i = 0; i < toHash.count(); ++i) {
+        const QString path = files.at(toHash.at(i)).path;
+        pool.start([results, i, path]() { results[i] = Hash(path); });
+    }
+    pool.waitForDone();
+
+    for(int i = 0; i < toHash.count(); ++i) {
+        files[toHash.at(i)].entry.hash = hashes.at(i);
+        if(!hashes.at(i).isEmpty()) stats.hashed++;
+    }
+
+    // hardlinks can't cross filesystems; extents can't either, but the kernel's the one to tell us that.
+    QHash<QByteArray, QList<int>> groups;
+    for(const int &i : std::as_const(candidates)) {
+        const Entry &entry = files.at(i).entry;
+        if(entry.hash.isEmpty()) continue;
+        QByteArray key = entry.hash + QByteArray::number(entry.size);
+        if(method == Hardlink) key += '@' + QByteArray::number(entry.device);
+        groups[key].append(i);
+    }
+
+    for(auto it = groups.cbegin(); it != groups.cend(); ++it) {
+        const QList<int> &group = it.value();
+        if(group.count() < 2) continue;
+
+        // share into whichever copy's already shared, so earlier runs' extents are what everything ends up on.
+        int sourceIndex = group.first();
+        for(const int &i : group)
+            if(files.at(i).entry.shared) {
+                sourceIndex = i;
+                break;
+            }
+        File &source = files[sourceIndex];
+
+        for(const int &i : group) {
+            if(i == sourceIndex) continue;
+            File &target = files[i];
+
+            const bool alreadyShared = method == Hardlink ? target.entry.inode == source.entry.inode
+                                                          : target.entry.shared && source.entry.shared;
+            if(alreadyShared) {
+                stats.alreadyShared += target.entry.size;
+                continue;
+            }
+
+            if(dryRun) {
+                stats.shared++;
+                stats.reclaimed += target.entry.size;
+                continue;
+            }
+
+            if(method == Hardlink ? ShareLink(source, target) : ShareRange(source, target)) {
+                stats.shared++;
+                stats.reclaimed += target.entry.size;
+                source.entry.shared = true;
+                target.entry.shared = true;
+                if(method == Hardlink) {
+                    target.entry.inode = source.entry.inode;
+                    target.entry.mtime = source.entry.mtime;
+                }
+            } else stats.failed++;
+        }
+    }
+
+    if(!dryRun) {
+        // rebuilt from this scan, so anything that's since been deleted drops out with it.
+        // skipped prefixes weren't scanned at all though, so they keep what they had.
+        const QHash<QString, Entry> previous = index;
+        index.clear();
+        for(auto it = previous.cbegin(); it != previous.cend(); ++it)
+            for(const QString &skippedPath : std::as_const(skipped))
+                if(it.key().startsWith(skippedPath)) index.insert(it.key(), it.value());
+        for(const int &i : std::as_const(candidates))
+            if(!files.at(i).entry.hash.isEmpty())
+                index.insert(files.at(i).path, files.at(i).entry);
+        SaveIndex();
+        WriteMarkers();
+    }
+
+    return stats;
+}
+
+void NeroDedup::Collect(const QString &prefix, const QString &prefixPath, QList<File> &files)
+{
+    for(const QString &dir : dedupDirs) {
+        QDirIterator it(prefixPath + '/' + dir, QDir::Files | QDir::Hidden | QDir::System | QDir::NoSymLinks,
+                        QDirIterator::Subdirectories);
+        while(it.hasNext()) {
+            const QString path = it.next();
+            // leftovers from an interrupted link or unshare
+            if(path.endsWith(".nero-dedup") || path.endsWith(".nero-unshare")) continue;
+
+            struct stat info;
+            if(lstat(path.toLocal8Bit().constData(), &info) != 0 || !S_ISREG(info.st_mode)) continue;
+            if(info.st_size < minimumSize) continue;
+
+            File file;
+            file.path = path;
+            file.prefix = prefix;
+            file.relative = path.mid(prefixPath.length() + 1);
+            file.entry.size = info.st_size;
+            file.entry.mtime = static_cast<qint64>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+            file.entry.inode = info.st_ino;
+            file.entry.device = info.st_dev;
+            files.append(file);
+        }
+    }
+}
+
+QByteArray NeroDedup::Hash(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) return {};
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if(!hash.addData(&file)) return {};
+    return hash.result();
+}
+
+// the file's still what was hashed, as far as the inode can tell.
+static bool IsUnchanged(const int &fd, const qint64 &size, const qint64 &mtime, const quint64 &inode)
+{
+    struct stat info;
+    if(fstat(fd, &info) != 0) return false;
+    return info.st_size == size && info.st_ino == inode &&
+           static_cast<qint64>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec == mtime;
+}
+
+bool NeroDedup::ShareRange(const File &source, const File &target)
+{
+#ifdef FIDEDUPERANGE
+    if(unsupported.contains(target.entry.device)) return false;
+
+    const int in = open(source.path.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+    if(in < 0) return false;
+    // opening for writing doesn't touch the file, but older kernels won't dedupe into anything opened read-only.
+    const int out = open(target.path.toLocal8Bit().constData(), O_RDWR | O_CLOEXEC);
+    if(out < 0) {
+        printf("Couldn't open %s for deduplication: %s\n", target.path.toLocal8Bit().constData(), strerror(errno));
+        close(in);
+        return false;
+    }
+
+    bool ok = IsUnchanged(in, source.entry.size, source.entry.mtime, source.entry.inode) &&
+              IsUnchanged(out, target.entry.size, target.entry.mtime, target.entry.inode);
+
+    QByteArray buffer(sizeof(file_dedupe_range) + sizeof(file_dedupe_range_info), 0);
+    file_dedupe_range *range = reinterpret_cast<file_dedupe_range*>(buffer.data());
+    range->dest_count = 1;
+    range->info[0].dest_fd = out;
+
+    qint64 offset = 0;
+    while(ok && offset < source.entry.size) {
+        range->src_offset = offset;
+        range->src_length = qMin(dedupeChunk, source.entry.size - offset);
+        range->info[0].dest_offset = offset;
+        range->info[0].bytes_deduped = 0;
+        range->info[0].status = 0;
+
+        const int error = ioctl(in, FIDEDUPERANGE, range) != 0 ? errno : -range->info[0].status;
+        if(error == EOPNOTSUPP || error == ENOTTY || error == EXDEV) {
+            printf("The filesystem holding %s can't share extents, skipping it (try --hardlink instead)\n",
+                   target.path.toLocal8Bit().constData());
+            unsupported.insert(target.entry.device);
+            ok = false;
+        } else if(error > 0) {
+            printf("Couldn't deduplicate %s: %s\n", target.path.toLocal8Bit().constData(), strerror(error));
+            ok = false;
+        } else if(range->info[0].status == FILE_DEDUPE_RANGE_DIFFERS || range->info[0].bytes_deduped == 0) {
+            // changed after it was hashed - the kernel compares them itself, so nothing got shared.
+            ok = false;
+        } else offset += range->info[0].bytes_deduped;
+    }
+
+    close(in);
+    close(out);
+    return ok;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(target);
+    if(unsupported.isEmpty()) {
+        printf("This build of Nero can't share extents, try --hardlink instead\n");
+        unsupported.insert(0);
+    }
+    return false;
+#endif
+}
+
+bool NeroDedup::ShareLink(const File &source, const File &target)
+{
+    const QByteArray sourcePath = source.path.toLocal8Bit();
+    const QByteArray targetPath = target.path.toLocal8Bit();
+    const QByteArray tempPath = targetPath + ".nero-dedup";
+
+    const int in = open(sourcePath.constData(), O_RDONLY | O_CLOEXEC);
+    if(in < 0) return false;
+    const int out = open(targetPath.constData(), O_RDONLY | O_CLOEXEC);
+    if(out < 0) {
+        close(in);
+        return false;
+    }
+
+    struct stat info;
+    bool ok = IsUnchanged(in, source.entry.size, source.entry.mtime, source.entry.inode) &&
+              IsUnchanged(out, target.entry.size, target.entry.mtime, target.entry.inode) &&
+              fstat(in, &info) == 0;
+
+    // read-only, so anything that does try writing to a shared file fails loudly instead of changing every prefix at once.
+    if(ok) ok = fchmod(in, info.st_mode & 0555) == 0;
+    close(in);
+    close(out);
+    if(!ok) return false;
+
+    // linked in next to it and renamed over, so the target's never missing if this gets interrupted.
+    unlink(tempPath.constData());
+    if(link(sourcePath.constData(), tempPath.constData()) != 0 || rename(tempPath.constData(), targetPath.constData()) != 0) {
+        printf("Couldn't link %s: %s\n", targetPath.constData(), strerror(errno));
+        unlink(tempPath.constData());
+        return false;
+    }
+
+    linked[source.prefix].append(source.relative);
+    linked[target.prefix].append(target.relative);
+    return true;
+}
+
+bool NeroDedup::Unshare(const QString &prefixPath)
+{
+    QFile marker(GetMarkerPath(prefixPath));
+    if(!marker.exists()) return true;
+    if(!marker.open(QIODevice::ReadOnly)) return false;
+
+    const QStringList paths = QString::fromUtf8(marker.readAll()).split('\n', Qt::SkipEmptyParts);
+    marker.close();
+
+    QStringList failed;
+    int copied = 0;
+    for(const QString &relative : paths) {
+        const QString path = prefixPath + '/' + relative;
+        const QByteArray localPath = path.toLocal8Bit();
+
+        struct stat info;
+        // already gone, or already replaced by something else
+        if(lstat(localPath.constData(), &info) != 0 || !S_ISREG(info.st_mode)) continue;
+        const mode_t mode = (info.st_mode & 07777) | S_IWUSR;
+
+        if(info.st_nlink > 1) {
+            // a copy of its own, swapped in with the same timestamps so Proton doesn't think it's been upgraded.
+            const QString tempPath = path + ".nero-unshare";
+            const QByteArray localTemp = tempPath.toLocal8Bit();
+            QFile::remove(tempPath);
+
+            const struct timespec times[2] = { info.st_atim, info.st_mtim };
+            if(!QFile::copy(path, tempPath) || chmod(localTemp.constData(), mode) != 0 ||
+               utimensat(AT_FDCWD, localTemp.constData(), times, 0) != 0 ||
+               rename(localTemp.constData(), localPath.constData()) != 0) {
+                QFile::remove(tempPath);
+                failed.append(relative);
+                continue;
+            }
+            copied++;
+        } else if(chmod(localPath.constData(), mode) != 0) {
+            failed.append(relative);
+        }
+    }
+
+    if(failed.isEmpty()) {
+        marker.remove();
+    } else {
+        QSaveFile remaining(marker.fileName());
+        if(remaining.open(QIODevice::WriteOnly)) {
+            remaining.write(failed.join('\n').toUtf8() + '\n');
+            remaining.commit();
+        }
+        printf("Couldn't unshare %d files in %s\n", static_cast<int>(failed.count()), prefixPath.toLocal8Bit().constData());
+    }
+
+    printf("Unshared %d deduplicated files in %s\n", copied, prefixPath.toLocal8Bit().constData());
+    return failed.isEmpty();
+}
+
+void NeroDedup::UnshareIfUpgrading(const QString &prefixPath, const QString &runnerPath)
+{
+    // the usual case, and just a stat.
+    if(!QFile::exists(GetMarkerPath(prefixPath))) return;
+
+    QFile prefixVersion(prefixPath + "/version");
+    QFile runnerVersion(runnerPath + "/version");
+    // same check Proton does, and if either one's missing it's safer to assume the worst.
+    if(prefixVersion.open(QIODevice::ReadOnly) && runnerVersion.open(QIODevice::ReadOnly) &&
+       prefixVersion.readAll().trimmed() == runnerVersion.readAll().trimmed())
+        return;
+
+    Unshare(prefixPath);
+}
+
+void NeroDedup::LoadIndex()
+{
+    index.clear();
+
+    QFile indexFile(GetIndexPath());
+    if(!indexFile.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&indexFile);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic, version, count;
+    in >> magic >> version;
+    if(magic != NERO_DEDUP_INDEX_MAGIC || version != NERO_DEDUP_INDEX_VERSION) return;
+
+    in >> count;
+    index.reserve(count);
+    for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Entry entry;
+        in >> path >> entry.size >> entry.mtime >> entry.inode >> entry.device >> entry.hash >> entry.shared;
+        index.insert(path, entry);
+    }
+
+    // a half-read index is worse than none at all
+    if(in.status() != QDataStream::Ok) index.clear();
+}
+
+void NeroDedup::SaveIndex() const
+{
+    QSaveFile indexFile(GetIndexPath());
+    if(!indexFile.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&indexFile);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << (quint32)NERO_DEDUP_INDEX_MAGIC << (quint32)NERO_DEDUP_INDEX_VERSION << (quint32)index.count();
+    for(auto it = index.cbegin(); it != index.cend(); ++it)
+        out << it.key() << it.value().size << it.value().mtime << it.value().inode << it.value().device
+            << it.value().hash << it.value().shared;
+
+    if(out.status() == QDataStream::Ok) indexFile.commit();
+}
+
+void NeroDedup::WriteMarkers() const
+{
+    const QString home = NeroFS::GetPrefixesPath()->path();
+
+    for(auto it = linked.cbegin(); it != linked.cend(); ++it) {
+        const QString markerPath = GetMarkerPath(home + '/' + it.key());
+
+        // added to whatever earlier runs linked (and nothing's unshared since)
+        QStringList paths;
+        QFile existing(markerPath);
+        if(existing.open(QIODevice::ReadOnly))
+            paths = QString::fromUtf8(existing.readAll()).split('\n', Qt::SkipEmptyParts);
+        paths.append(it.value());
+        paths.removeDuplicates();
+
+        QSaveFile marker(markerPath);
+        if(marker.open(QIODevice::WriteOnly)) {
+            marker.write(paths.join('\n').toUtf8() + '\n');
+            marker.commit();
+        }
+    }
+}
+
+QString NeroDedup::GetIndexPath()
+{
+    return NeroFS::GetPrefixesPath()->path() + "/.nero-dedup.index";
+}
+
+QString NeroDedup::GetMarkerPath(const QString &prefixPath)
+{
+    return prefixPath + "/.nero-dedup-hardlinks";
+}
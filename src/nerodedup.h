@@ -0,0 +1,106 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Cross-Prefix File Deduplication.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NERODEDUP_H
+#define NERODEDUP_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// Finds the files every prefix has its own copy of (system32/syswow64, and whatever vcrun/dotnet put in there),
+// and makes them share storage across all of the home dir's prefixes.
+// By default that's FIDEDUPERANGE, where the kernel checks the bytes really are the same before sharing extents,
+// and the first write to either side just gets its own copy again - nothing can go wrong, but only on btrfs/XFS/bcachefs.
+// Hardlinks work everywhere and share page cache too (reflinked files still get cached once per inode), but writing to
+// one writes to all of them - so they're opt-in, made read-only, never made in a running prefix, and broken again by Unshare
+// before anything that writes to a prefix's system files (winetricks, one-time runs, or Proton upgrading the prefix to another runner's files).
+// Hashes are kept in <prefixes>/.nero-dedup.index, so later scans only hash what's new or changed since.
+class NeroDedup
+{
+public:
+    enum Method {
+        Reflink,
+        Hardlink
+    };
+
+    struct Stats {
+        int scanned = 0;
+        int hashed = 0;
+        int shared = 0;
+        int failed = 0;
+        qint64 reclaimed = 0;
+        // from earlier runs, and still shared
+        qint64 alreadyShared = 0;
+    };
+
+    NeroDedup(const Method &method = Reflink, const bool &dryRun = false) : method(method), dryRun(dryRun) {}
+
+    // METHODS
+    // walks and hashes every prefix in the home dir, so keep this off the GUI thread.
+    Stats Run();
+
+    // gives every hardlinked file in the prefix its own (writable) inode back; a no-op for prefixes that never had any.
+    static bool Unshare(const QString &prefixPath);
+    // Unshare, but only if Proton's about to upgrade the prefix, i.e. its version file doesn't match the runner's.
+    static void UnshareIfUpgrading(const QString &prefixPath, const QString &runnerPath);
+
+private:
+    struct Entry {
+        qint64 size = 0;
+        qint64 mtime = 0;
+        quint64 inode = 0;
+        quint64 device = 0;
+        QByteArray hash;
+        // already deduplicated by an earlier run, and not touched since
+        bool shared = false;
+    };
+
+    struct File {
+        QString path;
+        QString prefix;
+        // from the prefix's root, for the hardlinks marker
+        QString relative;
+        Entry entry;
+    };
+
+    static void Collect(const QString &prefix, const QString &prefixPath, QList<File> &files);
+    static QByteArray Hash(const QString &path);
+    bool ShareRange(const File &source, const File &target);
+    bool ShareLink(const File &source, const File &target);
+    void LoadIndex();
+    void SaveIndex() const;
+    void WriteMarkers() const;
+
+    static QString GetIndexPath();
+    static QString GetMarkerPath(const QString &prefixPath);
+
+    const Method method;
+    const bool dryRun;
+    QHash<QString, Entry> index;
+    // prefix -> paths relative to it that hardlinking touched this run
+    QHash<QString, QStringList> linked;
+    // filesystems that turned out not to do FIDEDUPERANGE, so they're not asked again for every file
+    QSet<quint64> unsupported;
+};
+
+#endif // NERODEDUP_H
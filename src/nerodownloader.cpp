@@ -0,0 +1,212 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Shared Download & Content Cache Service.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerodownloader.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTimer>
+
+NeroDownloader *NeroDownloader::Get()
+{
+    // parented to the app, so it (and its one network manager) lives exactly as long as we do.
+    static QPointer<NeroDownloader> instance;
+    if(instance.isNull()) instance = new NeroDownloader(QCoreApplication::instance());
+    return instance;
+}
+
+QString NeroDownloader::GetCachePath(const QUrl &url)
+{
+    const QString name = url.fileName().isEmpty() ? QString("download") : url.fileName();
+    return QString("%1/nero-umu/downloads/%2-%3").arg(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation),
+                                                      QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex().left(16),
+                                                      name);
+}
+
+void NeroDownloader::Fetch(const QUrl &url, QObject *context, const Callback &callback, const int &maxAge)
+{
+    // someone's already getting it, so just wait for the same one
+    if(downloads.contains(url)) {
+        downloads[url].waiters.append({ context, callback });
+        return;
+    }
+
+    const QString path = GetCachePath(url);
+    const QSettings meta(path + ".meta", QSettings::IniFormat);
+
+    if(QFile::exists(path) && QDateTime::currentSecsSinceEpoch() - meta.value("Checked", 0).toLongLong() < maxAge) {
+        // still fresh, no need to even ask - but still call back from the event loop, same as a real download would.
+        const QPointer<QObject> guard(context);
+        QTimer::singleShot(0, this, [guard, callback, path]() {
+            if(!guard.isNull()) callback(path, QString());
+        });
+        return;
+    }
+
+    downloads[url].waiters.append({ context, callback });
+    Start(url);
+}
+
+void NeroDownloader::Start(const QUrl &url)
+{
+    Download &download = downloads[url];
+    const QString path = GetCachePath(url);
+    QDir().mkpath(QFileInfo(path).path());
+
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "Nero-UMU");
+
+    const QSettings meta(path + ".meta", QSettings::IniFormat);
+
+    // only re-download if it's actually changed
+    if(QFile::exists(path)) {
+        if(!meta.value("ETag").toByteArray().isEmpty())
+            request.setRawHeader("If-None-Match", meta.value("ETag").toByteArray());
+        if(!meta.value("LastModified").toByteArray().isEmpty())
+            request.setRawHeader("If-Modified-Since", meta.value("LastModified").toByteArray());
+    }
+
+    delete download.part;
+    download.part = new QFile(path + ".part", this);
+    download.resumeFrom = 0;
+
+    // pick up an interrupted download, as long as it's still the same file on the other end
+    const QByteArray partTag = meta.value("PartTag").toByteArray();
+    if(!download.retried && download.part->exists() && download.part->size() > 0 && !partTag.isEmpty()) {
+        download.resumeFrom = download.part->size();
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(download.resumeFrom) + '-');
+        request.setRawHeader("If-Range", partTag);
+        printf("Resuming download of %s from %lld bytes\n", url.toString().toLocal8Bit().constData(), download.resumeFrom);
+    }
+
+    download.reply = manager.get(request);
+
+    connect(download.reply, &QNetworkReply::metaDataChanged, this, [this, url]() { OnMetaData(url); });
+    connect(download.reply, &QNetworkReply::readyRead, this, [this, url]() { OnReadyRead(url); });
+    connect(download.reply, &QNetworkReply::finished, this, [this, url]() { OnFinished(url); });
+    connect(download.reply, &QNetworkReply::downloadProgress, this, [this, url](qint64 received, qint64 total) {
+        const qint64 offset = downloads.value(url).resumeFrom;
+        emit Progress(url, received + offset, total > 0 ? total + offset : total);
+    });
+}
+
+void NeroDownloader::OnMetaData(const QUrl &url)
+{
+    Download &download = downloads[url];
+    const int status = download.reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if(status != 200 && status != 206) return;
+
+    // server ignored the range (or the file changed since), so the old part is no good
+    if(status == 200) download.resumeFrom = 0;
+
+    if(!download.part->isOpen()) {
+        const bool opened = download.resumeFrom > 0 ? download.part->open(QIODevice::WriteOnly | QIODevice::Append)
+                                                    : download.part->open(QIODevice::WriteOnly | QIODevice::Truncate);
+        if(!opened) {
+            printf("Couldn't open %s for writing!\n", download.part->fileName().toLocal8Bit().constData());
+            download.reply->abort();
+            return;
+        }
+
+        // what If-Range gets checked against, should this get cut off
+        QSettings meta(GetCachePath(url) + ".meta", QSettings::IniFormat);
+        const QByteArray tag = download.reply->hasRawHeader("ETag") ? download.reply->rawHeader("ETag")
+                                                                      : download.reply->rawHeader("Last-Modified");
+        if(download.resumeFrom == 0) meta.setValue("PartTag", tag);
+    }
+}
+
+void NeroDownloader::OnReadyRead(const QUrl &url)
+{
+    Download &download = downloads[url];
+    if(!download.part->isOpen()) OnMetaData(url);
+
+    // 304s and error pages don't go anywhere
+    if(download.part->isOpen())
+        download.part->write(download.reply->readAll());
+    else download.reply->readAll();
+}
+
+void NeroDownloader::OnFinished(const QUrl &url)
+{
+    Download &download = downloads[url];
+    QNetworkReply *reply = download.reply;
+    download.reply = nullptr;
+    reply->deleteLater();
+
+    if(download.part->isOpen()) {
+        download.part->write(reply->readAll());
+        download.part->close();
+    }
+
+    const QString path = GetCachePath(url);
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QSettings meta(path + ".meta", QSettings::IniFormat);
+
+    if(status == 304) {
+        printf("%s hasn't changed, using cached copy\n", url.toString().toLocal8Bit().constData());
+        meta.setValue("Checked", QDateTime::currentSecsSinceEpoch());
+        Finish(url, path, QString());
+    } else if(status == 416 && !download.retried) {
+        // our part is somehow past the end of the file, so start over
+        download.retried = true;
+        download.part->remove();
+        meta.remove("PartTag");
+        Start(url);
+    } else if(reply->error() != QNetworkReply::NoError || (status != 200 && status != 206)) {
+        // the part is left behind to resume from next time
+        if(QFile::exists(path)) {
+            printf("Couldn't check %s for updates (%s), using cached copy\n", url.toString().toLocal8Bit().constData(),
+                   reply->errorString().toLocal8Bit().constData());
+            Finish(url, path, QString());
+        } else Finish(url, QString(), reply->errorString());
+    } else {
+        QFile::remove(path);
+        if(!QFile::rename(download.part->fileName(), path)) {
+            Finish(url, QString(), "Couldn't move finished download into the cache.");
+            return;
+        }
+
+        meta.setValue("Url", url.toString());
+        meta.setValue("ETag", reply->rawHeader("ETag"));
+        meta.setValue("LastModified", reply->rawHeader("Last-Modified"));
+        meta.setValue("Checked", QDateTime::currentSecsSinceEpoch());
+        meta.remove("PartTag");
+        printf("Downloaded %s\n", url.toString().toLocal8Bit().constData());
+        Finish(url, path, QString());
+    }
+}
+
+void NeroDownloader::Finish(const QUrl &url, const QString &path, const QString &error)
+{
+    const Download download = downloads.take(url);
+    delete download.part;
+
+    for(const auto &waiter : download.waiters)
+        if(!waiter.context.isNull()) waiter.callback(path, error);
+}
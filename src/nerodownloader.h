@@ -0,0 +1,83 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Shared Download & Content Cache Service.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NERODOWNLOADER_H
+#define NERODOWNLOADER_H
+
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+
+#include <functional>
+
+class QFile;
+class QNetworkReply;
+
+// One downloader for the whole app, with everything it fetches kept in ~/.cache/nero-umu/downloads.
+// Downloads stream straight to a .part file on disk, pick up where they left off if interrupted (Range + If-Range),
+// and anything already cached is only revalidated (ETag/Last-Modified) once it's older than maxAge,
+// so installing the same payload into a bunch of prefixes downloads it once.
+// GUI thread only.
+class NeroDownloader : public QObject
+{
+    Q_OBJECT
+
+public:
+    // path is the cached file, or empty with error set if there's nothing usable.
+    typedef std::function<void(const QString &path, const QString &error)> Callback;
+
+    static NeroDownloader *Get();
+
+    // METHODS
+    // callback is skipped if context is gone by the time the download's done.
+    void Fetch(const QUrl &url, QObject *context, const Callback &callback, const int &maxAge = 3600);
+    static QString GetCachePath(const QUrl &url);
+
+signals:
+    void Progress(const QUrl &url, const qint64 &received, const qint64 &total);
+
+private:
+    explicit NeroDownloader(QObject *parent) : QObject(parent), manager(this) {}
+
+    struct Waiter {
+        QPointer<QObject> context;
+        Callback callback;
+    };
+    struct Download {
+        QNetworkReply *reply = nullptr;
+        QFile *part = nullptr;
+        qint64 resumeFrom = 0;
+        bool retried = false;
+        QList<Waiter> waiters;
+    };
+
+    void Start(const QUrl &url);
+    void OnMetaData(const QUrl &url);
+    void OnReadyRead(const QUrl &url);
+    void OnFinished(const QUrl &url);
+    void Finish(const QUrl &url, const QString &path, const QString &error);
+
+    QNetworkAccessManager manager;
+    QHash<QUrl, Download> downloads;
+};
+
+#endif // NERODOWNLOADER_H
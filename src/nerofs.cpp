@@ -18,15 +18,17 @@
 */
 
 #include "nerofs.h"
+#include "neroiconcache.h"
 #include "neroconstants.h"
+#include "neroprefixindex.h"
+#include "nerorunnerindex.h"
 
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QStandardPaths>
 #include <QProcess>
-
-// this needs to be re-generated each time the caller needs to reference current prefixCfg.
-QSettings *prefixCfg;
+#include <QDateTime>
+#include <QFileInfo>
 
 QDir NeroFS::prefixesPath;
 QDir NeroFS::protonsPath;
@@ -34,8 +36,12 @@ QString NeroFS::currentPrefix;
 QString NeroFS::currentRunner;
 QString NeroFS::currentUMU;
 QStringList NeroFS::currentPrefixOverrides;
-QStringList NeroFS::prefixes;
 QStringList NeroFS::availableProtons;
+QHash<QString, NeroPrefixCfg*> NeroFS::prefixCfgs;
+QMutex NeroFS::prefixCfgsMutex;
+QMutex NeroFS::threadCfgMutex;
+QHash<QString, QString> NeroFS::toolKeys;
+bool NeroFS::umuTrusted = false;
 QSettings NeroFS::managerCfg(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + "/Nero-UMU.ini", QSettings::IniFormat);
 
 bool NeroFS::InitPaths() {
@@ -75,22 +81,25 @@ bool NeroFS::InitPaths() {
         }
     }
 
+    // kick off the runners index here, so it (and its watcher) lives on the GUI thread.
+    NeroRunnerIndex::Get();
+
     return true;
 }
 
 QStringList NeroFS::GetPrefixes()
 {
-    if(prefixes.isEmpty()) {
-        prefixes = prefixesPath.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name | QDir::IgnoreCase);
-        for(int i = prefixes.count()-1; i >= 0; --i) {
-            // should we do ACTUAL ini verification? Or just checking to make sure it exists?
-            if(!prefixesPath.exists(prefixes.at(i) + "/nero-settings.ini")) {
-                prefixes.removeAt(i);
-            }
-        }
-    }
+    // served from the prefix index, so this doesn't have to stat the home dir every time
+    return NeroPrefixIndex::Get()->GetNames();
+}
 
-    return prefixes;
+void NeroFS::UpdatePrefixIndex()
+{
+    NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+    if(prefixCfg != nullptr)
+        NeroPrefixIndex::Get()->Update(currentPrefix,
+                                       prefixCfg->GetString("PrefixSettings", "CurrentRunner"),
+                                       prefixCfg->ChildKeys("Shortcuts").count());
 }
 
 void NeroFS::CreateUserLinks(const QString &prefixName)
@@ -164,23 +173,52 @@ void NeroFS::CreateUserLinks(const QString &prefixName)
 
 QStringList* NeroFS::GetAvailableProtons()
 {
-    if(availableProtons.isEmpty())
-        availableProtons << protonsPath.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
-
+    // the index keeps itself up to date, so this is just a snapshot of it for the UI.
+    availableProtons = NeroRunnerIndex::Get()->GetNames();
     return &availableProtons;
 }
 
-QString NeroFS::GetIcoextract()
+QString NeroFS::GetRunnerPath(const QString &runner)
 {
-    return QStandardPaths::findExecutable("icoextract");
+    const QString path = NeroRunnerIndex::Get()->GetPath(runner);
+    // unknown runners still get a path, so callers checking for its existence behave like they used to.
+    return path.isEmpty() ? protonsPath.path() + '/' + runner : path;
 }
 
+bool NeroFS::RuntimeIsFresh()
+{
+    // umu keeps the runtime here - if it's gone, it needs to be fetched regardless
+    if(!QDir(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/umu").exists()) return false;
+
+    // own QSettings instead of managerCfg, since the GUI thread could be using that one right now.
+    QMutexLocker locker(&threadCfgMutex);
+    QSettings cfg(managerCfg.fileName(), QSettings::IniFormat);
+    cfg.beginGroup("NeroSettings");
+
+    // default of 6 hours; 0 means always check
+    const qint64 window = cfg.value("RuntimeFreshMinutes", 360).toLongLong() * 60 * 1000;
+    const qint64 lastVerified = cfg.value("RuntimeLastVerified", 0).toLongLong();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
 
-QString NeroFS::GetIcoutils()
+    return window > 0 && lastVerified > 0 && lastVerified <= now && now - lastVerified < window;
+}
+
+QVariant NeroFS::GetManagerValue(const QString &key, const QVariant &defaultValue)
 {
-    return QStandardPaths::findExecutable("icotool");
+    QMutexLocker locker(&threadCfgMutex);
+    QSettings cfg(managerCfg.fileName(), QSettings::IniFormat);
+    cfg.beginGroup("NeroSettings");
+    return cfg.value(key, defaultValue);
 }
 
+void NeroFS::SetRuntimeVerified()
+{
+    QMutexLocker locker(&threadCfgMutex);
+    QSettings cfg(managerCfg.fileName(), QSettings::IniFormat);
+    cfg.beginGroup("NeroSettings");
+    cfg.setValue("RuntimeLastVerified", QDateTime::currentMSecsSinceEpoch());
+    cfg.sync();
+}
 
 QString NeroFS::GetUmU()
 {
@@ -190,7 +228,7 @@ QString NeroFS::GetUmU()
         currentUMU = managerCfg.value("UMUpath").toString();
         if(!QFile::exists(currentUMU)) {
             // fallback to system path first
-            currentUMU = QStandardPaths::findExecutable("umu-run");
+            currentUMU = FindTool("umu-run");
             if(currentUMU.isEmpty()) {
                 // UMU not installed, prompt user for custom path
                 QMessageBox umuPrompt(QMessageBox::Information,
@@ -221,9 +259,18 @@ QString NeroFS::GetUmU()
     } else return currentUMU;
 }
 
-bool NeroFS::SetUmU(const QString &umuPath)
+bool NeroFS::SetUmU(const QString &umuPath, const bool &force)
 {
     if(!umuPath.isEmpty()) {
+        // running umu -v can take a good while (it's a python zipapp), so don't if it's the same one as last time.
+        const QString key = GetFileKey(umuPath);
+        if(!force && !key.isEmpty() && managerCfg.value("UMUverifiedKey").toString() == key) {
+            printf("Using %s from %s\n", managerCfg.value("UMUversion").toString().toLocal8Bit().constData(), umuPath.toLocal8Bit().constData());
+            currentUMU = umuPath;
+            umuTrusted = true;
+            return true;
+        }
+
         QProcess umuTester;
         umuTester.setProcessEnvironment(QProcessEnvironment::systemEnvironment());
         umuTester.start(umuPath, {"-v"});
@@ -232,8 +279,12 @@ bool NeroFS::SetUmU(const QString &umuPath)
                 printf("ERROR: UMU test ended with exit code %d - not usable!", umuTester.exitCode());
                 return false;
             } else {
-                printf("Successfully initialized %s from %s\n", umuTester.readAllStandardOutput().trimmed().constData(), umuPath.toLocal8Bit().constData());
+                const QByteArray version = umuTester.readAllStandardOutput().trimmed();
+                printf("Successfully initialized %s from %s\n", version.constData(), umuPath.toLocal8Bit().constData());
                 currentUMU = umuPath;
+                umuTrusted = false;
+                managerCfg.setValue("UMUverifiedKey", key);
+                managerCfg.setValue("UMUversion", QString(version));
                 return true;
             }
         } else {
@@ -244,20 +295,81 @@ bool NeroFS::SetUmU(const QString &umuPath)
     } else return false;
 }
 
+bool NeroFS::UmuIsVerified()
+{
+    // same order GetUmU looks in
+    QString path = GetManagerValue("UMUpath").toString();
+    if(!QFile::exists(path)) path = FindTool("umu-run");
+
+    const QString key = GetFileKey(path);
+    return !key.isEmpty() && GetManagerValue("UMUverifiedKey").toString() == key;
+}
+
+void NeroFS::ForgetUmU()
+{
+    managerCfg.remove("UMUverifiedKey");
+    managerCfg.remove("UMUversion");
+    umuTrusted = false;
+}
+
+QString NeroFS::GetFileKey(const QString &path)
+{
+    const QFileInfo info(path);
+    if(!info.exists()) return QString();
+
+    // mtime/size are the symlink target's, so swapping that out still changes the key.
+    return QString("%1|%2|%3").arg(info.absoluteFilePath())
+                              .arg(info.lastModified().toMSecsSinceEpoch())
+                              .arg(info.size());
+}
+
+QString NeroFS::FindTool(const QString &name)
+{
+    QMutexLocker locker(&threadCfgMutex);
+
+    // keys start with the path, so it's all that's needed to check the tool's still the same.
+    auto isCurrent = [](const QString &key) {
+        return !key.isEmpty() && GetFileKey(key.section('|', 0, -3)) == key;
+    };
+
+    if(isCurrent(toolKeys.value(name)))
+        return toolKeys.value(name).section('|', 0, -3);
+
+    QSettings cfg(managerCfg.fileName(), QSettings::IniFormat);
+    cfg.beginGroup("NeroSettings");
+    cfg.beginGroup("ToolPaths");
+
+    // a different PATH might turn up a different tool, so everything found with the old one is out.
+    const QString searchPath = qEnvironmentVariable("PATH");
+    if(cfg.value("SearchPath").toString() != searchPath) {
+        cfg.remove("");
+        cfg.setValue("SearchPath", searchPath);
+    } else if(isCurrent(cfg.value(name).toString())) {
+        toolKeys.insert(name, cfg.value(name).toString());
+        return toolKeys.value(name).section('|', 0, -3);
+    }
+
+    const QString path = QStandardPaths::findExecutable(name);
+    if(path.isEmpty()) {
+        // not remembered, so installing it while Nero's open still gets picked up.
+        toolKeys.remove(name);
+        cfg.remove(name);
+        return path;
+    }
+
+    toolKeys.insert(name, GetFileKey(path));
+    cfg.setValue(name, toolKeys.value(name));
+    return path;
+}
+
 QString NeroFS::GetWinetricks(const QString &runner)
 {
-    if(!runner.isEmpty()) {
-        if(QDir(protonsPath.path() + '/' + runner + "/protonfixes").exists("winetricks"))
-            return protonsPath.path() + '/' + runner + "/protonfixes/winetricks";
-        else {
-            // fall back to system winetricks
-            return QStandardPaths::findExecutable("winetricks");
-        }
-    } else if(QDir(protonsPath.path() + '/' + currentRunner + "/protonfixes").exists("winetricks"))
-        return protonsPath.path() + '/' + currentRunner + "/protonfixes/winetricks";
+    const QString runnerPath = GetRunnerPath(runner.isEmpty() ? GetCurrentRunner() : runner);
+    if(QDir(runnerPath + "/protonfixes").exists("winetricks"))
+        return runnerPath + "/protonfixes/winetricks";
     else {
         // fall back to system winetricks
-        return QStandardPaths::findExecutable("winetricks");
+        return FindTool("winetricks");
     }
 }
 
@@ -265,42 +377,80 @@ void NeroFS::SetCurrentPrefix(const QString &prefix)
 {
     currentPrefix = prefix;
 
-    GetCurrentPrefixCfg();
-    prefixCfg->beginGroup("PrefixSettings");
-    currentRunner = prefixCfg->value("CurrentRunner").toString();
+    // runner is looked up as needed, so that selecting a prefix doesn't have to parse its ini
+    // (e.g. CLI shortcut launches that can be served entirely from a cached launch profile).
+    currentRunner.clear();
 }
 
-// TODO: yeah, this is kinda ugly ngl...
-QSettings* NeroFS::GetCurrentPrefixCfg()
+QString NeroFS::GetCurrentRunner()
 {
-    if(prefixCfg != nullptr) {
-        delete prefixCfg;
-        prefixCfg = nullptr;
+    if(currentRunner.isEmpty()) {
+        NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+        if(prefixCfg != nullptr)
+            currentRunner = prefixCfg->GetString("PrefixSettings", "CurrentRunner");
     }
 
+    return currentRunner;
+}
+
+NeroPrefixCfg* NeroFS::GetCurrentPrefixCfg()
+{
     if(!currentPrefix.isEmpty())
-        prefixCfg = new QSettings(prefixesPath.path() + '/' + currentPrefix + "/nero-settings.ini", QSettings::IniFormat);
+        return GetPrefixCfg(currentPrefix);
+    else return nullptr;
+}
+
+NeroPrefixCfg* NeroFS::GetPrefixCfg(const QString &prefix)
+{
+    QMutexLocker locker(&prefixCfgsMutex);
+
+    NeroPrefixCfg *prefixCfg = prefixCfgs.value(prefix, nullptr);
+    if(prefixCfg == nullptr) {
+        // the binary copy's on unless turned off in the manager's ini, e.g. to rule it out when something looks off.
+        prefixCfg = new NeroPrefixCfg(prefixesPath.path() + '/' + prefix + "/nero-settings.ini",
+                                      GetManagerValue("BinaryPrefixConfig", true).toBool());
+        prefixCfgs.insert(prefix, prefixCfg);
+    } else prefixCfg->ReloadIfChanged();
 
     return prefixCfg;
 }
 
-bool NeroFS::SetCurrentPrefixCfg(const QString &group, const QString &key, const QVariant &value)
+bool NeroFS::PrefixCfgIsDirty(const QString &prefix)
 {
-    if(GetCurrentPrefixCfg() != nullptr) {
-        prefixCfg->beginGroup(group);
+    QMutexLocker locker(&prefixCfgsMutex);
+
+    // a config that was never loaded can't have anything pending
+    NeroPrefixCfg *prefixCfg = prefixCfgs.value(prefix, nullptr);
+    return prefixCfg != nullptr && prefixCfg->IsDirty();
+}
+
+void NeroFS::SyncPrefixCfgs()
+{
+    QMutexLocker locker(&prefixCfgsMutex);
+
+    for(const auto &prefixCfg : std::as_const(prefixCfgs))
+        prefixCfg->Sync();
+}
 
+bool NeroFS::SetCurrentPrefixCfg(const QString &group, const QString &key, const QVariant &value)
+{
+    NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+    if(prefixCfg != nullptr) {
         // Only delete blank values if this is a shortcut
         if(group != "PrefixSettings") {
             if((value.type() != QMetaType::QStringList && value.toString().isEmpty()) ||
                (value.type() == QMetaType::QStringList && value.toStringList().isEmpty()))
-                prefixCfg->remove(key);
-            else prefixCfg->setValue(key, value);
+                prefixCfg->Remove(group, key);
+            else prefixCfg->SetValue(group, key, value);
         }
-        else prefixCfg->setValue(key, value);
+        else prefixCfg->SetValue(group, key, value);
 
         // sync current runner to config
         if(key == "CurrentRunner") currentRunner = value.toString();
 
+        // only things the prefixes list shows need to go back to the index
+        if(key == "CurrentRunner" || group == "Shortcuts") UpdatePrefixIndex();
+
         return true;
     } else {
         // no prefix is loaded, so no config to set.
@@ -310,82 +460,46 @@ bool NeroFS::SetCurrentPrefixCfg(const QString &group, const QString &key, const
 
 QMap<QString, QVariant> NeroFS::GetCurrentPrefixSettings()
 {
-    GetCurrentPrefixCfg();
-    prefixCfg->beginGroup("PrefixSettings");
-
-    const QStringList settings = prefixCfg->childKeys();
-    QMap<QString, QVariant> settingsMap;
-
-    for(const auto &key : std::as_const(settings))
-        settingsMap[key] = prefixCfg->value(key);
-
-    return settingsMap;
+    NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+    if(prefixCfg != nullptr)
+        return prefixCfg->GetGroup("PrefixSettings");
+    else return QMap<QString, QVariant>();
 }
 
 void NeroFS::AddNewPrefix(const QString &newPrefix, const QString &runner)
 {
-    prefixes.append(newPrefix);
+    NeroPrefixIndex::Get()->Add(newPrefix, runner);
     SetCurrentPrefix(newPrefix);
-    GetCurrentPrefixCfg();
-    prefixCfg->beginGroup("PrefixSettings");
-    prefixCfg->setValue("Name", newPrefix);
-    prefixCfg->setValue("CurrentRunner", runner);
-    prefixCfg->setValue("WindowsVersion", NeroConstant::WinVer10);
-    prefixCfg->setValue("Gamemode", false);
-    prefixCfg->setValue("VKcapture", false);
-    prefixCfg->setValue("Mangohud", false);
-    prefixCfg->setValue("EnableNVAPI", false);
-    prefixCfg->setValue("ScalingMode", NeroConstant::ScalingNormal);
-    prefixCfg->setValue("FSRcustomResW", "");
-    prefixCfg->setValue("FSRcustomResH", "");
-    prefixCfg->setValue("GamescopeOutResW", "");
-    prefixCfg->setValue("GamescopeOutResH", "");
-    prefixCfg->setValue("GamescopeWinResW", "");
-    prefixCfg->setValue("GamescopeWinResH", "");
-    prefixCfg->setValue("GamescopeScaler", NeroConstant::GSscalerAuto);
-    prefixCfg->setValue("GamescopeFilter", NeroConstant::GSfilterLinear);
+    NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+    prefixCfg->SetValue("PrefixSettings", NeroSetting::GetKey(NeroSetting::Name), newPrefix);
+    prefixCfg->SetValue("PrefixSettings", NeroSetting::GetKey(NeroSetting::CurrentRunner), runner);
+    // everything else prefixes can set gets written out with its default, so it's all there to hand edit.
     //prefixCfg->setValue("GamescopeFilterStrength", 0);
-    prefixCfg->setValue("DLLoverrides", {""});
-    prefixCfg->setValue("ForceiGPU", false);
-    prefixCfg->setValue("LimitGLextensions", false);
-    prefixCfg->setValue("DebugOutput", NeroConstant::DebugDisabled);
-    prefixCfg->setValue("FileSyncMode", NeroConstant::NTsync);
-    prefixCfg->setValue("NoD8VK", false);
-    prefixCfg->setValue("ForceWineD3D", false);
-    prefixCfg->setValue("UseWayland", false);
-    prefixCfg->setValue("UseHDR", false);
-    prefixCfg->setValue("AllowHidraw", false);
-    prefixCfg->setValue("UseXalia", false);
-    prefixCfg->setValue("CustomEnvVars", {""});
-    prefixCfg->setValue("RuntimeUpdateOnLaunch", true);
-    prefixCfg->setValue("DiscordRPCinstalled", false);
-    prefixCfg->endGroup();
+    for(const auto &def : NeroSetting::schema)
+        if(def.seed && (def.scope & NeroSetting::ScopePrefix))
+            prefixCfg->SetValue("PrefixSettings", def.key, NeroSetting::GetSeed(def.id));
+    // new prefix should be on disk right away, not whenever the event loop gets around to it.
+    prefixCfg->Sync();
     // since we aren't actually selecting this prefix, just clear the value.
     currentPrefix.clear();
 }
 
 void NeroFS::AddNewShortcut(const QString &newShortcutHash, const QString &newShortcutName, const QString &newAppPath) {
     SetCurrentPrefixCfg("Shortcuts", newShortcutHash, newShortcutName);
-    SetCurrentPrefixCfg(QString("Shortcuts--%1").arg(newShortcutHash), "Name", newShortcutName);
-    SetCurrentPrefixCfg(QString("Shortcuts--%1").arg(newShortcutHash), "Path", newAppPath);
-    SetCurrentPrefixCfg(QString("Shortcuts--%1").arg(newShortcutHash), "LimitFPS", 0);
+    SetCurrentPrefixCfg(QString("Shortcuts--%1").arg(newShortcutHash), NeroSetting::GetKey(NeroSetting::Name), newShortcutName);
+    SetCurrentPrefixCfg(QString("Shortcuts--%1").arg(newShortcutHash), NeroSetting::GetKey(NeroSetting::Path), newAppPath);
     //SetCurrentPrefixCfg(QString("Shortcuts--%1").arg(newShortcutHash), "GamescopeFilterStrength", 0);
-    SetCurrentPrefixCfg(QString("Shortcuts--%1").arg(newShortcutHash), "IgnoreGlobalDLLs", false);
+    // the rest fall back to the prefix's, except the few that only shortcuts have.
+    for(const auto &def : NeroSetting::schema)
+        if(def.seed && def.scope == NeroSetting::ScopeShortcut)
+            SetCurrentPrefixCfg(QString("Shortcuts--%1").arg(newShortcutHash), def.key, NeroSetting::GetSeed(def.id));
 }
 
 QMap<QString, QVariant> NeroFS::GetShortcutSettings(const QString &shortcutHash)
 {
-    if(GetCurrentPrefixCfg() != nullptr) {
-        if(!prefixCfg->group().isEmpty()) prefixCfg->endGroup();
-        prefixCfg->beginGroup("Shortcuts--" + shortcutHash);
-
-        const QStringList settingKeys = prefixCfg->childKeys();
-        QMap<QString, QVariant> settings;
-
-        for(const auto &key : std::as_const(settingKeys))
-            settings[key] = prefixCfg->value(key);
-
-        return settings;
+    NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+    if(prefixCfg != nullptr) {
+        return prefixCfg->GetGroup("Shortcuts--" + shortcutHash);
     } else {
         printf("THIS SHOULDN'T HAVE HAPPENED: GetCurrentPrefixCfg returned null in GetShortcutSettings which EXPECTS a real pointer!\n");
         return QMap<QString, QVariant>();
@@ -394,15 +508,13 @@ QMap<QString, QVariant> NeroFS::GetShortcutSettings(const QString &shortcutHash)
 
 QStringList NeroFS::GetCurrentPrefixShortcuts()
 {
-    if(GetCurrentPrefixCfg() != nullptr) {
-        if(!prefixCfg->group().isEmpty()) prefixCfg->endGroup();
-        prefixCfg->beginGroup("Shortcuts");
-
-        QStringList hashes = prefixCfg->childKeys();
+    NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+    if(prefixCfg != nullptr) {
+        const QMap<QString, QVariant> shortcuts = prefixCfg->GetGroup("Shortcuts");
         QStringList names;
 
-        for(const auto &hash : std::as_const(hashes))
-            names.append(prefixCfg->value(hash).toString());
+        for(const auto &name : shortcuts)
+            names.append(name.toString());
 
         return names;
     } else {
@@ -413,21 +525,15 @@ QStringList NeroFS::GetCurrentPrefixShortcuts()
 
 QMap<QString, QString> NeroFS::GetCurrentShortcutsMap()
 {
-    if(GetCurrentPrefixCfg() != nullptr) {
-        if(!prefixCfg->group().isEmpty()) prefixCfg->endGroup();
-        prefixCfg->beginGroup("Shortcuts");
-
-        QStringList hashes = prefixCfg->childKeys();
-        QStringList names;
-
-        for(const auto &hash : std::as_const(hashes))
-            names.append(prefixCfg->value(hash).toString());
+    NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+    if(prefixCfg != nullptr) {
+        const QMap<QString, QVariant> shortcuts = prefixCfg->GetGroup("Shortcuts");
 
         // QString Left = name, QString Right = hash
         QMap<QString, QString> shortcutsMap;
 
-        for(int i = 0; i < hashes.count(); ++i)
-            shortcutsMap[names.at(i)] = hashes.at(i);
+        for(auto i = shortcuts.constBegin(); i != shortcuts.constEnd(); ++i)
+            shortcutsMap[i.value().toString()] = i.key();
 
         return shortcutsMap;
     } else {
@@ -438,7 +544,17 @@ QMap<QString, QString> NeroFS::GetCurrentShortcutsMap()
 
 bool NeroFS::DeletePrefix(const QString &prefix)
 {
-    prefixes.removeOne(prefix);
+    NeroPrefixIndex::Get()->Remove(prefix);
+
+    prefixCfgsMutex.lock();
+    NeroPrefixCfg *prefixCfg = prefixCfgs.take(prefix);
+    prefixCfgsMutex.unlock();
+    if(prefixCfg != nullptr) {
+        // don't let pending writes recreate the ini we're about to delete.
+        prefixCfg->Discard();
+        prefixCfg->deleteLater();
+    }
+
     if(QDir(prefixesPath.path() + '/' + prefix).removeRecursively())
         return true;
     else return false;
@@ -446,18 +562,34 @@ bool NeroFS::DeletePrefix(const QString &prefix)
 
 void NeroFS::DeleteShortcut(const QString &shortcutHash)
 {
-    if(GetCurrentPrefixCfg() != nullptr) {
-        if(!prefixCfg->group().isEmpty()) prefixCfg->endGroup();
-        prefixCfg->beginGroup("Shortcuts");
-        QString name = prefixCfg->value(shortcutHash).toString();
-        prefixCfg->remove(shortcutHash);
-        prefixCfg->endGroup();
-        prefixCfg->beginGroup("Shortcuts--" + shortcutHash);
-        prefixCfg->remove("");
-        prefixCfg->endGroup();
-        QFile icoFile(prefixesPath.path() + '/' + currentPrefix + "/.icoCache/" + name + '-' + shortcutHash + ".png");
+    NeroPrefixCfg *prefixCfg = GetCurrentPrefixCfg();
+    if(prefixCfg != nullptr) {
+        const QString prefixPath = prefixesPath.path() + '/' + currentPrefix;
+        const QString name = prefixCfg->GetString("Shortcuts", shortcutHash);
+        const QString iconKey = prefixCfg->GetString("Shortcuts--" + shortcutHash, NeroSetting::IconKey);
+        prefixCfg->Remove("Shortcuts", shortcutHash);
+        prefixCfg->Remove("Shortcuts--" + shortcutHash);
+        UpdatePrefixIndex();
+
+        // icons are shared by content, so only drop it if nothing else is still using it.
+        if(!iconKey.isEmpty() && !IsIconKeyInUse(currentPrefix, iconKey))
+            NeroIconCache::Remove(prefixPath, iconKey);
+
+        QFile icoFile(NeroIconCache::GetLegacyPath(prefixPath, name, shortcutHash));
         if(icoFile.exists()) icoFile.remove();
     } else {
         printf("THIS SHOULDN'T HAVE HAPPENED: GetCurrentPrefixCfg returned null in DeleteShortcut which EXPECTS a real pointer!\n");
     }
 }
+
+bool NeroFS::IsIconKeyInUse(const QString &prefix, const QString &iconKey)
+{
+    NeroPrefixCfg *prefixCfg = GetPrefixCfg(prefix);
+    if(prefixCfg != nullptr) {
+        for(const auto &hash : prefixCfg->ChildKeys("Shortcuts"))
+            if(prefixCfg->GetString("Shortcuts--" + hash, NeroSetting::IconKey) == iconKey)
+                return true;
+    }
+
+    return false;
+}
@@ -20,8 +20,12 @@
 #ifndef NEROFS_H
 #define NEROFS_H
 
+#include "neroprefixcfg.h"
+
 #include <QDir>
 #include <QSettings>
+#include <QHash>
+#include <QMutex>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QStandardPaths>
@@ -37,8 +41,13 @@ private:
     static QString currentUMU;
     static QSettings managerCfg;
     static QStringList currentPrefixOverrides;
-    static QStringList prefixes;
     static QStringList availableProtons;
+    static QHash<QString, NeroPrefixCfg*> prefixCfgs;
+    static QMutex prefixCfgsMutex;
+    // for manager config reads/writes from outside the GUI thread
+    static QMutex threadCfgMutex;
+    static QHash<QString, QString> toolKeys;
+    static bool umuTrusted;
 
 public:
     NeroFS();
@@ -49,10 +58,15 @@ public:
     static QDir* GetPrefixesPath() { return &prefixesPath; }
     static QDir* GetProtonsPath() { return &protonsPath; }
     static QString GetCurrentPrefix() { return currentPrefix; }
-    static QString GetCurrentRunner() { return currentRunner; }
+    static QString GetCurrentRunner();
     static QStringList GetCurrentOverrides() { return currentPrefixOverrides; }
+    // GUI thread only; runner threads should ask NeroRunnerIndex directly.
     static QStringList* GetAvailableProtons();
+    // full path to a runner from any of the index's roots - thread-safe.
+    static QString GetRunnerPath(const QString &);
     static QStringList GetPrefixes();
+    // pushes the current prefix's runner & shortcuts count to the prefix index.
+    static void UpdatePrefixIndex();
     static QStringList GetCurrentPrefixShortcuts();
     static QMap<QString, QVariant> GetCurrentPrefixSettings();
     static QMap<QString, QString> GetCurrentShortcutsMap();
@@ -63,14 +77,34 @@ public:
     static void AddNewShortcut(const QString &, const QString &, const QString &);
     static bool DeletePrefix(const QString &);
     static void DeleteShortcut(const QString &);
+    static bool IsIconKeyInUse(const QString &, const QString &);
 
-    static QSettings* GetCurrentPrefixCfg();
+    static NeroPrefixCfg* GetCurrentPrefixCfg();
+    static NeroPrefixCfg* GetPrefixCfg(const QString &);
+    static bool PrefixCfgIsDirty(const QString &);
+    static void SyncPrefixCfgs();
 
-    static QString GetIcoextract();
-    static QString GetIcoutils();
     static QString GetUmU();
     static QString GetWinetricks(const QString & = "");
-    static bool SetUmU(const QString & = "");
+    // umu that was already confirmed working (and hasn't changed since) is trusted without running it again,
+    // unless forced; the manager still double checks it in the background once it's up.
+    static bool SetUmU(const QString & = "", const bool &force = false);
+    static bool UmuWasTrusted() { return umuTrusted; }
+    // whether GetUmU would find a umu that's already been verified, i.e. won't need to ask the user anything.
+    // safe to call before there's an app.
+    static bool UmuIsVerified();
+    static void ForgetUmU();
+    // "path|mtime|size", so cached results about a file can tell when it's been replaced.
+    static QString GetFileKey(const QString &);
+    // PATH lookup that's remembered (in the manager config too) until PATH or the tool itself changes.
+    // safe to call from any thread.
+    static QString FindTool(const QString &);
+    // whether umu's Steam Runtime was confirmed up-to-date within RuntimeFreshMinutes.
+    // these two are safe to call from runner threads.
+    static bool RuntimeIsFresh();
+    static void SetRuntimeVerified();
+    // thread-safe read of a NeroSettings value.
+    static QVariant GetManagerValue(const QString &, const QVariant & = QVariant());
 
     static void SetCurrentPrefix(const QString &);
     static bool SetCurrentPrefixCfg(const QString &, const QString &, const QVariant &);
@@ -17,285 +17,390 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
-/*  !! This app relies on the following external components: !!
-
-    `icoextract`, MIT License, (C) 2015-2016 Fadhil Mandaga / (C) 2019 James Lu
-
-    `icotool` as part of `icoutils`, GPLv3, (C) 1998 Oskar Liljeblad
-
-    As this Free Software relies on existing binaries present on the user's system,
-    any licenses attached to this file do not apply to these components,
-    and are governed by their respective owners.
+/*  Icons are pulled straight out of the executable's resource section (RT_GROUP_ICON -> RT_ICON),
+    or out of .ico containers, without needing any external tools.
+    Files are memory-mapped, so only the headers and the resource pages actually get read from disk.
 */
 
 #include "neroico.h"
-#include "nerofs.h"
 
-#include <QDir>
+#include <QCoreApplication>
+#include <QFile>
+#include <QPointer>
 #include <QString>
-#include <QProcess>
+#include <QThread>
+#include <QVector>
+#include <QtEndian>
+
+#include <cstring>
+
+// Windows resource type IDs
+#define NERO_RT_ICON 3
+#define NERO_RT_GROUP_ICON 14
+
+static inline quint16 ReadU16(const uchar *data) { return qFromLittleEndian<quint16>(data); }
+static inline quint32 ReadU32(const uchar *data) { return qFromLittleEndian<quint32>(data); }
+
+QImage NeroIcoExtractor::GetIconImage(const QString &sourceFile)
+{
+    if(sourceFile.endsWith(".png", Qt::CaseInsensitive))
+        return QImage(sourceFile);
+
+    const bool isIco = sourceFile.endsWith(".ico", Qt::CaseInsensitive);
+    if(!isIco && !sourceFile.endsWith(".exe", Qt::CaseInsensitive) && !sourceFile.endsWith(".dll", Qt::CaseInsensitive))
+        return QImage();
+
+    QFile file(sourceFile);
+    if(!file.open(QIODevice::ReadOnly)) {
+        printf("Couldn't open %s for icon extraction, aborting...\n", sourceFile.toLocal8Bit().constData());
+        return QImage();
+    }
+
+    const qint64 fileSize = file.size();
+    uchar *data = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+    if(data == nullptr) {
+        printf("Couldn't map %s for icon extraction, aborting...\n", sourceFile.toLocal8Bit().constData());
+        return QImage();
+    }
+
+    const QImage icon = isIco ? ExtractFromICO(data, fileSize) : ExtractFromPE(data, fileSize);
+
+    file.unmap(data);
+    return icon;
+}
+
+QThreadPool *NeroIcoExtractor::GetPool()
+{
+    // leave at least half the machine alone for whatever's actually being launched
+    static QThreadPool *pool = [] {
+        QThreadPool *newPool = new QThreadPool(QCoreApplication::instance());
+        newPool->setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
+        return newPool;
+    }();
+
+    return pool;
+}
 
-QString NeroIcoExtractor::GetIcon(QString sourceFile)
+void NeroIcoExtractor::GetIconImageAsync(const QString &sourceFile, QObject *context, const std::function<void(const QImage &)> &callback)
 {
-    if(sourceFile.endsWith(".exe", Qt::CaseInsensitive)) {
-        if(!NeroFS::GetIcoextract().isEmpty() && !NeroFS::GetIcoutils().isEmpty()) {
-            QDir tmpDir(QDir::temp());
-            // test if this is writable
-            tmpDir.mkdir("nero-manager");
-            if(tmpDir.cd("nero-manager")) {
-                // clean tmp directory
-                for(const auto &file : tmpDir.entryList())
-                    tmpDir.remove(file);
-
-                QProcess extProcess;
-                extProcess.setWorkingDirectory(tmpDir.path());
-
-                // extract .ico
-                extProcess.start(NeroFS::GetIcoextract(), { sourceFile,
-                                                            QString("%1.ico").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".exe")) });
-                extProcess.waitForFinished();
-
-                if(extProcess.exitCode() == 0) {
-                    // list the ico file's contents to find the largest one.
-                    extProcess.start(NeroFS::GetIcoutils(), { "-l",
-                                                              "--icon",
-                                                              QString("%1.ico").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".exe")) });
-
-                    extProcess.waitForFinished();
-
-                    // prepping for icon index values storage
-                    QString stdout;
-                    int index;
-                    int size;
-                    int depth;
-                    QStringList icotoolOutput;
-                    QMap<int, int> icoScoreTable;
-
-                    while(extProcess.canReadLine()) {
-                        stdout = extProcess.readLine();
-
-                        if(stdout.startsWith("--icon")) {
-                            // leftref is removed post-Qt6, shut up :<
-                            index = stdout.remove("--icon --index=").left(stdout.indexOf(' ')).toInt();
-                            icotoolOutput = stdout.split(' ', Qt::SkipEmptyParts);
-
-                            // trim these lines to get acceptable values
-                            icotoolOutput[1].remove("--width=");
-                            icotoolOutput[3].remove("--bit-depth=");
-
-                            size = icotoolOutput.at(1).toInt();
-                            depth = icotoolOutput.at(3).toInt();
-
-                            // whichever's the highest key wins!
-                            icoScoreTable[size*depth] = index;
-                        }
-                    }
-
-                    // Some games, like Need for Speed Underground 2, don't seem to have an icon that's parseable by icotool
-                    // so exit if no scored indexes could be found
-                    if(icoScoreTable.size() == 0) {
-                        printf("No icons were parsed by icotool, aborting...\n");
-                        return "";
-                    }
-
-                    if(extProcess.exitCode() == 0) {
-                        // now we actually extract the file, using the highest scored icon
-                        extProcess.start(NeroFS::GetIcoutils(), { "-x",
-                                                                  QString("%1.ico").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".exe")),
-                                                                  "--icon",
-                                                                  "-i",
-                                                                  QString("%1").arg(icoScoreTable.last()),
-                                                                  "-o",
-                                                                  QString("%1.png").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".exe")) } );
-
-                        extProcess.waitForFinished();
-
-                        if(tmpDir.exists(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".exe") + ".png")) {
-                            return QString("%1/%2.png").arg(tmpDir.path(), sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".exe"));
-                        } else {
-                            printf("icotool failed to convert icon to png, aborting...\n");
-                            return "";
-                        }
-                    } else {
-                        printf("icotool couldn't list contents of icon file, aborting...\n");
-                        return "";
-                    }
-                } else {
-                    printf("icoextract couldn't extract an icon, likely because the requested file didn't have any. Aborting...\n");
-                    return "";
-                }
-            } else {
-                printf("Cannot create temp scratch directory, aborting...\n");
-                return "";
+    QPointer<QObject> receiver(context);
+
+    GetPool()->start([=]() {
+        const QImage icon = GetIconImage(sourceFile);
+
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [=]() {
+            if(!receiver.isNull()) callback(icon);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QImage NeroIcoExtractor::ExtractFromPE(const uchar *data, const qint64 &size)
+{
+    if(size < 0x40 || data[0] != 'M' || data[1] != 'Z') {
+        printf("Not a valid PE executable, aborting...\n");
+        return QImage();
+    }
+
+    const quint32 peOffset = ReadU32(data + 0x3C);
+    if((qint64)peOffset + 24 > size || memcmp(data + peOffset, "PE\0\0", 4) != 0) {
+        printf("Not a valid PE executable, aborting...\n");
+        return QImage();
+    }
+
+    // COFF header starts right after the signature
+    const quint16 sectionCount = ReadU16(data + peOffset + 6);
+    const quint16 optHeaderSize = ReadU16(data + peOffset + 20);
+    const qint64 optOffset = (qint64)peOffset + 24;
+    if(optHeaderSize < 2 || optOffset + optHeaderSize > size) {
+        printf("Not a valid PE executable, aborting...\n");
+        return QImage();
+    }
+
+    // the data directory moves depending on if this is a 32 or 64-bit image
+    qint64 dirCountOffset, dirOffset;
+    switch(ReadU16(data + optOffset)) {
+    case 0x10b: dirCountOffset = 92; dirOffset = 96; break;
+    case 0x20b: dirCountOffset = 108; dirOffset = 112; break;
+    default:
+        printf("Unknown PE optional header type, aborting...\n");
+        return QImage();
+    }
+
+    // resources are the third entry in the data directory
+    if(optHeaderSize < dirOffset + 3*8 || ReadU32(data + optOffset + dirCountOffset) < 3) {
+        printf("Executable has no resource directory, aborting...\n");
+        return QImage();
+    }
+
+    const quint32 rsrcRva = ReadU32(data + optOffset + dirOffset + 2*8);
+    const quint32 rsrcSize = ReadU32(data + optOffset + dirOffset + 2*8 + 4);
+    if(rsrcRva == 0 || rsrcSize == 0) {
+        printf("Executable has no resource directory, aborting...\n");
+        return QImage();
+    }
+
+    const qint64 sectionTable = optOffset + optHeaderSize;
+    if(sectionTable + (qint64)sectionCount*40 > size) {
+        printf("Executable section table is truncated, aborting...\n");
+        return QImage();
+    }
+
+    // translates a virtual address into where it actually lives in the file, or -1 if it's not backed by file data.
+    auto rvaToOffset = [&](const quint32 &rva, const quint32 &length) -> qint64 {
+        for(int i = 0; i < sectionCount; ++i) {
+            const uchar *section = data + sectionTable + i*40;
+            const quint32 virtualAddress = ReadU32(section + 12);
+            const quint32 rawSize = ReadU32(section + 16);
+            const quint32 rawOffset = ReadU32(section + 20);
+            const quint32 span = qMax(ReadU32(section + 8), rawSize);
+
+            if(rva >= virtualAddress && rva - virtualAddress < span) {
+                const quint32 delta = rva - virtualAddress;
+                const qint64 offset = (qint64)rawOffset + delta;
+                if((qint64)delta + length > rawSize || offset + length > size) return -1;
+                else return offset;
             }
-        } else {
-            printf("icoextract and/or icoutils not found, aborting...\n");
-            return "";
         }
-    } else if(sourceFile.endsWith(".dll", Qt::CaseInsensitive)) {
-        if(!NeroFS::GetIcoextract().isEmpty() && !NeroFS::GetIcoutils().isEmpty()) {
-            QDir tmpDir(QDir::temp());
-            // test if this is writable
-            tmpDir.mkdir("nero-manager");
-            if(tmpDir.cd("nero-manager")) {
-                // clean tmp directory
-                for(const auto &file : tmpDir.entryList())
-                    tmpDir.remove(file);
-
-                QProcess extProcess;
-                extProcess.setWorkingDirectory(tmpDir.path());
-
-                // extract .ico
-                extProcess.start(NeroFS::GetIcoextract(), { sourceFile,
-                                                           QString("%1.ico").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".dll")) });
-                extProcess.waitForFinished();
-
-                if(extProcess.exitCode() == 0) {
-                    // list the ico file's contents to find the largest one.
-                    extProcess.start(NeroFS::GetIcoutils(), { "-l",
-                                                             "--icon",
-                                                             QString("%1.ico").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".dll")) });
-
-                    extProcess.waitForFinished();
-
-                    // prepping for icon index values storage
-                    QString stdout;
-                    int index;
-                    int size;
-                    int depth;
-                    QStringList icotoolOutput;
-                    QMap<int, int> icoScoreTable;
-
-                    while(extProcess.canReadLine()) {
-                        stdout = extProcess.readLine();
-
-                        if(stdout.startsWith("--icon")) {
-                            // leftref is removed post-Qt6, shut up :<
-                            index = stdout.remove("--icon --index=").left(stdout.indexOf(' ')).toInt();
-                            icotoolOutput = stdout.split(' ', Qt::SkipEmptyParts);
-
-                            // trim these lines to get acceptable values
-                            icotoolOutput[1].remove("--width=");
-                            icotoolOutput[3].remove("--bit-depth=");
-
-                            size = icotoolOutput.at(1).toInt();
-                            depth = icotoolOutput.at(3).toInt();
-
-                            // whichever's the highest key wins!
-                            icoScoreTable[size*depth] = index;
-                        }
-                    }
-
-                    if(extProcess.exitCode() == 0) {
-                        // now we actually extract the file, using the highest scored icon
-                        extProcess.start(NeroFS::GetIcoutils(), { "-x",
-                                                                 QString("%1.ico").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".dll")),
-                                                                 "--icon",
-                                                                 "-i",
-                                                                 QString("%1").arg(icoScoreTable.last()),
-                                                                 "-o",
-                                                                 QString("%1.png").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".dll")) } );
-
-                        extProcess.waitForFinished();
-
-                        if(extProcess.exitCode() == 0) {
-                            return QString("%1/%2.png").arg(tmpDir.path(), sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".dll"));
-                        } else {
-                            printf("icotool failed to convert icon to png, aborting...\n");
-                            return "";
-                        }
-                    } else {
-                        printf("icotool couldn't list contents of icon file, aborting...\n");
-                        return "";
-                    }
-                } else {
-                    printf("icoextract couldn't extract an icon, likely because the requested file didn't have any. Aborting...\n");
-                    return "";
-                }
-            } else {
-                printf("Cannot create temp scratch directory, aborting...\n");
-                return "";
-            }
-        } else {
-            printf("icoextract and/or icoutils not found, aborting...\n");
-            return "";
+        return -1;
+    };
+
+    const qint64 rsrcOffset = rvaToOffset(rsrcRva, 16);
+    if(rsrcOffset < 0) {
+        printf("Executable resource directory is out of bounds, aborting...\n");
+        return QImage();
+    }
+
+    const uchar *rsrc = data + rsrcOffset;
+    const qint64 rsrcLength = qMin<qint64>(rsrcSize, size - rsrcOffset);
+
+    // walks one level of the resource tree - id < 0 just takes the first entry.
+    // returns the entry's OffsetToData, or 0 if nothing matched (nothing valid can point back at the root).
+    auto findEntry = [&](const quint32 &dirOffset, const int &id) -> quint32 {
+        if((qint64)dirOffset + 16 > rsrcLength) return 0;
+
+        const int count = ReadU16(rsrc + dirOffset + 12) + ReadU16(rsrc + dirOffset + 14);
+        for(int i = 0; i < count; ++i) {
+            const qint64 entry = (qint64)dirOffset + 16 + i*8;
+            if(entry + 8 > rsrcLength) return 0;
+
+            const quint32 name = ReadU32(rsrc + entry);
+            if(id < 0 || (!(name & 0x80000000) && name == (quint32)id))
+                return ReadU32(rsrc + entry + 4);
         }
-    } else if(sourceFile.endsWith(".ico", Qt::CaseInsensitive)) {
-        QDir tmpDir(QDir::temp());
-        // test if this is writable
-        tmpDir.mkdir("nero-manager");
-        if(tmpDir.cd("nero-manager")) {
-            // clean tmp directory
-            for(const auto &file : tmpDir.entryList())
-                tmpDir.remove(file);
-
-            QProcess extProcess;
-            extProcess.setWorkingDirectory(tmpDir.path());
-
-            // list the ico file's contents to find the largest one.
-            extProcess.start(NeroFS::GetIcoutils(), { "-l",
-                                                     "--icon",
-                                                     sourceFile });
-
-            extProcess.waitForFinished();
-
-            // prepping for icon index values storage
-            QString stdout;
-            int index;
-            int size;
-            int depth;
-            QStringList icotoolOutput;
-            QMap<int, int> icoScoreTable;
-
-            while(extProcess.canReadLine()) {
-                stdout = extProcess.readLine();
-
-                if(stdout.startsWith("--icon")) {
-                    // leftref is removed post-Qt6, shut up :<
-                    index = stdout.remove("--icon --index=").left(stdout.indexOf(' ')).toInt();
-                    icotoolOutput = stdout.split(' ', Qt::SkipEmptyParts);
-
-                    // trim these lines to get acceptable values
-                    icotoolOutput[1].remove("--width=");
-                    icotoolOutput[3].remove("--bit-depth=");
-
-                    size = icotoolOutput.at(1).toInt();
-                    depth = icotoolOutput.at(3).toInt();
-
-                    // whichever's the highest key wins!
-                    icoScoreTable[size*depth] = index;
-                }
+        return 0;
+    };
+
+    // type -> name -> (first) language -> data entry
+    auto findData = [&](const int &type, const int &name, quint32 &dataSize) -> const uchar* {
+        quint32 entry = findEntry(0, type);
+        if(!(entry & 0x80000000)) return nullptr;
+
+        entry = findEntry(entry & 0x7FFFFFFF, name);
+        if(!(entry & 0x80000000)) return nullptr;
+
+        entry = findEntry(entry & 0x7FFFFFFF, -1);
+        if(entry == 0 || (entry & 0x80000000) || (qint64)entry + 16 > rsrcLength) return nullptr;
+
+        dataSize = ReadU32(rsrc + entry + 4);
+        const qint64 dataOffset = rvaToOffset(ReadU32(rsrc + entry), dataSize);
+        if(dataOffset < 0) return nullptr;
+        else return data + dataOffset;
+    };
+
+    quint32 groupSize = 0;
+    const uchar *group = findData(NERO_RT_GROUP_ICON, -1, groupSize);
+    if(group == nullptr || groupSize < 6) {
+        printf("Couldn't find an icon group, likely because the requested file didn't have any. Aborting...\n");
+        return QImage();
+    }
+
+    // GRPICONDIR is the same as an ICONDIR, except each entry ends with the RT_ICON ID instead of a file offset.
+    QList<IconEntry> entries;
+    const int count = ReadU16(group + 4);
+    for(int i = 0; i < count; ++i) {
+        const quint32 entryOffset = 6 + i*14;
+        if(entryOffset + 14 > groupSize) break;
+
+        const uchar *entry = group + entryOffset;
+        IconEntry icon;
+        icon.width = entry[0] == 0 ? 256 : entry[0];
+        icon.depth = ReadU16(entry + 6);
+        icon.size = 0;
+        icon.data = findData(NERO_RT_ICON, ReadU16(entry + 12), icon.size);
+
+        if(icon.data != nullptr && icon.size > 0) entries.append(icon);
+    }
+
+    return PickBestIcon(entries);
+}
+
+QImage NeroIcoExtractor::ExtractFromICO(const uchar *data, const qint64 &size)
+{
+    if(size < 6 || ReadU16(data) != 0 || ReadU16(data + 2) != 1) {
+        printf("Not a valid icon file, aborting...\n");
+        return QImage();
+    }
+
+    QList<IconEntry> entries;
+    const int count = ReadU16(data + 4);
+    for(int i = 0; i < count; ++i) {
+        const qint64 entryOffset = 6 + i*16;
+        if(entryOffset + 16 > size) break;
+
+        const uchar *entry = data + entryOffset;
+        const quint32 bytes = ReadU32(entry + 8);
+        const quint32 offset = ReadU32(entry + 12);
+        if(bytes == 0 || (qint64)offset + bytes > size) continue;
+
+        IconEntry icon;
+        icon.width = entry[0] == 0 ? 256 : entry[0];
+        icon.depth = ReadU16(entry + 6);
+        icon.data = data + offset;
+        icon.size = bytes;
+        entries.append(icon);
+    }
+
+    return PickBestIcon(entries);
+}
+
+QImage NeroIcoExtractor::PickBestIcon(const QList<IconEntry> &entries)
+{
+    QList<int> scores;
+    for(const auto &entry : entries) {
+        // a lot of icon directories leave the depth as 0, so just ask the image itself.
+        const int depth = entry.depth > 0 ? entry.depth : GetIconDataDepth(entry.data, entry.size);
+        scores.append(entry.width * depth);
+    }
+
+    // whichever's the highest score wins! (ties go to whichever came last)
+    // if the winner can't be decoded (e.g. some ancient 16-bit DIB), fall back to the next best one.
+    for(int tries = 0; tries < entries.count(); ++tries) {
+        int best = -1;
+        for(int i = 0; i < scores.count(); ++i)
+            if(scores.at(i) >= 0 && (best < 0 || scores.at(i) >= scores.at(best))) best = i;
+        if(best < 0) break;
+
+        const QImage icon = DecodeIconData(entries.at(best).data, entries.at(best).size);
+        if(!icon.isNull()) return icon;
+        else scores[best] = -1;
+    }
+
+    printf("No icons could be parsed, aborting...\n");
+    return QImage();
+}
+
+int NeroIcoExtractor::GetIconDataDepth(const uchar *data, const quint32 &size)
+{
+    if(size >= 26 && memcmp(data, "\x89PNG", 4) == 0) {
+        // IHDR is always the first chunk: bit depth per channel, then the color type
+        int channels;
+        switch(data[25]) {
+        case 2: channels = 3; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default: channels = 1; break;
+        }
+        return data[24] * channels;
+    } else if(size >= 40) {
+        return ReadU16(data + 14);
+    } else return 0;
+}
+
+QImage NeroIcoExtractor::DecodeIconData(const uchar *data, const quint32 &size)
+{
+    // Vista+ icons are usually just embedded PNGs
+    if(size >= 8 && memcmp(data, "\x89PNG\r\n\x1A\n", 8) == 0)
+        return QImage::fromData(data, static_cast<int>(size), "PNG");
+
+    // otherwise it's a headerless BMP, with its height doubled to cover the AND mask underneath.
+    if(size < 40) return QImage();
+
+    const quint32 headerSize = ReadU32(data);
+    const qint32 width = static_cast<qint32>(ReadU32(data + 4));
+    const qint32 fullHeight = static_cast<qint32>(ReadU32(data + 8));
+    const int bpp = ReadU16(data + 14);
+    const quint32 compression = ReadU32(data + 16);
+    quint32 colorsUsed = ReadU32(data + 32);
+    const int height = qAbs(fullHeight) / 2;
+
+    if(headerSize < 40 || headerSize > size || width <= 0 || width > 1024 || height <= 0 || height > 1024)
+        return QImage();
+    // only BI_RGB and BI_BITFIELDS show up in icons
+    if(compression != 0 && compression != 3)
+        return QImage();
+    if(bpp != 1 && bpp != 4 && bpp != 8 && bpp != 24 && bpp != 32)
+        return QImage();
+
+    quint32 offset = headerSize;
+    // bitfield masks trail a plain BITMAPINFOHEADER
+    if(compression == 3 && headerSize == 40) offset += 12;
+
+    QVector<QRgb> palette;
+    if(bpp <= 8) {
+        if(colorsUsed == 0 || colorsUsed > (1u << bpp)) colorsUsed = 1u << bpp;
+        if(offset + colorsUsed*4 > size) return QImage();
+
+        for(quint32 i = 0; i < colorsUsed; ++i) {
+            const uchar *color = data + offset + i*4;
+            palette.append(qRgb(color[2], color[1], color[0]));
+        }
+        offset += colorsUsed*4;
+    }
+
+    const quint32 colorStride = ((width * bpp + 31) / 32) * 4;
+    const quint32 maskStride = ((width + 31) / 32) * 4;
+    if(offset + colorStride*height > size) return QImage();
+
+    const uchar *colorBits = data + offset;
+    const uchar *maskBits = colorBits + colorStride*height;
+    // some icons skimp on the mask entirely, so don't go reading past the end for it.
+    const bool hasMask = offset + colorStride*height + maskStride*height <= size;
+
+    QImage icon(width, height, QImage::Format_ARGB32);
+    bool hasAlpha = false;
+
+    for(int y = 0; y < height; ++y) {
+        // DIBs are stored bottom-up, unless the height says otherwise
+        const int row = fullHeight > 0 ? height - 1 - y : y;
+        const uchar *src = colorBits + row*colorStride;
+        QRgb *dst = reinterpret_cast<QRgb*>(icon.scanLine(y));
+
+        for(int x = 0; x < width; ++x) {
+            switch(bpp) {
+            case 32:
+                dst[x] = qRgba(src[x*4+2], src[x*4+1], src[x*4], src[x*4+3]);
+                if(src[x*4+3] != 0) hasAlpha = true;
+                break;
+            case 24:
+                dst[x] = qRgb(src[x*3+2], src[x*3+1], src[x*3]);
+                break;
+            case 8:
+                dst[x] = palette.value(src[x]);
+                break;
+            case 4:
+                dst[x] = palette.value((src[x/2] >> (x % 2 ? 0 : 4)) & 0x0F);
+                break;
+            default:
+                dst[x] = palette.value((src[x/8] >> (7 - x % 8)) & 0x01);
+                break;
             }
+        }
+    }
 
-            if(extProcess.exitCode() == 0) {
-                // now we actually extract the file, using the highest scored icon
-                extProcess.start(NeroFS::GetIcoutils(), { "-x",
-                                                         sourceFile,
-                                                         "--icon",
-                                                         "-i",
-                                                         QString("%1").arg(icoScoreTable.last()),
-                                                         "-o",
-                                                         QString("%1.png").arg(sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".ico")) } );
-
-                extProcess.waitForFinished();
-
-                if(extProcess.exitCode() == 0) {
-                    return QString("%1/%2.png").arg(tmpDir.path(), sourceFile.mid(sourceFile.lastIndexOf('/')+1).remove(".ico"));
-                } else {
-                    printf("icotool failed to convert icon to png, aborting...\n");
-                    return "";
-                }
-            } else {
-                printf("icotool couldn't list contents of icon file, aborting...\n");
-                return "";
+    // anything without its own alpha channel (or a 32-bit icon that left it empty) relies on the AND mask
+    if(bpp != 32 || !hasAlpha) {
+        for(int y = 0; y < height; ++y) {
+            const int row = fullHeight > 0 ? height - 1 - y : y;
+            const uchar *mask = maskBits + row*maskStride;
+            QRgb *dst = reinterpret_cast<QRgb*>(icon.scanLine(y));
+
+            for(int x = 0; x < width; ++x) {
+                if(hasMask && (mask[x/8] >> (7 - x % 8)) & 0x01)
+                    dst[x] = qRgba(0, 0, 0, 0);
+                else dst[x] |= 0xFF000000;
             }
         }
-    } else if(sourceFile.endsWith(".png", Qt::CaseInsensitive)) {
-        // needs no conversion, so just use as-is
-        return sourceFile;
-    } else {
-        return "";
     }
 
-    return "";
+    return icon;
 }
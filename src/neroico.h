@@ -22,12 +22,36 @@
 
 #include <QString>
 #include <QDir>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QThreadPool>
+
+#include <functional>
 
 class NeroIcoExtractor
 {
 public:
-    static QString GetIcon(QString sourceFile);
+    static QImage GetIconImage(const QString &sourceFile);
+    // decodes on the icon pool, then hands the result to callback on the GUI thread - if context is still around by then.
+    static void GetIconImageAsync(const QString &sourceFile, QObject *context, const std::function<void(const QImage &)> &callback);
+    // shared by anything doing icon work in the background, capped so a big batch doesn't hog every core.
+    static QThreadPool *GetPool();
     static void CheckIcoCache(QDir cache) { if(!cache.exists(".icoCache")) { cache.mkdir(".icoCache"); } }
+
+private:
+    struct IconEntry {
+        int width;
+        int depth;
+        const uchar *data;
+        quint32 size;
+    };
+
+    static QImage ExtractFromPE(const uchar *, const qint64 &);
+    static QImage ExtractFromICO(const uchar *, const qint64 &);
+    static QImage PickBestIcon(const QList<IconEntry> &);
+    static QImage DecodeIconData(const uchar *, const quint32 &);
+    static int GetIconDataDepth(const uchar *, const quint32 &);
 };
 
 #endif // NEROICO_H
@@ -0,0 +1,276 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Packed Shortcut Icons Cache.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroiconcache.h"
+#include "neroico.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPixmap>
+#include <QSaveFile>
+#include <QThread>
+#include <QTimer>
+
+// bump the version whenever the stored sizes or layout change, so old packs get thrown out.
+#define NERO_ICON_PACK_MAGIC 0x4E49434F
+#define NERO_ICON_PACK_VERSION 1
+// long enough for a whole refresh's worth of icons to land in the same write
+#define NERO_ICON_PACK_FLUSH_MS 500
+
+const QList<int> NeroIconCache::sizes = { Small, Medium, Large };
+QHash<QString, NeroIconCache::IconPack> NeroIconCache::packs;
+QMutex NeroIconCache::packsMutex;
+QMutex NeroIconCache::flushMutex;
+
+NeroIconCache::IconPack &NeroIconCache::GetPack(const QString &prefixPath)
+{
+    const QFileInfo packInfo(prefixPath + "/.icoCache/icons.pack");
+    const qint64 modified = packInfo.exists() ? packInfo.lastModified().toMSecsSinceEpoch() : 0;
+    const qint64 size = packInfo.exists() ? packInfo.size() : -1;
+
+    IconPack &pack = packs[prefixPath];
+    if(pack.dirty || (pack.modified == modified && pack.size == size)) return pack;
+
+    // pack's new, or someone else (i.e. another Nero instance) wrote to it - reread the whole thing.
+    pack = IconPack();
+    pack.modified = modified;
+    pack.size = size;
+
+    QFile packFile(packInfo.filePath());
+    if(!packFile.open(QIODevice::ReadOnly)) return pack;
+
+    QDataStream in(&packFile);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0, version = 0;
+    QList<int> storedSizes;
+    in >> magic >> version;
+    if(magic != NERO_ICON_PACK_MAGIC || version != NERO_ICON_PACK_VERSION) return pack;
+
+    in >> storedSizes;
+    if(storedSizes != sizes) return pack;
+
+    in >> pack.icons;
+    if(in.status() != QDataStream::Ok) {
+        printf("Icon pack for %s is corrupted, ignoring...\n", prefixPath.toLocal8Bit().constData());
+        pack.icons.clear();
+    }
+
+    return pack;
+}
+
+bool NeroIconCache::ScheduleFlush(const QString &prefixPath, IconPack &pack)
+{
+    pack.dirty = true;
+    // no event loop to come back to (i.e. CLI runs), so the caller writes it as soon as it lets go of the lock.
+    if(QCoreApplication::instance() == nullptr) return false;
+    if(pack.flushScheduled) return true;
+    pack.flushScheduled = true;
+
+    // the timer has to live on the GUI thread, but the writing itself doesn't.
+    QMetaObject::invokeMethod(qApp, [prefixPath]() {
+        QTimer::singleShot(NERO_ICON_PACK_FLUSH_MS, qApp, [prefixPath]() {
+            NeroIcoExtractor::GetPool()->start([prefixPath]() { Flush(prefixPath); });
+        });
+    }, Qt::QueuedConnection);
+    return true;
+}
+
+bool NeroIconCache::Flush(const QString &prefixPath)
+{
+    // one at a time, or an older snapshot could get committed over a newer one.
+    QMutexLocker flushLocker(&flushMutex);
+
+    // serialized while holding the lock, but lookups don't have to wait on the disk.
+    QByteArray data;
+    {
+        QMutexLocker locker(&packsMutex);
+        IconPack &pack = packs[prefixPath];
+        if(!pack.dirty) {
+            pack.flushScheduled = false;
+            return true;
+        }
+        pack.dirty = false;
+
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_15);
+        out << (quint32)NERO_ICON_PACK_MAGIC << (quint32)NERO_ICON_PACK_VERSION << sizes << pack.icons;
+    }
+
+    QDir(prefixPath).mkpath(".icoCache");
+
+    QSaveFile packFile(prefixPath + "/.icoCache/icons.pack");
+    bool written = packFile.open(QIODevice::WriteOnly);
+    if(!written) printf("Couldn't open icon pack for %s for writing!\n", prefixPath.toLocal8Bit().constData());
+    else if(packFile.write(data) != data.size() || !packFile.commit()) {
+        printf("Couldn't write icon pack for %s!\n", prefixPath.toLocal8Bit().constData());
+        written = false;
+    }
+
+    QMutexLocker locker(&packsMutex);
+    IconPack &pack = packs[prefixPath];
+    pack.flushScheduled = false;
+    if(written) {
+        // we already have what we just wrote, so no need to read it back in.
+        const QFileInfo packInfo(prefixPath + "/.icoCache/icons.pack");
+        pack.modified = packInfo.lastModified().toMSecsSinceEpoch();
+        pack.size = packInfo.size();
+    } else pack.dirty = true;
+
+    // more came in while this was writing
+    if(written && pack.dirty) ScheduleFlush(prefixPath, pack);
+    return written;
+}
+
+void NeroIconCache::FlushAll()
+{
+    QStringList dirty;
+    {
+        QMutexLocker locker(&packsMutex);
+        for(auto it = packs.cbegin(); it != packs.cend(); ++it)
+            if(it.value().dirty) dirty.append(it.key());
+    }
+
+    for(const auto &prefixPath : std::as_const(dirty))
+        Flush(prefixPath);
+}
+
+QString NeroIconCache::Store(const QString &prefixPath, const QImage &icon)
+{
+    if(icon.isNull()) return "";
+
+    const QImage source = icon.convertToFormat(QImage::Format_ARGB32);
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(source.width()) + 'x' + QByteArray::number(source.height()));
+    hash.addData(reinterpret_cast<const char*>(source.constBits()), static_cast<int>(source.sizeInBytes()));
+    const QString key = hash.result().toHex();
+
+    // do the actual scaling/compressing before taking the lock, since that's the slow part.
+    QList<QByteArray> variants;
+    {
+        QMutexLocker locker(&packsMutex);
+        if(GetPack(prefixPath).icons.contains(key)) return key;
+    }
+
+    for(const int &size : sizes) {
+        QByteArray png;
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        source.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation).save(&buffer, "PNG");
+        variants.append(png);
+    }
+
+    bool scheduled;
+    {
+        QMutexLocker locker(&packsMutex);
+        IconPack &pack = GetPack(prefixPath);
+        pack.icons[key] = variants;
+        scheduled = ScheduleFlush(prefixPath, pack);
+    }
+
+    if(scheduled || Flush(prefixPath)) return key;
+    else return "";
+}
+
+QString NeroIconCache::StoreFile(const QString &prefixPath, const QString &iconFile)
+{
+    if(iconFile.isEmpty()) return "";
+    else return Store(prefixPath, NeroIcoExtractor::GetIconImage(iconFile));
+}
+
+QString NeroIconCache::ImportLegacy(const QString &prefixPath, const QString &name, const QString &hash)
+{
+    const QString legacyPath = GetLegacyPath(prefixPath, name, hash);
+    if(QFile::exists(legacyPath)) return Store(prefixPath, QImage(legacyPath));
+    else return "";
+}
+
+bool NeroIconCache::Contains(const QString &prefixPath, const QString &key)
+{
+    if(key.isEmpty()) return false;
+
+    QMutexLocker locker(&packsMutex);
+    return GetPack(prefixPath).icons.contains(key);
+}
+
+QImage NeroIconCache::GetImage(const QString &prefixPath, const QString &key, const int &size)
+{
+    if(key.isEmpty()) return QImage();
+
+    QByteArray png;
+    {
+        QMutexLocker locker(&packsMutex);
+        const QList<QByteArray> variants = GetPack(prefixPath).icons.value(key);
+        // take the closest stored size that's at least as big as what was asked for
+        for(int i = 0; i < sizes.count() && i < variants.count(); ++i) {
+            png = variants.at(i);
+            if(sizes.at(i) >= size) break;
+        }
+    }
+
+    // decoding doesn't need the lock
+    return QImage::fromData(png, "PNG");
+}
+
+QList<QImage> NeroIconCache::GetImages(const QString &prefixPath, const QString &key)
+{
+    if(key.isEmpty()) return {};
+
+    QList<QByteArray> variants;
+    {
+        QMutexLocker locker(&packsMutex);
+        variants = GetPack(prefixPath).icons.value(key);
+    }
+
+    QList<QImage> images;
+    for(const auto &png : std::as_const(variants)) {
+        const QImage image = QImage::fromData(png, "PNG");
+        if(!image.isNull()) images.append(image);
+    }
+    return images;
+}
+
+void NeroIconCache::Remove(const QString &prefixPath, const QString &key)
+{
+    if(key.isEmpty()) return;
+
+    bool scheduled = true;
+    {
+        QMutexLocker locker(&packsMutex);
+        IconPack &pack = GetPack(prefixPath);
+        if(pack.icons.remove(key)) scheduled = ScheduleFlush(prefixPath, pack);
+    }
+
+    if(!scheduled) Flush(prefixPath);
+}
+
+QIcon NeroIconCache::ToIcon(const QList<QImage> &images)
+{
+    QIcon icon;
+    for(const auto &image : images)
+        icon.addPixmap(QPixmap::fromImage(image));
+    return icon;
+}
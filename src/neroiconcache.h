@@ -0,0 +1,91 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Packed Shortcut Icons Cache.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROICONCACHE_H
+#define NEROICONCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+
+// One pack file per prefix (.icoCache/icons.pack), holding pre-scaled PNGs for every size the UI shows.
+// Entries are keyed by a hash of the icon's contents rather than the shortcut's name,
+// so renaming a shortcut doesn't orphan anything, and shortcuts to the same program share one entry.
+// Changes are written out in batches a little while after they're made (or right away without an event loop),
+// so refreshing a whole prefix's icons is one write rather than one per icon.
+// Everything besides ToIcon/GetIcon is safe to call from worker threads.
+class NeroIconCache
+{
+public:
+    enum IconSize {
+        Small = 24,     // shortcuts list
+        Medium = 48,    // shortcut wizard
+        Large = 64      // runner dialog & shortcut settings
+    };
+
+    // METHODS
+    static QString Store(const QString &prefixPath, const QImage &);
+    // same as above, but for anything NeroIcoExtractor can read (png/ico/exe/dll).
+    static QString StoreFile(const QString &prefixPath, const QString &);
+    // imports a pre-pack "<name>-<hash>.png" icon if there is one. The old file is left for the caller to clean up.
+    static QString ImportLegacy(const QString &prefixPath, const QString &name, const QString &hash);
+    static QString GetLegacyPath(const QString &prefixPath, const QString &name, const QString &hash)
+        { return QString("%1/.icoCache/%2-%3.png").arg(prefixPath, name, hash); }
+
+    static bool Contains(const QString &prefixPath, const QString &key);
+    static QImage GetImage(const QString &prefixPath, const QString &key, const int &size);
+    // every stored size, smallest to largest - empty if not found.
+    static QList<QImage> GetImages(const QString &prefixPath, const QString &key);
+    static void Remove(const QString &prefixPath, const QString &key);
+    // writes out anything that hasn't been yet - for on the way out, since the scheduled writes won't happen after that.
+    static void FlushAll();
+
+    // these create pixmaps, so GUI thread only!
+    static QIcon ToIcon(const QList<QImage> &);
+    static QIcon GetIcon(const QString &prefixPath, const QString &key) { return ToIcon(GetImages(prefixPath, key)); }
+
+private:
+    struct IconPack {
+        qint64 modified = 0;
+        qint64 size = -1;
+        QMap<QString, QList<QByteArray>> icons;
+        // has changes that aren't on disk yet, so it's not reread even if the file changed underneath it
+        bool dirty = false;
+        bool flushScheduled = false;
+    };
+
+    // these expect the caller to already be holding packsMutex
+    static IconPack &GetPack(const QString &prefixPath);
+    // false if it couldn't be, and needs flushing once the lock's let go of
+    static bool ScheduleFlush(const QString &prefixPath, IconPack &);
+
+    // takes the lock itself, but not while writing
+    static bool Flush(const QString &prefixPath);
+
+    static const QList<int> sizes;
+    static QHash<QString, IconPack> packs;
+    static QMutex packsMutex;
+    static QMutex flushMutex;
+};
+
+#endif // NEROICONCACHE_H
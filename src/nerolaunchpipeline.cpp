@@ -0,0 +1,145 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Launch Stage Pipeline.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerolaunchpipeline.h"
+
+#include <QEventLoop>
+#include <QThreadPool>
+
+void NeroLaunchPipeline::Add(const QString &name, const QStringList &after, const Where &where, const std::function<void()> &work)
+{
+    Stage stage;
+    stage.name = name;
+    stage.after = after;
+    stage.where = where;
+    stage.work = work;
+    stages.append(stage);
+    remaining++;
+}
+
+void NeroLaunchPipeline::Run()
+{
+    if(running) return;
+    running = true;
+    clock.start();
+
+    // anything depending on a stage that was never added would wait forever, so don't let it.
+    for(auto &stage : stages) {
+        QStringList after;
+        for(const auto &name : std::as_const(stage.after)) {
+            bool exists = false;
+            for(const auto &other : std::as_const(stages))
+                if(other.name == name) exists = true;
+            if(exists) after << name;
+            else printf("Launch stage %s is after unknown stage %s, ignoring that\n",
+                        stage.name.toLocal8Bit().constData(), name.toLocal8Bit().constData());
+        }
+        stage.after = after;
+    }
+
+    StartReady();
+    if(remaining == 0) emit Finished();
+}
+
+void NeroLaunchPipeline::Complete(const QString &name)
+{
+    for(int i = 0; i < stages.count(); ++i)
+        if(stages.at(i).name == name && stages.at(i).where == External && !stages.at(i).done)
+            return StageDone(i);
+}
+
+void NeroLaunchPipeline::Wait()
+{
+    if(IsFinished()) return;
+
+    QEventLoop loop;
+    connect(this, &NeroLaunchPipeline::Finished, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+qint64 NeroLaunchPipeline::GetDuration(const QString &name) const
+{
+    for(const auto &stage : stages)
+        if(stage.name == name) return stage.duration;
+    return -1;
+}
+
+bool NeroLaunchPipeline::IsReady(const Stage &stage) const
+{
+    for(const auto &name : stage.after)
+        for(const auto &other : stages)
+            if(other.name == name && !other.done) return false;
+    return true;
+}
+
+void NeroLaunchPipeline::StartReady()
+{
+    // Here stages finishing call back into this, so only the outermost call does the looping.
+    if(!running || starting) return;
+    starting = true;
+
+    bool progressed = true;
+    while(progressed) {
+        progressed = false;
+        for(int i = 0; i < stages.count(); ++i) {
+            Stage &stage = stages[i];
+            if(stage.started || stage.done || !IsReady(stage)) continue;
+
+            stage.started = true;
+            stage.startedAt = clock.elapsed();
+            progressed = true;
+
+            switch(stage.where) {
+            case Pool: {
+                const std::function<void()> work = stage.work;
+                QThreadPool::globalInstance()->start([this, i, work]() {
+                    if(work) work();
+                    QMetaObject::invokeMethod(this, [this, i]() { StageDone(i); }, Qt::QueuedConnection);
+                });
+                break;
+            }
+            case Here:
+                if(stage.work) stage.work();
+                StageDone(i);
+                break;
+            case External:
+                // already done if Complete() came in before Run()
+                break;
+            }
+        }
+    }
+
+    starting = false;
+}
+
+void NeroLaunchPipeline::StageDone(const int &index)
+{
+    Stage &stage = stages[index];
+    if(stage.done) return;
+
+    stage.done = true;
+    // External stages can well be done before anything started counting
+    stage.duration = stage.startedAt < 0 ? 0 : clock.elapsed() - stage.startedAt;
+    remaining--;
+
+    if(!running) return;
+    StartReady();
+    // only from the outermost call, so Finished doesn't fire in the middle of another stage.
+    if(remaining == 0 && !starting) emit Finished();
+}
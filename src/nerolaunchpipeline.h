@@ -0,0 +1,85 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Launch Stage Pipeline.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROLAUNCHPIPELINE_H
+#define NEROLAUNCHPIPELINE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+#include <functional>
+
+// The steps between resolving a launch and exec'ing umu, as a small dependency graph.
+// Each stage starts as soon as everything it's after is done: Pool stages go off to the global thread pool,
+// Here stages run on the pipeline's own thread (anything touching its QObjects has to be one of these),
+// and External stages are just waited on until Complete() is called for them (i.e. a script process finishing).
+// Everything's added before Run(), and the pipeline has to outlive Finished - pool stages still point back at it.
+class NeroLaunchPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Where {
+        Pool,
+        Here,
+        External
+    };
+
+    explicit NeroLaunchPipeline(QObject *parent = nullptr) : QObject(parent) {}
+
+    // METHODS
+    void Add(const QString &name, const QStringList &after, const Where &where, const std::function<void()> &work = {});
+    void Run();
+    // fine to call before Run(), for processes that fail to start right away.
+    void Complete(const QString &name);
+    // spins a local event loop until Finished, for the CLI's blocking launches.
+    void Wait();
+    bool IsFinished() const { return running && remaining == 0; }
+    // ms from the stage being started to it being done, or -1 if it hasn't been.
+    qint64 GetDuration(const QString &name) const;
+
+signals:
+    void Finished();
+
+private:
+    struct Stage {
+        QString name;
+        QStringList after;
+        Where where;
+        std::function<void()> work;
+        bool started = false;
+        bool done = false;
+        qint64 startedAt = -1;
+        qint64 duration = -1;
+    };
+
+    bool IsReady(const Stage &) const;
+    void StartReady();
+    void StageDone(const int &index);
+
+    QList<Stage> stages;
+    QElapsedTimer clock;
+    int remaining = 0;
+    bool running = false;
+    bool starting = false;
+};
+
+#endif // NEROLAUNCHPIPELINE_H
@@ -0,0 +1,386 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Manager Prefixes & Shortcuts List Models.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerolists.h"
+#include "neroprefixindex.h"
+
+#include <QAbstractItemView>
+#include <QApplication>
+#include <QDateTime>
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QStyleOptionButton>
+#include <QToolTip>
+
+static QPoint EventPos(const QMouseEvent *event)
+{
+    #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return event->position().toPoint();
+    #else
+    return event->pos();
+    #endif
+}
+
+/* Prefixes */
+
+QVariant NeroPrefixesModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= names.count()) return QVariant();
+
+    const QString &name = names.at(index.row());
+    switch(role) {
+    case Qt::DisplayRole:
+    case NeroListRole::Key:
+        return name;
+    case Qt::ToolTipRole: {
+        const NeroPrefixEntry entry = NeroPrefixIndex::Get()->Find(name);
+        return QString("Runner: %1\n%2 Apps\nLast played: %3")
+                .arg(entry.runner.isEmpty() ? "Unknown" : entry.runner)
+                .arg(entry.shortcuts)
+                .arg(entry.lastPlayed ? QDateTime::fromMSecsSinceEpoch(entry.lastPlayed).toString("yyyy-MM-dd hh:mm") : "Never");
+    }
+    case NeroListRole::RowButton:
+        return true;
+    case NeroListRole::SecondaryIcon: {
+        static const QIcon deleteIcon = QIcon::fromTheme("edit-delete");
+        return deleteIcon;
+    }
+    case NeroListRole::SecondaryTip:
+        return "Delete " + name;
+    default:
+        return QVariant();
+    }
+}
+
+void NeroPrefixesModel::Reload()
+{
+    const QStringList newNames = NeroPrefixIndex::Get()->GetNames();
+
+    if(newNames == names) {
+        // same prefixes, but runners/counts might've changed - tooltips are all that'd show it
+        if(!names.isEmpty()) emit dataChanged(index(0), index(names.count()-1), { Qt::ToolTipRole });
+        return;
+    }
+
+    beginResetModel();
+    names = newNames;
+    endResetModel();
+}
+
+/* Shortcuts */
+
+NeroShortcutsModel::NeroShortcutsModel(QObject *parent) : QAbstractListModel(parent)
+{
+    // every row shares these, rather than each one getting its own copy
+    placeholder = QIcon::fromTheme("application-x-executable");
+    playIcon = QIcon::fromTheme("media-playback-start");
+    stopIcon = QIcon::fromTheme("media-playback-stop");
+    editIcon = QIcon::fromTheme("document-properties");
+}
+
+QVariant NeroShortcutsModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= shortcuts.count()) return QVariant();
+
+    const Shortcut &shortcut = shortcuts.at(index.row());
+    switch(role) {
+    case Qt::DisplayRole:
+        return shortcut.name;
+    case Qt::DecorationRole:
+        return shortcut.icon.isNull() ? placeholder : shortcut.icon;
+    case NeroListRole::Key:
+        return shortcut.hash;
+    case NeroListRole::Running:
+        return shortcut.running;
+    case NeroListRole::PrimaryIcon:
+        return shortcut.running ? stopIcon : playIcon;
+    case NeroListRole::PrimaryTip:
+        return (shortcut.running ? "Stop " : "Start ") + shortcut.name;
+    case NeroListRole::SecondaryIcon:
+        return editIcon;
+    case NeroListRole::SecondaryTip:
+        return "Edit properties of " + shortcut.name;
+    default:
+        return QVariant();
+    }
+}
+
+void NeroShortcutsModel::SetShortcuts(const QList<Shortcut> &newShortcuts)
+{
+    beginResetModel();
+    shortcuts = newShortcuts;
+    endResetModel();
+}
+
+int NeroShortcutsModel::Add(const QString &hash, const QString &name)
+{
+    const int row = shortcuts.count();
+
+    Shortcut shortcut;
+    shortcut.hash = hash;
+    shortcut.name = name;
+
+    beginInsertRows(QModelIndex(), row, row);
+    shortcuts.append(shortcut);
+    endInsertRows();
+
+    return row;
+}
+
+void NeroShortcutsModel::Remove(const int &row)
+{
+    if(row < 0 || row >= shortcuts.count()) return;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    shortcuts.removeAt(row);
+    endRemoveRows();
+}
+
+void NeroShortcutsModel::Rename(const int &row, const QString &name)
+{
+    if(row < 0 || row >= shortcuts.count()) return;
+
+    shortcuts[row].name = name;
+    RowChanged(row);
+}
+
+void NeroShortcutsModel::SetIcon(const int &row, const QIcon &icon)
+{
+    if(row < 0 || row >= shortcuts.count()) return;
+
+    shortcuts[row].icon = icon;
+    RowChanged(row);
+}
+
+void NeroShortcutsModel::SetRunning(const int &row, const bool &running, const int &session)
+{
+    if(row < 0 || row >= shortcuts.count()) return;
+
+    shortcuts[row].running = running;
+    shortcuts[row].session = running ? session : -1;
+    RowChanged(row);
+}
+
+int NeroShortcutsModel::RowOf(const QString &hash) const
+{
+    for(int i = 0; i < shortcuts.count(); ++i)
+        if(shortcuts.at(i).hash == hash) return i;
+    return -1;
+}
+
+/* Delegate */
+
+NeroListDelegate::NeroListDelegate(QObject *parent, const QFont &font, const bool &showIcons)
+    : QStyledItemDelegate(parent), font(font), showIcons(showIcons)
+{
+}
+
+QSize NeroListDelegate::ButtonSize(const QStyleOptionViewItem &option) const
+{
+    const QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+
+    QStyleOptionButton button;
+    button.iconSize = QSize(16, 16);
+    return style->sizeFromContents(QStyle::CT_PushButton, &button, button.iconSize, option.widget);
+}
+
+QSize NeroListDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+    const QFontMetrics metrics(font);
+
+    int height = qMax(ButtonSize(option).height(), metrics.height()) + 4;
+    if(showIcons) height = qMax(height, 24 + 8);
+    if(index.data(NeroListRole::RowButton).toBool()) {
+        QStyleOptionButton button;
+        button.text = "Nero";
+        button.fontMetrics = metrics;
+        height = qMax(height, style->sizeFromContents(QStyle::CT_PushButton, &button, QSize(metrics.height(), metrics.height()), option.widget).height() + 4);
+    }
+
+    // the view stretches rows to fit anyways, width doesn't matter here
+    return QSize(1, height);
+}
+
+QRect NeroListDelegate::PartRect(const QStyleOptionViewItem &option, const QModelIndex &index, const int &part) const
+{
+    const int spacing = 6;
+    const QSize button = ButtonSize(option);
+    const int top = option.rect.top() + (option.rect.height() - button.height()) / 2;
+
+    // buttons are laid out from the right edge inwards, and the row gets whatever's left
+    int right = option.rect.right() - spacing;
+    QRect secondary, primary;
+    if(!index.data(NeroListRole::SecondaryIcon).value<QIcon>().isNull()) {
+        secondary = QRect(right - button.width() + 1, top, button.width(), button.height());
+        right = secondary.left() - spacing;
+    }
+    if(!index.data(NeroListRole::PrimaryIcon).value<QIcon>().isNull()) {
+        primary = QRect(right - button.width() + 1, top, button.width(), button.height());
+        right = primary.left() - spacing;
+    }
+
+    switch(part) {
+    case PartPrimary: return primary;
+    case PartSecondary: return secondary;
+    case PartRow: return QRect(option.rect.left() + spacing, option.rect.top() + 2,
+                               right - option.rect.left() - spacing + 1, option.rect.height() - 4);
+    default: return QRect();
+    }
+}
+
+int NeroListDelegate::PartAt(const QStyleOptionViewItem &option, const QModelIndex &index, const QPoint &pos) const
+{
+    if(PartRect(option, index, PartPrimary).contains(pos)) return PartPrimary;
+    else if(PartRect(option, index, PartSecondary).contains(pos)) return PartSecondary;
+    else if(PartRect(option, index, PartRow).contains(pos)) return PartRow;
+    else return PartNone;
+}
+
+void NeroListDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+    const bool enabled = option.state & QStyle::State_Enabled;
+    const bool rowHovered = option.state & QStyle::State_MouseOver;
+
+    auto buttonState = [&](const int &part) {
+        QStyle::State state = enabled ? QStyle::State_Enabled : QStyle::State_None;
+        if(rowHovered && hoverIndex == index && hoverPart == part) state |= QStyle::State_MouseOver;
+        if(pressedIndex == index && pressedPart == part) state |= QStyle::State_Sunken;
+        else state |= QStyle::State_Raised;
+        if(part == PartRow && (option.state & QStyle::State_HasFocus)) state |= QStyle::State_HasFocus;
+        return state;
+    };
+
+    painter->save();
+    painter->setFont(font);
+
+    const QRect rowRect = PartRect(option, index, PartRow);
+    const QString name = index.data(Qt::DisplayRole).toString();
+
+    if(index.data(NeroListRole::RowButton).toBool()) {
+        QStyleOptionButton button;
+        button.rect = rowRect;
+        button.text = name;
+        button.fontMetrics = QFontMetrics(font);
+        button.palette = option.palette;
+        button.direction = option.direction;
+        button.state = buttonState(PartRow);
+        style->drawControl(QStyle::CE_PushButton, &button, painter, option.widget);
+    } else {
+        // hover/selection background, so keyboard navigation can be seen
+        style->drawPrimitive(QStyle::PE_PanelItemViewItem, &option, painter, option.widget);
+
+        int textLeft = rowRect.left();
+        if(showIcons) {
+            const QIcon icon = index.data(Qt::DecorationRole).value<QIcon>();
+            const QRect iconRect(rowRect.left(), rowRect.top() + (rowRect.height() - 24) / 2, 24, 24);
+            // real talk: Silent Hill The Arcade can suck it. 16x16 in 2007, seriously???
+            const QSize actual = icon.actualSize(QSize(24, 24));
+            const QPixmap pixmap = actual.height() < 24 ? icon.pixmap(actual).scaled(24, 24, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                                                        : icon.pixmap(24, 24);
+            painter->drawPixmap(iconRect, pixmap);
+            textLeft = iconRect.right() + 1 + 8;
+        }
+
+        const QRect textRect(textLeft, rowRect.top(), rowRect.right() - textLeft + 1, rowRect.height());
+        painter->setPen(option.palette.color(enabled ? QPalette::Normal : QPalette::Disabled,
+                                             (option.state & QStyle::State_Selected) ? QPalette::HighlightedText : QPalette::WindowText));
+        painter->drawText(textRect, Qt::AlignVCenter | Qt::AlignLeft, QFontMetrics(font).elidedText(name, Qt::ElideRight, textRect.width()));
+    }
+
+    for(const int part : { (int)PartPrimary, (int)PartSecondary }) {
+        const QIcon icon = index.data(part == PartPrimary ? NeroListRole::PrimaryIcon : NeroListRole::SecondaryIcon).value<QIcon>();
+        if(icon.isNull()) continue;
+
+        QStyleOptionButton button;
+        button.rect = PartRect(option, index, part);
+        button.icon = icon;
+        button.iconSize = QSize(16, 16);
+        button.palette = option.palette;
+        button.direction = option.direction;
+        button.state = buttonState(part);
+        // edit/delete buttons were always flat, play wasn't
+        if(part == PartSecondary) button.features |= QStyleOptionButton::Flat;
+        style->drawControl(QStyle::CE_PushButton, &button, painter, option.widget);
+    }
+
+    painter->restore();
+}
+
+bool NeroListDelegate::editorEvent(QEvent *event, QAbstractItemModel *, const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+    auto repaint = [&option]() {
+        if(auto *view = qobject_cast<const QAbstractItemView*>(option.widget))
+            view->viewport()->update();
+    };
+
+    switch(event->type()) {
+    case QEvent::MouseMove: {
+        const int part = PartAt(option, index, EventPos(static_cast<QMouseEvent*>(event)));
+        if(hoverIndex != index || hoverPart != part) {
+            hoverIndex = index;
+            hoverPart = part;
+            repaint();
+        }
+        return false;
+    }
+    case QEvent::MouseButtonPress:
+        if(static_cast<QMouseEvent*>(event)->button() != Qt::LeftButton) return false;
+        pressedIndex = index;
+        pressedPart = PartAt(option, index, EventPos(static_cast<QMouseEvent*>(event)));
+        repaint();
+        // let the view still move the selection over, so keyboard nav picks up from here
+        return false;
+    case QEvent::MouseButtonRelease: {
+        if(static_cast<QMouseEvent*>(event)->button() != Qt::LeftButton) return false;
+        const int part = PartAt(option, index, EventPos(static_cast<QMouseEvent*>(event)));
+        const bool clicked = pressedIndex == index && pressedPart == part && part != PartNone;
+        pressedIndex = QPersistentModelIndex();
+        pressedPart = PartNone;
+        repaint();
+        if(clicked) emit Clicked(index, part);
+        // eaten either way, so the view doesn't "activate" the row on top of this (i.e. single-click activation on KDE)
+        return true;
+    }
+    case QEvent::MouseButtonDblClick:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool NeroListDelegate::helpEvent(QHelpEvent *event, QAbstractItemView *view, const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+    if(event->type() != QEvent::ToolTip || !index.isValid())
+        return QStyledItemDelegate::helpEvent(event, view, option, index);
+
+    QString tip;
+    switch(PartAt(option, index, event->pos())) {
+    case PartPrimary: tip = index.data(NeroListRole::PrimaryTip).toString(); break;
+    case PartSecondary: tip = index.data(NeroListRole::SecondaryTip).toString(); break;
+    case PartRow: tip = index.data(Qt::ToolTipRole).toString(); break;
+    default: break;
+    }
+
+    if(tip.isEmpty()) QToolTip::hideText();
+    else QToolTip::showText(event->globalPos(), tip, view);
+    return true;
+}
@@ -0,0 +1,139 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Manager Prefixes & Shortcuts List Models.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROLISTS_H
+#define NEROLISTS_H
+
+#include <QAbstractListModel>
+#include <QFont>
+#include <QIcon>
+#include <QList>
+#include <QPersistentModelIndex>
+#include <QStyledItemDelegate>
+
+// Roles the delegate looks for - models only need to provide the ones that apply to them.
+namespace NeroListRole {
+    enum {
+        Key = Qt::UserRole + 1,     // prefix name or shortcut hash
+        RowButton,                  // draw the whole row as one big button (prefixes list)
+        PrimaryIcon,                // optional buttons at the end of the row
+        PrimaryTip,
+        SecondaryIcon,
+        SecondaryTip,
+        Running
+    };
+}
+
+class NeroPrefixesModel : public QAbstractListModel
+{
+public:
+    explicit NeroPrefixesModel(QObject *parent = nullptr) : QAbstractListModel(parent) {}
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override { return parent.isValid() ? 0 : names.count(); }
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // METHODS
+    // reads everything from the prefix index, never the home dir.
+    void Reload();
+    QString NameAt(const int &row) const { return names.value(row); }
+
+private:
+    QStringList names;
+};
+
+class NeroShortcutsModel : public QAbstractListModel
+{
+public:
+    struct Shortcut {
+        QString hash;
+        QString name;
+        QIcon icon;
+        bool running = false;
+        // id of its session, while running
+        int session = -1;
+    };
+
+    explicit NeroShortcutsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override { return parent.isValid() ? 0 : shortcuts.count(); }
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // METHODS
+    // rows are what the manager calls "slots", and stay put until the list is reset or one's removed.
+    void SetShortcuts(const QList<Shortcut> &);
+    void Clear() { SetShortcuts({}); }
+    int Add(const QString &hash, const QString &name);
+    void Remove(const int &row);
+    void Rename(const int &row, const QString &name);
+    void SetIcon(const int &row, const QIcon &icon);
+    void SetRunning(const int &row, const bool &running, const int &session = -1);
+
+    int RowOf(const QString &hash) const;
+    const Shortcut &At(const int &row) const { return shortcuts.at(row); }
+
+private:
+    void RowChanged(const int &row) { emit dataChanged(index(row), index(row)); }
+
+    QList<Shortcut> shortcuts;
+    QIcon placeholder;
+    QIcon playIcon;
+    QIcon stopIcon;
+    QIcon editIcon;
+};
+
+// Paints a row's icon/name and its buttons straight onto the view, so only rows actually on screen cost anything.
+// Clicks on the row or one of its buttons come back through Clicked, with the index being whatever the view's model is
+// (i.e. the proxy, if there is one).
+class NeroListDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    enum Part {
+        PartNone = -1,
+        PartRow,
+        PartPrimary,
+        PartSecondary
+    };
+
+    NeroListDelegate(QObject *parent, const QFont &font, const bool &showIcons);
+
+    void paint(QPainter *, const QStyleOptionViewItem &, const QModelIndex &) const override;
+    QSize sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const override;
+    bool editorEvent(QEvent *, QAbstractItemModel *, const QStyleOptionViewItem &, const QModelIndex &) override;
+    bool helpEvent(QHelpEvent *, QAbstractItemView *, const QStyleOptionViewItem &, const QModelIndex &) override;
+
+signals:
+    void Clicked(const QModelIndex &, const int &part);
+
+private:
+    QRect PartRect(const QStyleOptionViewItem &, const QModelIndex &, const int &part) const;
+    int PartAt(const QStyleOptionViewItem &, const QModelIndex &, const QPoint &) const;
+    QSize ButtonSize(const QStyleOptionViewItem &) const;
+
+    QFont font;
+    bool showIcons;
+
+    QPersistentModelIndex hoverIndex;
+    int hoverPart = PartNone;
+    QPersistentModelIndex pressedIndex;
+    int pressedPart = PartNone;
+};
+
+#endif // NEROLISTS_H
@@ -0,0 +1,282 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Background Runner Log Writer.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerolog.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QList>
+#include <QRegularExpression>
+
+#include <algorithm>
+
+#ifdef NERO_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// 4MB is about a second's worth of WINEDEBUG=+loaddll,debugstr,mscoree,seh at its worst
+#define NERO_LOG_RING_SIZE (4*1024*1024)
+// write out once this much is pending, or after NERO_LOG_FLUSH_MS, whichever's first
+#define NERO_LOG_CHUNK_SIZE (1024*1024)
+#define NERO_LOG_FLUSH_MS 250
+
+NeroLogWriter::NeroLogWriter(const int &keepRuns, const qint64 &segmentSize, const int &maxSegments)
+{
+    this->keepRuns = qMax(1, keepRuns);
+    this->segmentSize = segmentSize;
+    this->maxSegments = qMax(2, maxSegments);
+}
+
+NeroLogWriter::~NeroLogWriter()
+{
+    Close();
+}
+
+bool NeroLogWriter::CompressionAvailable()
+{
+#ifdef NERO_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+QString NeroLogWriter::SegmentPath(const int &run, const int &segment) const
+{
+    QString path = basePath;
+    if(run > 0) path.append('.' + QString::number(run));
+    if(segment > 0) path.append("-part" + QString::number(segment));
+    return path + extension;
+}
+
+void NeroLogWriter::RotateRuns()
+{
+    const QFileInfo baseInfo(basePath);
+    QDir logsDir(baseInfo.path());
+    // <base>[.run][-partN].txt[.zst]
+    const QRegularExpression segmentName("^(?:\\.(\\d+))?(?:-part\\d+)?(\\.txt(?:\\.zst)?)$");
+
+    struct OldSegment {
+        int run;
+        QString name;
+    };
+    QList<OldSegment> oldSegments;
+
+    for(const auto &name : logsDir.entryList(QDir::Files)) {
+        if(!name.startsWith(baseInfo.fileName())) continue;
+
+        const QRegularExpressionMatch match = segmentName.match(name.mid(baseInfo.fileName().length()));
+        if(match.hasMatch())
+            oldSegments.append({ match.captured(1).toInt(), name });
+    }
+
+    // oldest first, so nothing gets renamed on top of something that hasn't moved yet
+    std::sort(oldSegments.begin(), oldSegments.end(), [](const OldSegment &a, const OldSegment &b) { return a.run > b.run; });
+
+    for(const auto &old : std::as_const(oldSegments)) {
+        if(old.run + 1 >= keepRuns) {
+            logsDir.remove(old.name);
+        } else {
+            QString newName = old.name;
+            const QString runPrefix = old.run > 0 ? baseInfo.fileName() + '.' + QString::number(old.run) : baseInfo.fileName();
+            newName.replace(0, runPrefix.length(), baseInfo.fileName() + '.' + QString::number(old.run + 1));
+            logsDir.remove(newName);
+            logsDir.rename(old.name, newName);
+        }
+    }
+}
+
+bool NeroLogWriter::Open(const QString &path)
+{
+    Close();
+
+    basePath = path;
+    extension = CompressionAvailable() ? ".txt.zst" : ".txt";
+    RotateRuns();
+
+    if(!OpenSegment(0)) return false;
+
+    ring.resize(NERO_LOG_RING_SIZE);
+    writePos = 0, readPos = 0, dropped = 0;
+    closing = false;
+    wake.tryAcquire(wake.available());
+    opened = true;
+    start(QThread::LowPriority);
+    return true;
+}
+
+bool NeroLogWriter::OpenSegment(const int &newSegment)
+{
+    segment = newSegment;
+    file.setFileName(SegmentPath(0, segment));
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        printf("Couldn't open log file %s for writing!\n", file.fileName().toLocal8Bit().constData());
+        return false;
+    }
+
+#ifdef NERO_HAVE_ZSTD
+    zstd = ZSTD_createCCtx();
+    // anything higher than fast-ish levels just eats CPU the game could be using
+    ZSTD_CCtx_setParameter(zstd, ZSTD_c_compressionLevel, 3);
+#endif
+
+    // first segment has the environment & startup in it, so that one's always kept;
+    // past that, only the most recent segments stick around.
+    if(segment >= maxSegments)
+        QFile::remove(SegmentPath(0, segment - maxSegments + 1));
+
+    return true;
+}
+
+void NeroLogWriter::CloseSegment()
+{
+    if(!file.isOpen()) return;
+
+#ifdef NERO_HAVE_ZSTD
+    if(zstd != nullptr) {
+        // finish off the frame, so each segment can be decompressed on its own.
+        QByteArray out(static_cast<int>(ZSTD_CStreamOutSize()), Qt::Uninitialized);
+        ZSTD_inBuffer input = { nullptr, 0, 0 };
+        size_t remaining;
+        do {
+            ZSTD_outBuffer output = { out.data(), static_cast<size_t>(out.size()), 0 };
+            remaining = ZSTD_compressStream2(zstd, &output, &input, ZSTD_e_end);
+            if(ZSTD_isError(remaining)) break;
+            file.write(out.constData(), output.pos);
+        } while(remaining != 0);
+
+        ZSTD_freeCCtx(zstd);
+        zstd = nullptr;
+    }
+#endif
+
+    file.close();
+}
+
+void NeroLogWriter::Write(const QByteArray &chunk)
+{
+    if(!opened || chunk.isEmpty()) return;
+
+    const quint64 write = writePos.load(std::memory_order_relaxed);
+    const quint64 read = readPos.load(std::memory_order_acquire);
+    const quint64 size = static_cast<quint64>(chunk.size());
+
+    // never wait on the writer - if it's this far behind, losing some output beats stalling the game.
+    if(size > static_cast<quint64>(ring.size()) - (write - read)) {
+        dropped.fetch_add(size, std::memory_order_relaxed);
+        return;
+    }
+
+    const quint64 offset = write % ring.size();
+    const quint64 firstPart = qMin(size, static_cast<quint64>(ring.size()) - offset);
+    memcpy(ring.data() + offset, chunk.constData(), firstPart);
+    if(firstPart < size)
+        memcpy(ring.data(), chunk.constData() + firstPart, size - firstPart);
+
+    writePos.store(write + size, std::memory_order_release);
+    // the writer only ever goes to sleep on an empty ring, so anything else means it's already up.
+    if(write == read) wake.release();
+}
+
+void NeroLogWriter::Close()
+{
+    if(!opened) return;
+
+    closing = true;
+    wake.release();
+    wait();
+
+    CloseSegment();
+    ring.clear();
+    opened = false;
+}
+
+void NeroLogWriter::run()
+{
+    QByteArray pending;
+    QElapsedTimer sinceFlush;
+    sinceFlush.start();
+
+    while(true) {
+        // grab the flag before looking at the ring, so nothing written right before closing gets left behind
+        const bool finishing = closing.load();
+        const quint64 read = readPos.load(std::memory_order_relaxed);
+        const quint64 write = writePos.load(std::memory_order_acquire);
+
+        if(write != read) {
+            const quint64 offset = read % ring.size();
+            const quint64 size = write - read;
+            const quint64 firstPart = qMin(size, static_cast<quint64>(ring.size()) - offset);
+            pending.append(ring.constData() + offset, static_cast<int>(firstPart));
+            if(firstPart < size)
+                pending.append(ring.constData(), static_cast<int>(size - firstPart));
+
+            readPos.store(write, std::memory_order_release);
+        }
+
+        const quint64 lost = dropped.exchange(0, std::memory_order_relaxed);
+        if(lost > 0)
+            pending.append(QString("\n[Nero: log writer fell behind, %1 bytes of output were dropped]\n").arg(lost).toLocal8Bit());
+
+        if(!pending.isEmpty() && (finishing || pending.size() >= NERO_LOG_CHUNK_SIZE || sinceFlush.elapsed() >= NERO_LOG_FLUSH_MS)) {
+            WriteChunk(pending);
+            pending.clear();
+            sinceFlush.restart();
+        }
+
+        if(finishing && writePos.load(std::memory_order_acquire) == readPos.load(std::memory_order_relaxed)) break;
+        else if(write == read) {
+            // nothing to do until more output shows up, or whatever's pending is due.
+            const int timeout = pending.isEmpty() ? -1 : qMax<int>(0, NERO_LOG_FLUSH_MS - sinceFlush.elapsed());
+            if(wake.tryAcquire(1, timeout)) wake.tryAcquire(wake.available());
+        }
+    }
+
+    file.flush();
+}
+
+void NeroLogWriter::WriteChunk(const QByteArray &chunk)
+{
+    if(!file.isOpen()) return;
+
+#ifdef NERO_HAVE_ZSTD
+    if(zstd != nullptr) {
+        QByteArray out(static_cast<int>(ZSTD_CStreamOutSize()), Qt::Uninitialized);
+        ZSTD_inBuffer input = { chunk.constData(), static_cast<size_t>(chunk.size()), 0 };
+        while(input.pos < input.size) {
+            ZSTD_outBuffer output = { out.data(), static_cast<size_t>(out.size()), 0 };
+            if(ZSTD_isError(ZSTD_compressStream2(zstd, &output, &input, ZSTD_e_continue))) break;
+            WriteOut(out.constData(), output.pos);
+        }
+    } else WriteOut(chunk.constData(), chunk.size());
+#else
+    WriteOut(chunk.constData(), chunk.size());
+#endif
+
+    if(file.size() >= segmentSize) {
+        CloseSegment();
+        OpenSegment(segment + 1);
+    }
+}
+
+void NeroLogWriter::WriteOut(const char *data, const qint64 &size)
+{
+    if(size > 0) file.write(data, size);
+}
@@ -0,0 +1,90 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Background Runner Log Writer.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROLOG_H
+#define NEROLOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QSemaphore>
+#include <QThread>
+
+#include <atomic>
+
+struct ZSTD_CCtx_s;
+
+// Takes log output off of the runner's hands, so a slow disk (or a very chatty WINEDEBUG)
+// never pushes back on umu's stderr pipe.
+// The runner copies output into a fixed-size single-producer/single-consumer ring, and never waits on it -
+// if the writer thread falls that far behind, output is dropped (and noted in the log) instead.
+// The writer thread drains the ring in big chunks, compresses them if zstd was available at build time,
+// and rolls over to a new segment file once the current one gets too big.
+//
+// Files are named <base>.txt for the latest run (<base>-part<N>.txt for later segments),
+// with older runs shifted to <base>.1.txt, <base>.2.txt and so on, up to keepRuns.
+class NeroLogWriter : public QThread
+{
+public:
+    NeroLogWriter(const int &keepRuns = 5, const qint64 &segmentSize = 64*1024*1024, const int &maxSegments = 8);
+    ~NeroLogWriter();
+
+    // METHODS
+    // base path is everything but the extension.
+    bool Open(const QString &);
+    // only ever call this from one thread at a time!
+    void Write(const QByteArray &);
+    // flushes anything still queued, then stops the writer thread.
+    void Close();
+    bool IsOpen() const { return opened; }
+    static bool CompressionAvailable();
+
+protected:
+    void run() override;
+
+private:
+    void RotateRuns();
+    QString SegmentPath(const int &run, const int &segment) const;
+    bool OpenSegment(const int &);
+    void CloseSegment();
+    void WriteChunk(const QByteArray &);
+    void WriteOut(const char *, const qint64 &);
+
+    // VARS
+    int keepRuns;
+    qint64 segmentSize;
+    int maxSegments;
+
+    QString basePath;
+    QString extension;
+    QFile file;
+    int segment = 0;
+    bool opened = false;
+    ZSTD_CCtx_s *zstd = nullptr;
+
+    // the ring itself - positions only ever count up, and get wrapped on access.
+    QByteArray ring;
+    std::atomic<quint64> writePos{0};
+    std::atomic<quint64> readPos{0};
+    std::atomic<quint64> dropped{0};
+    std::atomic<bool> closing{false};
+    // released whenever something lands in an empty ring (or it's closing), so an idle writer can just sleep
+    QSemaphore wake;
+};
+
+#endif // NEROLOG_H
@@ -21,15 +21,21 @@
 #include "./ui_neromanager.h"
 #include "nerofs.h"
 #include "neroico.h"
+#include "nerolists.h"
+#include "neroiconcache.h"
+#include "neroregistry.h"
 #include "neropreferences.h"
+#include "neroprefixindex.h"
 #include "neroprefixsettings.h"
 #include "nerorunner.h"
 #include "nerorunnerdialog.h"
+#include "nerorunnerindex.h"
 #include "neroshortcut.h"
 #include "nerotricks.h"
 
 #include <QCryptographicHash>
 #include <QFileDialog>
+#include <QPointer>
 #include <QProcess>
 #include <QTimer>
 #include <QShortcut>
@@ -107,6 +113,9 @@ NeroManagerWindow::NeroManagerWindow(QWidget *parent)
     for(auto &action : sysTrayActions)
         sysTrayMenu.addAction(&action);
     connect(&sysTrayActions[0], &QAction::triggered, this, &NeroManagerWindow::actionExit_activated);
+    // what's running in every prefix, not just the open one
+    sysTrayMenu.insertMenu(&sysTrayActions[0], &sessionsMenu);
+    sessionsMenu.menuAction()->setVisible(false);
     sysTray->setContextMenu(&sysTrayMenu);
     sysTray->show();
     sysTray->setToolTip("Nero Manager");
@@ -115,13 +124,91 @@ NeroManagerWindow::NeroManagerWindow(QWidget *parent)
 
     ui->prefixContentsArea->setVisible(false);
 
-    CheckWinetricks();
+    // both lists only paint the rows that are on screen, and get sorted/filtered through their proxies.
+    prefixesModel = new NeroPrefixesModel(this);
+    prefixesProxy = new QSortFilterProxyModel(this);
+    prefixesProxy->setSourceModel(prefixesModel);
+    prefixesProxy->setSortCaseSensitivity(Qt::CaseInsensitive);
+    prefixesProxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    prefixesProxy->sort(0);
+    NeroListDelegate *prefixesDelegate = SetupListView(ui->prefixesListView, prefixesProxy, listFont, false);
+    connect(prefixesDelegate, &NeroListDelegate::Clicked, this, &NeroManagerWindow::prefixesList_clicked);
+    connect(ui->prefixesListView, &QListView::activated, this, [this](const QModelIndex &index) {
+        prefixesList_clicked(index, NeroListDelegate::PartRow);
+    });
+    connect(ui->prefixesFilter, &QLineEdit::textChanged, prefixesProxy, &QSortFilterProxyModel::setFilterFixedString);
+
+    shortcutsModel = new NeroShortcutsModel(this);
+    shortcutsProxy = new QSortFilterProxyModel(this);
+    shortcutsProxy->setSourceModel(shortcutsModel);
+    shortcutsProxy->setSortCaseSensitivity(Qt::CaseInsensitive);
+    shortcutsProxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    shortcutsProxy->sort(0);
+    NeroListDelegate *shortcutsDelegate = SetupListView(ui->shortcutsListView, shortcutsProxy, font(), true);
+    connect(shortcutsDelegate, &NeroListDelegate::Clicked, this, &NeroManagerWindow::shortcutsList_clicked);
+    // enter on a shortcut starts (or stops) it, same as its play button
+    connect(ui->shortcutsListView, &QListView::activated, this, [this](const QModelIndex &index) {
+        shortcutsList_clicked(index, NeroListDelegate::PartPrimary);
+    });
+    connect(ui->shortcutsFilter, &QLineEdit::textChanged, shortcutsProxy, &QSortFilterProxyModel::setFilterFixedString);
+
+    // winetricks is only checked once a prefix is opened, since that's the first time its button shows up.
 
     blinkTimer = new QTimer();
     connect(blinkTimer, &QTimer::timeout, this, &NeroManagerWindow::blinkTimer_timeout);
 
+    // first check is held off a bit so it doesn't compete with startup.
+    runtimeRefreshTimer = new QTimer(this);
+    runtimeRefreshTimer->setInterval(15*60*1000);
+    connect(runtimeRefreshTimer, &QTimer::timeout, this, &NeroManagerWindow::RefreshRuntimeIfIdle);
+    runtimeRefreshTimer->start();
+    QTimer::singleShot(60*1000, this, &NeroManagerWindow::RefreshRuntimeIfIdle);
+
+    // prefixes made/removed outside of this window (or found by the index's own checks)
+    connect(NeroPrefixIndex::Get(), &NeroPrefixIndex::PrefixesChanged, this, &NeroManagerWindow::RenderPrefixes);
+
+    NeroSessionManager *sessions = NeroSessionManager::Get();
+    connect(sessions, &NeroSessionManager::SessionsChanged, this, &NeroManagerWindow::UpdateRunningState);
+    connect(sessions, &NeroSessionManager::SessionStatus, this, &NeroManagerWindow::handleUmuSignal);
+    connect(sessions, &NeroSessionManager::SessionResources, this, &NeroManagerWindow::handleUmuResources);
+    connect(sessions, &NeroSessionManager::SessionFinished, this, &NeroManagerWindow::handleUmuResults);
+
     RenderPrefixes();
     SetHeader();
+
+    // anything that doesn't need to be done before the window shows up waits until it has.
+    QTimer::singleShot(0, this, &NeroManagerWindow::FinishStartup);
+}
+
+void NeroManagerWindow::FinishStartup()
+{
+    // the daemon just quits by itself if there's already one running.
+    if(managerCfg->value("StartDaemon").toBool())
+        QProcess::startDetached(QCoreApplication::applicationFilePath(), { "--daemon" });
+
+    // umu was only trusted because it's the same file that passed last time, so give it a proper check now.
+    if(NeroFS::UmuWasTrusted()) {
+        QProcess *umuTester = new QProcess(this);
+        umuTester->setProcessEnvironment(QProcessEnvironment::systemEnvironment());
+
+        auto umuFailed = [this, umuTester]() {
+            umuTester->deleteLater();
+            NeroFS::ForgetUmU();
+            QMessageBox::warning(this,
+                                 "UMU!?",
+                                 "umu at " + NeroFS::GetUmU() + " didn't pass its test run, and might not work!\n"
+                                 "It'll be checked again the next time Nero starts.");
+        };
+        connect(umuTester, &QProcess::errorOccurred, this, [umuFailed](QProcess::ProcessError error) {
+            if(error == QProcess::FailedToStart) umuFailed();
+        });
+        connect(umuTester, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [umuTester, umuFailed](int exitCode, QProcess::ExitStatus status) {
+            if(status == QProcess::NormalExit && exitCode == 0) umuTester->deleteLater();
+            else umuFailed();
+        });
+        umuTester->start(NeroFS::GetUmU(), { "-v" });
+    }
 }
 
 NeroManagerWindow::~NeroManagerWindow()
@@ -129,6 +216,10 @@ NeroManagerWindow::~NeroManagerWindow()
     managerCfg->setValue("WinSize", this->size());
     managerCfg->sync();
 
+    // in case anything was changed right before closing.
+    NeroFS::SyncPrefixCfgs();
+    NeroIconCache::FlushAll();
+
     delete ui;
 }
 
@@ -180,242 +271,194 @@ void NeroManagerWindow::SetHeader(const QString prefix, const unsigned int short
     }
 }
 
+NeroListDelegate *NeroManagerWindow::SetupListView(QListView *view, QAbstractItemModel *model, const QFont &font, const bool &showIcons)
+{
+    NeroListDelegate *delegate = new NeroListDelegate(view, font, showIcons);
+    view->setModel(model);
+    view->setItemDelegate(delegate);
+    // the delegate needs to see the mouse to highlight its buttons
+    view->setMouseTracking(true);
+    view->viewport()->setAttribute(Qt::WA_Hover);
+    // blend in with the window like the old scroll areas did
+    view->viewport()->setBackgroundRole(QPalette::Window);
+    return delegate;
+}
+
 void NeroManagerWindow::RenderPrefixes()
 {
-    // TODO: use user-provided sorting option? StringList only provides "ascending" sort.
-    // also doing this check twice is redundant af. Just doing it this way rn to maintain sortability.
-    if(NeroFS::GetPrefixes().isEmpty()) {
-        StartBlinkTimer();
-    } else {
-        StopBlinkTimer();
+    // TODO: use user-provided sorting option? Proxy only does ascending by name for now.
+    // everything here comes from the prefix index, so this never has to touch the home dir itself.
+    prefixesModel->Reload();
+
+    if(prefixesModel->rowCount() == 0) StartBlinkTimer();
+    else StopBlinkTimer();
+}
 
-        if(!prefixMainButton.isEmpty()) {
-            for(auto btn : prefixMainButton)
-                delete btn;
-            for(auto btn : prefixDeleteButton)
-                delete btn;
-            prefixMainButton.clear(), prefixDeleteButton.clear();
+void NeroManagerWindow::RenderPrefixList()
+{
+    // anything still loading for the last list is no good now
+    iconsGeneration++;
+
+    NeroPrefixCfg *prefixCfg = NeroFS::GetCurrentPrefixCfg();
+    QList<NeroShortcutsModel::Shortcut> shortcuts;
+    if(prefixCfg != nullptr) {
+        // TODO: implement sorting options here(?) - the proxy sorts by name for now.
+        const QMap<QString, QVariant> group = prefixCfg->GetGroup("Shortcuts");
+        for(auto i = group.constBegin(); i != group.constEnd(); ++i) {
+            NeroShortcutsModel::Shortcut shortcut;
+            shortcut.hash = i.key();
+            shortcut.name = i.value().toString();
+            shortcuts << shortcut;
         }
+    }
+    shortcutsModel->SetShortcuts(shortcuts);
+    // this prefix might've been left with things still running in it
+    UpdateRunningState();
 
-        for(int i = 0; i < NeroFS::GetPrefixes().count(); i++) {
-            prefixMainButton << new QPushButton(NeroFS::GetPrefixes().at(i));
-            prefixDeleteButton << new QPushButton(QIcon::fromTheme("edit-delete"), "");
+    // rows show a placeholder until their real icon's been decoded.
+    for(const auto &shortcut : std::as_const(shortcuts))
+        LoadShortcutIcon(shortcut.hash, shortcut.name);
+}
 
-            prefixMainButton.at(i)->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
-            prefixMainButton.at(i)->setFont(listFont);
-            prefixMainButton.at(i)->setProperty("slot", i);
+void NeroManagerWindow::CreatePrefix(const QString &newPrefix, const QString &runner, const QStringList &tricksToInstall, const bool &userSymlinks,
+                                     const QString &templateName, const bool &saveAsTemplate)
+{
+    const QString prefixPath = NeroFS::GetPrefixesPath()->path() + '/' + newPrefix;
+
+    if(!templateName.isEmpty()) {
+        const NeroPrefixTemplates::Template base = NeroPrefixTemplates::GetTemplate(templateName);
+        QStringList extraTricks = tricksToInstall;
+        for(const auto &verb : base.verbs)
+            extraTricks.removeAll(verb);
+
+        NeroTemplateJob *cloneJob = new NeroTemplateJob(NeroTemplateJob::CreatePrefix, templateName, prefixPath);
+
+        connect(cloneJob, &QThread::finished, this, [=]() {
+            const bool cloned = cloneJob->GetResult();
+            cloneJob->deleteLater();
+
+            if(!cloned) {
+                QMessageBox::warning(this,
+                                     "Template Clone Failed",
+                                     QString("Couldn't make \"%1\" from template \"%2\", so it'll be built from scratch instead.").arg(newPrefix, templateName));
+                CreatePrefix(newPrefix, runner, tricksToInstall, userSymlinks, "", saveAsTemplate);
+            } else if(extraTricks.isEmpty()) {
+                FinishCreatePrefix(newPrefix, runner, 0, {}, userSymlinks);
+                if(saveAsTemplate) SavePrefixTemplate(newPrefix, runner, base.verbs);
+            } else {
+                NeroTricksJob *job = new NeroTricksJob(prefixPath, NeroFS::GetRunnerPath(runner), extraTricks, true);
+                connect(job, &QThread::finished, this, [=]() {
+                    FinishCreatePrefix(newPrefix, runner, job->GetExitCode(), job->GetFailedVerbs(), userSymlinks);
+                    if(saveAsTemplate && job->GetExitCode() == 0) SavePrefixTemplate(newPrefix, runner, base.verbs + extraTricks);
+                    job->deleteLater();
+                });
+                StartJob(job, "Generating Prefix");
+            }
+        });
 
-            prefixDeleteButton.at(i)->setFlat(true);
-            prefixDeleteButton.at(i)->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
-            prefixDeleteButton.at(i)->setToolTip("Delete " + NeroFS::GetPrefixes().at(i));
-            prefixDeleteButton.at(i)->setProperty("slot", i);
+        StartJob(cloneJob, "Generating Prefix")->setText(QString("Cloning template %1...").arg(templateName));
+        return;
+    }
 
-            ui->prefixesList->addWidget(prefixMainButton.at(i), i, 0);
-            ui->prefixesList->addWidget(prefixDeleteButton.at(i), i, 1);
+    NeroTricksJob *job = new NeroTricksJob(prefixPath,
+                                           NeroFS::GetRunnerPath(runner),
+                                           tricksToInstall, true);
 
-            connect(prefixMainButton.at(i),   &QPushButton::clicked, this, &NeroManagerWindow::prefixMainButtons_clicked);
-            connect(prefixDeleteButton.at(i), &QPushButton::clicked, this, &NeroManagerWindow::prefixDeleteButtons_clicked);
-        }
-    }
+    // everything else needs the prefix to actually exist first, so it waits for the job.
+    connect(job, &QThread::finished, this, [=]() {
+        FinishCreatePrefix(newPrefix, runner, job->GetExitCode(), job->GetFailedVerbs(), userSymlinks);
+        // a template with half its verbs missing isn't much of a template
+        if(saveAsTemplate && job->GetExitCode() == 0) SavePrefixTemplate(newPrefix, runner, tricksToInstall);
+        job->deleteLater();
+    });
+
+    StartJob(job, "Generating Prefix");
 }
 
-void NeroManagerWindow::RenderPrefixList()
+void NeroManagerWindow::SavePrefixTemplate(const QString &prefix, const QString &runner, const QStringList &verbs)
 {
-    QSettings *currentPrefixIni = NeroFS::GetCurrentPrefixCfg();
-    currentPrefixIni->beginGroup("Shortcuts");
-
-    if(!currentPrefixIni->childKeys().isEmpty()) {
-        QStringList sortedShortcuts = NeroFS::GetCurrentPrefixShortcuts();
-
-        // TODO: implement sorting options here(?)
-        sortedShortcuts.sort(Qt::CaseInsensitive);
-
-        QMap<QString, QString> hashMap = NeroFS::GetCurrentShortcutsMap();
-
-        // now start adding things
-        for(int i = 0; i < sortedShortcuts.count(); i++) {
-            if(QFile::exists(QString("%1/%2/.icoCache/%3").arg(NeroFS::GetPrefixesPath()->path(),
-                                                               NeroFS::GetCurrentPrefix(),
-                                                               QString("%1-%2.png").arg(sortedShortcuts.at(i), hashMap[sortedShortcuts.at(i)])))) {
-                prefixShortcutIco << new QIcon(QPixmap(QString("%1/%2/.icoCache/%3").arg(NeroFS::GetPrefixesPath()->path(),
-                                                                                         NeroFS::GetCurrentPrefix(),
-                                                                                         QString("%1-%2.png").arg(sortedShortcuts.at(i), hashMap[sortedShortcuts.at(i)]))));
-            } else prefixShortcutIco << new QIcon(QIcon::fromTheme("application-x-executable"));
-
-            prefixShortcutIcon << new QLabel();
-            // real talk: Silent Hill The Arcade can suck it. 16x16 in 2007, seriously???
-            if(prefixShortcutIco.at(i)->actualSize(QSize(24,24)).height() < 24)
-                prefixShortcutIcon.at(i)->setPixmap(prefixShortcutIco.at(i)->pixmap(prefixShortcutIco.at(i)->actualSize(QSize(24,24))).scaled(24,24,Qt::KeepAspectRatio,Qt::SmoothTransformation));
-            else prefixShortcutIcon.at(i)->setPixmap(prefixShortcutIco.at(i)->pixmap(24,24));
-            prefixShortcutIcon.at(i)->setAlignment(Qt::AlignCenter);
-
-            prefixShortcutLabel << new QLabel(sortedShortcuts.at(i));
-            prefixShortcutLabel.at(i)->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
-
-            // media-playback-start should change to media-playback-stop when being slot is being played.
-            prefixShortcutPlayButton << new QPushButton(QIcon::fromTheme("media-playback-start"), "");
-            prefixShortcutPlayButton.at(i)->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-            prefixShortcutPlayButton.at(i)->setToolTip("Start " + sortedShortcuts.at(i));
-            prefixShortcutPlayButton.at(i)->setIconSize(QSize(16, 16));
-            prefixShortcutPlayButton.at(i)->setProperty("slot", i);
-            prefixShortcutPlayButton.at(i)->setProperty("hash", hashMap[sortedShortcuts.at(i)]);
-
-            prefixShortcutEditButton << new QPushButton(QIcon::fromTheme("document-properties"), "");
-            prefixShortcutEditButton.at(i)->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-            prefixShortcutEditButton.at(i)->setIconSize(QSize(16, 16));
-            prefixShortcutEditButton.at(i)->setToolTip("Edit properties of " + sortedShortcuts.at(i));
-            prefixShortcutEditButton.at(i)->setFlat(true);
-            prefixShortcutEditButton.at(i)->setProperty("slot", i);
-
-            ui->prefixContentsGrid->addWidget(prefixShortcutIcon.at(i), i, 0);
-            ui->prefixContentsGrid->addWidget(prefixShortcutLabel.at(i), i, 1);
-            ui->prefixContentsGrid->addWidget(prefixShortcutPlayButton.at(i), i, 2, Qt::AlignLeft);
-            ui->prefixContentsGrid->addWidget(prefixShortcutEditButton.at(i), i, 3, Qt::AlignLeft);
-
-            connect(prefixShortcutPlayButton.at(i), &QPushButton::clicked, this, &NeroManagerWindow::prefixShortcutPlayButtons_clicked);
-            connect(prefixShortcutEditButton.at(i), &QPushButton::clicked, this, &NeroManagerWindow::prefixShortcutEditButtons_clicked);
+    const QString prefixPath = NeroFS::GetPrefixesPath()->path() + '/' + prefix;
+    if(!QDir(prefixPath).exists()) return;
+
+    NeroTemplateJob *job = new NeroTemplateJob(NeroTemplateJob::SaveTemplate, prefix, prefixPath, runner, verbs);
+
+    connect(job, &QThread::finished, this, [this, job, prefix]() {
+        if(sysTray->supportsMessages()) {
+            if(job->GetResult())
+                sysTray->showMessage("Saved Template \"" + prefix + "\"",
+                                     "New prefixes can now be made from \"" + prefix + "\" in the New Prefix Wizard.");
+            else sysTray->showMessage("Error Saving Template \"" + prefix + "\"",
+                                      "Couldn't save prefix \"" + prefix + "\" as a template. The prefix itself is unaffected.");
         }
+        job->deleteLater();
+    });
 
-        ui->prefixContentsGrid->setColumnStretch(1, 1);
-    }
+    StartJob(job, "Saving Template")->setText(QString("Saving %1 as a template...").arg(prefix));
 }
 
-void NeroManagerWindow::CreatePrefix(const QString &newPrefix, const QString &runner, QStringList tricksToInstall)
+QMessageBox *NeroManagerWindow::StartJob(QThread *job, const QString &title)
 {
-    QProcess umu;
-    QMessageBox waitBox(QMessageBox::NoIcon,
-                        "Generating Prefix",
-                        "Please wait...",
-                        QMessageBox::NoButton,
-                        this,
-                        Qt::Dialog | Qt::FramelessWindowHint | Qt::MSWindowsFixedSizeDialogHint);
-    waitBox.setStandardButtons(QMessageBox::NoButton);
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-
-    env.insert("WINEPREFIX", NeroFS::GetPrefixesPath()->path() + '/' + newPrefix);
-
-    // Only explicit set GAMEID when not already declared by user for (their) testing purposes
-    // (may or may not cause issues if user also selects tricks verbs, but since it needs to be expressly set by user, they assume all responsibility)
-    // See SeongGino/Nero-umu#66 for more info
-    if(!env.contains("GAMEID")) env.insert("GAMEID", "0");
-
-    env.insert("PROTONPATH", NeroFS::GetProtonsPath()->path() + '/' + runner);
-    // for Proton 10+. this shit gets real annoying
-    env.insert("PROTON_USE_XALIA", "0");
-    //env.insert("UMU_RUNTIME_UPDATE", "0");
-    umu.setProcessEnvironment(env);
-    umu.setProcessChannelMode(QProcess::MergedChannels);
-
-    if(tricksToInstall.isEmpty()) {
-        // UMU is supposed to have "createprefix" action, but it doesn't actually do anything
-        // (on newer versions, it just runs explorer.exe pointed at nothing)
-        // we just need an easy scapegoat process that exits on its own without spawning a console window
-        umu.start(NeroFS::GetUmU(), {"reg", "/?"});
-    } else {
-        tricksToInstall.prepend("winetricks");
-        QStringList argsList;
-
-        // NOTE: until https://github.com/Winetricks/winetricks/issues/2367 is resolved,
-        // delete two offending reg entries so that dotnet verbs don't erroneously exit.
-        if(!tricksToInstall.filter("dotnet").isEmpty()) {
-            argsList = (QStringList) {  NeroFS::GetUmU() + " reg delete \"HKLM\\Software\\Wow6432Node\\Microsoft\\.NETFramework\" /f && " +
-                                        NeroFS::GetUmU() + " reg delete \"HKLM\\Software\\Wow6432Node\\Microsoft\\NET Framework Setup\" /f && " +
-                                        NeroFS::GetUmU() + ' ' + tricksToInstall.join(' ') };
-            printf(".NET verb detected, cleaning up registry keys before winetricks install...\n");
-        } else argsList = (QStringList){NeroFS::GetUmU() + ' ' + tricksToInstall.join(' ')};
-
-        argsList.prepend("-c");
-        umu.start("/bin/sh", argsList);
-        tricksToInstall.removeFirst();
+    QMessageBox *waitBox = new QMessageBox(QMessageBox::NoIcon,
+                                           title,
+                                           "Please wait...",
+                                           QMessageBox::NoButton,
+                                           this,
+                                           Qt::Dialog | Qt::FramelessWindowHint | Qt::MSWindowsFixedSizeDialogHint);
+    waitBox->setStandardButtons(QMessageBox::NoButton);
+
+    if(NeroTricksJob *tricksJob = qobject_cast<NeroTricksJob*>(job)) {
+        connect(tricksJob, &NeroTricksJob::StepStarted, waitBox, [waitBox](const int &index, const int &count, const QString &label) {
+            if(count > 1)
+                waitBox->setText(QString("%1\n\n(step %2 of %3, this stage may take a while...)").arg(label).arg(index + 1).arg(count));
+            else waitBox->setText(label);
+        });
     }
+    connect(job, &QThread::finished, waitBox, [waitBox]() {
+        QGuiApplication::restoreOverrideCursor();
+        waitBox->deleteLater();
+    });
 
-    waitBox.open();
-    waitBox.raise();
+    waitBox->open();
+    waitBox->raise();
     QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-    // don't use blocking function so that the dialog shows and the UI doesn't freeze.
-    while(umu.state() != QProcess::NotRunning) {
-        QApplication::processEvents();
-        QByteArray stdout;
-        // TODO: use QTextStream instead of printing line-by-line?
-        umu.waitForReadyRead(1000);
-        if(umu.canReadLine()) {
-            stdout = umu.readLine();
-            printf("%s", stdout.constData());
-            if(stdout.contains("Proton: Upgrading")) {
-                waitBox.setText("Creating prefix " + newPrefix + " using " + runner + "...");
-            } else if(stdout.contains("Downloading latest steamrt sniper")) {
-                waitBox.setText("umu: Updating runtime to latest version...");
-            } else if(stdout.contains("Proton: Running winetricks verbs in prefix:")) {
-                waitBox.setText("Running installations for Winetricks verbs:\n\n" +
-                                tricksToInstall.join('\n') +
-                                "\n\nThis stage may take a while...");
-            }
-        }
-    }
+    job->start();
+    return waitBox;
+}
 
-    if(umu.exitCode() == 0) {
+void NeroManagerWindow::FinishCreatePrefix(const QString &newPrefix, const QString &runner, const int &exitCode, const QStringList &failedVerbs, const bool &userSymlinks)
+{
+    if(exitCode == 0) {
         if(sysTray->supportsMessages())
             sysTray->showMessage("Finished Making Prefix \"" + newPrefix + "\"",
                                  "New Proton prefix \"" + newPrefix + "\" has been created successfully.");
     } else {
         if(sysTray->supportsMessages())
             sysTray->showMessage("Error Making Prefix \"" + newPrefix + "\"",
-                                 "Prefix creation process for \"" + newPrefix + "\" has exited with error code " + QString::number(umu.exitCode()) +
-                                 ". This usually means that a winetricks verb has failed installation. "
+                                 "Prefix creation process for \"" + newPrefix + "\" has exited with error code " + QString::number(exitCode) + ". " +
+                                 (failedVerbs.isEmpty() ? QString() : "These Winetricks verbs failed to install: " + failedVerbs.join(", ") + ". ") +
                                  "Confirm that the desired verbs have installed in the prefix's \"Install Winetricks Components\" window.");
     }
 
     QDir prefixPath(NeroFS::GetPrefixesPath()->path() + '/' + newPrefix);
     if(prefixPath.exists("system.reg")) {
         // Add fixes to system.reg
-        QFile regFile(prefixPath.path() + "/system.reg");
-        if(regFile.open(QFile::ReadWrite)) {
-            QString newReg;
-            QString line;
-
-            while(!regFile.atEnd()) {
-                line = regFile.readLine();
-                newReg.append(line);
-                // DualSense fix
-                //if(line.startsWith("[System\\\\CurrentControlSet\\\\Services\\\\winebus]"))
-                //    newReg.append("\"DisableHidraw\"=dword:00000001\n");
-                // connect COM ports for lightguns (in case someone still wants to use MAMEHOOKER) ;)
-                if(line.startsWith("[Software\\\\Wine\\\\Ports]"))
-                    newReg.append(  "\"COM1\"=\"/dev/ttyACM0\"\n"
-                                  "\"COM2\"=\"/dev/ttyACM1\"\n"
-                                  "\"COM3\"=\"/dev/ttyACM2\"\n"
-                                  "\"COM4\"=\"/dev/ttyACM3\"\n"
-                                  "\"COM5\"=\"/dev/ttyS0\"\n");
-            }
-
-            regFile.resize(0);
-            regFile.write(newReg.toUtf8());
-            regFile.close();
-        }
-
-        // add prefix btn to list
+        NeroRegistry systemReg(NeroRegistry::GetSystemReg(prefixPath.path()));
+        // DualSense fix
+        //systemReg.SetDword("System\\CurrentControlSet\\Services\\winebus", "DisableHidraw", 1);
+        // connect COM ports for lightguns (in case someone still wants to use MAMEHOOKER) ;)
+        systemReg.SetString("Software\\Wine\\Ports", "COM1", "/dev/ttyACM0");
+        systemReg.SetString("Software\\Wine\\Ports", "COM2", "/dev/ttyACM1");
+        systemReg.SetString("Software\\Wine\\Ports", "COM3", "/dev/ttyACM2");
+        systemReg.SetString("Software\\Wine\\Ports", "COM4", "/dev/ttyACM3");
+        systemReg.SetString("Software\\Wine\\Ports", "COM5", "/dev/ttyS0");
+        if(!systemReg.Apply())
+            printf("Couldn't add COM port mappings to %s\n", newPrefix.toLocal8Bit().constData());
+
+        // the index tells the prefixes list about it
         NeroFS::AddNewPrefix(newPrefix, runner);
 
-        unsigned int pos = prefixMainButton.count();
-
-        prefixMainButton << new QPushButton(newPrefix);
-        prefixDeleteButton << new QPushButton(QIcon::fromTheme("edit-delete"), "");
-
-        prefixMainButton.at(pos)->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
-        prefixMainButton.at(pos)->setFont(listFont);
-        prefixMainButton.at(pos)->setProperty("slot", pos);
-
-        prefixDeleteButton.at(pos)->setFlat(true);
-        prefixDeleteButton.at(pos)->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
-        prefixDeleteButton.at(pos)->setToolTip("Delete " + newPrefix);
-        prefixDeleteButton.at(pos)->setProperty("slot", pos);
-
-        ui->prefixesList->addWidget(prefixMainButton.at(pos), pos, 0);
-        ui->prefixesList->addWidget(prefixDeleteButton.at(pos), pos, 1);
-
-        connect(prefixMainButton.at(pos),   &QPushButton::clicked, this, &NeroManagerWindow::prefixMainButtons_clicked);
-        connect(prefixDeleteButton.at(pos), &QPushButton::clicked, this, &NeroManagerWindow::prefixDeleteButtons_clicked);
+        if(userSymlinks) NeroFS::CreateUserLinks(newPrefix);
     }
 
     QApplication::alert(this);
@@ -423,9 +466,8 @@ void NeroManagerWindow::CreatePrefix(const QString &newPrefix, const QString &ru
     if(!NeroFS::GetPrefixes().isEmpty())
         StopBlinkTimer();
 
-    sysTray->setIcon(QIcon(":/ico/systrayPhi"));
-
-    QGuiApplication::restoreOverrideCursor();
+    // back to whatever it was before the prefix was started
+    UpdateRunningState();
 }
 
 void NeroManagerWindow::CheckWinetricks()
@@ -463,66 +505,21 @@ void NeroManagerWindow::on_addButton_clicked()
                 // hash function here
                 QString hashName(QCryptographicHash::hash(QByteArray::number(LOLRANDOM), QCryptographicHash::Md5).toHex(0));
 
-                QSettings *currentPrefixIni = NeroFS::GetCurrentPrefixCfg();
-                currentPrefixIni->beginGroup("Shortcuts");
+                NeroPrefixCfg *currentPrefixIni = NeroFS::GetCurrentPrefixCfg();
 
                 // if this hash matches anything, repeatedly generate hashes until a unique one is found
                 while(true) {
-                    if(currentPrefixIni->childKeys().contains(hashName)) {
+                    if(currentPrefixIni->Contains("Shortcuts", hashName)) {
                         hashName = QCryptographicHash::hash(QByteArray::number(LOLRANDOM+rand()), QCryptographicHash::Md5).toHex(0);
                     } else break;
                 }
 
                 NeroFS::AddNewShortcut(hashName, shortcutAdd.shortcutName, shortcutAdd.appPath);
 
-                // because the Shortcuts getter always returns a resorted list, just add to the bottom for user convenience.
-                unsigned int pos = prefixShortcutLabel.count();
-
-                if(shortcutAdd.appIcon.isEmpty()) {
-                    prefixShortcutIco << new QIcon(QIcon::fromTheme("application-x-executable"));
-                } else {
-                    QFile::copy(shortcutAdd.appIcon, QString("%1/%2/.icoCache/%3").arg( NeroFS::GetPrefixesPath()->path(),
-                                                                                        NeroFS::GetCurrentPrefix(),
-                                                                                        shortcutAdd.shortcutName + '-' + hashName + ".png"));
-                    prefixShortcutIco << new QIcon(QPixmap(QString("%1/%2/.icoCache/%3").arg(   NeroFS::GetPrefixesPath()->path(),
-                                                                                                NeroFS::GetCurrentPrefix(),
-                                                                                                shortcutAdd.shortcutName + '-' + hashName + ".png")));
-                }
-
-                prefixShortcutIcon << new QLabel();
-                // real talk: Silent Hill The Arcade can suck it. 16x16 in 2007, seriously???
-                if(prefixShortcutIco.last()->actualSize(QSize(24,24)).height() < 24)
-                    prefixShortcutIcon.last()->setPixmap(prefixShortcutIco.last()->pixmap(prefixShortcutIco.last()->actualSize(QSize(24,24))).scaled(24,24,Qt::KeepAspectRatio,Qt::SmoothTransformation));
-                else prefixShortcutIcon.last()->setPixmap(prefixShortcutIco.last()->pixmap(24,24));
-                prefixShortcutIcon.last()->setAlignment(Qt::AlignCenter);
-
-                prefixShortcutLabel << new QLabel(shortcutAdd.shortcutName);
-                prefixShortcutLabel.last()->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
-
-                // media-playback-start should change to media-playback-stop when playing
-                prefixShortcutPlayButton << new QPushButton(QIcon::fromTheme("media-playback-start"), "");
-                prefixShortcutPlayButton.last()->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-                prefixShortcutPlayButton.last()->setIconSize(QSize(16, 16));
-                prefixShortcutPlayButton.last()->setToolTip("Start " + shortcutAdd.shortcutName);
-                prefixShortcutPlayButton.last()->setProperty("slot", pos);
-                prefixShortcutPlayButton.last()->setProperty("hash", hashName);
-
-                prefixShortcutEditButton << new QPushButton(QIcon::fromTheme("document-properties"), "");
-                prefixShortcutEditButton.last()->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-                prefixShortcutEditButton.last()->setIconSize(QSize(16, 16));
-                prefixShortcutEditButton.last()->setToolTip("Edit properties of " + shortcutAdd.shortcutName);
-                prefixShortcutEditButton.last()->setFlat(true);
-                prefixShortcutEditButton.last()->setProperty("slot", pos);
-
-                ui->prefixContentsGrid->addWidget(prefixShortcutIcon.last(),        pos, 0);
-                ui->prefixContentsGrid->addWidget(prefixShortcutLabel.last(),       pos, 1);
-                ui->prefixContentsGrid->addWidget(prefixShortcutPlayButton.last(),  pos, 2, Qt::AlignLeft);
-                ui->prefixContentsGrid->addWidget(prefixShortcutEditButton.last(),  pos, 3, Qt::AlignLeft);
-
-                connect(prefixShortcutPlayButton.last(), SIGNAL(clicked()), this, SLOT(prefixShortcutPlayButtons_clicked()));
-                connect(prefixShortcutEditButton.last(), SIGNAL(clicked()), this, SLOT(prefixShortcutEditButtons_clicked()));
-
-                if(pos == 0) { ui->prefixContentsGrid->setColumnStretch(1, 1); }
+                // the proxy sorts it in with everything else
+                shortcutsModel->Add(hashName, shortcutAdd.shortcutName);
+                if(!shortcutAdd.appIcon.isEmpty())
+                    LoadShortcutIcon(hashName, shortcutAdd.shortcutName, shortcutAdd.appIcon);
 
                 SetHeader(NeroFS::GetCurrentPrefix(), NeroFS::GetCurrentPrefixShortcuts().count());
             }
@@ -539,41 +536,37 @@ void NeroManagerWindow::on_addButton_clicked()
 void NeroManagerWindow::on_backButton_clicked()
 {
     // this also handles the page toggling
+    // (anything running in this prefix keeps going, and can still be stopped from the tray's running list)
     if(prefixIsSelected) {
-        if(currentlyRunning.count() > 0) {
-            if(runnerWindow == nullptr) {
-                runnerWindow = new NeroRunnerDialog(this);
-                runnerWindow->SetupWindow(false, "all running apps in current prefix");
-                runnerWindow->show();
-            }
-            for(int i = threadsCount; i > 0; --i) {
-                // for the current prefix, we only need to run the prefix kill command once to end them all!
-                if(umuController.at(i-1) != nullptr) {
-                    umuController.at(i-1)->Stop();
-                    break;
-                }
-            }
-        } else SetHeader();
+        SetHeader();
+        UpdateRunningState();
     } else {
         // TODO: implement favorites
     }
 }
 
-void NeroManagerWindow::prefixMainButtons_clicked()
+void NeroManagerWindow::prefixesList_clicked(const QModelIndex &index, const int &part)
 {
-    auto *obj = qobject_cast<QPushButton*>(sender());
+    const QString prefix = index.data(NeroListRole::Key).toString();
+    if(prefix.isEmpty()) return;
+
+    if(part == NeroListDelegate::PartSecondary) RemovePrefix(prefix);
+    else if(part == NeroListDelegate::PartRow) OpenPrefix(prefix);
+}
 
-    if(NeroFS::GetCurrentPrefix() != obj->text()) {
-        if(prefixShortcutLabel.count())
+void NeroManagerWindow::OpenPrefix(const QString &prefix)
+{
+    if(NeroFS::GetCurrentPrefix() != prefix) {
+        if(shortcutsModel->rowCount())
             CleanupShortcuts();
 
-        NeroFS::SetCurrentPrefix(obj->text());
+        NeroFS::SetCurrentPrefix(prefix);
 
         RenderPrefixList();
 
         if(!NeroFS::GetAvailableProtons()->contains(NeroFS::GetCurrentRunner())) {
-            NeroFS::SetCurrentPrefixCfg("PrefixSettings", "CurrentRunner", NeroFS::GetAvailableProtons()->constFirst());
-            NeroFS::SetCurrentPrefix(obj->text());
+            NeroFS::SetCurrentPrefixCfg("PrefixSettings", "CurrentRunner", NeroRunnerIndex::Get()->FindReplacement(NeroFS::GetCurrentRunner()));
+            NeroFS::SetCurrentPrefix(prefix);
             QMessageBox::warning(this,
                                  "Current Runner not found!",
                                  "The runner that was assigned to this prefix could not be found in the list of available Proton runners.\n"
@@ -583,23 +576,31 @@ void NeroManagerWindow::prefixMainButtons_clicked()
     }
 
     SetHeader(NeroFS::GetCurrentPrefix(), NeroFS::GetCurrentPrefixShortcuts().count());
+    // the ini's been read by now anyways, so might as well make sure the index agrees with it
+    NeroFS::UpdatePrefixIndex();
 
     CheckWinetricks();
+    UpdateRunningState();
 }
 
-void NeroManagerWindow::prefixDeleteButtons_clicked()
+void NeroManagerWindow::RemovePrefix(const QString &prefix)
 {
-    int slot = sender()->property("slot").toInt();
-
     if(QMessageBox::question(this,
                              "Removing Prefix",
-                             "Are you sure you wish to delete " + prefixMainButton.at(slot)->text() + "?\n\n"
+                             "Are you sure you wish to delete " + prefix + "?\n\n"
                              "All data inside the prefix will be deleted.\n"
                              "This operation CAN NOT BE UNDONE."
                             ) == QMessageBox::Yes)
     {
-        if(NeroFS::DeletePrefix(prefixMainButton.at(slot)->text())) {
-            if(NeroFS::GetCurrentPrefix() == prefixMainButton.at(slot)->text())
+        if(NeroSessionManager::Get()->Count(prefix)) {
+            QMessageBox::warning(this,
+                                 "Prefix is Running!",
+                                 prefix + " still has apps running in it. Stop them first, then try again.");
+            return;
+        }
+
+        if(NeroFS::DeletePrefix(prefix)) {
+            if(NeroFS::GetCurrentPrefix() == prefix)
                 CleanupShortcuts();
 
             RenderPrefixes();
@@ -607,58 +608,51 @@ void NeroManagerWindow::prefixDeleteButtons_clicked()
     }
 }
 
-void NeroManagerWindow::prefixShortcutPlayButtons_clicked()
+void NeroManagerWindow::shortcutsList_clicked(const QModelIndex &index, const int &part)
 {
+    if(!index.isValid()) return;
+
+    // rows in the source model are the manager's "slots"
+    const int slot = shortcutsProxy->mapToSource(index).row();
 
-    int slot = sender()->property("slot").toInt();
+    if(part == NeroListDelegate::PartPrimary) PlayShortcut(slot);
+    else if(part == NeroListDelegate::PartSecondary) EditShortcut(slot);
+}
+
+void NeroManagerWindow::PlayShortcut(const int &slot)
+{
+    // copied, since the model can change under us while this goes
+    const NeroShortcutsModel::Shortcut shortcut = shortcutsModel->At(slot);
+    QIcon icon = shortcutsModel->index(slot).data(Qt::DecorationRole).value<QIcon>();
 
-    if(currentlyRunning.contains(slot)) {
+    const int session = NeroSessionManager::Get()->FindShortcut(NeroFS::GetCurrentPrefix(), shortcut.hash);
+    if(session >= 0) {
         if(runnerWindow == nullptr) {
             runnerWindow = new NeroRunnerDialog(this);
-            runnerWindow->SetupWindow(false, prefixShortcutLabel.at(slot)->text(), prefixShortcutIco.at(slot));
+            runnerWindow->SetupWindow(false, shortcut.name, &icon);
             runnerWindow->show();
+            runnerSession = session;
         }
 
-        umuController.at(prefixShortcutPlayButton.at(slot)->property("thread").toInt())->Stop();
+        NeroSessionManager::Get()->Stop(session);
     } else {
-        QMap<QString, QVariant> shortcutSettings = NeroFS::GetShortcutSettings(sender()->property("hash").toString());
+        QMap<QString, QVariant> shortcutSettings = NeroFS::GetShortcutSettings(shortcut.hash);
 
         // in case the directory has a Windows drive letter prefix,
         // which should be harmless in the context of what Windows allows files/dirs to be named anyways.
-        if(QFileInfo::exists(shortcutSettings.value("Path").toString().replace("C:/",
-                                                                               NeroFS::GetPrefixesPath()->canonicalPath()+'/'+NeroFS::GetCurrentPrefix()+"/drive_c/"))) {
-            ui->prefixSettingsBtn->setEnabled(false);
-            ui->prefixTricksBtn->setEnabled(false);
-
-            prefixShortcutPlayButton.at(slot)->setIcon(QIcon::fromTheme("media-playback-stop"));
-            prefixShortcutPlayButton.at(slot)->setToolTip("Stop " + prefixShortcutLabel.at(slot)->text());
-            ui->backButton->setIcon(QIcon::fromTheme("media-playback-stop"));
-            ui->backButton->setToolTip("Shut down all running programs in this prefix.");
-            sysTray->setIcon(QIcon(":/ico/systrayPhiPlaying"));
-            threadsCount += 1;
-            currentlyRunning.append(slot);
-            if(currentlyRunning.count() > 1)
-                sysTray->setToolTip("Nero Manager (" + NeroFS::GetCurrentPrefix() + " is running " + QString::number(currentlyRunning.count()) + " apps)");
-            else sysTray->setToolTip("Nero Manager (" + NeroFS::GetCurrentPrefix() + " is running " + prefixShortcutLabel.at(slot)->text() + ')');
-
+        const QString exePath = shortcutSettings.value("Path").toString().replace("C:/",
+                                                                                 NeroFS::GetPrefixesPath()->canonicalPath()+'/'+NeroFS::GetCurrentPrefix()+"/drive_c/");
+        const int id = QFileInfo::exists(exePath) ? NeroSessionManager::Get()->StartShortcut(NeroFS::GetCurrentPrefix(), shortcut.hash) : -1;
+        if(id >= 0) {
             if(managerCfg->value("ShortcutHidesManager").toBool())
                 this->hide();
 
             if(runnerWindow == nullptr) {
                 runnerWindow = new NeroRunnerDialog(this);
-                runnerWindow->SetupWindow(true, prefixShortcutLabel.at(slot)->text(), prefixShortcutIco.at(slot));
+                runnerWindow->SetupWindow(true, shortcut.name, &icon);
                 runnerWindow->show();
+                runnerSession = id;
             }
-
-            if(currentlyRunning.count() > 1)
-                umuController << new NeroThreadController(slot, sender()->property("hash").toString(), true);
-            else umuController << new NeroThreadController(slot, sender()->property("hash").toString());
-
-            umuController.last()->setProperty("slot", threadsCount-1);
-            prefixShortcutPlayButton.at(slot)->setProperty("thread", threadsCount-1);
-            connect(umuController.last(),                       &NeroThreadController::passUmuResults,  this, &NeroManagerWindow::handleUmuResults);
-            connect(&umuController.last()->umuWorker->Runner,   &NeroRunner::StatusUpdate,              this, &NeroManagerWindow::handleUmuSignal);
-            emit umuController.last()->operate();
         } else {
             QMessageBox::critical(this,
                                   "Executable could not be found!",
@@ -668,14 +662,12 @@ void NeroManagerWindow::prefixShortcutPlayButtons_clicked()
     }
 }
 
-void NeroManagerWindow::prefixShortcutEditButtons_clicked()
+void NeroManagerWindow::EditShortcut(const int &slot)
 {
-    int slot = sender()->property("slot").toInt();
-
-    prefixSettings = new NeroPrefixSettingsWindow(this, prefixShortcutPlayButton.at(slot)->property("hash").toString());
+    prefixSettings = new NeroPrefixSettingsWindow(this, shortcutsModel->At(slot).hash);
     prefixSettings->setProperty("slot", slot);
     connect(prefixSettings, &NeroPrefixSettingsWindow::finished, this, &NeroManagerWindow::prefixSettings_result);
-    if(currentlyRunning.count())
+    if(NeroSessionManager::Get()->Count(NeroFS::GetCurrentPrefix()))
         if(prefixSettings->deleteShortcut != nullptr)
             prefixSettings->deleteShortcut->setEnabled(false);
     prefixSettings->show();
@@ -692,39 +684,11 @@ void NeroManagerWindow::on_oneTimeRunBtn_clicked()
 
     if(!oneTimeApp.isEmpty()) {
         oneTimeLastPath = oneTimeApp;
-        ui->prefixSettingsBtn->setEnabled(false);
-        ui->prefixTricksBtn->setEnabled(false);
-
-        ui->backButton->setIcon(QIcon::fromTheme("media-playback-stop"));
-        ui->backButton->setToolTip("Shut down all running programs in this prefix.");
-        sysTray->setIcon(QIcon(":/ico/systrayPhiPlaying"));
-        threadsCount += 1;
-        currentlyRunning.append(-1);
-        if(currentlyRunning.count() > 1)
-            sysTray->setToolTip("Nero Manager (" + NeroFS::GetCurrentPrefix() + " is running " + QString::number(currentlyRunning.count()) + " apps)");
-        else sysTray->setToolTip("Nero Manager (" + NeroFS::GetCurrentPrefix() + " is running " + oneTimeApp.mid(oneTimeApp.lastIndexOf('/')+1) + ')');
 
-        if(runnerWindow == nullptr) {
-            QIcon icon;
-            QString iconPath = NeroIcoExtractor::GetIcon(oneTimeApp);
-            if(!iconPath.isEmpty())
-                icon = QIcon(QPixmap(iconPath));
-            runnerWindow = new NeroRunnerDialog(this);
-            runnerWindow->setModal(true);
-            runnerWindow->SetupWindow(true, oneTimeApp.mid(oneTimeApp.lastIndexOf('/')+1), &icon);
-            runnerWindow->show();
-            QDir tempDir(QDir::tempPath() + "/nero-manager");
-            tempDir.removeRecursively();
-        }
-
-        if(ui->oneTimeRunArgs->text().isEmpty()) {
-            if(currentlyRunning.count() > 1)
-                umuController << new NeroThreadController(-1, oneTimeApp, true);
-            else umuController << new NeroThreadController(-1, oneTimeApp, false);
-        } else {
+        QStringList args;
+        if(!ui->oneTimeRunArgs->text().isEmpty()) {
             // SUPER UNGA BUNGA: manually split string into a list
             QString buf = ui->oneTimeRunArgs->text();
-            QStringList args;
             args.append("");
             bool quotation = false;
             for(const auto &chara : std::as_const(buf)) {
@@ -742,36 +706,79 @@ void NeroManagerWindow::on_oneTimeRunBtn_clicked()
                 }
             }
             if(args.last().isEmpty()) args.removeLast();
+        }
+
+        const int id = NeroSessionManager::Get()->StartOnetime(NeroFS::GetCurrentPrefix(), oneTimeApp, args);
 
-            if(currentlyRunning.count() > 1)
-                umuController << new NeroThreadController(-1, oneTimeApp, true, args);
-            else umuController << new NeroThreadController(-1, oneTimeApp, false, args);
+        if(runnerWindow == nullptr) {
+            runnerWindow = new NeroRunnerDialog(this);
+            runnerWindow->setModal(true);
+            runnerWindow->SetupWindow(true, oneTimeApp.mid(oneTimeApp.lastIndexOf('/')+1));
+            runnerWindow->show();
+            runnerSession = id;
+
+            // don't hold up the launch for this, the dialog can pick it up whenever it's ready.
+            NeroRunnerDialog *dialog = runnerWindow;
+            NeroIcoExtractor::GetIconImageAsync(oneTimeApp, dialog, [dialog](const QImage &icon) {
+                if(!icon.isNull()) dialog->SetIcon(QIcon(QPixmap::fromImage(icon)));
+            });
         }
+    }
+}
+
+void NeroManagerWindow::LoadShortcutIcon(const QString &hash, const QString &name, const QString &iconSource)
+{
+    const QString prefixName = NeroFS::GetCurrentPrefix();
+    const QString prefixPath = NeroFS::GetPrefixesPath()->path() + '/' + prefixName;
+    const QString oldKey = NeroFS::GetCurrentPrefixCfg()->GetString("Shortcuts--" + hash, "IconKey");
+    const unsigned int generation = iconsGeneration;
+    QPointer<NeroManagerWindow> window(this);
+
+    NeroIcoExtractor::GetPool()->start([=]() {
+        QString key;
+        if(!iconSource.isEmpty()) key = NeroIconCache::StoreFile(prefixPath, iconSource);
+        // shortcuts made before the icon pack existed still have a loose png lying around
+        else if(oldKey.isEmpty()) key = NeroIconCache::ImportLegacy(prefixPath, name, hash);
+        else key = oldKey;
+
+        const QList<QImage> images = NeroIconCache::GetImages(prefixPath, key);
+        if(images.isEmpty()) return;
+
+        QMetaObject::invokeMethod(qApp, [=]() {
+            // settings get updated even if the list's gone, as long as the shortcut itself still exists.
+            NeroPrefixCfg *prefixCfg = QDir(prefixPath).exists() ? NeroFS::GetPrefixCfg(prefixName) : nullptr;
+            if(key != oldKey && prefixCfg != nullptr && prefixCfg->Contains("Shortcuts", hash)) {
+                prefixCfg->SetValue("Shortcuts--" + hash, "IconKey", key);
+                if(oldKey.isEmpty()) QFile::remove(NeroIconCache::GetLegacyPath(prefixPath, name, hash));
+                else if(!NeroFS::IsIconKeyInUse(prefixName, oldKey)) NeroIconCache::Remove(prefixPath, oldKey);
+            }
+
+            // window's gone, or the list's been rebuilt since this was queued
+            if(window.isNull() || window->iconsGeneration != generation) return;
+            window->shortcutsModel->SetIcon(window->shortcutsModel->RowOf(hash), NeroIconCache::ToIcon(images));
+        }, Qt::QueuedConnection);
+    });
+}
+
+void NeroManagerWindow::RefreshAllIcons()
+{
+    const QString drivePath = NeroFS::GetPrefixesPath()->canonicalPath() + '/' + NeroFS::GetCurrentPrefix() + "/drive_c/";
 
-        umuController.last()->setProperty("slot", threadsCount-1);
-        umuController.last()->setProperty("running", oneTimeApp.mid(oneTimeApp.lastIndexOf('/')+1));
-        oneOffsRunning.append(oneTimeApp.mid(oneTimeApp.lastIndexOf('/')+1));
-        connect(umuController.last(),                       &NeroThreadController::passUmuResults,  this, &NeroManagerWindow::handleUmuResults);
-        connect(&umuController.last()->umuWorker->Runner,   &NeroRunner::StatusUpdate,              this, &NeroManagerWindow::handleUmuSignal);
-        emit umuController.last()->operate();
+    // each shortcut is its own job, so the pool spreads these out on its own.
+    for(int i = 0; i < shortcutsModel->rowCount(); i++) {
+        const NeroShortcutsModel::Shortcut &shortcut = shortcutsModel->At(i);
+        const QString path = NeroFS::GetShortcutSettings(shortcut.hash).value("Path").toString().replace("C:/", drivePath);
+        LoadShortcutIcon(shortcut.hash, shortcut.name, path);
     }
 }
 
 void NeroManagerWindow::CleanupShortcuts()
 {
-    for(unsigned int i = 0; i < prefixShortcutLabel.count(); i++) {
-        delete prefixShortcutIco[i];
-        delete prefixShortcutIcon[i];
-        delete prefixShortcutLabel[i];
-        delete prefixShortcutPlayButton[i];
-        delete prefixShortcutEditButton[i];
-    }
+    // anything still being decoded for the old list should just be dropped.
+    iconsGeneration++;
 
-    prefixShortcutIco.clear();
-    prefixShortcutIcon.clear();
-    prefixShortcutLabel.clear();
-    prefixShortcutPlayButton.clear();
-    prefixShortcutEditButton.clear();
+    shortcutsModel->Clear();
+    ui->shortcutsFilter->clear();
 }
 
 void NeroManagerWindow::on_prefixSettingsBtn_clicked()
@@ -779,6 +786,7 @@ void NeroManagerWindow::on_prefixSettingsBtn_clicked()
     prefixSettings = new NeroPrefixSettingsWindow(this);
     prefixSettings->setProperty("slot", -1);
     connect(prefixSettings, &NeroPrefixSettingsWindow::finished, this, &NeroManagerWindow::prefixSettings_result);
+    connect(prefixSettings, &NeroPrefixSettingsWindow::refreshIconsRequested, this, &NeroManagerWindow::RefreshAllIcons);
     prefixSettings->show();
 }
 
@@ -817,82 +825,32 @@ void NeroManagerWindow::tricksWindow_result()
             // Start tricks installation
             sysTray->setIcon(QIcon(":/ico/systrayPhiBusy"));
 
-            QProcess umu;
-            QMessageBox waitBox(QMessageBox::NoIcon,
-                                "Generating Prefix",
-                                "Please wait...",
-                                QMessageBox::NoButton,
-                                this,
-                                Qt::Dialog | Qt::FramelessWindowHint | Qt::MSWindowsFixedSizeDialogHint);
-            waitBox.setStandardButtons(QMessageBox::NoButton);
-            QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-
-            QMap<QString, QVariant> settingsMap = NeroFS::GetCurrentPrefixSettings();
-            QString prefix = NeroFS::GetCurrentPrefix();
-
-            env.insert("WINEPREFIX", NeroFS::GetPrefixesPath()->path() + '/' + prefix);
-            env.insert("GAMEID", "0"); // force gameid here since tricks installation wouldn't benefit from having a forced profile
-            env.insert("PROTONPATH", NeroFS::GetProtonsPath()->path() + '/' + settingsMap["CurrentRunner"].toString());
-            // for Proton 10+. this shit gets real annoying
-            env.insert("PROTON_USE_XALIA", "0");
-            //env.insert("UMU_RUNTIME_UPDATE", "0");
-            umu.setProcessEnvironment(env);
-            umu.setProcessChannelMode(QProcess::MergedChannels);
-
-            verbsToInstall.prepend("winetricks");
-
-            QStringList argsList;
+            const QString prefix = NeroFS::GetCurrentPrefix();
+            const QString runner = NeroFS::GetCurrentPrefixSettings().value("CurrentRunner").toString();
 
             // NOTE: until https://github.com/Winetricks/winetricks/issues/2367 is resolved, delete two offending reg entries
-            if(tricks->installedVerbs.filter("dotnet").isEmpty() && !verbsToInstall.filter("dotnet").isEmpty()) {
-                argsList = (QStringList) {  NeroFS::GetUmU() + " reg delete \"HKLM\\Software\\Wow6432Node\\Microsoft\\.NETFramework\" /f && " +
-                                            NeroFS::GetUmU() + " reg delete \"HKLM\\Software\\Wow6432Node\\Microsoft\\NET Framework Setup\" /f && " +
-                                            NeroFS::GetUmU() + ' ' + verbsToInstall.join(' ') };
-                printf("First time .NET verb has been requested, cleaning up registry keys before winetricks install...\n");
-            } else argsList = (QStringList){NeroFS::GetUmU() + ' ' + verbsToInstall.join(' ')};
-
-            argsList.prepend("-c");
-            umu.start("/bin/sh", argsList);
-            verbsToInstall.removeFirst();
-
-            waitBox.open();
-            waitBox.raise();
-            QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-
-            // don't use blocking function so that the dialog shows and the UI doesn't freeze.
-            while(umu.state() != QProcess::NotRunning) {
-                QApplication::processEvents();
-                QByteArray stdout;
-                // TODO: use QTextStream instead of printing line-by-line?
-                umu.waitForReadyRead(100);
-                if(umu.canReadLine()) {
-                    stdout = umu.readLine();
-                    printf("%s", stdout.constData());
-                    if(stdout.contains("Proton: Upgrading")) {
-                        waitBox.setText(QString("Updating %1 with new Proton %2...").arg(prefix, settingsMap["CurrentRunner"].toString()));
-                    } else if(stdout.contains("Downloading latest steamrt sniper")) {
-                        waitBox.setText("umu: Updating runtime to latest version...");
-                    } else if(stdout.contains("Proton: Running winetricks verbs in prefix:")) {
-                        waitBox.setText(QString("Running installations for Winetricks verbs:\n\n%1\n\nThis stage may take a while...").arg(verbsToInstall.join('\n')));
-                    }
-                }
-            }
-
-            QApplication::alert(this);
-            if(umu.exitCode() != 0) {
-                if(sysTray->supportsMessages())
-                    sysTray->showMessage("Winetricks Installation Returned An Error",
-                                         "Winetricks process in prefix \"" + prefix + "\" has exited with error code " + QString::number(umu.exitCode()) + ". "
-                                                                                                                                                           "Not all queued verbs may have finished installing. "
-                                                                                                                                                           "Confirm which verbs have been successfully installed by checking for grayed-out entries in the \"Install Winetricks Components\" window for this prefix.",
-                                         QSystemTrayIcon::Warning);
-            } else if(sysTray->supportsMessages())
-                sysTray->showMessage("Finished Installing Winetricks",
-                                     "Queued Winetricks verbs has finished installing to prefix \"" + NeroFS::GetCurrentPrefix() + "\".");
-
-            QGuiApplication::restoreOverrideCursor();
-
-            sysTray->setIcon(QIcon(":/ico/systrayPhi"));
+            // (only needed the first time a .NET verb goes into this prefix)
+            NeroTricksJob *job = new NeroTricksJob(NeroFS::GetPrefixesPath()->path() + '/' + prefix,
+                                                   NeroFS::GetRunnerPath(runner),
+                                                   verbsToInstall, tricks->installedVerbs.filter("dotnet").isEmpty());
+
+            connect(job, &QThread::finished, this, [this, job, prefix]() {
+                QApplication::alert(this);
+                if(job->GetExitCode() != 0) {
+                    if(sysTray->supportsMessages())
+                        sysTray->showMessage("Winetricks Installation Returned An Error",
+                                             "Winetricks verbs " + job->GetFailedVerbs().join(", ") + " in prefix \"" + prefix + "\" failed to install. "
+                                             "Confirm which verbs have been successfully installed by checking for grayed-out entries in the \"Install Winetricks Components\" window for this prefix.",
+                                             QSystemTrayIcon::Warning);
+                } else if(sysTray->supportsMessages())
+                    sysTray->showMessage("Finished Installing Winetricks",
+                                         "Queued Winetricks verbs has finished installing to prefix \"" + prefix + "\".");
+
+                sysTray->setIcon(QIcon(":/ico/systrayPhi"));
+                job->deleteLater();
+            });
+
+            StartJob(job, "Installing Winetricks Verbs");
 
             delete tricks;
             tricks = nullptr;
@@ -907,10 +865,19 @@ void NeroManagerWindow::tricksWindow_result()
 void NeroManagerWindow::prefixWizard_result()
 {
     if(wizard->result() == QDialog::Accepted) {
-        sysTray->setIcon(QIcon(":/ico/systrayPhiBusy"));
-        CreatePrefix(wizard->prefixName, NeroFS::GetAvailableProtons()->at(wizard->protonRunner), wizard->verbsToInstall);
+        // templates outlive the prefixes they were saved from, so one by this name might still be around.
+        bool saveAsTemplate = wizard->saveAsTemplate;
+        if(saveAsTemplate && NeroPrefixTemplates::GetTemplates().contains(wizard->prefixName))
+            saveAsTemplate = QMessageBox::question(this,
+                                                   "Template Already Exists",
+                                                   QString("There's already a template named \"%1\".\n\n"
+                                                           "Replace it with this prefix once it's made? "
+                                                           "Otherwise, the prefix will still be made, just not saved as a template.").arg(wizard->prefixName))
+                             == QMessageBox::Yes;
 
-        if(wizard->userSymlinks) NeroFS::CreateUserLinks(wizard->prefixName);
+        sysTray->setIcon(QIcon(":/ico/systrayPhiBusy"));
+        CreatePrefix(wizard->prefixName, wizard->protonRunner, wizard->verbsToInstall, wizard->userSymlinks,
+                     wizard->templateName, saveAsTemplate);
     } else if(NeroFS::GetPrefixes().isEmpty()) StartBlinkTimer();
 
     delete wizard;
@@ -925,44 +892,23 @@ void NeroManagerWindow::prefixSettings_result()
         if(prefixSettings->result() == QDialog::Accepted) {
             // update app icon if changed
             if(!prefixSettings->newAppIcon.isEmpty()) {
-                delete prefixShortcutIco.at(slot);
-                prefixShortcutIco[slot] = new QIcon(prefixSettings->newAppIcon);
-                if(prefixShortcutIco.at(slot)->actualSize(QSize(24,24)).height() < 24)
-                    prefixShortcutIcon.at(slot)->setPixmap(prefixShortcutIco.at(slot)->pixmap(prefixShortcutIco.at(slot)->actualSize(QSize(24,24))).scaled(24,24,Qt::KeepAspectRatio,Qt::SmoothTransformation));
-                else prefixShortcutIcon.at(slot)->setPixmap(prefixShortcutIco.at(slot)->pixmap(24,24));
+                const QString hash = shortcutsModel->At(slot).hash;
+                const QIcon icon = NeroIconCache::GetIcon(NeroFS::GetPrefixesPath()->path() + '/' + NeroFS::GetCurrentPrefix(),
+                                                          NeroFS::GetCurrentPrefixCfg()->GetString("Shortcuts--" + hash, "IconKey"));
+                if(!icon.isNull()) shortcutsModel->SetIcon(slot, icon);
             }
             // update app name if changed
-            if(prefixSettings->appName != prefixShortcutLabel.at(slot)->text()) {
-                QMap<QString, QString> settings = NeroFS::GetCurrentShortcutsMap();
-                NeroFS::SetCurrentPrefixCfg("Shortcuts", settings.value(prefixShortcutLabel.at(slot)->text()), prefixSettings->appName);
-                // move existing ico (if any) to new name
-                QFile ico(NeroFS::GetPrefixesPath()->path() + '/' +
-                          NeroFS::GetCurrentPrefix()+ "/.icoCache/" +
-                          prefixShortcutLabel.at(slot)->text() + '-' +
-                          settings.value(prefixShortcutLabel.at(slot)->text()) + ".png");
-                if(ico.exists())
-                    ico.rename(NeroFS::GetPrefixesPath()->path() + '/' +
-                               NeroFS::GetCurrentPrefix() + "/.icoCache/" +
-                               prefixSettings->appName + '-' +
-                               settings.value(prefixShortcutLabel.at(slot)->text()) + ".png");
-
-                prefixShortcutLabel.at(slot)->setText(prefixSettings->appName);
-                prefixShortcutPlayButton.at(slot)->setToolTip("Start " + prefixSettings->appName);
+            if(prefixSettings->appName != shortcutsModel->At(slot).name) {
+                NeroFS::SetCurrentPrefixCfg("Shortcuts", shortcutsModel->At(slot).hash, prefixSettings->appName);
+                // icons are keyed by content now, so nothing to move around here.
+
+                shortcutsModel->Rename(slot, prefixSettings->appName);
             }
         // delete shortcut signal
         } else if(prefixSettings->result() == -1) {
-            QMap<QString, QString> settings = NeroFS::GetCurrentShortcutsMap();
-            NeroFS::DeleteShortcut(settings.value(prefixShortcutLabel.at(slot)->text()));
-            delete prefixShortcutIco[slot];
-            delete prefixShortcutIcon[slot];
-            delete prefixShortcutLabel[slot];
-            delete prefixShortcutPlayButton[slot];
-            delete prefixShortcutEditButton[slot];
-            prefixShortcutIco[slot] = nullptr;
-            prefixShortcutIcon[slot] = nullptr;
-            prefixShortcutLabel[slot] = nullptr;
-            prefixShortcutPlayButton[slot] = nullptr;
-            prefixShortcutEditButton[slot] = nullptr;
+            NeroFS::DeleteShortcut(shortcutsModel->At(slot).hash);
+            // nothing can be running while a shortcut's deleted, so no slots in use get shifted by this.
+            shortcutsModel->Remove(slot);
 
             SetHeader(NeroFS::GetCurrentPrefix(), NeroFS::GetCurrentPrefixShortcuts().count());
         }
@@ -1038,10 +984,50 @@ void NeroManagerWindow::blinkTimer_timeout()
     }
 }
 
+void NeroManagerWindow::RefreshRuntimeIfIdle()
+{
+    if(runtimeRefresh != nullptr || NeroSessionManager::Get()->Count() > 0 || NeroFS::RuntimeIsFresh()) return;
+
+    // no point in fetching updates for a prefix that doesn't want them
+    if(NeroFS::GetCurrentPrefix().isEmpty() || !NeroFS::GetCurrentPrefixSettings().value("RuntimeUpdateOnLaunch").toBool()) return;
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("UMU_RUNTIME_UPDATE", "1");
+    // just the runtime, no Proton or prefix needed
+    env.insert("UMU_NO_PROTON", "1");
+    // umu still makes up (and creates) a default prefix under ~/Games/umu without one, so point it at one that already exists.
+    env.insert(CliArgs::Wine::prefix, NeroFS::GetPrefixesPath()->path() + '/' + NeroFS::GetCurrentPrefix());
+    if(!env.contains(CliArgs::gameId)) env.insert(CliArgs::gameId, "0");
+
+    runtimeRefresh = new QProcess(this);
+    runtimeRefresh->setProcessEnvironment(env);
+    runtimeRefresh->setProcessChannelMode(QProcess::MergedChannels);
+    connect(runtimeRefresh, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this](int exitCode, QProcess::ExitStatus status) {
+        const QByteArray output = runtimeRefresh->readAll();
+        if(status == QProcess::NormalExit && (exitCode == 0 || output.contains("steamrt3 is up to date"))) {
+            printf("Steam Runtime refreshed in the background.\n");
+            NeroFS::SetRuntimeVerified();
+        } else printf("Background Steam Runtime refresh failed:\n%s\n", output.constData());
+
+        runtimeRefresh->deleteLater();
+        runtimeRefresh = nullptr;
+    });
+
+    // finished never fires if umu couldn't even start
+    connect(runtimeRefresh, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if(error != QProcess::FailedToStart) return;
+        runtimeRefresh->deleteLater();
+        runtimeRefresh = nullptr;
+    });
+
+    printf("Refreshing Steam Runtime in the background...\n");
+    runtimeRefresh->start(NeroFS::GetUmU(), { "/usr/bin/true" });
+}
+
 void NeroManagerWindow::StartBlinkTimer()
 {
     blinkTimer->start(800);
-    if(!prefixIsSelected) { ui->missingPrefixesLabelArea->setVisible(true); ui->prefixesScrollArea->setVisible(false); }
+    if(!prefixIsSelected) { ui->missingPrefixesLabelArea->setVisible(true); ui->prefixesListView->setVisible(false); ui->prefixesFilter->setVisible(false); }
 }
 
 void NeroManagerWindow::StopBlinkTimer()
@@ -1049,65 +1035,140 @@ void NeroManagerWindow::StopBlinkTimer()
     ui->addButton->setStyleSheet("");
     ui->addButton->setFlat(true);
     blinkTimer->stop();
-    if(!prefixIsSelected) { ui->missingPrefixesLabelArea->setVisible(false); ui->prefixesScrollArea->setVisible(true); }
+    if(!prefixIsSelected) { ui->missingPrefixesLabelArea->setVisible(false); ui->prefixesListView->setVisible(true); ui->prefixesFilter->setVisible(true); }
 }
 
 // umu runner stuff here!
-void NeroThreadWorker::umuRunnerProcess()
+void NeroManagerWindow::UpdateRunningState()
 {
-    int result;
-    if(currentSlot >= 0) {
-        // for shortcuts, parameters = hash
-        result = Runner.StartShortcut(currentParameters, alreadyRunning);
-    } else {
-        // for one time, parameters = path, oneTimeArgs = contents of oneTimeArguments
-        result = Runner.StartOnetime(currentParameters, alreadyRunning, oneTimeArgs);
+    NeroSessionManager *sessions = NeroSessionManager::Get();
+    const QList<NeroSessionContext> running = sessions->GetSessions();
+    const QString prefix = NeroFS::GetCurrentPrefix();
+
+    // rows only show what's running for the prefix that's open right now
+    for(int i = 0; i < shortcutsModel->rowCount(); ++i) {
+        const int id = sessions->FindShortcut(prefix, shortcutsModel->At(i).hash);
+        if(shortcutsModel->At(i).session != id)
+            shortcutsModel->SetRunning(i, id >= 0, id);
+    }
+
+    // the prefix shouldn't be changed out from under whatever's running in it.
+    if(prefixIsSelected) {
+        const bool prefixRunning = sessions->Count(prefix) > 0;
+        ui->prefixSettingsBtn->setEnabled(!prefixRunning);
+        ui->prefixTricksBtn->setEnabled(!prefixRunning && !NeroFS::GetWinetricks().isEmpty());
     }
 
-    emit umuExited(currentSlot, result);
+    sysTray->setIcon(QIcon(running.isEmpty() ? ":/ico/systrayPhi" : ":/ico/systrayPhiPlaying"));
+    UpdateTrayTooltip();
+    RenderSessionsMenu();
 }
 
-void NeroManagerWindow::handleUmuResults(const int &buttonSlot, const int &result)
+void NeroManagerWindow::UpdateTrayTooltip()
 {
-    const unsigned int threadSlot = sender()->property("slot").toInt();
+    const QList<NeroSessionContext> running = NeroSessionManager::Get()->GetSessions();
 
-    if(buttonSlot >= 0) {
-        prefixShortcutPlayButton.at(buttonSlot)->setIcon(QIcon::fromTheme("media-playback-start"));
-        prefixShortcutPlayButton.at(buttonSlot)->setToolTip("Start " + prefixShortcutLabel.at(buttonSlot)->text());
+    QStringList prefixes;
+    for(const auto &session : running)
+        if(!prefixes.contains(session.prefix)) prefixes << session.prefix;
 
-        if(managerCfg->value("ShortcutHidesManager").toBool())
-            if(this->isHidden()) this->show();
-    } else oneOffsRunning.removeOne(sender()->property("running").toString());
+    if(running.isEmpty())
+        sysTray->setToolTip("Nero Manager");
+    else if(running.count() == 1)
+        // with just the one, there's room for what it's doing too
+        sysTray->setToolTip("Nero Manager (" + running.first().prefix + " is running " + SessionText(running.first()) + ')');
+    else if(prefixes.count() == 1)
+        sysTray->setToolTip("Nero Manager (" + prefixes.first() + " is running " + QString::number(running.count()) + " apps)");
+    else sysTray->setToolTip(QString("Nero Manager (running %1 apps in %2 prefixes)").arg(running.count()).arg(prefixes.count()));
+}
 
-    delete umuController[threadSlot];
-    umuController[threadSlot] = nullptr;
+QString NeroManagerWindow::SessionText(const NeroSessionContext &session)
+{
+    NeroResourceSample sample;
+    if(NeroSessionManager::Get()->GetResources(session.id, sample))
+        return session.name + " - " + sample.Summary();
+    return session.name;
+}
 
-    currentlyRunning.removeOne(buttonSlot);
-    if(currentlyRunning.count() == 0) {
-        currentlyRunning.clear();
-        threadsCount = 0;
-        umuController.clear();
-        ui->backButton->setIcon(QIcon::fromTheme("go-previous"));
-        ui->backButton->setToolTip("Go back to prefixes list.");
-        sysTray->setIcon(QIcon(":/ico/systrayPhi"));
-        sysTray->setToolTip("Nero Manager");
-        ui->prefixSettingsBtn->setEnabled(true);
-        ui->prefixTricksBtn->setEnabled(true);
-    } else if(currentlyRunning.count() == 1) {
-        if(currentlyRunning.first() != -1)
-            sysTray->setToolTip("Nero Manager (" + NeroFS::GetCurrentPrefix() + " is running " + prefixShortcutLabel.at(currentlyRunning.first())->text() + ')');
-        else sysTray->setToolTip("Nero Manager (" + NeroFS::GetCurrentPrefix() + " is running " + oneOffsRunning.first() + ')');
-    } else sysTray->setToolTip("Nero Manager (" + NeroFS::GetCurrentPrefix() + " is running " + QString::number(currentlyRunning.count()) + " apps)");
+void NeroManagerWindow::RenderSessionsMenu()
+{
+    sessionsMenu.clear();
+    sessionActions.clear();
+
+    const QList<NeroSessionContext> running = NeroSessionManager::Get()->GetSessions();
+    sessionsMenu.menuAction()->setVisible(!running.isEmpty());
+    if(running.isEmpty()) return;
+    sessionsMenu.setTitle(QString("Running (%1)").arg(running.count()));
+
+    QStringList prefixes;
+    for(const auto &session : running)
+        if(!prefixes.contains(session.prefix)) prefixes << session.prefix;
+
+    for(const auto &prefix : std::as_const(prefixes)) {
+        sessionsMenu.addSection(prefix);
+
+        int count = 0;
+        for(const auto &session : running) {
+            if(session.prefix != prefix) continue;
+            ++count;
+
+            QAction *stop = sessionsMenu.addAction(QIcon::fromTheme("media-playback-stop"), SessionText(session));
+            stop->setToolTip("Stop " + session.name + ", running since " + session.started.toString("hh:mm"));
+            sessionActions.insert(session.id, stop);
+            connect(stop, &QAction::triggered, this, [this, session]() {
+                ShowStopping(session.id, session.name);
+                NeroSessionManager::Get()->Stop(session.id);
+            });
+        }
+
+        if(count > 1) {
+            QAction *stopAll = sessionsMenu.addAction(QIcon::fromTheme("process-stop"), "Shut down everything in " + prefix);
+            const int first = NeroSessionManager::Get()->GetSessions(prefix).first().id;
+            connect(stopAll, &QAction::triggered, this, [this, prefix, first]() {
+                ShowStopping(first, "all running apps in " + prefix);
+                NeroSessionManager::Get()->StopPrefix(prefix);
+            });
+        }
+    }
+}
+
+void NeroManagerWindow::ShowStopping(const int &id, const QString &name)
+{
+    if(runnerWindow != nullptr) return;
+
+    runnerWindow = new NeroRunnerDialog(this);
+    runnerWindow->SetupWindow(false, name);
+    runnerWindow->show();
+    runnerSession = id;
+}
 
-    if(runnerWindow != nullptr) {
+void NeroManagerWindow::handleUmuResults(const NeroSessionContext &session, const int &result)
+{
+    if(session.IsShortcut() && managerCfg->value("ShortcutHidesManager").toBool())
+        if(this->isHidden()) this->show();
+
+    if(runnerWindow != nullptr && runnerSession == session.id) {
         delete runnerWindow;
         runnerWindow = nullptr;
+        runnerSession = -1;
     }
 }
 
-void NeroManagerWindow::handleUmuSignal(const int &signalType)
+void NeroManagerWindow::handleUmuResources(const int &id, const NeroResourceSample &sample)
+{
+    if(runnerWindow != nullptr && runnerSession == id)
+        runnerWindow->SetResources(sample.Summary());
+
+    // the menu might be open, so the entry's just updated rather than the whole thing redone.
+    if(sessionActions.contains(id))
+        sessionActions.value(id)->setText(SessionText(NeroSessionManager::Get()->GetSession(id)));
+
+    UpdateTrayTooltip();
+}
+
+void NeroManagerWindow::handleUmuSignal(const int &id, const int &signalType)
 {
-    if(runnerWindow != nullptr) {
+    if(runnerWindow != nullptr && runnerSession == id) {
         switch(signalType) {
         case NeroRunner::RunnerStarting:
             runnerWindow->SetText("umu launching...");
@@ -1118,6 +1179,7 @@ void NeroManagerWindow::handleUmuSignal(const int &signalType)
         case NeroRunner::RunnerProtonStarted:
             delete runnerWindow;
             runnerWindow = nullptr;
+            runnerSession = -1;
             break;
         case NeroRunner::RunnerProtonStopping:
             runnerWindow->SetText("Stopping Proton process...");
@@ -1125,6 +1187,7 @@ void NeroManagerWindow::handleUmuSignal(const int &signalType)
         case NeroRunner::RunnerProtonStopped:
             delete runnerWindow;
             runnerWindow = nullptr;
+            runnerSession = -1;
             break;
         }
     }
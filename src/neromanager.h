@@ -24,12 +24,17 @@
 #include "neroprefixsettings.h"
 #include "nerorunner.h"
 #include "nerorunnerdialog.h"
+#include "nerosession.h"
 #include "nerotricks.h"
+#include "nerotemplates.h"
+#include "nerotricksjob.h"
 #include "nerowizard.h"
+#include "nerolists.h"
 
 #include <QMainWindow>
 #include <QDir>
 #include <QLabel>
+#include <QListView>
 #include <QPushButton>
 #include <QBoxLayout>
 #include <QTimer>
@@ -37,6 +42,8 @@
 #include <QSettings>
 #include <QSystemTrayIcon>
 #include <QMenu>
+#include <QProcess>
+#include <QSortFilterProxyModel>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -44,54 +51,6 @@ class NeroManagerWindow;
 }
 QT_END_NAMESPACE
 
-// may or may not be copy/paste Qt doc example here
-class NeroThreadWorker : public QObject
-{
-    Q_OBJECT
-
-public:
-    NeroThreadWorker(const int &slot, const QString &params, const bool &prefixAlreadyRunning = false, const QStringList &extArgs = {}) {
-        currentSlot = slot, currentParameters = params, oneTimeArgs = extArgs, alreadyRunning = prefixAlreadyRunning;
-    }
-    ~NeroThreadWorker() {};
-    NeroRunner Runner;
-public slots:
-    void umuRunnerProcess();
-signals:
-    void umuExited(const int &, const int &);
-private:
-    bool alreadyRunning = false;
-    int currentSlot;
-    QString currentParameters;
-    QStringList oneTimeArgs;
-};
-
-class NeroThreadController : public QObject
-{
-    Q_OBJECT
-    QThread umuThread;
-public:
-    NeroThreadController(const int &slot, const QString &params, const bool &prefixAlreadyRunning = false, const QStringList &extArgs = {}) {
-        umuWorker = new NeroThreadWorker(slot, params, prefixAlreadyRunning, extArgs);
-        umuWorker->moveToThread(&umuThread);
-        connect(&umuThread, &QThread::finished, umuWorker, &QObject::deleteLater);
-        connect(this, &NeroThreadController::operate, umuWorker, &NeroThreadWorker::umuRunnerProcess);
-        connect(umuWorker, &NeroThreadWorker::umuExited, this, &NeroThreadController::handleUmuResults);
-        umuThread.start();
-    }
-    ~NeroThreadController() {
-        umuThread.quit();
-        umuThread.wait();
-    }
-    NeroThreadWorker *umuWorker;
-    void Stop() { umuWorker->Runner.halt = true; }
-signals:
-    void operate();
-    void passUmuResults(const int &, const int &);
-public slots:
-    void handleUmuResults(const int &buttonSlot, const int &result) { emit passUmuResults(buttonSlot, result); }
-};
-
 class NeroManagerWindow : public QMainWindow
 {
     Q_OBJECT
@@ -105,14 +64,13 @@ protected:
     void closeEvent(QCloseEvent *event) { delete sysTray; }
 
 public slots:
-    void handleUmuResults(const int &, const int &);
-    void handleUmuSignal(const int &);
+    void handleUmuResults(const NeroSessionContext &, const int &);
+    void handleUmuSignal(const int &id, const int &status);
+    void handleUmuResources(const int &id, const NeroResourceSample &);
 
 private slots:
-    void prefixMainButtons_clicked();
-    void prefixDeleteButtons_clicked();
-    void prefixShortcutPlayButtons_clicked();
-    void prefixShortcutEditButtons_clicked();
+    void prefixesList_clicked(const QModelIndex &, const int &part);
+    void shortcutsList_clicked(const QModelIndex &, const int &part);
     void blinkTimer_timeout();
     void tricksWindow_result();
     void prefixWizard_result();
@@ -150,11 +108,37 @@ private:
     void CheckWinetricks();
     void RenderPrefixes();
     void RenderPrefixList();
-    void CreatePrefix(const QString &, const QString &, QStringList tricksToInstall = {});
-    void RenderShortcuts();
+    // prefix creation runs in the background, and is finished up once the job's done.
+    // with a template, the prefix is cloned from it and only verbs it doesn't already have get installed.
+    void CreatePrefix(const QString &, const QString &, const QStringList &tricksToInstall = {}, const bool &userSymlinks = false,
+                      const QString &templateName = "", const bool &saveAsTemplate = false);
+    void FinishCreatePrefix(const QString &, const QString &, const int &exitCode, const QStringList &failedVerbs, const bool &userSymlinks);
+    void SavePrefixTemplate(const QString &, const QString &, const QStringList &verbs);
+    // shows a wait box (that follows the job's progress, if it's a tricks job), and starts it.
+    QMessageBox *StartJob(QThread *, const QString &title);
     void CleanupShortcuts();
+    // decodes (and stores, if iconSource is set) in the background, then fills in that shortcut's row.
+    void LoadShortcutIcon(const QString &hash, const QString &name, const QString &iconSource = "");
+    void RefreshAllIcons();
+    void OpenPrefix(const QString &);
+    void RemovePrefix(const QString &);
+    // slots are rows in the (unfiltered) shortcuts model.
+    void PlayShortcut(const int &slot);
+    void EditShortcut(const int &slot);
+    NeroListDelegate *SetupListView(QListView *, QAbstractItemModel *, const QFont &, const bool &showIcons);
+    // runs umu by itself to update the Steam Runtime while nothing else is going on, so launches can skip it.
+    void RefreshRuntimeIfIdle();
+    // the rest of startup, once the window's up.
+    void FinishStartup();
     void StartBlinkTimer();
     void StopBlinkTimer();
+    // brings the shortcut rows, prefix buttons and tray in line with whatever sessions are running, in any prefix.
+    void UpdateRunningState();
+    void RenderSessionsMenu();
+    void UpdateTrayTooltip();
+    QString SessionText(const NeroSessionContext &);
+    // shows the runner dialog as stopping, if it's not already up.
+    void ShowStopping(const int &id, const QString &name);
 
     // VARS & OBJECTS
     unsigned int LOLRANDOM;
@@ -165,27 +149,27 @@ private:
     QAction sysTrayActions[1] = { QAction("Exit Nero") };
     QSettings *managerCfg;
     QTimer *blinkTimer;
+    QTimer *runtimeRefreshTimer;
+    QProcess *runtimeRefresh = nullptr;
     int blinkingState = 1;
     bool prefixIsSelected = false;
     QString oneTimeLastPath;
 
-    // umu threads
-    QList<NeroThreadController*> umuController;
-    QList<int> currentlyRunning;
-    int threadsCount = 0;
-    QStringList oneOffsRunning;
+    // umu sessions - the runner dialog only follows the one it was opened for.
+    int runnerSession = -1;
+    QMenu sessionsMenu;
+    // session id -> its entry in the menu, so samples can update it in place
+    QHash<int, QAction*> sessionActions;
 
     // Prefixes list assets
-    QList<QPushButton*> prefixMainButton;
-    QList<QPushButton*> prefixDeleteButton;
+    NeroPrefixesModel *prefixesModel;
+    QSortFilterProxyModel *prefixesProxy;
 
     // Prefix Shortcuts list assets
-    QList<QLabel*> prefixShortcutLabel;
-    QList<QIcon*> prefixShortcutIco;
-    QList<QLabel*> prefixShortcutIcon;
-    QList<QPushButton*> prefixShortcutPlayButton;
-    QList<QPushButton*> prefixShortcutEditButton;
-    QList<QSpacerItem*> prefixShortcutSpacer;
+    NeroShortcutsModel *shortcutsModel;
+    QSortFilterProxyModel *shortcutsProxy;
+    // bumped whenever the shortcuts list is rebuilt, so late async icon loads know to bail.
+    unsigned int iconsGeneration = 0;
 
     QFont listFont;
 };
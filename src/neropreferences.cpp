@@ -21,10 +21,10 @@
 #include "ui_neropreferences.h"
 #include "nerofs.h"
 
+#include <QCoreApplication>
 #include <QShortcut>
 #include <QFileDialog>
 #include <QProcess>
-#include <QStandardPaths>
 
 NeroManagerPreferences::NeroManagerPreferences(QWidget *parent)
     : QDialog(parent)
@@ -40,11 +40,13 @@ NeroManagerPreferences::NeroManagerPreferences(QWidget *parent)
     managerCfg = NeroFS::GetManagerCfg();
     //ui->runnerNotifs->setChecked(managerCfg->value("UseNotifier").toBool());
     ui->shortcutHide->setChecked(managerCfg->value("ShortcutHidesManager").toBool());
+    ui->shareShaderCaches->setChecked(managerCfg->value("ShareShaderCaches", true).toBool());
+    ui->startDaemon->setChecked(managerCfg->value("StartDaemon").toBool());
     ui->umuPath->setText(managerCfg->value("UMUpath").toString());
-    if(ui->umuPath->text().isEmpty() || ui->umuPath->text() == QStandardPaths::findExecutable("umu-run")) {
+    if(ui->umuPath->text().isEmpty() || ui->umuPath->text() == NeroFS::FindTool("umu-run")) {
         ui->umuPath->clear();
         ui->umuPath->setPlaceholderText(ui->umuPath->placeholderText() + " (" +
-                                        QStandardPaths::findExecutable("umu-run") + ")");
+                                        NeroFS::FindTool("umu-run") + ")");
         ui->umuPathClearBtn->setVisible(false);
     }
 }
@@ -54,10 +56,15 @@ NeroManagerPreferences::~NeroManagerPreferences()
     if(accepted) {
         //managerCfg->setValue("UseNotifier", ui->runnerNotifs->isChecked());
         managerCfg->setValue("ShortcutHidesManager", ui->shortcutHide->isChecked());
+        managerCfg->setValue("ShareShaderCaches", ui->shareShaderCaches->isChecked());
+        // turning it on starts it right away; it's left running if turned off, for whatever's still using it.
+        if(ui->startDaemon->isChecked() && !managerCfg->value("StartDaemon").toBool())
+            QProcess::startDetached(QCoreApplication::applicationFilePath(), { "--daemon" });
+        managerCfg->setValue("StartDaemon", ui->startDaemon->isChecked());
 
         if(ui->umuPath->text().isEmpty()) {
             if(!managerCfg->value("UMUpath").toString().isEmpty()) {
-                if(NeroFS::SetUmU(QStandardPaths::findExecutable("umu-run"))) managerCfg->setValue("UMUpath", "");
+                if(NeroFS::SetUmU(NeroFS::FindTool("umu-run"))) managerCfg->setValue("UMUpath", "");
                 else QMessageBox::warning(NULL,
                                           "No working system UMU!",
                                           "System paths do not contain a working UMU instance!\n"
@@ -0,0 +1,415 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Cached Prefix Configuration.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroprefixcfg.h"
+
+#include <QBitArray>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QThread>
+#include <QTimer>
+
+#define NERO_SETTINGS_CACHE_MAGIC 0x4E534346
+#define NERO_SETTINGS_CACHE_VERSION 1
+
+NeroPrefixCfg::NeroPrefixCfg(const QString &path, const bool &useSidecar)
+{
+    iniPath = path;
+    this->useSidecar = useSidecar;
+
+    QWriteLocker locker(&lock);
+    Load();
+}
+
+NeroPrefixCfg::~NeroPrefixCfg()
+{
+    // last chance to get anything unwritten out to disk
+    Sync();
+}
+
+QString NeroPrefixCfg::GetSidecarPath() const
+{
+    return QFileInfo(iniPath).path() + "/.nero-settings.cache";
+}
+
+void NeroPrefixCfg::Load()
+{
+    // looked at before reading anything, so a write landing in the middle just means another reload later.
+    QFileInfo iniInfo(iniPath);
+    loadedModified = iniInfo.lastModified();
+    loadedSize = iniInfo.exists() ? iniInfo.size() : -1;
+    reloadCount++;
+
+    groups.clear();
+    if(!useSidecar || loadedSize < 0 || !LoadSidecar()) {
+        LoadIni();
+        if(useSidecar && loadedSize >= 0) WriteSidecar();
+    }
+
+    // anything we haven't written out yet still takes priority over what's on disk
+    for(const auto &write : std::as_const(pending))
+        Apply(write);
+}
+
+void NeroPrefixCfg::LoadIni()
+{
+    QSettings ini(iniPath, QSettings::IniFormat);
+    const QStringList keys = ini.allKeys();
+
+    for(const auto &key : keys) {
+        const int split = key.indexOf('/');
+        if(split < 0) Store(groups["General"], "General", key, ini.value(key));
+        else {
+            const QString group = key.left(split);
+            Store(groups[group], group, key.mid(split+1), ini.value(key));
+        }
+    }
+}
+
+bool NeroPrefixCfg::LoadSidecar()
+{
+    QFile sidecar(GetSidecarPath());
+    if(!sidecar.open(QIODevice::ReadOnly)) return false;
+
+    // everything gets copied out as it's read, so there's no point in reading it all in first.
+    uchar *mapped = sidecar.map(0, sidecar.size());
+    if(mapped == nullptr) return false;
+
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), sidecar.size());
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_15);
+    const bool loaded = ReadSidecar(in);
+    sidecar.unmap(mapped);
+
+    if(!loaded) groups.clear();
+    return loaded;
+}
+
+bool NeroPrefixCfg::ReadSidecar(QDataStream &in)
+{
+    quint32 magic = 0, version = 0, schemaVersion = 0;
+    in >> magic >> version;
+    if(magic != NERO_SETTINGS_CACHE_MAGIC || version != NERO_SETTINGS_CACHE_VERSION) return false;
+
+    qint64 iniModified = 0, iniSize = -1;
+    in >> schemaVersion >> iniModified >> iniSize;
+    if(iniModified != loadedModified.toMSecsSinceEpoch() || iniSize != loadedSize) return false;
+
+    QStringList keyNames;
+    quint32 groupCount = 0;
+    in >> keyNames >> groupCount;
+    if(in.status() != QDataStream::Ok) return false;
+
+    // same schema is the same order, so values go straight in.
+    // Anything else gets matched back up by name and checked again.
+    const bool migrate = schemaVersion != NeroSetting::schemaVersion || keyNames.count() != NeroSetting::KeyCount;
+
+    for(quint32 i = 0; i < groupCount && in.status() == QDataStream::Ok; ++i) {
+        QString name;
+        QBitArray present;
+        in >> name >> present;
+        if(present.size() != keyNames.count()) return false;
+
+        Group &group = groups[name];
+        for(int key = 0; key < present.size(); ++key) {
+            if(!present.testBit(key)) continue;
+            QVariant value;
+            in >> value;
+            if(migrate) Store(group, name, keyNames.at(key), value);
+            else group.known[key] = value;
+        }
+
+        QMap<QString, QVariant> other;
+        in >> other;
+        if(migrate) {
+            for(auto iter = other.constBegin(); iter != other.constEnd(); ++iter)
+                Store(group, name, iter.key(), iter.value());
+        } else group.other = other;
+    }
+    if(in.status() != QDataStream::Ok) return false;
+
+    if(migrate) {
+        printf("Carried settings cache for %s over from schema v%u to v%u\n", iniPath.toLocal8Bit().constData(),
+               schemaVersion, NeroSetting::schemaVersion);
+        WriteSidecar();
+    }
+    return true;
+}
+
+void NeroPrefixCfg::WriteSidecar() const
+{
+    QSaveFile sidecar(GetSidecarPath());
+    // i.e. the prefix itself isn't there yet
+    if(!sidecar.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&sidecar);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << (quint32)NERO_SETTINGS_CACHE_MAGIC << (quint32)NERO_SETTINGS_CACHE_VERSION << (quint32)NeroSetting::schemaVersion
+        << loadedModified.toMSecsSinceEpoch() << loadedSize
+        << NeroSetting::GetKeys() << (quint32)groups.count();
+
+    for(auto iter = groups.constBegin(); iter != groups.constEnd(); ++iter) {
+        QBitArray present(NeroSetting::KeyCount);
+        for(int key = 0; key < NeroSetting::KeyCount; ++key)
+            if(iter->known.at(key).isValid()) present.setBit(key);
+
+        out << iter.key() << present;
+        for(int key = 0; key < NeroSetting::KeyCount; ++key)
+            if(present.testBit(key)) out << iter->known.at(key);
+        out << iter->other;
+    }
+
+    if(!sidecar.commit())
+        printf("Couldn't write settings cache for %s\n", iniPath.toLocal8Bit().constData());
+}
+
+void NeroPrefixCfg::Store(Group &group, const QString &groupName, const QString &key, QVariant value)
+{
+    const int index = NeroSetting::Find(key);
+    if(index < 0) group.other.insert(key, value);
+    else if(NeroSetting::Check(static_cast<NeroSetting::Key>(index), value)) group.known[index] = value;
+    // left as-is in the ini for whoever put it there, it's just treated as unset.
+    else printf("Ignoring invalid %s in %s of %s: \"%s\"\n", key.toLocal8Bit().constData(), groupName.toLocal8Bit().constData(),
+                iniPath.toLocal8Bit().constData(), value.toString().toLocal8Bit().constData());
+}
+
+QMap<QString, QVariant> NeroPrefixCfg::Flatten(const Group &group)
+{
+    QMap<QString, QVariant> flat = group.other;
+    for(int key = 0; key < NeroSetting::KeyCount; ++key)
+        if(group.known.at(key).isValid())
+            flat.insert(QString::fromLatin1(NeroSetting::GetKey(static_cast<NeroSetting::Key>(key))), group.known.at(key));
+    return flat;
+}
+
+void NeroPrefixCfg::Apply(const PendingWrite &write)
+{
+    if(write.remove) {
+        if(write.key.isEmpty()) groups.remove(write.group);
+        else if(groups.contains(write.group)) {
+            Group &group = groups[write.group];
+            if(write.index >= 0) group.known[write.index] = QVariant();
+            else group.other.remove(write.key);
+        }
+    } else if(write.index >= 0) groups[write.group].known[write.index] = write.value;
+    else groups[write.group].other[write.key] = write.value;
+}
+
+bool NeroPrefixCfg::ChangedOnDisk() const
+{
+    QFileInfo iniInfo(iniPath);
+    if(!iniInfo.exists()) return loadedSize != -1;
+    else return iniInfo.size() != loadedSize || iniInfo.lastModified() != loadedModified;
+}
+
+QVariant NeroPrefixCfg::Value(const QString &group, const QString &key, const QVariant &defaultValue) const
+{
+    const int index = NeroSetting::Find(key);
+    QReadLocker locker(&lock);
+
+    const auto groupIter = groups.constFind(group);
+    if(groupIter == groups.constEnd()) return defaultValue;
+
+    if(index >= 0) {
+        const QVariant &value = groupIter->known.at(index);
+        return value.isValid() ? value : defaultValue;
+    }
+
+    const auto keyIter = groupIter->other.constFind(key);
+    if(keyIter == groupIter->other.constEnd()) return defaultValue;
+    else return keyIter.value();
+}
+
+QVariant NeroPrefixCfg::Value(const QString &path) const
+{
+    const int split = path.indexOf('/');
+    if(split < 0) return Value("General", path);
+    else return Value(path.left(split), path.mid(split+1));
+}
+
+QVariant NeroPrefixCfg::Value(const QString &group, const NeroSetting::Key &key) const
+{
+    QReadLocker locker(&lock);
+
+    const auto groupIter = groups.constFind(group);
+    if(groupIter == groups.constEnd()) return QVariant();
+    else return groupIter->known.at(key);
+}
+
+QVariant NeroPrefixCfg::ValueOrDefault(const QString &group, const NeroSetting::Key &key) const
+{
+    // blank is "use the prefix's" for shortcuts, so it goes to the default all the same
+    const QVariant value = Value(group, key);
+    if(!value.isValid() || (value.userType() == QMetaType::QString && value.toString().isEmpty()))
+        return NeroSetting::GetDefault(key);
+    else return value;
+}
+
+bool NeroPrefixCfg::Contains(const QString &group, const QString &key) const
+{
+    const int index = NeroSetting::Find(key);
+    QReadLocker locker(&lock);
+
+    const auto groupIter = groups.constFind(group);
+    if(groupIter == groups.constEnd()) return false;
+    else if(index >= 0) return groupIter->known.at(index).isValid();
+    else return groupIter->other.contains(key);
+}
+
+bool NeroPrefixCfg::Contains(const QString &group, const NeroSetting::Key &key) const
+{
+    return Value(group, key).isValid();
+}
+
+QStringList NeroPrefixCfg::ChildKeys(const QString &group) const
+{
+    QReadLocker locker(&lock);
+
+    const auto groupIter = groups.constFind(group);
+    if(groupIter == groups.constEnd()) return QStringList();
+    else return Flatten(*groupIter).keys();
+}
+
+QMap<QString, QVariant> NeroPrefixCfg::GetGroup(const QString &group) const
+{
+    QReadLocker locker(&lock);
+
+    const auto groupIter = groups.constFind(group);
+    if(groupIter == groups.constEnd()) return QMap<QString, QVariant>();
+    else return Flatten(*groupIter);
+}
+
+void NeroPrefixCfg::SetValue(const QString &group, const QString &key, const QVariant &value)
+{
+    const int index = NeroSetting::Find(key);
+    QVariant checked = value;
+    if(index >= 0 && !NeroSetting::Check(static_cast<NeroSetting::Key>(index), checked)) {
+        printf("Not setting %s in %s to invalid value \"%s\"\n", key.toLocal8Bit().constData(), group.toLocal8Bit().constData(),
+               value.toString().toLocal8Bit().constData());
+        return;
+    }
+
+    {
+        QWriteLocker locker(&lock);
+        pending.append({ group, key, index, checked, false });
+        Apply(pending.last());
+    }
+    ScheduleSync();
+}
+
+void NeroPrefixCfg::Remove(const QString &group, const QString &key)
+{
+    {
+        QWriteLocker locker(&lock);
+        pending.append({ group, key, key.isEmpty() ? -1 : NeroSetting::Find(key), QVariant(), true });
+        Apply(pending.last());
+    }
+    ScheduleSync();
+}
+
+void NeroPrefixCfg::ScheduleSync()
+{
+    {
+        QWriteLocker locker(&lock);
+        if(syncScheduled) return;
+        syncScheduled = true;
+    }
+
+    // batch everything set within the same event loop pass into one write,
+    // unless there's no event loop to come back to (i.e. CLI runs).
+    if(QCoreApplication::instance() != nullptr && QThread::currentThread() == thread())
+        QTimer::singleShot(0, this, [this]() { Sync(); });
+    else Sync();
+}
+
+bool NeroPrefixCfg::ReloadIfChanged()
+{
+    QWriteLocker locker(&lock);
+
+    if(ChangedOnDisk()) {
+        Load();
+        return true;
+    } else return false;
+}
+
+bool NeroPrefixCfg::Sync()
+{
+    QWriteLocker locker(&lock);
+    syncScheduled = false;
+
+    if(pending.isEmpty()) return true;
+
+    // if someone else wrote to the file since we last looked, QSettings will merge our changes on top of theirs;
+    // we just need to pick up their side of it afterwards.
+    const bool externallyChanged = ChangedOnDisk();
+
+    QSettings ini(iniPath, QSettings::IniFormat);
+    for(const auto &write : std::as_const(pending)) {
+        if(write.remove) {
+            ini.beginGroup(write.group);
+            ini.remove(write.key);
+            ini.endGroup();
+        } else ini.setValue(write.group + '/' + write.key, write.value);
+    }
+    ini.sync();
+
+    if(ini.status() != QSettings::NoError) {
+        printf("ERROR: Failed to write settings to %s! Keeping changes in memory for now.\n", iniPath.toLocal8Bit().constData());
+        return false;
+    }
+
+    pending.clear();
+
+    // the sidecar goes stale along with the ini's mtime, and is redone from whatever parses it next.
+    if(externallyChanged) Load();
+    else {
+        QFileInfo iniInfo(iniPath);
+        loadedModified = iniInfo.lastModified();
+        loadedSize = iniInfo.size();
+    }
+
+    return true;
+}
+
+void NeroPrefixCfg::Discard()
+{
+    QWriteLocker locker(&lock);
+    pending.clear();
+}
+
+bool NeroPrefixCfg::IsDirty() const
+{
+    QReadLocker locker(&lock);
+    return !pending.isEmpty();
+}
+
+QDateTime NeroPrefixCfg::GetLastModified() const
+{
+    QReadLocker locker(&lock);
+    return loadedModified;
+}
+
+qint64 NeroPrefixCfg::GetFileSize() const
+{
+    QReadLocker locker(&lock);
+    return loadedSize;
+}
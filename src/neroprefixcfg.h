@@ -0,0 +1,140 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Cached Prefix Configuration.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROPREFIXCFG_H
+#define NEROPREFIXCFG_H
+
+#include "nerosettings.h"
+
+#include <QObject>
+#include <QDataStream>
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QReadWriteLock>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+// In-memory copy of a prefix's nero-settings.ini.
+// The file is parsed once, and only re-read if its mtime/size changes underneath us
+// (e.g. a CLI instance or hand edit touched it while the manager was open).
+// Writes land in memory first and are flushed as one batch once control returns to the event loop.
+// Settings the schema (see NeroSetting) knows about are kept per group in a flat array, checked once as they're loaded.
+// With useSidecar, a binary copy of what was parsed is kept next to the ini as .nero-settings.cache
+// and read instead of the ini for as long as the ini's mtime/size still match it - the ini stays the one to edit.
+class NeroPrefixCfg : public QObject
+{
+public:
+    NeroPrefixCfg(const QString &, const bool &useSidecar = true);
+    ~NeroPrefixCfg();
+
+    // METHODS
+    QVariant Value(const QString &group, const QString &key, const QVariant &defaultValue = QVariant()) const;
+    // "Group/Key" lookup, same as what QSettings::value() would take.
+    QVariant Value(const QString &) const;
+
+    bool GetBool(const QString &group, const QString &key, const bool defaultValue = false) const
+        { return Value(group, key, defaultValue).toBool(); }
+    int GetInt(const QString &group, const QString &key, const int defaultValue = 0) const
+        { return Value(group, key, defaultValue).toInt(); }
+    QString GetString(const QString &group, const QString &key, const QString &defaultValue = "") const
+        { return Value(group, key, defaultValue).toString(); }
+    QStringList GetStringList(const QString &group, const QString &key) const
+        { return Value(group, key).toStringList(); }
+
+    // schema settings straight out of the array; Value() is invalid if unset, the getters fall back to the schema's default.
+    QVariant Value(const QString &group, const NeroSetting::Key &) const;
+    bool GetBool(const QString &group, const NeroSetting::Key &key) const
+        { return ValueOrDefault(group, key).toBool(); }
+    int GetInt(const QString &group, const NeroSetting::Key &key) const
+        { return ValueOrDefault(group, key).toInt(); }
+    QString GetString(const QString &group, const NeroSetting::Key &key) const
+        { return ValueOrDefault(group, key).toString(); }
+    QStringList GetStringList(const QString &group, const NeroSetting::Key &key) const
+        { return ValueOrDefault(group, key).toStringList(); }
+
+    bool Contains(const QString &, const QString &) const;
+    bool Contains(const QString &, const NeroSetting::Key &) const;
+    QStringList ChildKeys(const QString &) const;
+    QMap<QString, QVariant> GetGroup(const QString &) const;
+
+    // schema settings are checked first, and invalid values are refused rather than written out.
+    void SetValue(const QString &, const QString &, const QVariant &);
+    // empty key removes the whole group, same as QSettings.
+    void Remove(const QString &, const QString & = "");
+
+    bool ReloadIfChanged();
+    bool Sync();
+    void Discard();
+
+    bool IsDirty() const;
+    QString GetPath() const { return iniPath; }
+    QString GetSidecarPath() const;
+    QDateTime GetLastModified() const;
+    qint64 GetFileSize() const;
+    unsigned int GetReloadCount() const { return reloadCount; }
+
+private:
+    struct Group {
+        // indexed by NeroSetting::Key, invalid where unset
+        QVector<QVariant> known = QVector<QVariant>(NeroSetting::KeyCount);
+        // anything the schema doesn't cover, i.e. the Shortcuts list itself
+        QMap<QString, QVariant> other;
+    };
+
+    struct PendingWrite {
+        QString group;
+        QString key;
+        // into the schema, or -1
+        int index;
+        QVariant value;
+        bool remove;
+    };
+
+    QVariant ValueOrDefault(const QString &group, const NeroSetting::Key &) const;
+
+    // these expect the caller to already be holding the lock
+    void Load();
+    void LoadIni();
+    bool LoadSidecar();
+    bool ReadSidecar(QDataStream &);
+    void WriteSidecar() const;
+    void Store(Group &, const QString &group, const QString &key, QVariant value);
+    static QMap<QString, QVariant> Flatten(const Group &);
+    void Apply(const PendingWrite &);
+    bool ChangedOnDisk() const;
+    void ScheduleSync();
+
+    // VARS
+    QString iniPath;
+    bool useSidecar;
+    QHash<QString, Group> groups;
+    QList<PendingWrite> pending;
+
+    QDateTime loadedModified;
+    qint64 loadedSize = -1;
+    unsigned int reloadCount = 0;
+    bool syncScheduled = false;
+
+    mutable QReadWriteLock lock;
+};
+
+#endif // NEROPREFIXCFG_H
@@ -0,0 +1,267 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Prefixes Catalogue.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroprefixindex.h"
+#include "nerofs.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QPointer>
+#include <QSettings>
+#include <QThreadPool>
+
+#include <algorithm>
+
+NeroPrefixIndex *NeroPrefixIndex::Get()
+{
+    static QPointer<NeroPrefixIndex> instance;
+    if(instance.isNull()) instance = new NeroPrefixIndex(QCoreApplication::instance());
+    return instance;
+}
+
+NeroPrefixIndex::NeroPrefixIndex(QObject *parent) : QObject(parent), watcher(this), validateTimer(this)
+{
+    home = NeroFS::GetPrefixesPath()->path();
+
+    validateTimer.setSingleShot(true);
+    validateTimer.setInterval(500);
+    connect(&validateTimer, &QTimer::timeout, this, &NeroPrefixIndex::Validate);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, &validateTimer, QOverload<>::of(&QTimer::start));
+
+    Load();
+    if(homeModified < 0) {
+        // nothing to go off of yet, so this first one has to be done the slow way.
+        entries = Scan(home, -1, {}, homeModified);
+        Save();
+    } else {
+        // otherwise, trust what we have until the event loop's free to double check it.
+        QTimer::singleShot(0, this, &NeroPrefixIndex::Validate);
+    }
+
+    if(QFileInfo::exists(home)) watcher.addPath(home);
+}
+
+QStringList NeroPrefixIndex::GetNames() const
+{
+    QStringList names = entries.keys();
+    std::sort(names.begin(), names.end(), [](const QString &a, const QString &b) {
+        return a.compare(b, Qt::CaseInsensitive) < 0;
+    });
+    return names;
+}
+
+void NeroPrefixIndex::Add(const QString &name, const QString &runner)
+{
+    NeroPrefixEntry entry;
+    entry.name = name;
+    entry.runner = runner;
+    entries.insert(name, entry);
+
+    if(validating) validateAgain = true;
+    Save();
+    emit PrefixesChanged();
+}
+
+void NeroPrefixIndex::Remove(const QString &name)
+{
+    if(!entries.remove(name)) return;
+
+    if(validating) validateAgain = true;
+    Save();
+    emit PrefixesChanged();
+}
+
+void NeroPrefixIndex::Update(const QString &name, const QString &runner, const int &shortcuts)
+{
+    if(!entries.contains(name)) return;
+
+    NeroPrefixEntry &entry = entries[name];
+    if(entry.runner == runner && entry.shortcuts == shortcuts) return;
+    entry.runner = runner;
+    entry.shortcuts = shortcuts;
+
+    Save();
+    emit PrefixesChanged();
+}
+
+void NeroPrefixIndex::SetLastPlayed(const QString &name)
+{
+    if(!entries.contains(name)) return;
+
+    entries[name].lastPlayed = QDateTime::currentMSecsSinceEpoch();
+    Save();
+    emit PrefixesChanged();
+}
+
+void NeroPrefixIndex::Validate()
+{
+    if(validating) {
+        validateAgain = true;
+        return;
+    }
+    validating = true;
+
+    const QString scanHome = home;
+    const qint64 knownModified = homeModified;
+    const QMap<QString, NeroPrefixEntry> known = entries;
+    QPointer<NeroPrefixIndex> receiver(this);
+
+    // stats on a network home can take a while, so none of this happens on the GUI thread.
+    QThreadPool::globalInstance()->start([=]() {
+        qint64 scannedModified = -1;
+        const QMap<QString, NeroPrefixEntry> scanned = Scan(scanHome, knownModified, known, scannedModified);
+
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [=]() {
+            if(!receiver.isNull()) receiver->ApplyScan(scanned, scannedModified);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QMap<QString, NeroPrefixEntry> NeroPrefixIndex::Scan(const QString &home, const qint64 &knownModified,
+                                                     const QMap<QString, NeroPrefixEntry> &known, qint64 &homeModified)
+{
+    const QFileInfo homeInfo(home);
+    homeModified = homeInfo.isDir() ? homeInfo.lastModified().toMSecsSinceEpoch() : -1;
+
+    // the home dir only needs listing again if a prefix was actually added/removed/renamed
+    QStringList names;
+    if(knownModified >= 0 && homeModified == knownModified) names = known.keys();
+    else if(homeModified >= 0) names = QDir(home).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    QMap<QString, NeroPrefixEntry> scanned;
+    for(const auto &name : std::as_const(names)) {
+        const QFileInfo iniInfo(home + '/' + name + "/nero-settings.ini");
+        // should we do ACTUAL ini verification? Or just checking to make sure it exists?
+        if(!iniInfo.exists()) continue;
+
+        NeroPrefixEntry entry = known.value(name);
+        entry.name = name;
+
+        const qint64 iniModified = iniInfo.lastModified().toMSecsSinceEpoch();
+        if(entry.iniModified != iniModified || entry.iniSize != iniInfo.size()) {
+            QSettings ini(iniInfo.filePath(), QSettings::IniFormat);
+            entry.runner = ini.value("PrefixSettings/CurrentRunner").toString();
+            ini.beginGroup("Shortcuts");
+            entry.shortcuts = ini.childKeys().count();
+            ini.endGroup();
+            entry.iniModified = iniModified;
+            entry.iniSize = iniInfo.size();
+        }
+
+        scanned.insert(name, entry);
+    }
+
+    return scanned;
+}
+
+void NeroPrefixIndex::ApplyScan(const QMap<QString, NeroPrefixEntry> &scanned, const qint64 &scannedModified)
+{
+    validating = false;
+
+    if(validateAgain) {
+        // prefixes were added or removed while that was running, so it's already out of date.
+        validateAgain = false;
+        Validate();
+        return;
+    }
+
+    QMap<QString, NeroPrefixEntry> merged = scanned;
+    for(auto i = merged.begin(); i != merged.end(); ++i) {
+        if(!entries.contains(i.key())) continue;
+        const NeroPrefixEntry &current = entries[i.key()];
+        i.value().lastPlayed = qMax(i.value().lastPlayed, current.lastPlayed);
+        // ini wasn't reread, so whatever Nero itself set in the meantime is newer
+        if(i.value().iniModified == current.iniModified && i.value().iniSize == current.iniSize) {
+            i.value().runner = current.runner;
+            i.value().shortcuts = current.shortcuts;
+        }
+    }
+
+    bool changed = merged.keys() != entries.keys();
+    if(!changed) {
+        for(auto i = merged.constBegin(); i != merged.constEnd(); ++i) {
+            const NeroPrefixEntry &current = entries[i.key()];
+            if(current.runner != i.value().runner || current.shortcuts != i.value().shortcuts) {
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    entries = merged;
+    homeModified = scannedModified;
+    Save();
+
+    if(!watcher.directories().contains(home) && QFileInfo::exists(home)) watcher.addPath(home);
+    if(changed) emit PrefixesChanged();
+}
+
+void NeroPrefixIndex::Load()
+{
+    QSettings *cfg = NeroFS::GetManagerCfg();
+    cfg->beginGroup("PrefixIndex");
+
+    // index is for a different home dir - useless to us
+    if(cfg->value("Home").toString() == home) {
+        homeModified = cfg->value("HomeModified", -1).toLongLong();
+
+        const int count = cfg->beginReadArray("Prefixes");
+        for(int i = 0; i < count; ++i) {
+            cfg->setArrayIndex(i);
+            NeroPrefixEntry entry;
+            entry.name = cfg->value("Name").toString();
+            entry.runner = cfg->value("Runner").toString();
+            entry.shortcuts = cfg->value("Shortcuts").toInt();
+            entry.lastPlayed = cfg->value("LastPlayed").toLongLong();
+            entry.iniModified = cfg->value("IniModified").toLongLong();
+            entry.iniSize = cfg->value("IniSize", -1).toLongLong();
+            if(!entry.name.isEmpty()) entries.insert(entry.name, entry);
+        }
+        cfg->endArray();
+    }
+
+    cfg->endGroup();
+}
+
+void NeroPrefixIndex::Save()
+{
+    QSettings *cfg = NeroFS::GetManagerCfg();
+    cfg->beginGroup("PrefixIndex");
+    cfg->remove("");
+
+    cfg->setValue("Home", home);
+    cfg->setValue("HomeModified", homeModified);
+
+    cfg->beginWriteArray("Prefixes", entries.count());
+    int i = 0;
+    for(const auto &entry : std::as_const(entries)) {
+        cfg->setArrayIndex(i++);
+        cfg->setValue("Name", entry.name);
+        cfg->setValue("Runner", entry.runner);
+        cfg->setValue("Shortcuts", entry.shortcuts);
+        cfg->setValue("LastPlayed", entry.lastPlayed);
+        cfg->setValue("IniModified", entry.iniModified);
+        cfg->setValue("IniSize", entry.iniSize);
+    }
+    cfg->endArray();
+
+    cfg->endGroup();
+}
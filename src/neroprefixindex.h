@@ -0,0 +1,90 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Prefixes Catalogue.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROPREFIXINDEX_H
+#define NEROPREFIXINDEX_H
+
+#include <QFileSystemWatcher>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+struct NeroPrefixEntry
+{
+    QString name;
+    QString runner;
+    int shortcuts = 0;
+    qint64 lastPlayed = 0;
+    // what nero-settings.ini looked like when runner/shortcuts were last read from it
+    qint64 iniModified = 0;
+    qint64 iniSize = -1;
+};
+
+// A small index of every prefix in the Nero home directory, kept in the manager config (PrefixIndex),
+// so the prefixes list renders without touching the home dir at all - which matters when it's on NFS.
+// Nero's own changes go straight into the index as they happen. Anything else (other instances, file managers)
+// is picked up by a background check after startup, and whenever the watcher sees the home dir change.
+// GUI thread only.
+class NeroPrefixIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static NeroPrefixIndex *Get();
+
+    // METHODS
+    // sorted the same way the home dir used to be listed (by name, ignoring case).
+    QStringList GetNames() const;
+    NeroPrefixEntry Find(const QString &name) const { return entries.value(name); }
+    bool Contains(const QString &name) const { return entries.contains(name); }
+
+    void Add(const QString &name, const QString &runner);
+    void Remove(const QString &name);
+    void Update(const QString &name, const QString &runner, const int &shortcuts);
+    void SetLastPlayed(const QString &name);
+
+public slots:
+    // checks the index against the home dir off the GUI thread.
+    void Validate();
+
+signals:
+    void PrefixesChanged();
+
+private:
+    explicit NeroPrefixIndex(QObject *parent);
+
+    static QMap<QString, NeroPrefixEntry> Scan(const QString &home, const qint64 &knownModified,
+                                               const QMap<QString, NeroPrefixEntry> &known, qint64 &homeModified);
+    void ApplyScan(const QMap<QString, NeroPrefixEntry> &scanned, const qint64 &homeModified);
+    void Load();
+    void Save();
+
+    QString home;
+    qint64 homeModified = -1;
+    QMap<QString, NeroPrefixEntry> entries;
+
+    QFileSystemWatcher watcher;
+    QTimer validateTimer;
+    bool validating = false;
+    bool validateAgain = false;
+};
+
+#endif // NEROPREFIXINDEX_H
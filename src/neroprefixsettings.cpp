@@ -20,15 +20,22 @@
 #include "neroprefixsettings.h"
 #include "ui_neroprefixsettings.h"
 #include "neroconstants.h"
+#include "nerodownloader.h"
 #include "nerodrives.h"
 #include "nerofs.h"
 #include "neroico.h"
+#include "neroiconcache.h"
+#include "neroregistry.h"
+#include "nerorunnerindex.h"
+#include "neroshadercache.h"
+#include "nerotimings.h"
 
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QAction>
+#include <QFileInfo>
 #include <QProcess>
 #include <QSpinBox>
+#include <QSaveFile>
+#include <QSignalBlocker>
 #include <QShortcut>
 
 #include "../lib/quazip/quazip/quazip.h"
@@ -53,6 +60,19 @@ NeroPrefixSettingsWindow::NeroPrefixSettingsWindow(QWidget *parent, const QStrin
     // prefix runner box is used to govern availability of scaling options in both prefix and shortcut settings
     ui->prefixRunner->addItems(*NeroFS::GetAvailableProtons());
     ui->prefixRunner->setCurrentText(NeroFS::GetCurrentRunner());
+    // runners can come and go while this is open (e.g. one that just finished extracting)
+    connect(NeroRunnerIndex::Get(), &NeroRunnerIndex::RunnersChanged, this, [this]() {
+        const QString current = ui->prefixRunner->currentText();
+        {
+            const QSignalBlocker blocker(ui->prefixRunner);
+            ui->prefixRunner->clear();
+            ui->prefixRunner->addItems(*NeroFS::GetAvailableProtons());
+            ui->prefixRunner->setCurrentIndex(-1);
+        }
+        // through the usual signal, so a runner that vanished shows up as a change
+        const int index = ui->prefixRunner->findText(current);
+        ui->prefixRunner->setCurrentIndex(index >= 0 ? index : 0);
+    });
 
     if(shortcutHash.isEmpty()) {
         settings = NeroFS::GetCurrentPrefixSettings();
@@ -62,12 +82,18 @@ NeroPrefixSettingsWindow::NeroPrefixSettingsWindow(QWidget *parent, const QStrin
         ui->windowsVerSection->setVisible(false);
         ui->runnerGroup->setVisible(false);
         ui->fpsBox->setVisible(false);
+        ui->launchTimingsGroup->setVisible(false);
 
         if(settings.value("DiscordRPCinstalled").toBool()) {
             ui->prefixInstallDiscordRPC->setEnabled(false);
             ui->prefixInstallDiscordRPC->setText("Discord RPC Service Already Installed");
         }
 
+        refreshIcons = new QPushButton(QIcon::fromTheme("view-refresh"), "Refresh All Icons");
+        refreshIcons->setToolTip("Re-extract the icon of every shortcut in this prefix from its executable.");
+        ui->buttonBox->addButton(refreshIcons, QDialogButtonBox::ResetRole);
+        connect(refreshIcons, &QPushButton::clicked, this, &NeroPrefixSettingsWindow::refreshIconsRequested);
+
         this->setWindowTitle("Prefix Settings");
     } else {
         currentShortcutHash = shortcutHash;
@@ -80,6 +106,8 @@ NeroPrefixSettingsWindow::NeroPrefixSettingsWindow(QWidget *parent, const QStrin
         ui->prefixServices->setVisible(false);
         ui->nameMatchWarning->setVisible(false);
 
+        LoadLaunchTimings();
+
         deleteShortcut = new QPushButton(QIcon::fromTheme("edit-delete"), "Delete Shortcut");
         ui->buttonBox->addButton(deleteShortcut, QDialogButtonBox::ResetRole);
         connect(deleteShortcut, &QPushButton::clicked, this, &NeroPrefixSettingsWindow::deleteShortcut_clicked);
@@ -102,8 +130,10 @@ NeroPrefixSettingsWindow::NeroPrefixSettingsWindow(QWidget *parent, const QStrin
             winVersionListBackwards.append(ui->winVerBox->itemText(i-1));
     }
 
+    const NeroRunnerVersion runnerVersion = NeroRunnerIndex::Get()->Find(ui->prefixRunner->currentText()).version;
+
     // FSR scalers are only implem'd in GE-Proton
-    if(!ui->prefixRunner->currentText().startsWith("GE-Proton")) {
+    if(runnerVersion.flavor != NeroRunnerVersion::GE) {
         SetComboBoxItemEnabled(ui->setScalingBox, NeroConstant::ScalingFSRperformance, false);
         SetComboBoxItemEnabled(ui->setScalingBox, NeroConstant::ScalingFSRbalanced, false);
         SetComboBoxItemEnabled(ui->setScalingBox, NeroConstant::ScalingFSRquality, false);
@@ -117,7 +147,7 @@ NeroPrefixSettingsWindow::NeroPrefixSettingsWindow(QWidget *parent, const QStrin
     }
 
     // Wayland requires base version to be Proton 10+
-    if(!ui->prefixRunner->currentText().startsWith("GE-Proton10") && !ui->prefixRunner->currentText().startsWith("Proton 10")) {
+    if(!runnerVersion.IsAtLeast(10)) {
         ui->toggleWayland->setEnabled(false);
         ui->toggleWaylandHDR->setEnabled(false);
     }
@@ -250,6 +280,11 @@ void NeroPrefixSettingsWindow::LoadSettings()
     SetCheckboxState("UseHDR",             ui->toggleWaylandHDR);
     SetCheckboxState("AllowHidraw",        ui->toggleHidraw);
     SetCheckboxState("UseXalia",           ui->toggleXalia);
+    // advanced tab->scheduling group
+    ui->cpuSetBox->setCurrentIndex(settings.value("CpuSet").toInt());
+    ui->processPriorityBox->setCurrentIndex(settings.value("ProcessPriority").toInt());
+    ui->ioPriorityBox->setCurrentIndex(settings.value("IoPriority").toInt());
+    SetCheckboxState("ElevateScheduling", ui->toggleElevateScheduling);
 
     if(currentShortcutHash.isEmpty()) {
         // for prefix general settings, checkboxes are normal two-state
@@ -261,6 +296,7 @@ void NeroPrefixSettingsWindow::LoadSettings()
         else ui->prefixRunner->setCurrentIndex(0),
              ui->prefixRunner->setFont(boldFont);
         ui->togglePrefixRuntimeUpdates->setChecked(settings.value("RuntimeUpdateOnLaunch").toBool());
+        ui->toggleWarmPrefix->setChecked(settings.value("WarmPrefix").toBool());
 
         // advanced tab
         //ui->prefixEnvVars->setText(settings.value("CustomEnvVars").toString());
@@ -276,6 +312,7 @@ void NeroPrefixSettingsWindow::LoadSettings()
         ui->postRunScriptPath->setText(settings.value("PostRunScript").toString());
         if(ui->preRunScriptPath->text().isEmpty())  ui->preRunClearBtn->setVisible(false);
         if(ui->postRunScriptPath->text().isEmpty()) ui->postRunClearBtn->setVisible(false);
+        SetCheckboxState("PreRunInBackground", ui->togglePreRunBackground);
 
         if(QFileInfo::exists(settings["Path"].toString().replace("C:/",
                                                                  NeroFS::GetPrefixesPath()->canonicalPath()+'/'+NeroFS::GetCurrentPrefix()+"/drive_c/")))
@@ -289,21 +326,12 @@ void NeroPrefixSettingsWindow::LoadSettings()
                 ui->shortcutPath->setStyleSheet("color: red");
         }
 
-        QDir ico(NeroFS::GetPrefixesPath()->path()+'/'+NeroFS::GetCurrentPrefix()+"/.icoCache");
-        if(ico.exists(settings["Name"].toString()+'-'+currentShortcutHash+".png")) {
-            if(QPixmap(ico.path()+'/'+settings["Name"].toString()+'-'+currentShortcutHash+".png").height() < 64)
-                ui->shortcutIco->setIcon(QPixmap(ico.path()+'/'+
-                                                 settings["Name"].toString()+'-'+
-                                                 currentShortcutHash+".png")
-                                                .scaled(64,64, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-            else ui->shortcutIco->setIcon(QPixmap(ico.path()+'/'+
-                                                  settings["Name"].toString()+'-'+
-                                                  currentShortcutHash+".png"));
-        }
+        const QIcon shortcutIcon = NeroIconCache::GetIcon(NeroFS::GetPrefixesPath()->path()+'/'+NeroFS::GetCurrentPrefix(),
+                                                          settings.value("IconKey").toString());
+        if(!shortcutIcon.isNull())
+            ui->shortcutIco->setIcon(shortcutIcon);
         this->setWindowTitle("Shortcut Settings");
-        this->setWindowIcon(QPixmap(ico.path()+'/'+
-                                    settings["Name"].toString()+'-'+
-                                    currentShortcutHash+".png"));
+        this->setWindowIcon(shortcutIcon);
 
         ui->limitFPSbox->setValue(settings.value("LimitFPS").toInt());
 
@@ -377,16 +405,17 @@ void NeroPrefixSettingsWindow::on_shortcutIco_clicked()
         "Windows Executable, Dynamic Link Library, Icon Resource File, or Portable Network Graphics File (*.dll *.exe *.ico *.png);;Windows Dynamic Link Library (*.dll);;Windows Executable (*.exe);;Windows Icon Resource (*.ico);;Portable Network Graphics File (*.png)");
 
     if(!newIcon.isEmpty()) {
-        QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-        newIcon = NeroIcoExtractor::GetIcon(newIcon);
-        QGuiApplication::restoreOverrideCursor();
+        const unsigned int request = ++iconRequests;
+        NeroIcoExtractor::GetIconImageAsync(newIcon, this, [this, newIcon, request](const QImage &icon) {
+            // something else was picked while this one was still decoding
+            if(request != iconRequests || icon.isNull()) return;
 
-        if(!newIcon.isEmpty()) {
             newAppIcon = newIcon;
-            if(QPixmap(newAppIcon).height() < 64)
-                ui->shortcutIco->setIcon(QPixmap(newAppIcon).scaled(64,64,Qt::KeepAspectRatio,Qt::SmoothTransformation));
-            else ui->shortcutIco->setIcon(QPixmap(newAppIcon));
-        }
+            newAppIconImage = icon;
+            if(icon.height() < 64)
+                ui->shortcutIco->setIcon(QPixmap::fromImage(icon.scaled(64,64,Qt::KeepAspectRatio,Qt::SmoothTransformation)));
+            else ui->shortcutIco->setIcon(QPixmap::fromImage(icon));
+        });
     }
 }
 
@@ -602,14 +631,7 @@ void NeroPrefixSettingsWindow::on_postRunClearBtn_clicked()
 
 void NeroPrefixSettingsWindow::on_prefixInstallDiscordRPC_clicked()
 {
-    QDir tmpDir(QDir::temp());
-    if(!tmpDir.exists("nero-manager"))
-        tmpDir.mkdir("nero-manager");
-
-    QNetworkAccessManager* manager = new QNetworkAccessManager();
-    QUrl url("https://github.com/EnderIce2/rpc-bridge/releases/latest/download/bridge.zip");
-    QNetworkRequest req(url);
-    QNetworkReply* reply = manager->get(req);
+    const QUrl url("https://github.com/EnderIce2/rpc-bridge/releases/latest/download/bridge.zip");
 
     NeroPrefixSettingsWindow::blockSignals(true);
     umuRunning = true;
@@ -617,12 +639,25 @@ void NeroPrefixSettingsWindow::on_prefixInstallDiscordRPC_clicked()
     ui->infoBox->setTitle("Downloading Discord RPC Bridge...");
     ui->infoText->setText("");
 
-    do {
-        QApplication::processEvents();
-    } while (!reply->isFinished());
+    const QMetaObject::Connection progress = connect(NeroDownloader::Get(), &NeroDownloader::Progress, this,
+                                                     [this, url](const QUrl &from, const qint64 &received, const qint64 &total) {
+        if(from != url) return;
+        if(total > 0)
+            ui->infoText->setText(QString("%1 / %2 KiB").arg(received / 1024).arg(total / 1024));
+        else ui->infoText->setText(QString("%1 KiB").arg(received / 1024));
+    });
+
+    // the zip's shared by every prefix, so this is only an actual download the first time (or once a new release is out).
+    NeroDownloader::Get()->Fetch(url, this, [this, progress](const QString &zipPath, const QString &error) {
+        disconnect(progress);
+        InstallDiscordRPC(zipPath, error);
+    });
+}
 
-    if(reply->error() != QNetworkReply::NoError) {
-        QString errorReply = "Error Message: " + reply->errorString();
+void NeroPrefixSettingsWindow::InstallDiscordRPC(const QString &zipPath, const QString &error)
+{
+    if(zipPath.isEmpty()) {
+        QString errorReply = "Error Message: " + error;
         QString failedDownload = "Nero failed to download the Discord RPC Bridge.\n" + errorReply;
         QMessageBox::warning(this,
                              "Error!",
@@ -630,32 +665,43 @@ void NeroPrefixSettingsWindow::on_prefixInstallDiscordRPC_clicked()
         ui->infoBox->setTitle("");
         ui->infoText->setText(failedDownload);
         enableWidgets(true);
+        umuRunning = false;
+        NeroPrefixSettingsWindow::blockSignals(false);
         return; //failed to download, return here
     }
 
-    QByteArray bytes = reply->readAll();
-    QString path(tmpDir.path() + "/nero-manager/bridge.zip");
-    QSaveFile bridgeZip = QSaveFile(path);
-    bridgeZip.open(QIODevice::WriteOnly);
-    QDataStream zipStream(&bridgeZip);
-    zipStream << bytes;
-    bridgeZip.commit();
-    printf("Extracting bridge.zip...\n");
-    ui->infoBox->setTitle("Extracting bridge package...");
-
-    // QuaZip is like minizip, except it actually works here.
-    QuaZip zipFile(tmpDir.absoluteFilePath("nero-manager/bridge.zip"));
-    zipFile.open(QuaZip::mdUnzip);
-    zipFile.setCurrentFile("bridge.exe");
-    QuaZipFile exeToExtract(&zipFile);
-
-    if(exeToExtract.open(QIODevice::ReadOnly)) {
-        QFile outFile(tmpDir.absoluteFilePath("nero-manager/bridge.exe"));
-        outFile.open(QIODevice::ReadWrite);
-        outFile.write(exeToExtract.readAll());
-        outFile.close();
-
-        StartUmu(tmpDir.absoluteFilePath("nero-manager/bridge.exe"), { "--install" });
+    // extracted next to the cached zip, and only again once the zip's been updated
+    const QString exePath = zipPath + ".bridge.exe";
+    const QFileInfo exeInfo(exePath);
+    bool extracted = exeInfo.exists() && exeInfo.lastModified() >= QFileInfo(zipPath).lastModified();
+    QString extractError;
+
+    if(!extracted) {
+        printf("Extracting bridge.zip...\n");
+        ui->infoBox->setTitle("Extracting bridge package...");
+
+        // QuaZip is like minizip, except it actually works here.
+        QuaZip zipFile(zipPath);
+        zipFile.open(QuaZip::mdUnzip);
+        zipFile.setCurrentFile("bridge.exe");
+        QuaZipFile exeToExtract(&zipFile);
+
+        if(exeToExtract.open(QIODevice::ReadOnly)) {
+            QSaveFile outFile(exePath);
+            if(outFile.open(QIODevice::WriteOnly)) {
+                // chunked, rather than the whole exe in memory at once
+                QByteArray buffer(64 * 1024, Qt::Uninitialized);
+                qint64 readBytes;
+                while((readBytes = exeToExtract.read(buffer.data(), buffer.size())) > 0)
+                    outFile.write(buffer.constData(), readBytes);
+                extracted = readBytes == 0 && outFile.commit();
+            }
+            if(!extracted) extractError = "Couldn't write the extracted bridge.";
+        } else extractError = exeToExtract.errorString();
+    }
+
+    if(extracted) {
+        StartUmu(exePath, { "--install" });
 
         ui->prefixInstallDiscordRPC->setEnabled(false);
         ui->prefixInstallDiscordRPC->setText("Discord RPC Service Already Installed");
@@ -664,11 +710,11 @@ void NeroPrefixSettingsWindow::on_prefixInstallDiscordRPC_clicked()
     } else {
         QMessageBox::warning(this,
                              "Error!",
-                             QString("Bridge extraction exited with the error:\n\n%1").arg(exeToExtract.errorString()));
+                             QString("Bridge extraction exited with the error:\n\n%1").arg(extractError));
         ui->infoBox->setTitle("");
-        ui->infoText->setText(QString("Bridge extraction exited with the error: %1").arg(exeToExtract.errorString()));
+        ui->infoText->setText(QString("Bridge extraction exited with the error: %1").arg(extractError));
     }
-    
+
     enableWidgets(true);
     umuRunning = false;
     NeroPrefixSettingsWindow::blockSignals(false);
@@ -720,7 +766,7 @@ void NeroPrefixSettingsWindow::StartUmu(const QString command, QStringList args)
 
         env.insert("WINEPREFIX", QString("%1/%2").arg(NeroFS::GetPrefixesPath()->path(), NeroFS::GetCurrentPrefix()));
         env.insert("GAMEID", "0");
-        env.insert("PROTONPATH", QString("%1/%2").arg(NeroFS::GetProtonsPath()->path(), NeroFS::GetCurrentRunner()));
+        env.insert("PROTONPATH", NeroFS::GetRunnerPath(NeroFS::GetCurrentRunner()));
         env.insert("PROTON_USE_XALIA", "0");
         env.insert("UMU_RUNTIME_UPDATE", "0");
         umu.setProcessEnvironment(env);
@@ -874,10 +920,18 @@ void NeroPrefixSettingsWindow::on_buttonBox_clicked(QAbstractButton *button)
             // per-shortcut settings
 
             // check if new ico was set.
-            if(!newAppIcon.isEmpty())
-                QFile::copy(newAppIcon, QString("%1/%2/.icoCache/%3").arg(NeroFS::GetPrefixesPath()->path(),
-                                                                          NeroFS::GetCurrentPrefix(),
-                                                                          QString("%1-%2.png").arg(settings.value("Name").toString(), currentShortcutHash)));
+            if(!newAppIcon.isEmpty()) {
+                // already decoded for the preview, so no need to go through the source file again.
+                const QString prefixPath = NeroFS::GetPrefixesPath()->path()+'/'+NeroFS::GetCurrentPrefix();
+                const QString oldKey = NeroFS::GetCurrentPrefixCfg()->GetString("Shortcuts--"+currentShortcutHash, "IconKey");
+                const QString iconKey = NeroIconCache::Store(prefixPath, newAppIconImage);
+                if(!iconKey.isEmpty()) {
+                    NeroFS::SetCurrentPrefixCfg("Shortcuts--"+currentShortcutHash, "IconKey", iconKey);
+                    // the replaced one's just taking up space now, unless another shortcut's using it too.
+                    if(!oldKey.isEmpty() && oldKey != iconKey && !NeroFS::IsIconKeyInUse(NeroFS::GetCurrentPrefix(), oldKey))
+                        NeroIconCache::Remove(prefixPath, oldKey);
+                }
+            }
 
             // for the generic input fields, changed values will have boldFont
             for(const auto &child : this->findChildren<QCheckBox*>())
@@ -907,37 +961,16 @@ void NeroPrefixSettingsWindow::on_buttonBox_clicked(QAbstractButton *button)
                 int winVerSelected = winVersionListBackwards.indexOf(ui->winVerBox->itemText(ui->winVerBox->currentIndex()));
                 NeroFS::SetCurrentPrefixCfg("Shortcuts--"+currentShortcutHash, "WindowsVersion", winVerSelected);
 
-                QDir prefixPath(NeroFS::GetPrefixesPath()->path()+'/'+NeroFS::GetCurrentPrefix());
-                if(prefixPath.exists("user.reg")) {
-                    QFile regFile(prefixPath.path()+"/user.reg");
-                    if(regFile.open(QFile::ReadWrite)) {
-                        QString newReg;
-                        QString line;
-                        const QString exe = settings.value("Path").toString().mid(settings.value("Path").toString().lastIndexOf('/')+1);
-                        const QString compareString = QString("[Software\\\\Wine\\\\AppDefaults\\\\%1]").arg(exe);
-                        bool exists = false;
-
-                        while(!regFile.atEnd()) {
-                            line = regFile.readLine();
-                            newReg.append(line);
-
-                            // winreg adds timestamp info, so just check the beginning of this line.
-                            if(line.startsWith(compareString)) {
-                                // in case this is a reg entry that's been absorbed into WinReg format (which adds timestamps)
-                                line = regFile.readLine();
-                                if(line.startsWith("#time=")) newReg.append(line), regFile.readLine();
-                                newReg.append(QString("\"Version\"=\"%1\"\n").arg(winVersionVerb.at(winVerSelected)));
-                                exists = true;
-                            }
-                        }
-
-                        if(!exists)
-                            newReg.append(QString("\n[Software\\\\Wine\\\\AppDefaults\\\\%1]\n\"Version\"=\"%2\"\n").arg(exe, winVersionVerb.at(winVerSelected)));
-
-                        regFile.resize(0);
-                        regFile.write(newReg.toUtf8());
-                        regFile.close();
-                    }
+                const QString prefixPath = NeroFS::GetPrefixesPath()->path()+'/'+NeroFS::GetCurrentPrefix();
+                if(QFile::exists(NeroRegistry::GetUserReg(prefixPath))) {
+                    const QString exe = settings.value("Path").toString().mid(settings.value("Path").toString().lastIndexOf('/')+1);
+                    NeroRegistry userReg(NeroRegistry::GetUserReg(prefixPath));
+                    userReg.SetString("Software\\Wine\\AppDefaults\\" + exe, "Version", winVersionVerb.at(winVerSelected));
+
+                    // prefix is running, so its wineserver owns the registry right now - go through it instead.
+                    if(!userReg.Apply() && userReg.IsLocked())
+                        StartUmu("reg", { "add", "HKCU\\Software\\Wine\\AppDefaults\\" + exe,
+                                          "/v", "Version", "/d", winVersionVerb.at(winVerSelected), "/f" });
                 }
             }
 
@@ -970,3 +1003,45 @@ void NeroPrefixSettingsWindow::on_openToShortcutPath_clicked()
     QDesktopServices::openUrl(QUrl::fromLocalFile(ui->shortcutPath->text().left(ui->shortcutPath->text().lastIndexOf('/'))
                                                                           .replace("C:", NeroFS::GetPrefixesPath()->path()+'/'+NeroFS::GetCurrentPrefix()+"/drive_c")));
 }
+
+void NeroPrefixSettingsWindow::LoadLaunchTimings()
+{
+    const QString prefixPath = NeroFS::GetPrefixesPath()->path() + '/' + NeroFS::GetCurrentPrefix();
+    const QString historyPath = NeroLaunchTimings::GetHistoryPath(prefixPath, currentShortcutHash);
+    const QList<NeroLaunchTimings::Stats> stats = NeroLaunchTimings::GetStats(historyPath);
+    if(stats.isEmpty() || stats.first().samples == 0) return;
+
+    auto toSeconds = [](const qint64 &ms) { return ms < 0 ? QString("-") : QString::number(ms / 1000.0, 'f', 2) + 's'; };
+
+    QString table = "<table cellspacing=\"4\"><tr><th></th><th>Last</th><th>Median</th><th>95%</th></tr>";
+    for(int i = 0; i < stats.count(); ++i) {
+        if(stats.at(i).samples == 0) continue;
+        table.append(QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td></tr>")
+                     .arg(NeroLaunchTimings::PhaseName(i),
+                          toSeconds(stats.at(i).last), toSeconds(stats.at(i).median), toSeconds(stats.at(i).p95)));
+    }
+    table.append("</table>");
+
+    // the usual suspects for slow launches, to compare against the overall total above
+    QStringList byTag;
+    for(const auto &tag : { "runtime-update", "gamescope", "mangohud", "gamemode" }) {
+        const NeroLaunchTimings::Stats total = NeroLaunchTimings::GetStats(historyPath, { tag }).last();
+        if(total.samples > 0)
+            byTag.append(QString("%1: %2 (%3 runs)").arg(tag, toSeconds(total.median)).arg(total.samples));
+    }
+    if(!byTag.isEmpty())
+        table.append("<p>Median total with " + byTag.join(", ") + "</p>");
+
+    // no new shaders on the last run means it was all cache hits
+    const NeroShaderCache::Stats cache = NeroShaderCache::GetStats(NeroShaderCache::GetCachePath(prefixPath, currentShortcutHash));
+    if(cache.runs > 0) {
+        table.append(QString("<p>Shader cache: %1 MiB over %2 runs%3, ").arg(QString::number(cache.size / 1048576.0, 'f', 1))
+                                                                       .arg(cache.runs)
+                                                                       .arg(cache.seeded ? " (seeded from another prefix)" : ""));
+        if(cache.lastGrowth > 0)
+            table.append(QString("%1 KiB of new shaders last run</p>").arg(cache.lastGrowth / 1024));
+        else table.append("no new shaders last run</p>");
+    }
+
+    ui->launchTimingsText->setText(table);
+}
@@ -21,6 +21,7 @@
 #define NEROPREFIXSETTINGS_H
 
 #include <QDialog>
+#include <QImage>
 #include <QLabel>
 #include <QMap>
 #include <QCompleter>
@@ -51,6 +52,10 @@ public:
     QString appName;
 
     QPushButton *deleteShortcut = nullptr;
+    QPushButton *refreshIcons = nullptr;
+
+signals:
+    void refreshIconsRequested();
 
 private slots:
     void on_shortcutIco_clicked();
@@ -99,6 +104,9 @@ private:
     Ui::NeroPrefixSettingsWindow *ui;
 
     void LoadSettings();
+    void LoadLaunchTimings();
+    // rest of the RPC bridge install, once the downloader has the zip (or gave up)
+    void InstallDiscordRPC(const QString &zipPath, const QString &error);
     void AddDLL(const QString, const int);
     void StartUmu(const QString, QStringList = {});
 
@@ -112,6 +120,9 @@ private:
 
     QString currentShortcutHash;
 
+    QImage newAppIconImage;
+    unsigned int iconRequests = 0;
+
     QStringList existingShortcuts;
 
     QStringList winVersionListBackwards;
@@ -0,0 +1,169 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Launched Process Tree Tracking & Teardown.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroprocesstree.h"
+#include "nerowineserver.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QThread>
+#include <QUuid>
+
+#include <signal.h>
+
+QString NeroProcessTree::NewSessionId()
+{
+    return QUuid::createUuid().toString(QUuid::WithoutBraces);
+}
+
+bool NeroProcessTree::ReadStat(const qint64 &pid, qint64 &ppid, quint64 &startTime, QByteArray &name, char &state)
+{
+    QFile statFile(QString("/proc/%1/stat").arg(pid));
+    if(!statFile.open(QIODevice::ReadOnly)) return false;
+    const QByteArray stat = statFile.readAll();
+
+    // comm can have spaces and parens in it, so everything's counted from the last ')'
+    const int nameStart = stat.indexOf('(');
+    const int nameEnd = stat.lastIndexOf(')');
+    if(nameStart < 0 || nameEnd < nameStart) return false;
+
+    name = stat.mid(nameStart + 1, nameEnd - nameStart - 1);
+    // fields from here start at #3 (state); ppid is #4, starttime is #22
+    const QList<QByteArray> fields = stat.mid(nameEnd + 2).split(' ');
+    if(fields.count() < 20) return false;
+
+    state = fields.at(0).isEmpty() ? '?' : fields.at(0).at(0);
+    ppid = fields.at(1).toLongLong();
+    startTime = fields.at(19).toULongLong();
+    return true;
+}
+
+QList<NeroProcessTree::Process> NeroProcessTree::Find(const QString &sessionId, const qint64 &rootPid)
+{
+    QByteArray tag;
+    tag.append('\0');
+    tag.append("NERO_SESSION=" + sessionId.toUtf8());
+    tag.append('\0');
+
+    const qint64 self = QCoreApplication::applicationPid();
+    QHash<qint64, qint64> parents;
+    QHash<qint64, Process> processes;
+    QList<qint64> tagged;
+
+    const QStringList pids = QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for(const auto &entry : pids) {
+        bool isPid = false;
+        const qint64 pid = entry.toLongLong(&isPid);
+        if(!isPid || pid == self) continue;
+
+        qint64 ppid;
+        Process process;
+        char state;
+        if(!ReadStat(pid, ppid, process.startTime, process.name, state) || state == 'Z') continue;
+        process.pid = pid;
+        parents[pid] = ppid;
+        processes[pid] = process;
+
+        // only readable for our own processes, which is all we'd be able to signal anyways
+        QFile environ(QString("/proc/%1/environ").arg(pid));
+        if(!sessionId.isEmpty() && environ.open(QIODevice::ReadOnly)) {
+            const QByteArray env = '\0' + environ.readAll() + '\0';
+            if(env.contains(tag)) tagged.append(pid);
+        }
+    }
+
+    QList<Process> found;
+    for(auto i = processes.constBegin(); i != processes.constEnd(); ++i) {
+        bool belongs = tagged.contains(i.key());
+        // walk up to see if this came from the root, in case something scrubbed its environment
+        for(qint64 pid = i.key(); !belongs && rootPid > 0 && pid > 1; pid = parents.value(pid, 0))
+            if(pid == rootPid) belongs = true;
+        if(belongs) found.append(i.value());
+    }
+    return found;
+}
+
+bool NeroProcessTree::IsAlive(const Process &process)
+{
+    qint64 ppid;
+    quint64 startTime;
+    QByteArray name;
+    char state;
+    return ReadStat(process.pid, ppid, startTime, name, state) && state != 'Z' && startTime == process.startTime;
+}
+
+QList<NeroProcessTree::Process> NeroProcessTree::Alive(const QList<Process> &processes)
+{
+    QList<Process> alive;
+    for(const auto &process : processes)
+        if(IsAlive(process)) alive.append(process);
+    return alive;
+}
+
+void NeroProcessTree::Signal(const QList<Process> &processes, const int &signal)
+{
+    for(const auto &process : processes)
+        // double-check it's still the same process right before signalling, since pids get recycled
+        if(IsAlive(process)) kill(static_cast<pid_t>(process.pid), signal);
+}
+
+bool NeroProcessTree::Terminate(const QString &sessionId, const qint64 &rootPid,
+                                const QString &prefixPath, const QString &runnerPath,
+                                const bool &killServer, const int &deadline)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<Process> processes = Find(sessionId, rootPid);
+    if(!killServer) {
+        // other launches in this prefix (or a warm one's next launch) still need the server
+        QList<Process> clients;
+        for(const auto &process : std::as_const(processes))
+            if(process.name != "wineserver") clients.append(process);
+        processes = clients;
+    }
+
+    // wineserver can end every client in the prefix straight away, without needing the runtime container.
+    if(killServer) NeroWineserver::Kill(prefixPath, runnerPath, SIGTERM);
+    Signal(processes, SIGTERM);
+
+    while(!(processes = Alive(processes)).isEmpty() && timer.elapsed() < deadline)
+        QThread::msleep(10);
+
+    if(!processes.isEmpty()) {
+        printf("%d processes didn't stop within %dms, killing...\n", static_cast<int>(processes.count()), deadline);
+        if(killServer) NeroWineserver::Kill(prefixPath, runnerPath, SIGKILL);
+        Signal(processes, SIGKILL);
+    }
+
+    // SIGKILL can't be ignored, but give the kernel a moment to actually reap everything
+    QElapsedTimer confirm;
+    confirm.start();
+    while(!(processes = Alive(processes)).isEmpty() && confirm.elapsed() < 500)
+        QThread::msleep(10);
+
+    for(const auto &process : std::as_const(processes))
+        printf("Process %lld (%s) is still around after shutdown!\n", process.pid, process.name.constData());
+
+    printf("Shutdown took %lldms\n", timer.elapsed());
+    return processes.isEmpty();
+}
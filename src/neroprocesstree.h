@@ -0,0 +1,58 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Launched Process Tree Tracking & Teardown.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROPROCESSTREE_H
+#define NEROPROCESSTREE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+// Every launch gets tagged with NERO_SESSION=<id> in its environment, which everything umu/Proton/Wine spawns
+// inherits - even processes that get reparented away from umu, which a plain ppid walk would lose track of.
+// Stopping a launch then means signalling exactly that set, rather than spinning up a whole new umu instance
+// to run wineboot and hoping it catches everything.
+class NeroProcessTree
+{
+public:
+    struct Process {
+        qint64 pid;
+        // for telling a pid that got reused apart from the one we found
+        quint64 startTime;
+        QByteArray name;
+    };
+
+    // METHODS
+    static QString NewSessionId();
+    // everything tagged with this session, plus anything descended from rootPid.
+    static QList<Process> Find(const QString &sessionId, const qint64 &rootPid = 0);
+    // asks nicely (SIGTERM, plus the prefix's wineserver if killServer), then SIGKILLs whatever's left after deadline ms.
+    // Returns whether everything's confirmed gone.
+    static bool Terminate(const QString &sessionId, const qint64 &rootPid,
+                          const QString &prefixPath, const QString &runnerPath,
+                          const bool &killServer, const int &deadline);
+
+private:
+    static bool ReadStat(const qint64 &pid, qint64 &ppid, quint64 &startTime, QByteArray &name, char &state);
+    static bool IsAlive(const Process &);
+    static void Signal(const QList<Process> &, const int &);
+    static QList<Process> Alive(const QList<Process> &);
+};
+
+#endif // NEROPROCESSTREE_H
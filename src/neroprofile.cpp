@@ -0,0 +1,193 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Precompiled Shortcut Launch Profiles.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroprofile.h"
+#include "nerosync.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+// bump this whenever NeroLaunchProfile's members change, so old caches get thrown out.
+#define NERO_PROFILE_CACHE_MAGIC 0x4E45524F
+#define NERO_PROFILE_CACHE_VERSION 5
+
+QHash<QString, NeroLaunchProfile::ProfileCache> NeroLaunchProfile::cacheByPrefix;
+QMutex NeroLaunchProfile::cacheMutex;
+
+bool NeroLaunchProfile::IniMatches(const QString &prefixPath, const qint64 &modified, const qint64 &size)
+{
+    QFileInfo iniInfo(prefixPath + "/nero-settings.ini");
+    if(!iniInfo.exists()) return false;
+    else return iniInfo.lastModified().toMSecsSinceEpoch() == modified && iniInfo.size() == size;
+}
+
+bool NeroLaunchProfile::GetCache(const QString &prefixPath, ProfileCache &cache)
+{
+    // assumes caller is holding cacheMutex
+    if(cacheByPrefix.contains(prefixPath)) {
+        const ProfileCache &memCache = cacheByPrefix[prefixPath];
+        if(IniMatches(prefixPath, memCache.iniModified, memCache.iniSize)) {
+            cache = memCache;
+            return true;
+        } else cacheByPrefix.remove(prefixPath);
+    }
+
+    QFile cacheFile(prefixPath + "/.launchprofiles.cache");
+    if(!cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&cacheFile);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if(magic != NERO_PROFILE_CACHE_MAGIC || version != NERO_PROFILE_CACHE_VERSION) return false;
+
+    ProfileCache diskCache;
+    in >> diskCache.iniModified >> diskCache.iniSize;
+    if(!IniMatches(prefixPath, diskCache.iniModified, diskCache.iniSize)) return false;
+
+    in >> diskCache.profiles;
+    if(in.status() != QDataStream::Ok) return false;
+
+    cacheByPrefix[prefixPath] = diskCache;
+    cache = diskCache;
+    return true;
+}
+
+bool NeroLaunchProfile::LoadCached(const QString &prefixPath, const QString &hash, NeroLaunchProfile &profile)
+{
+    QMutexLocker locker(&cacheMutex);
+
+    ProfileCache cache;
+    if(GetCache(prefixPath, cache) && cache.profiles.contains(hash)) {
+        profile = cache.profiles.value(hash);
+        // runners can be removed without the ini changing
+        return QFile::exists(profile.runnerPath);
+    } else return false;
+}
+
+QString NeroLaunchProfile::FindCachedHash(const QString &prefixPath, const QString &name)
+{
+    QMutexLocker locker(&cacheMutex);
+
+    ProfileCache cache;
+    if(GetCache(prefixPath, cache)) {
+        for(const auto &profile : std::as_const(cache.profiles))
+            if(profile.name == name) return profile.hash;
+    }
+
+    return QString();
+}
+
+void NeroLaunchProfile::StoreCached(const NeroLaunchProfile &profile)
+{
+    QMutexLocker locker(&cacheMutex);
+
+    // settings changed again while this was being resolved; not worth keeping.
+    if(!IniMatches(profile.prefixPath, profile.iniModified, profile.iniSize)) return;
+
+    ProfileCache cache;
+    if(!GetCache(profile.prefixPath, cache)) {
+        cache.iniModified = profile.iniModified;
+        cache.iniSize = profile.iniSize;
+    }
+    cache.profiles[profile.hash] = profile;
+    cacheByPrefix[profile.prefixPath] = cache;
+
+    QSaveFile cacheFile(profile.prefixPath + "/.launchprofiles.cache");
+    if(cacheFile.open(QIODevice::WriteOnly)) {
+        QDataStream out(&cacheFile);
+        out.setVersion(QDataStream::Qt_5_15);
+        out << (quint32)NERO_PROFILE_CACHE_MAGIC << (quint32)NERO_PROFILE_CACHE_VERSION
+            << cache.iniModified << cache.iniSize << cache.profiles;
+        if(!cacheFile.commit())
+            printf("Couldn't write launch profile cache for %s\n", profile.prefix.toLocal8Bit().constData());
+    }
+}
+
+void NeroLaunchProfile::InvalidateCache(const QString &prefixPath)
+{
+    QMutexLocker locker(&cacheMutex);
+
+    cacheByPrefix.remove(prefixPath);
+    QFile::remove(prefixPath + "/.launchprofiles.cache");
+}
+
+static QString BoolString(const bool &value) { return value ? "true" : "false"; }
+
+QString NeroLaunchProfile::Dump() const
+{
+    QString out;
+
+    out.append(QString("Prefix: %1\n").arg(prefix));
+    out.append(QString("Shortcut: %1 (%2)\n").arg(name, hash));
+    out.append(QString("Runner: %1 (%2)\n").arg(runner, runnerPath));
+    out.append(QString("Path: %1\n").arg(path));
+    out.append(QString("WorkingDir: %1\n").arg(workingDir));
+    out.append(QString("PreRunScript: %1%2\n").arg(preRunScript, preRunBackground ? " (background)" : ""));
+    out.append(QString("PostRunScript: %1\n").arg(postRunScript));
+    out.append(QString("Logging: %1\n").arg(BoolString(logging)));
+    out.append(QString("Warm Prefix: %1\n").arg(BoolString(warmPrefix)));
+
+    out.append("\nEnvironment:\n");
+    for(auto i = env.constBegin(); i != env.constEnd(); ++i)
+        out.append(QString("  %1=%2\n").arg(i.key(), i.value()));
+
+    out.append("\nEnvironment (if unset):\n");
+    for(auto i = envDefaults.constBegin(); i != envDefaults.constEnd(); ++i)
+        out.append(QString("  %1=%2\n").arg(i.key(), i.value()));
+
+    out.append(QString("\nDLL Overrides: %1\n").arg(dllOverrides.join(';')));
+    out.append(QString("Wayland: %1, HDR: %2\n").arg(BoolString(wayland), BoolString(hdr)));
+    out.append(QString("Gamemode: %1, MangoHud: %2\n").arg(BoolString(gamemode), BoolString(mangohud)));
+    out.append(QString("Gamescope: %1\n").arg(gamescope.join(' ')));
+    out.append(QString("Arguments: %1\n").arg(args.join(' ')));
+    out.append(QString("CPU Set: %1%2, Priority: %3, I/O Priority: %4, Elevated: %5\n")
+               .arg(cpuSet).arg(cpuList.isEmpty() ? QString() : " (" + cpuList + ')')
+               .arg(priority).arg(ioPriority).arg(BoolString(elevateScheduling)));
+    out.append(QString("Sync Mode: %1\n").arg(NeroSync::GetName(syncMode)));
+
+    return out;
+}
+
+QDataStream &operator<<(QDataStream &out, const NeroLaunchProfile &profile)
+{
+    out << profile.prefix << profile.prefixPath << profile.hash << profile.name
+        << profile.runner << profile.runnerPath << profile.path << profile.workingDir
+        << profile.preRunScript << profile.postRunScript << profile.preRunBackground
+        << profile.env << profile.envDefaults << profile.dllOverrides << profile.gamescope << profile.args
+        << profile.gamemode << profile.mangohud << profile.wayland << profile.hdr << profile.logging
+        << profile.warmPrefix << profile.cpuSet << profile.cpuList << profile.priority << profile.ioPriority
+        << profile.elevateScheduling << profile.syncMode << profile.iniModified << profile.iniSize;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, NeroLaunchProfile &profile)
+{
+    in >> profile.prefix >> profile.prefixPath >> profile.hash >> profile.name
+       >> profile.runner >> profile.runnerPath >> profile.path >> profile.workingDir
+       >> profile.preRunScript >> profile.postRunScript >> profile.preRunBackground
+       >> profile.env >> profile.envDefaults >> profile.dllOverrides >> profile.gamescope >> profile.args
+       >> profile.gamemode >> profile.mangohud >> profile.wayland >> profile.hdr >> profile.logging
+       >> profile.warmPrefix >> profile.cpuSet >> profile.cpuList >> profile.priority >> profile.ioPriority
+       >> profile.elevateScheduling >> profile.syncMode >> profile.iniModified >> profile.iniSize;
+    return in;
+}
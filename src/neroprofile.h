@@ -0,0 +1,110 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Precompiled Shortcut Launch Profiles.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROPROFILE_H
+#define NEROPROFILE_H
+
+#include <QDataStream>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+
+// Everything a shortcut launch needs once its prefix + shortcut settings have been resolved,
+// flattened so that a launch never has to go back to the ini.
+// Anything that depends on the user's current environment (i.e. only-if-unset vars, Wayland, MangoHud)
+// is stored as intent here, and is applied on top of the system environment by NeroRunner at launch.
+class NeroLaunchProfile
+{
+public:
+    NeroLaunchProfile() {}
+
+    // VARS
+    QString prefix;
+    QString prefixPath;
+    QString hash;
+    QString name;
+    QString runner;
+    QString runnerPath;
+    QString path;
+    QString workingDir;
+    QString preRunScript;
+    QString postRunScript;
+    // left running alongside the game, instead of having to finish before it starts.
+    bool preRunBackground = false;
+
+    // always set, overrides whatever's in the environment.
+    QMap<QString, QString> env;
+    // only set when the user hasn't already declared them.
+    QMap<QString, QString> envDefaults;
+    // prepended to any WINEDLLOVERRIDES that's already in the environment.
+    QStringList dllOverrides;
+    // gamescope wrapper, including the trailing "--" separator - empty if not used.
+    QStringList gamescope;
+    // arguments passed to the executable itself.
+    QStringList args;
+
+    bool gamemode = false;
+    bool mangohud = false;
+    bool wayland = false;
+    bool hdr = false;
+    bool logging = false;
+    // keep a persistent wineserver around between launches
+    bool warmPrefix = false;
+
+    // kept as the user's intent, since which cores a preset means is only settled at launch (see NeroScheduling).
+    int cpuSet = 0;
+    QString cpuList;
+    int priority = 0;
+    int ioPriority = 0;
+    bool elevateScheduling = false;
+    // also intent - Auto depends on the kernel that's running at launch time (see NeroSync).
+    int syncMode = 0;
+
+    // ini state this profile was resolved from
+    qint64 iniModified = 0;
+    qint64 iniSize = -1;
+
+    // METHODS
+    bool IsValid() const { return !hash.isEmpty(); }
+    QString Dump() const;
+
+    static bool LoadCached(const QString &prefixPath, const QString &hash, NeroLaunchProfile &profile);
+    static void StoreCached(const NeroLaunchProfile &);
+    static QString FindCachedHash(const QString &prefixPath, const QString &name);
+    static void InvalidateCache(const QString &prefixPath);
+
+private:
+    struct ProfileCache {
+        qint64 iniModified = 0;
+        qint64 iniSize = -1;
+        QMap<QString, NeroLaunchProfile> profiles;
+    };
+
+    static bool GetCache(const QString &prefixPath, ProfileCache &cache);
+    static bool IniMatches(const QString &prefixPath, const qint64 &modified, const qint64 &size);
+
+    static QHash<QString, ProfileCache> cacheByPrefix;
+    static QMutex cacheMutex;
+};
+
+QDataStream &operator<<(QDataStream &, const NeroLaunchProfile &);
+QDataStream &operator>>(QDataStream &, NeroLaunchProfile &);
+
+#endif // NEROPROFILE_H
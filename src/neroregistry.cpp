@@ -0,0 +1,359 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Wine Registry Files Reader/Patcher.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroregistry.h"
+#include "nerowineserver.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+
+#include <cctype>
+
+QHash<QString, NeroRegistry::KeyIndex> NeroRegistry::indexes;
+QMutex NeroRegistry::indexMutex;
+
+// value lines for hex data continue onto the next line with a trailing backslash
+static bool Continues(const QByteArray &line)
+{
+    return line.endsWith("\\\n") || line.endsWith("\\\r\n");
+}
+
+QByteArray NeroRegistry::EscapeKey(const QString &key)
+{
+    // same escaping as strings, which doubles up the path separators the way Wine writes them
+    return EscapeString(key);
+}
+
+QByteArray NeroRegistry::EscapeString(const QString &value)
+{
+    QByteArray escaped;
+    escaped.reserve(value.size());
+
+    for(const auto &ch : value) {
+        const ushort code = ch.unicode();
+        if(ch == '\\') escaped.append("\\\\");
+        else if(ch == '"') escaped.append("\\\"");
+        // Wine itself writes everything outside of printable ASCII as \x + 4 hex digits
+        else if(code < 32 || code > 126) escaped.append(QString("\\x%1").arg(code, 4, 16, QChar('0')).toLatin1());
+        else escaped.append(static_cast<char>(code));
+    }
+
+    return escaped;
+}
+
+QString NeroRegistry::UnescapeString(const QByteArray &value)
+{
+    // skip over any type prefix, i.e. str(2):"..." for REG_EXPAND_SZ
+    const int start = value.indexOf('"');
+    const int end = value.lastIndexOf('"');
+    if(start < 0 || end <= start) return QString();
+
+    QString unescaped;
+    for(int i = start + 1; i < end; ++i) {
+        if(value.at(i) != '\\' || i + 1 >= end) {
+            unescaped.append(QChar(static_cast<uchar>(value.at(i))));
+            continue;
+        }
+
+        const char next = value.at(++i);
+        if(next == 'x') {
+            int digits = 0;
+            ushort code = 0;
+            while(digits < 4 && i + 1 < end && isxdigit(static_cast<uchar>(value.at(i + 1)))) {
+                code = code * 16 + QByteArray(1, value.at(++i)).toUShort(nullptr, 16);
+                digits++;
+            }
+            unescaped.append(QChar(code));
+        } else if(next == 'n') unescaped.append('\n');
+        else if(next == 'r') unescaped.append('\r');
+        else if(next == 't') unescaped.append('\t');
+        else if(next == '0') unescaped.append(QChar(0));
+        else unescaped.append(QChar(static_cast<uchar>(next)));
+    }
+
+    return unescaped;
+}
+
+QByteArray NeroRegistry::MakeName(const QString &name)
+{
+    // @ is the key's default value
+    return name.isEmpty() ? QByteArray("@") : '"' + EscapeString(name) + '"';
+}
+
+QByteArray NeroRegistry::ParseKey(const QByteArray &line)
+{
+    const int end = line.lastIndexOf(']');
+    if(!line.startsWith('[') || end < 1) return QByteArray();
+    else return line.mid(1, end - 1).toLower();
+}
+
+QByteArray NeroRegistry::ParseName(const QByteArray &line, int *dataStart)
+{
+    if(line.startsWith("@=")) {
+        if(dataStart) *dataStart = 2;
+        return QByteArray("");
+    }
+    if(!line.startsWith('"')) return QByteArray();
+
+    for(int i = 1; i < line.size(); ++i) {
+        if(line.at(i) == '\\') ++i;
+        else if(line.at(i) == '"') {
+            if(i + 1 >= line.size() || line.at(i + 1) != '=') return QByteArray();
+            if(dataStart) *dataStart = i + 2;
+            return line.mid(1, i - 1).toLower();
+        }
+    }
+
+    return QByteArray();
+}
+
+NeroRegistry::KeyEdits &NeroRegistry::GetKeyEdits(const QString &key)
+{
+    const QByteArray escaped = EscapeKey(key);
+    const QByteArray lower = escaped.toLower();
+
+    if(!edits.contains(lower)) {
+        edits[lower].key = escaped;
+        keyOrder.append(lower);
+    }
+    return edits[lower];
+}
+
+void NeroRegistry::AddEdit(const QString &key, const QString &name, const QByteArray &line)
+{
+    KeyEdits &keyEdits = GetKeyEdits(key);
+    const QByteArray lowerName = name.isEmpty() ? QByteArray("") : EscapeString(name).toLower();
+
+    // last edit to a value wins
+    for(auto &edit : keyEdits.values) {
+        if(edit.name == lowerName) {
+            edit.line = line;
+            return;
+        }
+    }
+    keyEdits.values.append({ lowerName, line });
+}
+
+void NeroRegistry::SetString(const QString &key, const QString &name, const QString &value)
+{
+    AddEdit(key, name, MakeName(name) + "=\"" + EscapeString(value) + "\"\n");
+}
+
+void NeroRegistry::SetDword(const QString &key, const QString &name, const quint32 &value)
+{
+    AddEdit(key, name, MakeName(name) + "=dword:" + QByteArray::number(value, 16).rightJustified(8, '0') + '\n');
+}
+
+void NeroRegistry::DeleteValue(const QString &key, const QString &name)
+{
+    AddEdit(key, name, QByteArray());
+}
+
+void NeroRegistry::DeleteKey(const QString &key)
+{
+    KeyEdits &keyEdits = GetKeyEdits(key);
+    keyEdits.deleteKey = true;
+    keyEdits.values.clear();
+}
+
+bool NeroRegistry::IsLocked() const
+{
+    return NeroWineserver::IsAlive(QFileInfo(regPath).path());
+}
+
+bool NeroRegistry::Apply()
+{
+    if(edits.isEmpty()) return true;
+
+    if(IsLocked()) {
+        printf("Wineserver is running for %s, not patching it directly.\n", regPath.toLocal8Bit().constData());
+        return false;
+    }
+
+    QFile in(regPath);
+    if(!in.open(QIODevice::ReadOnly)) {
+        printf("Couldn't open %s for reading!\n", regPath.toLocal8Bit().constData());
+        return false;
+    }
+
+    QSaveFile out(regPath);
+    if(!out.open(QIODevice::WriteOnly)) {
+        printf("Couldn't open %s for writing!\n", regPath.toLocal8Bit().constData());
+        return false;
+    }
+
+    QList<QByteArray> deletedKeys;
+    for(const auto &key : std::as_const(keyOrder))
+        if(edits.value(key).deleteKey) deletedKeys.append(key);
+
+    auto isDeleted = [&deletedKeys](const QByteArray &key) {
+        for(const auto &deleted : std::as_const(deletedKeys))
+            if(key == deleted || key.startsWith(deleted + "\\\\")) return true;
+        return false;
+    };
+
+    QSet<QByteArray> seenKeys;
+    const KeyEdits *current = nullptr;
+    QSet<QByteArray> currentDone;
+    QByteArray heldBlank;
+    bool skipping = false;
+
+    // whatever wasn't already in the key goes at the end of it, before the blank line separating the next one
+    auto finishKey = [&]() {
+        if(current) {
+            for(const auto &edit : current->values)
+                if(!edit.line.isEmpty() && !currentDone.contains(edit.name))
+                    out.write(edit.line);
+        }
+        out.write(heldBlank);
+        heldBlank.clear();
+        currentDone.clear();
+        current = nullptr;
+    };
+
+    while(!in.atEnd()) {
+        QByteArray line = in.readLine();
+        while(Continues(line) && !in.atEnd())
+            line.append(in.readLine());
+
+        if(line.startsWith('[')) {
+            finishKey();
+
+            const QByteArray key = ParseKey(line);
+            skipping = isDeleted(key);
+            if(skipping) continue;
+
+            seenKeys.insert(key);
+            if(edits.contains(key)) current = &edits[key];
+            out.write(line);
+            continue;
+        }
+
+        if(skipping) continue;
+
+        if(current) {
+            if(line.trimmed().isEmpty()) {
+                heldBlank.append(line);
+                continue;
+            }
+            out.write(heldBlank);
+            heldBlank.clear();
+
+            const QByteArray name = ParseName(line);
+            if(!name.isNull()) {
+                bool replaced = false;
+                for(const auto &edit : current->values) {
+                    if(edit.name == name) {
+                        currentDone.insert(name);
+                        if(!edit.line.isEmpty()) out.write(edit.line);
+                        replaced = true;
+                        break;
+                    }
+                }
+                if(replaced) continue;
+            }
+        }
+
+        out.write(line);
+    }
+    finishKey();
+
+    // brand new keys go at the end, stamped the same way Wine stamps them
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const quint64 fileTime = (static_cast<quint64>(now) + 11644473600ULL) * 10000000ULL;
+    for(const auto &key : std::as_const(keyOrder)) {
+        if(seenKeys.contains(key)) continue;
+
+        const KeyEdits &keyEdits = edits[key];
+        QByteArray values;
+        for(const auto &edit : keyEdits.values)
+            values.append(edit.line);
+        if(values.isEmpty()) continue;
+
+        out.write("\n[" + keyEdits.key + "] " + QByteArray::number(now) + '\n');
+        out.write("#time=" + QByteArray::number(fileTime, 16) + '\n');
+        out.write(values);
+    }
+
+    in.close();
+    if(!out.commit()) {
+        printf("Couldn't write %s, leaving it as it was.\n", regPath.toLocal8Bit().constData());
+        return false;
+    }
+
+    edits.clear();
+    keyOrder.clear();
+    return true;
+}
+
+QByteArray NeroRegistry::GetValue(const QString &regFile, const QString &key, const QString &name)
+{
+    QFile file(regFile);
+    if(!file.open(QIODevice::ReadOnly)) return QByteArray();
+
+    const QFileInfo info(regFile);
+    qint64 offset = -1;
+    {
+        QMutexLocker locker(&indexMutex);
+        KeyIndex &index = indexes[regFile];
+        const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+        if(index.modified != modified || index.size != info.size()) {
+            index = KeyIndex();
+            index.modified = modified;
+            index.size = info.size();
+
+            while(!file.atEnd()) {
+                const qint64 pos = file.pos();
+                const QByteArray line = file.readLine();
+                if(line.startsWith('['))
+                    index.offsets.insert(ParseKey(line), pos);
+            }
+        }
+
+        offset = index.offsets.value(EscapeKey(key).toLower(), -1);
+    }
+
+    if(offset < 0 || !file.seek(offset)) return QByteArray();
+
+    const QByteArray wanted = name.isEmpty() ? QByteArray("") : EscapeString(name).toLower();
+    file.readLine();
+
+    while(!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if(line.startsWith('[')) break;
+        while(Continues(line) && !file.atEnd())
+            line.append(file.readLine());
+
+        int dataStart = 0;
+        const QByteArray lineName = ParseName(line, &dataStart);
+        if(!lineName.isNull() && lineName == wanted)
+            return line.mid(dataStart).trimmed();
+    }
+
+    return QByteArray();
+}
+
+QString NeroRegistry::GetString(const QString &regFile, const QString &key, const QString &name)
+{
+    return UnescapeString(GetValue(regFile, key, name));
+}
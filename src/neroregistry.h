@@ -0,0 +1,98 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Wine Registry Files Reader/Patcher.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROREGISTRY_H
+#define NEROREGISTRY_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+// Reads and patches Wine's own .reg files (system.reg/user.reg) directly, so simple registry changes
+// don't need a whole Proton/regedit launch. Edits are queued up and applied in a single streaming pass
+// into a temp file that replaces the original only once it's been fully written.
+// Keys are given as regedit would show them relative to the file's root, i.e. "Software\\Wine\\Ports"
+// for system.reg (HKLM) or "Software\\Wine\\AppDefaults\\game.exe" for user.reg (HKCU).
+//
+// Wine only reads these when its wineserver starts, and writes them back whenever it likes while running,
+// so nothing gets applied while the prefix's wineserver is up - callers should fall back to `reg` in that case.
+class NeroRegistry
+{
+public:
+    explicit NeroRegistry(const QString &regFile) : regPath(regFile) {}
+
+    static QString GetSystemReg(const QString &prefixPath) { return prefixPath + "/system.reg"; }
+    static QString GetUserReg(const QString &prefixPath) { return prefixPath + "/user.reg"; }
+
+    // METHODS
+    void SetString(const QString &key, const QString &name, const QString &value);
+    void SetDword(const QString &key, const QString &name, const quint32 &value);
+    void DeleteValue(const QString &key, const QString &name);
+    // takes all its subkeys with it, like regedit does
+    void DeleteKey(const QString &key);
+
+    bool HasEdits() const { return !edits.isEmpty(); }
+    // false (and nothing written) if the file couldn't be patched or the prefix is running.
+    bool Apply();
+    bool IsLocked() const;
+
+    // raw data as stored in the file (e.g. "\"text\"" or "dword:00000001"), empty if not found.
+    // Jumps straight to the key through an offset index, which is only rebuilt when the file changes.
+    static QByteArray GetValue(const QString &regFile, const QString &key, const QString &name);
+    static QString GetString(const QString &regFile, const QString &key, const QString &name);
+
+private:
+    struct Edit {
+        QByteArray name;
+        QByteArray line;     // full replacement line, empty to delete the value
+    };
+    struct KeyEdits {
+        QByteArray key;      // as written in the file, i.e. escaped
+        QList<Edit> values;
+        bool deleteKey = false;
+    };
+    struct KeyIndex {
+        qint64 modified = 0;
+        qint64 size = -1;
+        QHash<QByteArray, qint64> offsets;
+    };
+
+    KeyEdits &GetKeyEdits(const QString &key);
+    void AddEdit(const QString &key, const QString &name, const QByteArray &line);
+
+    static QByteArray EscapeKey(const QString &key);
+    static QByteArray EscapeString(const QString &value);
+    static QString UnescapeString(const QByteArray &value);
+    static QByteArray MakeName(const QString &name);
+    // name of the value on this line in lowercase (empty for @, null if it's not a value line at all)
+    static QByteArray ParseName(const QByteArray &line, int *dataStart = nullptr);
+    static QByteArray ParseKey(const QByteArray &line);
+
+    QString regPath;
+    // lowercased key -> edits, since the registry is case-insensitive
+    QHash<QByteArray, KeyEdits> edits;
+    QList<QByteArray> keyOrder;
+
+    static QHash<QString, KeyIndex> indexes;
+    static QMutex indexMutex;
+};
+
+#endif // NEROREGISTRY_H
@@ -0,0 +1,258 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Running Session Resource Sampler.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroresources.h"
+#include "neroprocesstree.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+#include <unistd.h>
+
+// samples between full walks of /proc for processes that joined (or left) the tree
+#define NERO_RESOURCES_RESCAN 5
+
+static QByteArray ReadProcFile(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) return QByteArray();
+    return file.readAll();
+}
+
+// value of a "key: value" line in /proc/<pid>/io or fdinfo, with key including the colon
+static quint64 ProcValue(const QByteArray &contents, const QByteArray &key, const int &from = 0)
+{
+    const int start = contents.indexOf(key, from);
+    if(start < 0) return 0;
+    const int end = contents.indexOf('\n', start);
+    return contents.mid(start + key.size(), end < 0 ? -1 : end - start - key.size()).trimmed().split(' ').first().toULongLong();
+}
+
+QString NeroResourceSample::Summary() const
+{
+    const QString memory = rss >= 1024*1024*1024 ? QString::number(rss / (1024.0*1024*1024), 'f', 1) + " GiB"
+                                                 : QString::number(rss / (1024*1024)) + " MiB";
+    QString summary = QString("CPU %1%, %2, %3 threads").arg(qRound(cpu)).arg(memory).arg(threads);
+
+    const qint64 io = readRate + writeRate;
+    if(io >= 1024*1024) summary += QString(", I/O %1 MiB/s").arg(io / (1024*1024));
+    if(gpu >= 0) summary += QString(", GPU %1%").arg(qRound(gpu));
+    return summary;
+}
+
+void NeroResourceMonitor::Start(const QString &sessionId, const qint64 &rootPid, const bool &sampleGpu, const QString &seriesPath)
+{
+    this->sessionId = sessionId;
+    this->rootPid = rootPid;
+    this->sampleGpu = sampleGpu;
+    tracked.clear();
+    joined.clear();
+    engineBusy.clear();
+    samplesUntilRescan = 0;
+    overheadNs = 0;
+    lastSample = 0;
+    clock.start();
+    StartWindow();
+    running = true;
+
+    // only the latest run's kept, it's the one anyone would be asking about.
+    if(!seriesPath.isEmpty()) {
+        series.setFileName(seriesPath);
+        if(series.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            series.write("# started " + QByteArray::number(QDateTime::currentMSecsSinceEpoch()) + '\n');
+            series.write("# elapsed_ms\tcpu_pct\trss_kib\tread_kibps\twrite_kibps\tthreads\tprocesses\tgpu_pct\n");
+        } else printf("Couldn't open %s for resource samples\n", seriesPath.toLocal8Bit().constData());
+    }
+}
+
+void NeroResourceMonitor::Stop()
+{
+    if(!running) return;
+    running = false;
+
+    printf("Resource sampling took %.3f%% of a core\n", GetOverhead() * 100);
+    if(series.isOpen()) {
+        series.write("# overhead_pct " + QByteArray::number(GetOverhead() * 100, 'f', 3) + '\n');
+        series.close();
+    }
+}
+
+double NeroResourceMonitor::GetOverhead() const
+{
+    const qint64 elapsed = clock.isValid() ? clock.nsecsElapsed() : 0;
+    return elapsed > 0 ? static_cast<double>(overheadNs) / elapsed : 0;
+}
+
+double NeroResourceMonitor::GetRecentOverhead() const
+{
+    if(windowSamples < NERO_RESOURCES_RESCAN) return -1;
+    const qint64 elapsed = clock.nsecsElapsed() - windowStartNs;
+    return elapsed > 0 ? static_cast<double>(windowOverheadNs) / elapsed : 0;
+}
+
+void NeroResourceMonitor::StartWindow()
+{
+    windowStartNs = clock.isValid() ? clock.nsecsElapsed() : 0;
+    windowOverheadNs = 0;
+    windowSamples = 0;
+}
+
+void NeroResourceMonitor::Rescan()
+{
+    // the shutdown engine's session tagging already knows what belongs to us
+    const QList<NeroProcessTree::Process> found = NeroProcessTree::Find(sessionId, rootPid);
+
+    QHash<qint64, Tracked> kept;
+    for(const auto &process : found) {
+        Tracked entry = tracked.value(process.pid);
+        // pid got reused since the last look
+        if(entry.startTime != process.startTime) {
+            entry = Tracked();
+            joined << process.pid;
+        }
+        entry.startTime = process.startTime;
+        if(sampleGpu) entry.drmFds = FindDrmFds(process.pid);
+        kept.insert(process.pid, entry);
+    }
+    tracked = kept;
+}
+
+QList<qint64> NeroResourceMonitor::TakeJoined()
+{
+    const QList<qint64> list = joined;
+    joined.clear();
+    return list;
+}
+
+QList<int> NeroResourceMonitor::FindDrmFds(const qint64 &pid)
+{
+    QList<int> fds;
+    const QString fdPath = QString("/proc/%1/fd/").arg(pid);
+    const QStringList entries = QDir(fdPath).entryList(QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot);
+
+    char target[64];
+    for(const auto &entry : entries) {
+        const ssize_t length = readlink(QFile::encodeName(fdPath + entry).constData(), target, sizeof(target) - 1);
+        if(length <= 0) continue;
+        target[length] = '\0';
+        if(qstrncmp(target, "/dev/dri/", 9) == 0) fds << entry.toInt();
+    }
+    return fds;
+}
+
+NeroResourceSample NeroResourceMonitor::Sample()
+{
+    NeroResourceSample sample;
+    if(!running) return sample;
+
+    QElapsedTimer cost;
+    cost.start();
+
+    if(--samplesUntilRescan <= 0) {
+        Rescan();
+        samplesUntilRescan = NERO_RESOURCES_RESCAN;
+    }
+
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    const qint64 now = clock.elapsed();
+    const double seconds = qMax<qint64>(now - lastSample, 1) / 1000.0;
+    lastSample = now;
+    sample.elapsed = now;
+
+    quint64 cpuTicks = 0;
+    qint64 readBytes = 0;
+    qint64 writeBytes = 0;
+    QHash<QByteArray, quint64> busy;
+
+    for(auto i = tracked.begin(); i != tracked.end();) {
+        const QByteArray stat = ReadProcFile(QString("/proc/%1/stat").arg(i.key()));
+        // fields from after comm start at #3 (state); utime #14, stime #15, num_threads #20, starttime #22, rss #24
+        const int nameEnd = stat.lastIndexOf(')');
+        const QList<QByteArray> fields = nameEnd < 0 ? QList<QByteArray>() : stat.mid(nameEnd + 2).split(' ');
+        if(fields.count() < 22 || fields.at(0) == "Z" || fields.at(19).toULongLong() != i->startTime) {
+            i = tracked.erase(i);
+            continue;
+        }
+
+        const quint64 ticks = fields.at(11).toULongLong() + fields.at(12).toULongLong();
+        const QByteArray io = ReadProcFile(QString("/proc/%1/io").arg(i.key()));
+        const qint64 read = ProcValue(io, "read_bytes:");
+        const qint64 written = ProcValue(io, "write_bytes:");
+
+        // new ones only get a baseline this time around
+        if(i->seen) {
+            if(ticks > i->cpuTicks) cpuTicks += ticks - i->cpuTicks;
+            if(read > i->readBytes) readBytes += read - i->readBytes;
+            if(written > i->writeBytes) writeBytes += written - i->writeBytes;
+        }
+        i->cpuTicks = ticks;
+        i->readBytes = read;
+        i->writeBytes = written;
+        i->seen = true;
+
+        sample.threads += fields.at(17).toInt();
+        sample.rss += fields.at(21).toLongLong() * pageSize;
+        sample.processes++;
+
+        // several fds (and processes) can share one DRM client, which only counts once.
+        for(const int &fd : std::as_const(i->drmFds)) {
+            const QByteArray fdinfo = ReadProcFile(QString("/proc/%1/fdinfo/%2").arg(i.key()).arg(fd));
+            const QByteArray client = QByteArray::number(ProcValue(fdinfo, "drm-client-id:"));
+            if(client == "0") continue;
+
+            for(int engine = fdinfo.indexOf("drm-engine-"); engine >= 0; engine = fdinfo.indexOf("drm-engine-", engine + 1)) {
+                const int colon = fdinfo.indexOf(':', engine);
+                if(colon < 0) break;
+                const QByteArray name = fdinfo.mid(engine + 11, colon - engine - 11);
+                // drm-engine-capacity-* is how many of an engine there are, not time spent
+                if(name.startsWith("capacity-")) continue;
+                busy.insert(client + '/' + name, ProcValue(fdinfo, "drm-engine-" + name + ':', engine));
+            }
+        }
+
+        ++i;
+    }
+
+    sample.cpu = cpuTicks * 100.0 / ticksPerSecond / seconds;
+    sample.readRate = readBytes / seconds;
+    sample.writeRate = writeBytes / seconds;
+
+    // engines are summed across clients, and the busiest one's what counts
+    QHash<QByteArray, quint64> engineDelta;
+    for(auto i = busy.constBegin(); i != busy.constEnd(); ++i) {
+        if(!engineBusy.contains(i.key()) || i.value() < engineBusy.value(i.key())) continue;
+        engineDelta[i.key().mid(i.key().indexOf('/') + 1)] += i.value() - engineBusy.value(i.key());
+    }
+    engineBusy = busy;
+    for(const auto &delta : std::as_const(engineDelta))
+        sample.gpu = qMin(100.0, qMax(sample.gpu, delta / (seconds * 1e7)));
+
+    if(series.isOpen())
+        series.write(QString("%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\n")
+                     .arg(sample.elapsed).arg(sample.cpu, 0, 'f', 1).arg(sample.rss / 1024)
+                     .arg(sample.readRate / 1024).arg(sample.writeRate / 1024)
+                     .arg(sample.threads).arg(sample.processes).arg(sample.gpu, 0, 'f', 1).toUtf8());
+
+    overheadNs += cost.nsecsElapsed();
+    windowOverheadNs += cost.nsecsElapsed();
+    ++windowSamples;
+    return sample;
+}
@@ -0,0 +1,107 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Running Session Resource Sampler.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NERORESOURCES_H
+#define NERORESOURCES_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+
+// One look at a session's whole process tree, summed up.
+struct NeroResourceSample {
+    // ms since sampling started
+    qint64 elapsed = 0;
+    // percent of one core, so a busy tree can go well past 100
+    double cpu = 0;
+    qint64 rss = 0;
+    // bytes/s actually hitting storage
+    qint64 readRate = 0;
+    qint64 writeRate = 0;
+    int threads = 0;
+    int processes = 0;
+    // busiest engine, -1 if there was no DRM fdinfo to go off of
+    double gpu = -1;
+
+    QString Summary() const;
+};
+Q_DECLARE_METATYPE(NeroResourceSample)
+
+// Samples the processes tagged with a session's id by reading /proc directly - stat, io, and fdinfo for GPU usage.
+// The tree itself is only rescanned every few samples; in between, just the processes already found get read,
+// which keeps a sample to a couple dozen small reads.
+class NeroResourceMonitor
+{
+public:
+    // samples get appended to seriesPath (truncated first), if there is one.
+    void Start(const QString &sessionId, const qint64 &rootPid, const bool &sampleGpu, const QString &seriesPath = "");
+    NeroResourceSample Sample();
+    void Stop();
+
+    bool IsRunning() const { return running; }
+    // processes that turned up in the tree since the last call, as of the latest rescan.
+    QList<qint64> TakeJoined();
+    // share of one core spent sampling so far, i.e. 0.001 is 0.1%
+    double GetOverhead() const;
+    // same, but only since the last StartWindow() - or -1 until that's covered a full rescan cycle,
+    // since those are what make some samples cost a lot more than others.
+    double GetRecentOverhead() const;
+    void StartWindow();
+
+    static QString GetSeriesPath(const QString &logPath) { return logPath + ".resources"; }
+
+private:
+    struct Tracked {
+        quint64 startTime = 0;
+        quint64 cpuTicks = 0;
+        qint64 readBytes = 0;
+        qint64 writeBytes = 0;
+        bool seen = false;
+        // fds pointing at /dev/dri, found during rescans
+        QList<int> drmFds;
+    };
+
+    void Rescan();
+    static QList<int> FindDrmFds(const qint64 &pid);
+
+    QString sessionId;
+    qint64 rootPid = 0;
+    bool sampleGpu = true;
+    bool running = false;
+    int samplesUntilRescan = 0;
+
+    QHash<qint64, Tracked> tracked;
+    QList<qint64> joined;
+    // per DRM client, per engine: busy ns as of the last sample
+    QHash<QByteArray, quint64> engineBusy;
+
+    QElapsedTimer clock;
+    qint64 lastSample = 0;
+    qint64 overheadNs = 0;
+    qint64 windowStartNs = 0;
+    qint64 windowOverheadNs = 0;
+    int windowSamples = 0;
+    QFile series;
+};
+
+#endif // NERORESOURCES_H
@@ -19,100 +19,269 @@
 
 #include "nerorunner.h"
 #include "neroconstants.h"
+#include "nerodedup.h"
+#include "nerolaunchpipeline.h"
 #include "nerofs.h"
-
-#include <QApplication>
+#include "neroprocesstree.h"
+#include "nerorunnerindex.h"
+#include "neroshadercache.h"
+#include "nerosync.h"
+#include "nerowineserver.h"
+
+#include <QByteArrayMatcher>
+#include <QEventLoop>
 #include <QProcess>
+#include <QSharedPointer>
 #include <QDir>
 #include <QDebug>
 #include <QStringBuilder>
 
 int NeroRunner::StartShortcut(const QString &hash, const bool &prefixAlreadyRunning)
 {
-    settings = NeroFS::GetCurrentPrefixCfg();
     // failsafe for cli runs
     if(NeroFS::GetUmU().isEmpty()) return -1;
     hashVal = hash;
-    CombinedSetting pathSetting = CombinedSetting(NeroConfig::path, *this);
-    QString prefixPath(NeroFS::GetPrefixesPath()->path() % '/' % NeroFS::GetCurrentPrefix());
-    QString pathDir = pathSetting.toString();
-    QString cPath = prefixPath % '/' % drive_c;
-    QString workingDir = pathDir.left(pathDir.lastIndexOf("/")).replace(cDrive, cPath);
-
-    bool startsWith = pathDir.startsWith(cDrive);
-    bool fileExists = QFileInfo::exists(workingDir); //faster than declaring obj
-    if(!startsWith && !fileExists) {
+    timings = NeroLaunchTimings();
+
+    const NeroLaunchProfile profile = GetProfile(hash);
+    timings.Mark(NeroLaunchTimings::Settings);
+
+    if(!CanLaunch(profile)) {
         // TODO: We should probably do something more
         return -1;
     }
 
-    QProcess runner;
+    NeroScheduledProcess runner;
+    NeroLaunchPipeline pipeline;
 
-    // TODO: this is ass for prerun scripts that should be running persistently.
-    CombinedSetting prerun = CombinedSetting(NeroConfig::prerunScript, *this);
-    if(prerun.hasSetting()) {
-        runner.start(prerun.toString(), (QStringList){});
-
-        while(runner.state() != QProcess::NotRunning) {
-            runner.waitForReadyRead(-1);
-            printf("%s", runner.readAll().constData());
+    // the script goes while everything else gets ready; background ones aren't waited on at all.
+    QProcess preRun;
+    if(!profile.preRunScript.isEmpty()) {
+        if(profile.preRunBackground) {
+            if(!QProcess::startDetached(profile.preRunScript, QStringList()))
+                printf("Couldn't start script %s\n", profile.preRunScript.toLocal8Bit().constData());
+        } else {
+            pipeline.Add("prerun", {}, NeroLaunchPipeline::External);
+            preRun.setProcessChannelMode(QProcess::ForwardedChannels);
+            connect(&preRun, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), &pipeline, [&pipeline]() {
+                pipeline.Complete("prerun");
+            });
+            connect(&preRun, &QProcess::errorOccurred, &pipeline, [&pipeline, &preRun](QProcess::ProcessError error) {
+                if(error != QProcess::FailedToStart) return;
+                printf("Couldn't start script %s\n", preRun.program().toLocal8Bit().constData());
+                pipeline.Complete("prerun");
+            });
+            preRun.start(profile.preRunScript, QStringList());
         }
-
-        printf("%s", runner.readAll().constData());
     }
 
+    NeroLogWriter log(Logs::keepRuns, Logs::segmentSize);
+    QString command;
+    QStringList arguments;
+    PrepareShortcut(pipeline, profile, prefixAlreadyRunning, runner, log, command, arguments);
+    pipeline.Run();
+    pipeline.Wait();
+    // whatever was left of the pre-run script after everything else was ready doesn't count towards the launch.
+    timings.Skip();
+
+    runner.start(command, arguments);
+    runner.waitForStarted(-1);
+    timings.Mark(NeroLaunchTimings::ProcessStart);
+    // already set before exec, this is just to hear about anything the kernel refused.
+    NeroScheduling::Apply(scheduling, runner.processId());
+    WaitLoop(runner, log);
+    FinishShortcut(profile);
+
+    // in case settings changed from manager
+    // detached, so whoever's waiting on the game (a terminal, Steam) is let go as soon as it's gone.
+    const QString postRunScript = GetProfile(hash).postRunScript;
+    if(!postRunScript.isEmpty() && !QProcess::startDetached(postRunScript, QStringList()))
+        printf("Couldn't start script %s\n", postRunScript.toLocal8Bit().constData());
+
+    return runner.exitCode();
+}
+
+bool NeroRunner::CanLaunch(const NeroLaunchProfile &profile) const
+{
+    // paths starting with a drive letter get resolved by Proton itself
+    return profile.path.startsWith(cDrive) || QFileInfo::exists(profile.workingDir);
+}
+
+void NeroRunner::PrepareShortcut(NeroLaunchPipeline &pipeline, const NeroLaunchProfile &profile, const bool &prefixAlreadyRunning,
+                                 NeroScheduledProcess &runner, NeroLogWriter &log, QString &command, QStringList &arguments)
+{
+    hashVal = profile.hash;
+    warmPrefix = profile.warmPrefix;
+
     runner.setProcessChannelMode(QProcess::ForwardedOutputChannel);
     runner.setReadChannel(QProcess::StandardError);
 
-    env = QProcessEnvironment::systemEnvironment();
-    env.insert(CliArgs::Wine::prefix, prefixPath);
+    // handed between stages, which can finish in any order
+    QSharedPointer<bool> attach(new bool(prefixAlreadyRunning));
+    QSharedPointer<QProcessEnvironment> cacheEnv(new QProcessEnvironment());
+    QSharedPointer<QProcessEnvironment> serverEnv(new QProcessEnvironment());
+
+    // Proton's about to copy its files over the hardlinked ones if the runner changed, so those get their own copies first.
+    pipeline.Add("unshare", {}, NeroLaunchPipeline::Pool, [profile]() {
+        NeroDedup::UnshareIfUpgrading(profile.prefixPath, profile.runnerPath);
+    });
+
+    // includes the runtime freshness check and sync probing, which are both just a few stats.
+    pipeline.Add("environment", {}, NeroLaunchPipeline::Here, [this, profile, &arguments, cacheEnv, serverEnv]() {
+        arguments = ApplyProfile(profile);
+        sessionId = NeroProcessTree::NewSessionId();
+        env.insert(CliArgs::neroSession, sessionId);
+        *cacheEnv = env;
+        *serverEnv = NeroWineserver::GetSyncEnv(env);
+    });
+
+    // a warm server can take a bit to come up, but nothing needs it until the verb's picked.
+    // it does need the sync mode though, since clients in a different one can't attach to it.
+    pipeline.Add("wineserver", { "environment" }, NeroLaunchPipeline::Pool, [profile, prefixAlreadyRunning, attach, serverEnv]() {
+        *attach = NeroWineserver::Prepare(profile.prefixPath, profile.runnerPath, *serverEnv, profile.warmPrefix, prefixAlreadyRunning);
+    });
+
+    // creating, seeding and measuring the cache is all disk, so it works off a copy of the env and gets merged back after.
+    pipeline.Add("shadercache", { "environment" }, NeroLaunchPipeline::Pool, [this, profile, cacheEnv]() {
+        const QString exePath = profile.path.startsWith(cDrive) ? QString(profile.path).replace(0, cDrive.length(), profile.prefixPath + "/drive_c/")
+                                                                : profile.path;
+        InitCache(*cacheEnv, profile.hash, NeroShaderCache::GetShareKey(cacheEnv->value(CliArgs::gameId), exePath));
+    });
+
+    pipeline.Add("finalize", { "unshare", "wineserver", "shadercache" }, NeroLaunchPipeline::Here,
+                 [this, profile, &runner, &log, &command, &arguments, attach, cacheEnv]() {
+        *attach ? env.insert(CliArgs::verb, CliArgs::run)
+                : env.insert(CliArgs::verb, CliArgs::waitForExitRun);
+        const QStringList cacheKeys = cacheEnv->keys();
+        for(const auto &key : cacheKeys)
+            if(!env.contains(key)) env.insert(key, cacheEnv->value(key));
+
+        timings.Mark(NeroLaunchTimings::Environment);
+        if(env.value(CliArgs::umuRuntimeUpdate) == TRUE) timings.AddTag("runtime-update");
+        if(!profile.gamescope.isEmpty()) timings.AddTag("gamescope");
+        if(profile.mangohud) timings.AddTag("mangohud");
+        if(profile.gamemode) timings.AddTag("gamemode");
+        if(!overrides.isEmpty()) timings.AddTag("overridden");
+
+        FinishPrepare(profile, runner, log, command, arguments);
+    });
+}
+
+void NeroRunner::FinishPrepare(const NeroLaunchProfile &profile, NeroScheduledProcess &runner, NeroLogWriter &log,
+                               QString &command, QStringList &arguments)
+{
+    runner.setProcessEnvironment(env);
+    scheduling = NeroScheduling::GetPolicy(profile.cpuSet, profile.cpuList, profile.priority,
+                                           profile.ioPriority, profile.elevateScheduling);
+    runner.SetPolicy(scheduling);
+    // some apps requires working directory to be in the right location
+    // (corrected if path starts with Windows drive letter prefix)
+    runner.setWorkingDirectory(profile.workingDir);
+    command = arguments.takeFirst();
+    QDir logsDir(profile.prefixPath);
+    if(!logsDir.exists(Logs::logDirName))
+        logsDir.mkdir(Logs::logDirName);
+    logsDir.cd(Logs::logDirName);
+    logPath = logsDir.path() % '/' % profile.name % '-' % profile.hash;
+    if(loggingEnabled && log.Open(logPath)) {
+        log.Write(syncSummary.toLocal8Bit() % Logs::newLine.toLocal8Bit());
+        log.Write(Logs::currentlyRunningEnv.toLocal8Bit());
+        log.Write(runner.environment().join('\n').toLocal8Bit());
+        log.Write(Logs::runningCommand.toLocal8Bit() % command.toLocal8Bit() % ' ' % arguments.join(' ').toLocal8Bit() % Logs::newLine.toLocal8Bit());
+        log.Write(Logs::blankLine.toLocal8Bit());
+    }
+}
+
+void NeroRunner::FinishShortcut(const NeroLaunchProfile &profile)
+{
+    FinishCache();
+    timings.Save(NeroLaunchTimings::GetHistoryPath(profile.prefixPath, profile.hash));
+}
+
+NeroLaunchProfile NeroRunner::GetProfile(const QString &hash)
+{
+    const QString prefixPath(NeroFS::GetPrefixesPath()->path() % '/' % prefix);
+    NeroLaunchProfile profile;
+
+    // one-off settings, not what the ini (or its cache) says.
+    if(!overrides.isEmpty()) return ResolveProfile(hash);
+
+    // unsaved changes haven't hit the ini yet, so the cached profile can't know about them.
+    if(!NeroFS::PrefixCfgIsDirty(prefix) &&
+       NeroLaunchProfile::LoadCached(prefixPath, hash, profile)) {
+        printf("Using cached launch profile for %s\n", profile.name.toLocal8Bit().constData());
+        return profile;
+    }
+
+    profile = ResolveProfile(hash);
+    if(!NeroFS::PrefixCfgIsDirty(prefix))
+        NeroLaunchProfile::StoreCached(profile);
+
+    return profile;
+}
+
+NeroLaunchProfile NeroRunner::ResolveProfile(const QString &hash)
+{
+    settings = NeroFS::GetPrefixCfg(prefix);
+    hashVal = hash;
+
+    NeroLaunchProfile profile;
+    profile.prefix = prefix;
+    profile.prefixPath = NeroFS::GetPrefixesPath()->path() % '/' % profile.prefix;
+    profile.hash = hash;
+    profile.iniModified = settings->GetLastModified().toMSecsSinceEpoch();
+    profile.iniSize = settings->GetFileSize();
+
+    profile.name = CombinedSetting(NeroSetting::Name, *this).toString();
+    profile.path = CombinedSetting(NeroSetting::Path, *this).toString();
+    QString cPath = profile.prefixPath % '/' % drive_c;
+    profile.workingDir = profile.path.left(profile.path.lastIndexOf("/")).replace(cDrive, cPath);
+
+    CombinedSetting prerun = CombinedSetting(NeroSetting::PreRunScript, *this);
+    if(prerun.hasSetting()) profile.preRunScript = prerun.toString();
+    profile.preRunBackground = CombinedSetting(NeroSetting::PreRunInBackground, *this).toBool();
+    CombinedSetting postrunScript = CombinedSetting(NeroSetting::PostRunScript, *this);
+    if(postrunScript.hasShortcutSetting()) profile.postRunScript = postrunScript.toString();
+
+    // the helpers below insert straight into env, so start from an empty one
+    // to only collect what Nero sets on its own.
+    env = QProcessEnvironment();
+    loggingEnabled = false;
+
+    env.insert(CliArgs::Wine::prefix, profile.prefixPath);
 
     // Only explicit set GAMEID when not already declared by user
     // See SeongGino/Nero-umu#66 for more info
-    if(!env.contains(CliArgs::gameId)) {
-        env.insert(CliArgs::gameId, "0");
-    }
-    QString protonRunner = CombinedSetting(NeroConfig::currentRunner, *this).toString();
-    QString runnerPath = NeroFS::GetProtonsPath()->path() % '/' % protonRunner;
-    if(!QFile::exists(runnerPath)) {
-        printf("Could not find %s in '%s', ", protonRunner.toLocal8Bit().constData(), NeroFS::GetProtonsPath()->absolutePath().toLocal8Bit().constData());
-        if(!NeroFS::GetAvailableProtons()->isEmpty()) {
-            protonRunner = NeroFS::GetAvailableProtons()->first();
+    profile.envDefaults.insert(CliArgs::gameId, "0");
+
+    profile.runner = CombinedSetting(NeroSetting::CurrentRunner, *this).toString();
+    profile.runnerPath = NeroFS::GetRunnerPath(profile.runner);
+    if(!QFile::exists(profile.runnerPath)) {
+        printf("Could not find %s in any runner directory, ", profile.runner.toLocal8Bit().constData());
+        const QString replacement = NeroRunnerIndex::Get()->FindReplacement(profile.runner);
+        if(!replacement.isEmpty()) {
+            profile.runner = replacement;
+            profile.runnerPath = NeroFS::GetRunnerPath(profile.runner);
         }
-        printf("using %s instead\n", protonRunner.toLocal8Bit().constData());
-    }
-    env.insert(CliArgs::protonPath, runnerPath);
-    bool isRuntimeUpdate = CombinedSetting(NeroConfig::runtimeUpdate, *this).toBool();
-    if(isRuntimeUpdate && !env.contains(CliArgs::umuRuntimeUpdate)){
-        env.insert(CliArgs::umuRuntimeUpdate, TRUE);
+        printf("using %s instead\n", profile.runner.toLocal8Bit().constData());
     }
+    env.insert(CliArgs::protonPath, profile.runnerPath);
 
-    prefixAlreadyRunning
-        ? env.insert(CliArgs::verb, CliArgs::run)
-        : env.insert(CliArgs::verb, CliArgs::waitForExitRun);
+    if(CombinedSetting(NeroSetting::RuntimeUpdateOnLaunch, *this).toBool())
+        profile.envDefaults.insert(CliArgs::umuRuntimeUpdate, TRUE);
 
     // WAS added here to unrotate Switch controllers,
     // but may not actually be necessary on newer versions based on SDL3? iunno
-    if(!env.contains(CliArgs::sdlUseButtonLabels)) {
-        env.insert(CliArgs::sdlUseButtonLabels, FALSE);
-    }
+    profile.envDefaults.insert(CliArgs::sdlUseButtonLabels, FALSE);
 
-    InitCache();
+    CombinedSetting dllOverride = CombinedSetting(NeroSetting::DLLoverrides, *this);
+    CombinedSetting ignored(NeroSetting::IgnoreGlobalDLLs, *this);
+    profile.dllOverrides = ignored.toBool()
+                        ? dllOverride.toStringList()
+                        : dllOverride.getPrefixVariant().toStringList() << dllOverride.toStringList();
 
-    //if(!settings->value("Shortcuts--"+hash+"/CustomEnvVars").toString().isEmpty()) {
-    //   q) << settings->value("Shortcuts--"+hash+"/CustomEnvVars").toStringList();
-    //}
-    CombinedSetting dllOverride = CombinedSetting(NeroConfig::dllOverride, *this);
-    CombinedSetting ignored(NeroConfig::ignoreGlobalDlls, *this);
-    bool ignoreGlobalDlls = ignored.toBool();
-    QStringList dllShortcutOverrides = ignoreGlobalDlls
-                                    ? dllOverride.toStringList()
-                                    : dllOverride.getPrefixVariant().toStringList() << dllOverride.toStringList();
-    dllShortcutOverrides << env.value(CliArgs::Wine::dllOverrides);
-    env.insert(CliArgs::Wine::dllOverrides, dllShortcutOverrides.join(';'));
-
-    CombinedSetting forceWine = CombinedSetting(NeroConfig::Proton::forceWineD3D, *this);
-    CombinedSetting disableD8vk(NeroConfig::Proton::noD8VK, *this);
+    CombinedSetting forceWine = CombinedSetting(NeroSetting::ForceWineD3D, *this);
+    CombinedSetting disableD8vk(NeroSetting::NoD8VK, *this);
     if (forceWine.hasSetting()) {
         bool isWine = forceWine.toBool();
         env.insert(CliArgs::Proton::useWineD3D, QString::number(isWine));
@@ -129,43 +298,33 @@ int NeroRunner::StartShortcut(const QString &hash, const bool &prefixAlreadyRunn
         {NeroConfig::forceIGpu,                 CliArgs::forceIgpu},
     };
     boolOptions = InsertArgs(boolOptions, false);
-    int fpsLimit = CombinedSetting(NeroConfig::limitFps, *this).toInt();
+    int fpsLimit = CombinedSetting(NeroSetting::LimitFPS, *this).toInt();
     if(fpsLimit)
         env.insert(CliArgs::dxvkFrameRate, QString::number(fpsLimit));
-    int syncType = CombinedSetting(NeroConfig::fileSyncMode, *this).toInt();
-    SetSyncMode(protonRunner, syncType);
-    CombinedSetting debug(NeroConfig::debugOutput, *this);
+    profile.syncMode = CombinedSetting(NeroSetting::FileSyncMode, *this).toInt();
+    CombinedSetting debug(NeroSetting::DebugOutput, *this);
     if(debug.hasSetting()) {
         InitDebugProperties(debug.toInt());
     }
     // TODO: ideally, we should set this as a colon-separated list of whitelisted "0xVID/0xPID" pairs
     //       but I guess this'll do for now.
-    CombinedSetting(NeroConfig::Proton::allowHidraw, *this).hasSettingAndToBool()
+    CombinedSetting(NeroSetting::AllowHidraw, *this).hasSettingAndToBool()
             ? env.insert(CliArgs::Proton::hiDraw, TRUE)
             : env.insert(CliArgs::Proton::preferSdl, TRUE);
 
-    CombinedSetting(NeroConfig::Proton::useXalia, *this).hasSettingAndToBool()
+    CombinedSetting(NeroSetting::UseXalia, *this).hasSettingAndToBool()
             ? env.insert(CliArgs::Proton::useXalia, TRUE)
             : env.insert(CliArgs::Proton::useXalia, FALSE);
 
-    bool isWaylandEnv = env.contains(CliArgs::waylandDisplay)
-            ? !env.value(CliArgs::waylandDisplay).isEmpty()
-            : false;
-    CombinedSetting wayland(NeroConfig::Proton::useWayland, *this);
-    if (isWaylandEnv && wayland.hasSetting() && wayland.toBool()) {
-        env.insert(CliArgs::Proton::enableWayland, TRUE);
-        bool isHdrEnabled = CombinedSetting(NeroConfig::Proton::useHdr, *this).toBool();
-        if (isHdrEnabled) {
-            env.insert(CliArgs::Proton::useHdr, TRUE);
-        }
-    }
-    QStringList arguments = {NeroFS::GetUmU(), pathSetting.toString()};
-    // some arguments are parsed as stringlists and others as string, so check which first.;
+    CombinedSetting wayland(NeroSetting::UseWayland, *this);
+    profile.wayland = wayland.hasSetting() && wayland.toBool();
+    profile.hdr = CombinedSetting(NeroSetting::UseHDR, *this).toBool();
 
-    QVariant argsVar =  CombinedSetting(NeroConfig::args, *this).getSettingVariant();
+    // some arguments are parsed as stringlists and others as string, so check which first.;
+    QVariant argsVar =  CombinedSetting(NeroSetting::Args, *this).getSettingVariant();
     int t = argsVar.type();
     if (t == QMetaType::QStringList && !argsVar.toStringList().isEmpty()) {
-        arguments.append(argsVar.toStringList());
+        profile.args.append(argsVar.toStringList());
     } else if (t == QMetaType::QString && !argsVar.toString().isEmpty()) {
         // SUPER UNGA BUNGA: manually split string into a list
         QString buf = argsVar.toString();
@@ -187,57 +346,74 @@ int NeroRunner::StartShortcut(const QString &hash, const bool &prefixAlreadyRunn
             }
         }
         if(args.last().isEmpty()) args.removeLast();
-        arguments.append(args);
+        profile.args.append(args);
     }
 
-    if(CombinedSetting(NeroConfig::gamemode, *this).toBool())
-        arguments.prepend(CliArgs::gamemoderun);
+    profile.gamemode = CombinedSetting(NeroSetting::Gamemode, *this).toBool();
 
-    int scalingMode = CombinedSetting(NeroConfig::Gamescope::scalingMode, *this).toInt();
-    QStringList gamescopeArgs = SetScalingMode(scalingMode, fpsLimit, false);
-    arguments = SetMangohud(gamescopeArgs, arguments);
+    int scalingMode = CombinedSetting(NeroSetting::ScalingMode, *this).toInt();
+    profile.gamescope = SetScalingMode(scalingMode, fpsLimit, false);
+    profile.mangohud = CombinedSetting(NeroSetting::Mangohud, *this).hasSettingAndToBool();
+    if(!profile.gamescope.isEmpty()) {
+        if(profile.mangohud) profile.gamescope << CliArgs::mangoapp;
+        profile.gamescope << CliArgs::doubleDash;
+    }
 
-    runner.setProcessEnvironment(env);
-    // some apps requires working directory to be in the right location
-    // (corrected if path starts with Windows drive letter prefix)
-    // settings->value("Shortcuts--"+hash+"/Path").toString();
+    profile.logging = loggingEnabled;
+    profile.warmPrefix = PrefixSetting(NeroSetting::WarmPrefix, *this).toBool();
 
-    runner.setWorkingDirectory(workingDir);
-    QString command = arguments.takeFirst();
-    QString name = CombinedSetting(NeroConfig::name, *this).toString();
-    QDir logsDir(prefixPath);
-    if(!logsDir.exists(Logs::logDirName))
-        logsDir.mkdir(Logs::logDirName);
-    logsDir.cd(Logs::logDirName);
-    QFile log = QFile(logsDir.path() % '/' % name % '-' % hash % ".txt");
-    if(loggingEnabled) {
-        log.open(QIODevice::WriteOnly);
-        log.resize(0);
-        log.write(Logs::currentlyRunningEnv.toLocal8Bit());
-        log.write(runner.environment().join('\n').toLocal8Bit());
-        log.write(Logs::runningCommand.toLocal8Bit() % command.toLocal8Bit() % ' ' % arguments.join(' ').toLocal8Bit() % Logs::newLine.toLocal8Bit());
-        log.write(Logs::blankLine.toLocal8Bit());
-    }
-    runner.start(command, arguments);
-    runner.waitForStarted(-1);
-    WaitLoop(runner, log);
+    profile.cpuSet = CombinedSetting(NeroSetting::CpuSet, *this).toInt();
+    profile.cpuList = CombinedSetting(NeroSetting::CpuList, *this).toString();
+    profile.priority = CombinedSetting(NeroSetting::ProcessPriority, *this).toInt();
+    profile.ioPriority = CombinedSetting(NeroSetting::IoPriority, *this).toInt();
+    profile.elevateScheduling = CombinedSetting(NeroSetting::ElevateScheduling, *this).toBool();
 
-    // in case settings changed from manager
-    settings = NeroFS::GetCurrentPrefixCfg();
+    const QStringList envKeys = env.keys();
+    for(const auto &key : envKeys)
+        profile.env.insert(key, env.value(key));
 
-    CombinedSetting postrunScript = CombinedSetting(NeroConfig::postRunScript, *this);
-    if(postrunScript.hasShortcutSetting()) {
-        runner.start(postrunScript.toString(), (QStringList){});
+    return profile;
+}
 
-        while(runner.state() != QProcess::NotRunning) {
-            runner.waitForReadyRead(-1);
-            printf("%s", runner.readAll().constData());
-        }
+QStringList NeroRunner::ApplyProfile(const NeroLaunchProfile &profile)
+{
+    env = baseEnv.isEmpty() ? QProcessEnvironment::systemEnvironment() : baseEnv;
+
+    for(auto i = profile.env.constBegin(); i != profile.env.constEnd(); ++i)
+        env.insert(i.key(), i.value());
+
+    for(auto i = profile.envDefaults.constBegin(); i != profile.envDefaults.constEnd(); ++i)
+        if(!env.contains(i.key())) env.insert(i.key(), i.value());
+
+    SkipFreshRuntimeUpdate();
+    SetSyncMode(profile.runner, profile.syncMode);
 
-        printf("%s", runner.readAll().constData());
+    QStringList dllOverrides = profile.dllOverrides;
+    dllOverrides << env.value(CliArgs::Wine::dllOverrides);
+    env.insert(CliArgs::Wine::dllOverrides, dllOverrides.join(';'));
+
+    bool isWaylandEnv = env.contains(CliArgs::waylandDisplay)
+            ? !env.value(CliArgs::waylandDisplay).isEmpty()
+            : false;
+    if(isWaylandEnv && profile.wayland) {
+        env.insert(CliArgs::Proton::enableWayland, TRUE);
+        if(profile.hdr)
+            env.insert(CliArgs::Proton::useHdr, TRUE);
     }
 
-    return runner.exitCode();
+    loggingEnabled = profile.logging;
+
+    QStringList arguments = {NeroFS::GetUmU(), profile.path};
+    arguments.append(profile.args);
+
+    if(profile.gamemode)
+        arguments.prepend(CliArgs::gamemoderun);
+
+    // mangoapp is already part of the gamescope args, otherwise respect user's own MANGOHUD var
+    if(profile.mangohud && profile.gamescope.isEmpty() && !env.contains(NeroConfig::mangohud.toUpper()))
+        arguments.prepend(NeroConfig::mangohud.toLower());
+
+    return profile.gamescope + arguments;
 }
 
 QString NeroRunner::GamescopeFilterType(int filterVal) {
@@ -261,16 +437,33 @@ int NeroRunner::StartOnetime(const QString &path, const bool &prefixAlreadyRunni
     // failsafe for cli runs
     if(NeroFS::GetUmU().isEmpty()) return -1;
 
-    settings = NeroFS::GetCurrentPrefixCfg();
+    NeroScheduledProcess runner;
+    NeroLogWriter log(Logs::keepRuns, Logs::segmentSize);
+    QString command;
+    QStringList arguments;
+    PrepareOnetime(path, prefixAlreadyRunning, args, runner, log, command, arguments);
+
+    runner.start(command, arguments);
+    runner.waitForStarted(-1);
+    NeroScheduling::Apply(scheduling, runner.processId());
+    WaitLoop(runner, log);
+    FinishCache();
+
+    return runner.exitCode();
+}
+
+void NeroRunner::PrepareOnetime(const QString &path, const bool &prefixAlreadyRunning, const QStringList &args,
+                                NeroScheduledProcess &runner, NeroLogWriter &log, QString &command, QStringList &arguments)
+{
+    settings = NeroFS::GetPrefixCfg(prefix);
 
-    QProcess runner;
     // umu seems to direct both umu-run frontend and Proton output to stderr,
     // meaning stdout is virtually unused.
     runner.setProcessChannelMode(QProcess::ForwardedOutputChannel);
     runner.setReadChannel(QProcess::StandardError);
 
-    env = QProcessEnvironment::systemEnvironment();
-    QString prefixPath = NeroFS::GetPrefixesPath()->path() % '/' % NeroFS::GetCurrentPrefix();
+    env = baseEnv.isEmpty() ? QProcessEnvironment::systemEnvironment() : baseEnv;
+    QString prefixPath = NeroFS::GetPrefixesPath()->path() % '/' % prefix;
     env.insert(CliArgs::Wine::prefix, prefixPath);
 
     // Only explicit set GAMEID when not already declared by user
@@ -280,19 +473,22 @@ int NeroRunner::StartOnetime(const QString &path, const bool &prefixAlreadyRunni
         env.insert(CliArgs::gameId, "0");
     }
     QString protonRunner = PrefixSetting(NeroConfig::currentRunner, *this).toString();
-    QString runnerPath = NeroFS::GetProtonsPath()->path()% '/' % protonRunner;
+    QString runnerPath = NeroFS::GetRunnerPath(protonRunner);
     if(!QFile::exists(runnerPath)) {
-        printf("Could not find %s in '%s', ", protonRunner.toLocal8Bit().constData(), NeroFS::GetProtonsPath()->absolutePath().toLocal8Bit().constData());
-        if(!NeroFS::GetAvailableProtons()->isEmpty()) {
-            protonRunner = NeroFS::GetAvailableProtons()->first();
+        printf("Could not find %s in any runner directory, ", protonRunner.toLocal8Bit().constData());
+        const QString replacement = NeroRunnerIndex::Get()->FindReplacement(protonRunner);
+        if(!replacement.isEmpty()) {
+            protonRunner = replacement;
+            runnerPath = NeroFS::GetRunnerPath(protonRunner);
         }
         printf("using %s instead\n", protonRunner.toLocal8Bit().constData());
     }
     env.insert(CliArgs::protonPath, runnerPath);
+    // one-time runs are mostly installers (vcredist, dotnet, .msi's), which write straight into system32 like winetricks does.
+    NeroDedup::Unshare(prefixPath);
 
-    prefixAlreadyRunning
-        ? env.insert(CliArgs::verb, CliArgs::run)
-        : env.insert(CliArgs::verb, CliArgs::waitForExitRun);
+    sessionId = NeroProcessTree::NewSessionId();
+    env.insert(CliArgs::neroSession, sessionId);
 
     if(!env.contains(CliArgs::sdlUseButtonLabels)) {
         env.insert(CliArgs::sdlUseButtonLabels, FALSE);
@@ -302,6 +498,7 @@ int NeroRunner::StartOnetime(const QString &path, const bool &prefixAlreadyRunni
     bool isRuntimeUpdateOnLaunch = PrefixSetting(NeroConfig::runtimeUpdate, *this).toBool();
     if(isRuntimeUpdateOnLaunch) {
         env.insert(CliArgs::umuRuntimeUpdate, TRUE);
+        SkipFreshRuntimeUpdate();
     }
     QStringList dllOverrides = PrefixSetting(NeroConfig::dllOverride, *this).toStringList();
     if(!dllOverrides.isEmpty()) {
@@ -325,6 +522,11 @@ int NeroRunner::StartOnetime(const QString &path, const bool &prefixAlreadyRunni
     simpleBoolSettings = InsertArgs(simpleBoolSettings, isPrefixOnly);
     int fileSyncMode = PrefixSetting(NeroConfig::fileSyncMode, *this).toInt();
     SetSyncMode(protonRunner, fileSyncMode);
+    // after the sync mode's been picked, so a warm server gets started in the same one
+    warmPrefix = PrefixSetting(NeroConfig::warmPrefix, *this).toBool();
+    NeroWineserver::Prepare(prefixPath, runnerPath, NeroWineserver::GetSyncEnv(env), warmPrefix, prefixAlreadyRunning)
+        ? env.insert(CliArgs::verb, CliArgs::run)
+        : env.insert(CliArgs::verb, CliArgs::waitForExitRun);
     int debugVal = PrefixSetting(NeroConfig::debugOutput, *this).toInt();
     InitDebugProperties(debugVal);
     // Different logic for Prefix Launch of this versus shortcut; is that intentional?
@@ -361,7 +563,7 @@ int NeroRunner::StartOnetime(const QString &path, const bool &prefixAlreadyRunni
         }
     }
 
-    QStringList arguments = {NeroFS::GetUmU()};
+    arguments = QStringList{NeroFS::GetUmU()};
 
     // Proton/umu should be able to translate Windows-type paths on its own, no conversion needed
     arguments.append(path);
@@ -378,30 +580,30 @@ int NeroRunner::StartOnetime(const QString &path, const bool &prefixAlreadyRunni
     arguments = SetMangohud(gamescopeArgs, arguments);
 
     runner.setProcessEnvironment(env);
+    scheduling = NeroScheduling::GetPolicy(PrefixSetting(NeroConfig::cpuSet, *this).toInt(),
+                                           PrefixSetting(NeroConfig::cpuList, *this).toString(),
+                                           PrefixSetting(NeroConfig::processPriority, *this).toInt(),
+                                           PrefixSetting(NeroConfig::ioPriority, *this).toInt(),
+                                           PrefixSetting(NeroConfig::elevateScheduling, *this).toBool());
+    runner.SetPolicy(scheduling);
     if(path.startsWith('/') || path.startsWith("~/") || path.startsWith("./")) {
-        runner.setWorkingDirectory(path.left(path.lastIndexOf("/")).replace("C:", NeroFS::GetPrefixesPath()->canonicalPath()+'/'+NeroFS::GetCurrentPrefix()+"/drive_c/"));
+        runner.setWorkingDirectory(path.left(path.lastIndexOf("/")).replace("C:", NeroFS::GetPrefixesPath()->canonicalPath()+'/'+prefix+"/drive_c/"));
     }
 
-    QString command = arguments.takeFirst();
+    command = arguments.takeFirst();
 
     QDir logsDir(prefixPath);
     if(!logsDir.exists(Logs::logDirName))
         logsDir.mkdir(Logs::logDirName);
     logsDir.cd(Logs::logDirName);
-    QFile log = QFile(logsDir.path() % '/' % path.mid(path.lastIndexOf('/')+1) % ".txt");
-    if(loggingEnabled) {
-        log.open(QIODevice::WriteOnly);
-        log.resize(0);
-        log.write(Logs::currentlyRunningEnv.toLocal8Bit());
-        log.write(runner.environment().join('\n').toLocal8Bit());
-        log.write(Logs::runningCommand.toLocal8Bit() % command.toLocal8Bit() % ' ' % arguments.join(' ').toLocal8Bit() % Logs::newLine.toLocal8Bit());
-        log.write(Logs::blankLine.toLocal8Bit());
+    logPath = logsDir.path() % '/' % path.mid(path.lastIndexOf('/')+1);
+    if(loggingEnabled && log.Open(logPath)) {
+        log.Write(syncSummary.toLocal8Bit() % Logs::newLine.toLocal8Bit());
+        log.Write(Logs::currentlyRunningEnv.toLocal8Bit());
+        log.Write(runner.environment().join('\n').toLocal8Bit());
+        log.Write(Logs::runningCommand.toLocal8Bit() % command.toLocal8Bit() % ' ' % arguments.join(' ').toLocal8Bit() % Logs::newLine.toLocal8Bit());
+        log.Write(Logs::blankLine.toLocal8Bit());
     }
-    runner.start(command, arguments);
-    runner.waitForStarted(-1);
-    WaitLoop(runner, log);
-
-    return runner.exitCode();
 }
 
 QStringList NeroRunner::SetScalingMode(int scalingMode, int fpsLimit, bool isPrefixOnly) {
@@ -552,17 +754,28 @@ QStringList NeroRunner::SetGamescopeArgs(int scalingMode, int fpsLimit, bool isP
 
 void NeroRunner::SetSyncMode(QString protonRunner, int syncType)
 {
-    // ntsync SHOULD be better in all scenarios compared to other sync options, but requires kernel 6.14+ and GE-Proton10-9+
-        // For older Protons, they should be safely ignoring this and fallback to fsync anyways.
-        // Newer protons than GE10-9 should enable this automatically from its end, and doesn't require WOW64
+    // ntsync SHOULD be better in all scenarios compared to other sync options, but requires kernel 6.14+ and a runner that knows about it
+        // (see NeroSync for how both of those are checked).
+        // GE-Proton10-9 also needs WOW64 for it, unlike anything newer
         // (and currently, WOW64 seems problematic for some fringe cases, like TeknoParrot's BudgieLoader not spawning a window)
 
-    switch(syncType) {
+    const NeroRunnerInfo runnerInfo = NeroRunnerIndex::Get()->Find(protonRunner);
+    const NeroRunnerVersion &version = runnerInfo.version;
+
+    QString reason;
+    const int resolved = NeroSync::Resolve(syncType, runnerInfo, &reason);
+    syncSummary = QString("Sync: %1 (%2%3)").arg(NeroSync::GetName(resolved),
+                                                 syncType == NeroConstant::AutoSync ? "auto, " : "", reason);
+    printf("%s\n", syncSummary.toLocal8Bit().constData());
+
+    // the default mode only ever turns ntsync on, and leaves anything else to Proton's own fallbacks like it always has.
+    if(syncType == NeroConstant::NTsync && resolved != NeroConstant::NTsync) return;
+
+    switch(resolved) {
         case NeroConstant::NTsync:
-            if(protonRunner == ge109) {
-                env.insert(CliArgs::Proton::Sync::ntSync, TRUE);
+            env.insert(CliArgs::Proton::Sync::ntSync, TRUE);
+            if(version.flavor == NeroRunnerVersion::GE && version.major == 10 && version.minor == 9)
                 env.insert(CliArgs::useWow64, TRUE);
-            }
             break;
         case NeroConstant::Fsync:
             env.insert(CliArgs::Proton::Sync::noNtSync, TRUE);
@@ -578,42 +791,105 @@ void NeroRunner::SetSyncMode(QString protonRunner, int syncType)
     }
 }
 
-void NeroRunner::WaitLoop(QProcess &runner, QFile &log)
+void NeroRunner::WaitLoop(QProcess &runner, NeroLogWriter &log)
 {
-    QByteArray stdout;
-    while(runner.state() != QProcess::NotRunning) {
-        if(!halt) {
-            runner.waitForReadyRead(1000);
-            if(runner.canReadLine()) {
-                stdout = runner.readLine();
-                printf("%s", stdout.constData());
-                if(loggingEnabled)
-                    log.write(stdout);
-
-                if(stdout.contains("umu-launcher"))
-                    emit StatusUpdate(NeroRunner::RunnerStarting);
-                else if(stdout.contains("steamrt3 is up to date"))
-                    emit StatusUpdate(NeroRunner::RunnerUpdated);
-                else if(stdout.startsWith("Proton: Executable") || stdout.contains("SteamAPI_Init"))
-                    emit StatusUpdate(NeroRunner::RunnerProtonStarted);
-            }
-        } else {
-            emit StatusUpdate(NeroRunner::RunnerProtonStopping);
-            StopProcess();
-            emit StatusUpdate(NeroRunner::RunnerProtonStopped);
-            break;
-        }
+    // everything's driven off of the process' own signals, so output is handled as soon as it arrives
+    // and a halt request doesn't have to wait around for a poll timeout.
+    QEventLoop loop;
+    bool protonStarted = false;
+
+    connect(&runner, &QProcess::readyRead, &loop, [&]() { DrainOutput(runner, log, protonStarted); });
+    connect(&runner, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), &loop, &QEventLoop::quit);
+
+    waitLoopMutex.lock();
+    waitLoop = &loop;
+    waitLoopMutex.unlock();
+    runnerPid = runner.processId();
+
+    if(!halt && runner.state() != QProcess::NotRunning)
+        loop.exec();
+
+    waitLoopMutex.lock();
+    waitLoop = nullptr;
+    waitLoopMutex.unlock();
+
+    DrainOutput(runner, log, protonStarted);
+
+    if(halt) {
+        emit StatusUpdate(NeroRunner::RunnerProtonStopping);
+        StopProcess(haltKeepsServer);
+        emit StatusUpdate(NeroRunner::RunnerProtonStopped);
     }
 
+    // umu doesn't always end on a newline, so grab any stragglers too.
     while(!runner.atEnd()) {
-        stdout = runner.readLine();
-        printf("%s", stdout.constData());
-        if(loggingEnabled)
-            log.write(stdout);
+        const QByteArray output = runner.readLine();
+        printf("%s", output.constData());
+        log.Write(output);
+    }
+
+    log.Close();
+}
+
+void NeroRunner::DrainOutput(QProcess &runner, NeroLogWriter &log, bool &protonStarted)
+{
+    static const QByteArrayMatcher umuStarting("umu-launcher");
+    static const QByteArrayMatcher runtimeUpdated("steamrt3 is up to date");
+    static const QByteArrayMatcher steamApiInit("SteamAPI_Init");
+
+    QByteArray output;
+    while(runner.canReadLine()) {
+        const QByteArray line = runner.readLine();
+        output.append(line);
+
+        // statuses only matter up until the game's actually up
+        if(!protonStarted) {
+            if(umuStarting.indexIn(line) >= 0)
+                emit StatusUpdate(NeroRunner::RunnerStarting);
+            else if(runtimeUpdated.indexIn(line) >= 0) {
+                timings.Mark(NeroLaunchTimings::RuntimeCheck);
+                NeroFS::SetRuntimeVerified();
+                emit StatusUpdate(NeroRunner::RunnerUpdated);
+            } else if(line.startsWith("Proton: Executable") || steamApiInit.indexIn(line) >= 0) {
+                // if Proton never said anything before this, its part of the wait is folded into this one,
+                // and ProtonStart's left unset instead of coming out as zero.
+                timings.Mark(NeroLaunchTimings::ExecutableStart);
+                emit StatusUpdate(NeroRunner::RunnerProtonStarted);
+                protonStarted = true;
+            } else if(line.startsWith("Proton:") || line.startsWith("ProtonFixes"))
+                timings.Mark(NeroLaunchTimings::ProtonStart);
+        }
     }
 
-    if(loggingEnabled && log.isOpen())
-        log.close();
+    if(output.isEmpty()) return;
+
+    // one write per batch instead of one per line
+    fwrite(output.constData(), 1, output.size(), stdout);
+    fflush(stdout);
+    log.Write(output);
+}
+
+void NeroRunner::SkipFreshRuntimeUpdate()
+{
+    // an update the user asked for in their own environment always goes through
+    if(env.value(CliArgs::umuRuntimeUpdate) != TRUE || QProcessEnvironment::systemEnvironment().contains(CliArgs::umuRuntimeUpdate))
+        return;
+
+    if(NeroFS::RuntimeIsFresh()) {
+        printf("Steam Runtime was verified recently, skipping update check.\n");
+        env.insert(CliArgs::umuRuntimeUpdate, FALSE);
+    }
+}
+
+void NeroRunner::Halt(const bool &keepServer)
+{
+    haltKeepsServer = keepServer;
+    halt = true;
+
+    // wake the wait loop up right away, from whatever thread asked for this.
+    QMutexLocker locker(&waitLoopMutex);
+    if(waitLoop != nullptr)
+        QMetaObject::invokeMethod(waitLoop, "quit", Qt::QueuedConnection);
 }
 
 void NeroRunner::InitDebugProperties(int value)
@@ -632,30 +908,35 @@ void NeroRunner::InitDebugProperties(int value)
     }
 }
 
-void NeroRunner::StopProcess()
+void NeroRunner::StopProcess(const bool &keepServer)
 {
-    // TODO: there's almost certainly a not-shitty way of stopping spawned Wine processes
-    //       currently, the Kingdom Hearts Re-Fined patches will consistently lock up the prefix and remains resident
-    //       even after this shutdown op has supposedly completed.
-    QApplication::processEvents();
-    QProcess wineStopper;
-    env.insert("UMU_NO_PROTON", "1");
-    env.remove("UMU_RUNTIME_UPDATE");
-    env.insert("UMU_RUNTIME_UPDATE", "0");
-    wineStopper.setProcessEnvironment(env);
-    wineStopper.start(NeroFS::GetUmU(), { NeroFS::GetProtonsPath()->path()+'/'+NeroFS::GetCurrentRunner()+'/'+"proton", "runinprefix", "wineboot", "-e" });
-    wineStopper.waitForFinished();
+    const QString prefixPath = NeroFS::GetPrefixesPath()->path() % '/' % prefix;
+
+    // keepServer only ends this launch's own processes; otherwise, the prefix's wineserver takes every client down with it.
+    // Stuck processes (i.e. the Kingdom Hearts Re-Fined patches) get SIGKILLed once the deadline's up.
+    const int deadline = NeroFS::GetManagerValue(NeroConfig::Manager::stopTimeout,
+                                                 NeroConfig::Manager::stopTimeoutDefault).toInt();
+    if(!NeroProcessTree::Terminate(sessionId, runnerPid, prefixPath, env.value(CliArgs::protonPath), !keepServer, deadline))
+        printf("Not everything in %s could be stopped!\n", prefix.toLocal8Bit().constData());
+
+    // a warm prefix's server sticks around for the next launch unless told otherwise.
+    if(warmPrefix && !keepServer)
+        NeroWineserver::Shutdown(prefixPath);
 }
 
-void NeroRunner::InitCache()
+void NeroRunner::InitCache(const QString &cacheId, const QString &shareKey)
 {
-    QDir cachePath(NeroFS::GetPrefixesPath()->path()+'/'+NeroFS::GetCurrentPrefix());
-    if(!cachePath.exists(".shaderCache")) {
-        cachePath.mkdir(".shaderCache");
-        if(!cachePath.cd(".shaderCache")) printf("Prefix cache directory not available! Not using cache...");
-        else {
-            env.insert("DXVK_STATE_CACHE_PATH", cachePath.absolutePath());
-            env.insert("VKD3D_SHADER_CACHE_PATH", cachePath.absolutePath());
-        }
-    }
+    InitCache(env, cacheId, shareKey);
+}
+
+void NeroRunner::InitCache(QProcessEnvironment &cacheEnv, const QString &cacheId, const QString &shareKey)
+{
+    shaderShareKey = shareKey;
+    shaderCachePath = NeroShaderCache::Prepare(cacheEnv, NeroFS::GetPrefixesPath()->path() % '/' % prefix, cacheId, shareKey);
+    shaderCacheSize = shaderCachePath.isEmpty() ? 0 : NeroShaderCache::GetSize(shaderCachePath);
+}
+
+void NeroRunner::FinishCache()
+{
+    NeroShaderCache::Finish(shaderCachePath, shaderCacheSize, shaderShareKey);
 }
@@ -21,30 +21,89 @@
 #define NERORUNNER_H
 
 #include "nerofs.h"
+#include "nerolog.h"
+#include "neroprofile.h"
+#include "neroscheduling.h"
+#include "nerosettings.h"
+#include "nerotimings.h"
 
 #include <QString>
+#include <QEventLoop>
+#include <QMutex>
+#include <QProcess>
 #include <QProcessEnvironment>
 #include <QFile>
 #include <QStringBuilder>
 #include <qvariant.h>
 
+#include <atomic>
+
+class NeroLaunchPipeline;
+
 class NeroRunner : public QObject
 {
     Q_OBJECT
 public:
-    NeroRunner() {};
+    // everything a runner does is against this prefix, not whatever the manager happens to have open.
+    explicit NeroRunner(const QString &prefix = NeroFS::GetCurrentPrefix()) : prefix(prefix) {};
 
+    // these block until the run's done - for the CLI, daemon and anything else that can spare a thread.
     int StartShortcut(const QString &, const bool & = false);
     int StartOnetime(const QString &, const bool & = false, const QStringList & = {});
+    // the same runs split up, for callers that drive the process themselves (see NeroSession).
+    // Prepare fills in the process' environment/working dir and opens the log, leaving it for the caller to start.
+    // For shortcuts that's a set of stages added to the pipeline, so everything passed in has to outlive it finishing.
+    bool CanLaunch(const NeroLaunchProfile &) const;
+    void PrepareShortcut(NeroLaunchPipeline &, const NeroLaunchProfile &, const bool &prefixAlreadyRunning,
+                         NeroScheduledProcess &, NeroLogWriter &, QString &command, QStringList &arguments);
+    void FinishShortcut(const NeroLaunchProfile &);
+    void PrepareOnetime(const QString &path, const bool &prefixAlreadyRunning, const QStringList &args,
+                        NeroScheduledProcess &, NeroLogWriter &, QString &command, QStringList &arguments);
+    // hands whatever full lines are waiting over to stdout and the log, and picks out statuses along the way.
+    void DrainOutput(QProcess &, NeroLogWriter &, bool &protonStarted);
+    const QString &GetPrefix() const { return prefix; }
+    NeroLaunchProfile GetProfile(const QString &);
+    NeroLaunchProfile ResolveProfile(const QString &);
+    QStringList ApplyProfile(const NeroLaunchProfile &);
     QString GetHash() {return hashVal;}
-    void WaitLoop(QProcess &, QFile &);
+    void WaitLoop(QProcess &, NeroLogWriter &);
+    // safe to call from any thread; stops the current run as soon as the wait loop sees it.
+    // keepServer lets a warm prefix's wineserver linger after its apps are stopped.
+    void Halt(const bool &keepServer = true);
     void writeToLog(QStringList lines);
-    void StopProcess();
-    void InitCache();
-    QSettings *settings = NeroFS::GetCurrentPrefixCfg();
-    bool halt = false;
+    void StopProcess(const bool &keepServer = true);
+    // per-shortcut (cacheId) shader cache, shared as shareKey with other prefixes running the same game.
+    void InitCache(const QString &cacheId = "", const QString &shareKey = "");
+    // same, but for an env that isn't the runner's own (i.e. a copy being worked on off-thread).
+    void InitCache(QProcessEnvironment &, const QString &cacheId, const QString &shareKey);
+    void FinishCache();
+    NeroPrefixCfg *settings = nullptr;
+    std::atomic<bool> halt{false};
+    std::atomic<bool> haltKeepsServer{true};
+    bool warmPrefix = false;
+    // tags everything spawned by the current launch, so it can all be found again when stopping.
+    QString sessionId;
+    qint64 runnerPid = 0;
+    QString shaderCachePath;
+    QString shaderShareKey;
+    qint64 shaderCacheSize = 0;
     bool loggingEnabled = false;
+    // base path (no extension) of the current run's log, whether or not logging's on
+    QString logPath;
+    // settings that win over both the shortcut's and the prefix's, for runs that shouldn't touch the ini (see NeroBench).
+    // Profiles resolved with any of these set are never cached.
+    QMap<QString, QVariant> overrides;
+    bool HasOverride(const NeroSetting::Key &key) const { return !overrides.isEmpty() && overrides.contains(NeroSetting::GetKey(key)); }
+    // where and how urgently the current run gets to use the CPU, set up by Prepare
+    NeroScheduling::Policy scheduling;
+    // which sync primitive the last Prepare* went with, and why - for the launch log
+    QString syncSummary;
     QProcessEnvironment env;
+    // what launches build env on top of instead of Nero's own environment, when it's set -
+    // e.g. the client's, for launches the daemon makes on someone else's behalf.
+    QProcessEnvironment baseEnv;
+    // of the last shortcut launch
+    NeroLaunchTimings timings;
     enum {
         RunnerStarting = 0,
         RunnerUpdated,
@@ -56,8 +115,13 @@ public:
     public:
         PrefixSetting(){}
         PrefixSetting(const QString settingName, NeroRunner &parent) {
-            QString hash = parent.GetHash();
-            this->settingVariant = parent.settings->value(prefixSettings % '/' % settingName);
+            this->settingVariant = parent.overrides.contains(settingName) ? parent.overrides.value(settingName)
+                                                                          : parent.settings->Value(prefixSettings, settingName);
+        }
+        // same, but straight out of the config's array for anything the schema has
+        PrefixSetting(const NeroSetting::Key setting, NeroRunner &parent) {
+            this->settingVariant = parent.HasOverride(setting) ? parent.overrides.value(NeroSetting::GetKey(setting))
+                                                               : parent.settings->Value(prefixSettings, setting);
         }
         const QString prefixSettings = "PrefixSettings";
 
@@ -84,11 +148,27 @@ public:
         CombinedSetting(){}
 
         CombinedSetting (const QString settingName, NeroRunner &parent) {
-            QString hash = parent.GetHash();
-            QString shortcutProperty =  shortcuts % hash % '/' % settingName;
-            QString prefixProperty = prefixSettings % '/' % settingName;
-            shortcut = parent.settings->value(shortcutProperty);
-            prefix = parent.settings->value(prefixProperty);
+            QString shortcutGroup = shortcuts % parent.GetHash();
+            shortcut = parent.overrides.contains(settingName) ? parent.overrides.value(settingName)
+                                                              : parent.settings->Value(shortcutGroup, settingName);
+            prefix = parent.settings->Value(prefixSettings, settingName);
+            Combine();
+        }
+        CombinedSetting (const NeroSetting::Key setting, NeroRunner &parent) {
+            const QString shortcutGroup = shortcuts % parent.GetHash();
+            shortcut = parent.HasOverride(setting) ? parent.overrides.value(NeroSetting::GetKey(setting))
+                                                   : parent.settings->Value(shortcutGroup, setting);
+            prefix = parent.settings->Value(prefixSettings, setting);
+            Combine();
+        }
+        QVariant getPrefixVariant() { return prefix; }
+        QVariant getShortcutVariant() { return shortcut; }
+        bool hasShortcutSetting() { return hasShortcut; }
+
+        bool hasSetting() override { return shortcut != QVariant() || prefix != QVariant(); }
+
+    private:
+        void Combine() {
             //blank QVariant means its default and is an invalid variant,
             //same as if we pulled an invalid property.
             if (shortcut != QVariant()) {
@@ -98,13 +178,7 @@ public:
                 PrefixSetting::settingVariant = prefix;
             }
         }
-        QVariant getPrefixVariant() { return prefix; }
-        QVariant getShortcutVariant() { return shortcut; }
-        bool hasShortcutSetting() { return hasShortcut; }
-
-        bool hasSetting() override { return shortcut != QVariant() || prefix != QVariant(); }
 
-    private:
         bool hasShortcut = false;
         QVariant prefix;
         QVariant shortcut;
@@ -120,6 +194,8 @@ private:
     QStringList SetMangohud(QStringList gamescope, QStringList arguments);
     int ConvertScaling(int scalingVal);
     void SetSyncMode(QString protonRunner, int syncType);
+    // the last of PrepareShortcut's stages: env onto the process, scheduling, and the log.
+    void FinishPrepare(const NeroLaunchProfile &, NeroScheduledProcess &, NeroLogWriter &, QString &command, QStringList &arguments);
     QStringList SetScalingMode(int scalingType, int fpsLimit, bool isPrefixOnly);
     QStringList SetGamescopeArgs(int scalingMode, int fpsLimit, bool isPrefixOnly);
     QStringList Gamescope(QMap<QString, QString> resMap, QStringList arguments);
@@ -132,10 +208,15 @@ private:
     const QString cDrive = "C:/";
     const QString drive_c = "drive_c/";
 
-    const QString ge109 = "GE-Proton10-9";
     void InitDebugProperties(int value);
+    // turns off UMU_RUNTIME_UPDATE if the runtime was confirmed current not long ago.
+    void SkipFreshRuntimeUpdate();
+    const QString prefix;
     QString hashVal;
 
+    QEventLoop *waitLoop = nullptr;
+    QMutex waitLoopMutex;
+
 
 signals:
     void StatusUpdate(int);
@@ -202,8 +283,10 @@ namespace CliArgs {
     const QString obsVkCapture = "OBS_VKCAPTURE";
     const QString protonPath = "PROTONPATH";
     const QString mangoapp = "--mangoapp";
+    const QString mangohudConfig = "MANGOHUD_CONFIG";
     const QString forceIgpu = "MESA_VK_DEVICE_SELECT_FORCE_DEFAULT_DEVICE";
     const QString umuRuntimeUpdate = "UMU_RUNTIME_UPDATE";
+    const QString neroSession = "NERO_SESSION";
     const QString gamemoderun = "gamemoderun";
     const QString gameId = "GAMEID";
     const QString useWow64 = "PROTON_USE_WOW64";
@@ -250,60 +333,76 @@ namespace CliArgs {
 
 namespace Logs {
     const QString logDirName = ".logs";
+    // how many previous runs' logs to keep around per shortcut, and when to start a new segment
+    const int keepRuns = 5;
+    const qint64 segmentSize = 64*1024*1024;
     const QString newLine = "\n";
     const QString currentlyRunningEnv = "Current running environment:" % newLine;
     const QString runningCommand = newLine % newLine % "Running command:" % newLine;
     const QString blankLine = "==============================================" % newLine;
 }
 
+// ini keys, for the places that still go by name - the ones the schema has come from it, see NeroSetting.
 namespace NeroConfig {
-    const QString name = "Name";
-    const QString currentRunner = "CurrentRunner";
-    const QString runtimeUpdate = "RuntimeUpdateOnLaunch";
+    const QString name = NeroSetting::GetKey(NeroSetting::Name);
+    const QString currentRunner = NeroSetting::GetKey(NeroSetting::CurrentRunner);
+    const QString runtimeUpdate = NeroSetting::GetKey(NeroSetting::RuntimeUpdateOnLaunch);
+    const QString warmPrefix = NeroSetting::GetKey(NeroSetting::WarmPrefix);
     const QString dlssIndicator = "DlssIndicator";
 
 
-    const QString path = "Path";
+    const QString path = NeroSetting::GetKey(NeroSetting::Path);
     //OBS
-    const QString vkCapture = "VKcapture";
+    const QString vkCapture = NeroSetting::GetKey(NeroSetting::VKcapture);
 
     //Force Integrated GPU
-    const QString forceIGpu = "ForceiGPU";
+    const QString forceIGpu = NeroSetting::GetKey(NeroSetting::ForceiGPU);
 
 
     namespace Proton {
-        const QString forceWineD3D = "ForceWineD3D";
-        const QString allowHidraw = "AllowHidraw";
-        const QString useXalia = "UseXalia";
-        const QString noD8VK = "NoD8VK";
-        const QString useWayland = "UseWayland";
-        const QString useHdr = "UseHDR";
-        const QString limitGlExtensions = "LimitGLextensions";
+        const QString forceWineD3D = NeroSetting::GetKey(NeroSetting::ForceWineD3D);
+        const QString allowHidraw = NeroSetting::GetKey(NeroSetting::AllowHidraw);
+        const QString useXalia = NeroSetting::GetKey(NeroSetting::UseXalia);
+        const QString noD8VK = NeroSetting::GetKey(NeroSetting::NoD8VK);
+        const QString useWayland = NeroSetting::GetKey(NeroSetting::UseWayland);
+        const QString useHdr = NeroSetting::GetKey(NeroSetting::UseHDR);
+        const QString limitGlExtensions = NeroSetting::GetKey(NeroSetting::LimitGLextensions);
     }
 
     // TODO: Standardize Resolutions
     namespace Gamescope{
         //FSR Custom Resolutions
-        const QString scalingType = "GamescopeScaler";
-        const QString scalingMode = "ScalingMode";
-        const QString fsrCustomW = "FSRcustomResW";
-        const QString fsrCustomH = "FSRcustomResH";
-        const QString filter = "GamescopeFilter";
-        const QString outputResH = "GamescopeOutResH";
-        const QString outputResW = "GamescopeOutResW";
-        const QString windowedResH = "GamescopeWinResH";
-        const QString windowedResW = "GamescopeWinResW";
+        const QString scalingType = NeroSetting::GetKey(NeroSetting::GamescopeScaler);
+        const QString scalingMode = NeroSetting::GetKey(NeroSetting::ScalingMode);
+        const QString fsrCustomW = NeroSetting::GetKey(NeroSetting::FSRcustomResW);
+        const QString fsrCustomH = NeroSetting::GetKey(NeroSetting::FSRcustomResH);
+        const QString filter = NeroSetting::GetKey(NeroSetting::GamescopeFilter);
+        const QString outputResH = NeroSetting::GetKey(NeroSetting::GamescopeOutResH);
+        const QString outputResW = NeroSetting::GetKey(NeroSetting::GamescopeOutResW);
+        const QString windowedResH = NeroSetting::GetKey(NeroSetting::GamescopeWinResH);
+        const QString windowedResW = NeroSetting::GetKey(NeroSetting::GamescopeWinResW);
+    }
+    const QString debugOutput = NeroSetting::GetKey(NeroSetting::DebugOutput);
+    const QString enableNvApi = NeroSetting::GetKey(NeroSetting::EnableNVAPI);
+
+    const QString limitFps = NeroSetting::GetKey(NeroSetting::LimitFPS);
+
+    const QString fileSyncMode = NeroSetting::GetKey(NeroSetting::FileSyncMode);
+    const QString ignoreGlobalDlls = NeroSetting::GetKey(NeroSetting::IgnoreGlobalDLLs);
+    const QString dllOverride = NeroSetting::GetKey(NeroSetting::DLLoverrides);
+    const QString gamemode = NeroSetting::GetKey(NeroSetting::Gamemode);
+    const QString args = NeroSetting::GetKey(NeroSetting::Args);
+
+    // Nero Manager's own config (NeroFS::GetManagerValue), not any prefix's
+    namespace Manager {
+        // how long a stopping launch gets before whatever's left of it is SIGKILLed
+        const QString stopTimeout = "StopTimeoutMs";
+        const int stopTimeoutDefault = 1500;
+        // 0 or less turns resource sampling off
+        const QString resourceSampleInterval = "ResourceSampleMs";
+        const int resourceSampleIntervalDefault = 2000;
+        const QString resourceSampleGpu = "ResourceSampleGpu";
     }
-    const QString debugOutput = "DebugOutput";
-    const QString enableNvApi = "EnableNVAPI";
-
-    const QString limitFps = "LimitFPS";
-
-    const QString fileSyncMode = "FileSyncMode";
-    const QString ignoreGlobalDlls = "IgnoreGlobalDLLs";
-    const QString dllOverride = "DLLoverrides";
-    const QString gamemode = "Gamemode";
-    const QString args = "Args";
 
     //TBD
     const QString nvidiaLibs = "NvidiaLibs";
@@ -315,8 +414,16 @@ namespace NeroConfig {
     const QString noSteamInput = "NoSteamInput";
     const QString wineCpuTopology = "WineCpuTopology";
     const QString localShaderCache = "LocalShaderCache";
-    const QString prerunScript = "PreRunScript";
-    const QString postRunScript = "PostRunScript";
-    const QString mangohud = "Mangohud";
+    const QString prerunScript = NeroSetting::GetKey(NeroSetting::PreRunScript);
+    const QString postRunScript = NeroSetting::GetKey(NeroSetting::PostRunScript);
+    const QString preRunInBackground = NeroSetting::GetKey(NeroSetting::PreRunInBackground);
+    const QString mangohud = NeroSetting::GetKey(NeroSetting::Mangohud);
+
+    // see NeroScheduling for what the indexes mean
+    const QString cpuSet = NeroSetting::GetKey(NeroSetting::CpuSet);
+    const QString cpuList = NeroSetting::GetKey(NeroSetting::CpuList);
+    const QString processPriority = NeroSetting::GetKey(NeroSetting::ProcessPriority);
+    const QString ioPriority = NeroSetting::GetKey(NeroSetting::IoPriority);
+    const QString elevateScheduling = NeroSetting::GetKey(NeroSetting::ElevateScheduling);
 }
 #endif // NERORUNNER_H
@@ -37,6 +37,8 @@ void NeroRunnerDialog::SetupWindow(const bool &isStarting,
                                    const QString &name,
                                    QIcon *icon)
 {
+    ui->resourcesText->setVisible(false);
+
     if(isStarting) {
         ui->header->setText("Starting " + name);
         ui->statusText->setText("Setting up umu environment...");
@@ -62,3 +64,18 @@ void NeroRunnerDialog::SetText(const QString &text)
 {
     ui->statusText->setText(text);
 }
+
+void NeroRunnerDialog::SetIcon(const QIcon &icon)
+{
+    if(icon.isNull()) return;
+
+    if(icon.actualSize(QSize(64,64)).height() < 64)
+        ui->icoLabel->setPixmap(icon.pixmap(icon.actualSize(QSize(64,64))).scaled(64,64,Qt::KeepAspectRatio,Qt::SmoothTransformation));
+    else ui->icoLabel->setPixmap(icon.pixmap(64,64));
+}
+
+void NeroRunnerDialog::SetResources(const QString &text)
+{
+    ui->resourcesText->setText(text);
+    ui->resourcesText->setVisible(!text.isEmpty());
+}
@@ -39,6 +39,10 @@ public:
                      const QString & = "",
                      QIcon *icon = nullptr);
     void SetText(const QString &);
+    // for icons that finish decoding after the window's already up.
+    void SetIcon(const QIcon &);
+    // what the session's process tree is using, while it's starting or stopping.
+    void SetResources(const QString &);
 
 private:
     Ui::NeroRunnerDialog *ui;
@@ -0,0 +1,417 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Proton Runners Index.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerorunnerindex.h"
+#include "nerofs.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// bump the version whenever Root or NeroRunnerInfo's stored members change, so old caches get thrown out.
+#define NERO_RUNNER_CACHE_MAGIC 0x4E52554E
+#define NERO_RUNNER_CACHE_VERSION 2
+
+static QDataStream &operator<<(QDataStream &out, const NeroRunnerInfo &runner)
+{
+    out << runner.name << runner.path << runner.displayName
+        << (qint32)runner.version.flavor << (qint32)runner.version.major << (qint32)runner.version.minor
+        << (qint32)runner.features << runner.modified;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, NeroRunnerInfo &runner)
+{
+    qint32 flavor = 0, major = 0, minor = 0, features = 0;
+    in >> runner.name >> runner.path >> runner.displayName >> flavor >> major >> minor >> features >> runner.modified;
+    runner.features = features;
+    runner.version.flavor = flavor;
+    runner.version.major = major;
+    runner.version.minor = minor;
+    return in;
+}
+
+NeroRunnerVersion NeroRunnerVersion::Parse(const QString &label)
+{
+    static const QRegularExpression geRegex("GE-Proton(\\d+)-(\\d+)", QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression valveRegex("^proton[ -]\\d", QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression numberRegex("(\\d+)\\.(\\d+)");
+    static const QRegularExpression majorRegex("proton[ _-]?(\\d+)", QRegularExpression::CaseInsensitiveOption);
+
+    NeroRunnerVersion version;
+
+    QRegularExpressionMatch match = geRegex.match(label);
+    if(match.hasMatch()) {
+        version.flavor = GE;
+        version.major = match.captured(1).toInt();
+        version.minor = match.captured(2).toInt();
+        return version;
+    }
+
+    if(label.contains("experimental", Qt::CaseInsensitive)) version.flavor = Experimental;
+    // "Proton 9.0 (Beta)" as a directory, "proton-9.0-2" in its version file
+    else if(valveRegex.match(label).hasMatch()) version.flavor = Valve;
+
+    match = numberRegex.match(label);
+    if(match.hasMatch()) {
+        version.major = match.captured(1).toInt();
+        version.minor = match.captured(2).toInt();
+    } else {
+        match = majorRegex.match(label);
+        if(match.hasMatch()) version.major = match.captured(1).toInt();
+    }
+
+    return version;
+}
+
+NeroRunnerIndex *NeroRunnerIndex::Get()
+{
+    // parented to the app, so the watcher lives exactly as long as we do.
+    static QPointer<NeroRunnerIndex> instance;
+    if(instance.isNull()) instance = new NeroRunnerIndex(QCoreApplication::instance());
+    return instance;
+}
+
+NeroRunnerIndex::NeroRunnerIndex(QObject *parent) : QObject(parent), watcher(this), refreshTimer(this)
+{
+    // runner archives get extracted a file at a time, so let things settle before looking again.
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(1000);
+    connect(&refreshTimer, &QTimer::timeout, this, &NeroRunnerIndex::Refresh);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, &refreshTimer, QOverload<>::of(&QTimer::start));
+
+    if(!LoadCache()) printf("No usable runners cache, scanning for runners...\n");
+    Refresh();
+}
+
+QString NeroRunnerIndex::GetCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/nero-umu/runners.cache";
+}
+
+QList<NeroRunnerIndex::Root> NeroRunnerIndex::GetConfiguredRoots()
+{
+    const QString home = qEnvironmentVariable("HOME");
+    QStringList paths, filters;
+
+    paths << home + "/.steam/steam/compatibilitytools.d";
+    filters << "";
+    paths << QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/Nero-UMU/compatibilitytools.d";
+    filters << "";
+    paths << home + "/.steam/steam/steamapps/common";
+    filters << "Proton*";
+
+    const QStringList userRoots = NeroFS::GetManagerValue("RunnerRoots").toStringList();
+    for(const auto &path : userRoots) {
+        if(path.isEmpty()) continue;
+        paths << QDir::cleanPath(path);
+        filters << "";
+    }
+
+    QList<Root> wanted;
+    for(int i = 0; i < paths.count(); ++i) {
+        // steam's user dir and data dir could well be the same place through a symlink
+        const QString path = QFileInfo(paths.at(i)).canonicalFilePath().isEmpty() ? paths.at(i)
+                                                                                  : QFileInfo(paths.at(i)).canonicalFilePath();
+        bool duplicate = false;
+        for(const auto &root : std::as_const(wanted))
+            if(root.path == path && root.filter == filters.at(i)) duplicate = true;
+        if(duplicate) continue;
+
+        Root root;
+        root.path = path;
+        root.filter = filters.at(i);
+        wanted.append(root);
+    }
+
+    return wanted;
+}
+
+NeroRunnerInfo NeroRunnerIndex::ParseRunner(const QString &name, const QString &path, const qint64 &modified)
+{
+    NeroRunnerInfo runner;
+    runner.name = name;
+    runner.path = path;
+    runner.modified = modified;
+
+    QStringList labels;
+
+    QFile vdf(path + "/compatibilitytool.vdf");
+    if(vdf.open(QIODevice::ReadOnly)) {
+        static const QRegularExpression displayRegex("\"display_name\"\\s+\"([^\"]*)\"");
+        const QRegularExpressionMatch match = displayRegex.match(QString::fromUtf8(vdf.read(64 * 1024)));
+        if(match.hasMatch()) runner.displayName = match.captured(1);
+        labels << runner.displayName;
+    }
+
+    // "<build timestamp> <name>", e.g. "1718900000 GE-Proton9-7"
+    QFile versionFile(path + "/version");
+    if(versionFile.open(QIODevice::ReadOnly)) {
+        const QString line = QString::fromUtf8(versionFile.readLine()).trimmed();
+        bool isTimestamp = false;
+        line.section(' ', 0, 0).toLongLong(&isTimestamp);
+        labels << (isTimestamp ? line.section(' ', 1) : line);
+    }
+
+    labels << name;
+    if(runner.displayName.isEmpty()) runner.displayName = name;
+
+    // take the numbers from whichever label has them first, and the most specific flavor any of them mention
+    for(const auto &label : std::as_const(labels)) {
+        const NeroRunnerVersion parsed = NeroRunnerVersion::Parse(label);
+        if(parsed.flavor > runner.version.flavor) runner.version.flavor = parsed.flavor;
+        if(!runner.version.major && parsed.major) {
+            runner.version.major = parsed.major;
+            runner.version.minor = parsed.minor;
+        }
+    }
+
+    // Proton's sync options are all plain env vars checked in the script, so whatever it mentions is what it supports -
+    // which beats keeping a list of which version of which fork got what.
+    QFile script(path + "/proton");
+    if(script.open(QIODevice::ReadOnly)) {
+        const QByteArray contents = script.readAll();
+        runner.features = 0;
+        if(contents.contains("NTSYNC")) runner.features |= NeroRunnerInfo::FeatureNtsync;
+        if(contents.contains("FSYNC")) runner.features |= NeroRunnerInfo::FeatureFsync;
+    }
+
+    return runner;
+}
+
+bool NeroRunnerIndex::UpdateRoot(Root &root)
+{
+    const QFileInfo rootInfo(root.path);
+    const qint64 modified = rootInfo.isDir() ? rootInfo.lastModified().toMSecsSinceEpoch() : -1;
+    bool changed = false;
+
+    QStringList names;
+    if(modified != root.modified) {
+        // something got added, removed or renamed - only time the root needs listing again
+        if(modified >= 0)
+            names = QDir(root.path).entryList(root.filter.isEmpty() ? QStringList() : QStringList(root.filter),
+                                              QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        root.modified = modified;
+        changed = true;
+    } else {
+        for(const auto &runner : std::as_const(root.runners))
+            names << runner.name;
+        names << root.pending;
+    }
+
+    QList<NeroRunnerInfo> found;
+    QStringList pending;
+    for(const auto &name : std::as_const(names)) {
+        const QString path = root.path + '/' + name;
+        const QFileInfo dirInfo(path);
+        const qint64 dirModified = dirInfo.lastModified().toMSecsSinceEpoch();
+
+        if(!QFileInfo(path + "/proton").isFile()) {
+            pending << name;
+            continue;
+        }
+
+        bool reused = false;
+        for(const auto &runner : std::as_const(root.runners)) {
+            if(runner.name == name && runner.modified == dirModified) {
+                found << runner;
+                reused = true;
+                break;
+            }
+        }
+
+        if(!reused) {
+            found << ParseRunner(name, path, dirModified);
+            changed = true;
+        }
+    }
+
+    if(found.count() != root.runners.count() || pending != root.pending) changed = true;
+    root.runners = found;
+    root.pending = pending;
+    return changed;
+}
+
+void NeroRunnerIndex::Refresh()
+{
+    bool changed = false;
+
+    QList<Root> updated;
+    const QList<Root> wanted = GetConfiguredRoots();
+    for(const auto &want : wanted) {
+        Root root = want;
+        // carry over what we already know about this root
+        for(const auto &known : std::as_const(roots)) {
+            if(known.path == want.path && known.filter == want.filter) {
+                root = known;
+                break;
+            }
+        }
+        if(UpdateRoot(root)) changed = true;
+        updated.append(root);
+    }
+    if(updated.count() != roots.count()) changed = true;
+    roots = updated;
+
+    Rewatch();
+
+    // always merged, even when nothing on disk changed - the cache only brings back the roots.
+    QMap<QString, NeroRunnerInfo> merged;
+    for(const auto &root : std::as_const(roots))
+        for(const auto &runner : root.runners)
+            if(!merged.contains(runner.name)) merged.insert(runner.name, runner);
+
+    bool listChanged = false;
+    {
+        QMutexLocker locker(&runnersMutex);
+        if(merged.keys() != runners.keys()) listChanged = true;
+        else for(auto i = merged.constBegin(); i != merged.constEnd(); ++i)
+            if(runners.value(i.key()).path != i.value().path) listChanged = true;
+        runners = merged;
+    }
+
+    if(changed) SaveCache();
+    if(listChanged) {
+        printf("Runners index updated, %d runners available\n", merged.count());
+        emit RunnersChanged();
+    }
+}
+
+void NeroRunnerIndex::Rewatch()
+{
+    QStringList paths;
+    for(const auto &root : std::as_const(roots)) {
+        if(root.modified < 0) continue;
+        paths << root.path;
+        // runners updated in place, and ones that are still being unpacked
+        for(const auto &runner : root.runners)
+            paths << runner.path;
+        for(const auto &name : root.pending)
+            paths << root.path + '/' + name;
+    }
+
+    const QStringList watching = watcher.directories();
+    QStringList stale, fresh;
+    for(const auto &path : watching)
+        if(!paths.contains(path)) stale << path;
+    for(const auto &path : std::as_const(paths))
+        if(!watching.contains(path)) fresh << path;
+
+    if(!stale.isEmpty()) watcher.removePaths(stale);
+    if(!fresh.isEmpty()) watcher.addPaths(fresh);
+}
+
+bool NeroRunnerIndex::LoadCache()
+{
+    QFile cacheFile(GetCachePath());
+    if(!cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&cacheFile);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version;
+    if(magic != NERO_RUNNER_CACHE_MAGIC || version != NERO_RUNNER_CACHE_VERSION) return false;
+
+    QList<Root> cached;
+    in >> count;
+    for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        Root root;
+        in >> root.path >> root.filter >> root.modified >> root.pending >> root.runners;
+        cached.append(root);
+    }
+    if(in.status() != QDataStream::Ok) return false;
+
+    // Refresh() still checks all of this against what's on disk, it just doesn't have to reparse anything that matches.
+    roots = cached;
+    return true;
+}
+
+void NeroRunnerIndex::SaveCache()
+{
+    QDir().mkpath(QFileInfo(GetCachePath()).path());
+
+    QSaveFile cacheFile(GetCachePath());
+    if(!cacheFile.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&cacheFile);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << (quint32)NERO_RUNNER_CACHE_MAGIC << (quint32)NERO_RUNNER_CACHE_VERSION << (quint32)roots.count();
+    for(const auto &root : std::as_const(roots))
+        out << root.path << root.filter << root.modified << root.pending << root.runners;
+
+    if(!cacheFile.commit()) printf("Couldn't write runners cache!\n");
+}
+
+QStringList NeroRunnerIndex::GetNames()
+{
+    QMutexLocker locker(&runnersMutex);
+    return runners.keys();
+}
+
+QStringList NeroRunnerIndex::GetRoots()
+{
+    QStringList paths;
+    for(const auto &root : std::as_const(roots))
+        paths << root.path;
+    return paths;
+}
+
+bool NeroRunnerIndex::Contains(const QString &name)
+{
+    QMutexLocker locker(&runnersMutex);
+    return runners.contains(name);
+}
+
+NeroRunnerInfo NeroRunnerIndex::Find(const QString &name)
+{
+    QMutexLocker locker(&runnersMutex);
+    return runners.value(name);
+}
+
+QString NeroRunnerIndex::GetPath(const QString &name)
+{
+    QMutexLocker locker(&runnersMutex);
+    return runners.value(name).path;
+}
+
+QString NeroRunnerIndex::FindReplacement(const QString &name)
+{
+    const NeroRunnerVersion wanted = NeroRunnerVersion::Parse(name);
+
+    QMutexLocker locker(&runnersMutex);
+    const NeroRunnerInfo *sameFlavor = nullptr, *newest = nullptr;
+    for(auto i = runners.constBegin(); i != runners.constEnd(); ++i) {
+        const NeroRunnerInfo &runner = i.value();
+        if(!newest || runner.version.IsNewerThan(newest->version)) newest = &runner;
+        if(runner.version.flavor == wanted.flavor && (!sameFlavor || runner.version.IsNewerThan(sameFlavor->version)))
+            sameFlavor = &runner;
+    }
+
+    if(sameFlavor) return sameFlavor->name;
+    else if(newest) return newest->name;
+    else return "";
+}
@@ -0,0 +1,131 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Proton Runners Index.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NERORUNNERINDEX_H
+#define NERORUNNERINDEX_H
+
+#include <QFileSystemWatcher>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+struct NeroRunnerVersion
+{
+    enum Flavor {
+        Unknown = 0,
+        Valve,
+        Experimental,
+        GE
+    };
+
+    int flavor = Unknown;
+    int major = 0;
+    int minor = 0;
+
+    bool IsAtLeast(const int &atLeastMajor, const int &atLeastMinor = 0) const
+        { return major > atLeastMajor || (major == atLeastMajor && minor >= atLeastMinor); }
+    bool IsNewerThan(const NeroRunnerVersion &other) const
+        { return major > other.major || (major == other.major && minor > other.minor); }
+
+    // from whatever the runner calls itself - display name, version file or directory name, in that order.
+    static NeroRunnerVersion Parse(const QString &);
+};
+
+struct NeroRunnerInfo
+{
+    // what the runner's proton script knows how to turn on
+    enum Feature {
+        FeatureNtsync = 0x1,
+        FeatureFsync = 0x2,
+        // the script couldn't be read, so the version's all there is to go off of
+        FeatureUnknown = 0x80
+    };
+
+    QString name;           // directory name, which is what prefixes store as CurrentRunner
+    QString path;
+    QString displayName;
+    NeroRunnerVersion version;
+    int features = FeatureUnknown;
+    qint64 modified = 0;    // runner dir's mtime when this was parsed
+
+    bool IsValid() const { return !path.isEmpty(); }
+};
+
+// Every Proton runner Nero can see, across Steam's compatibilitytools.d, Steam's own Proton installs,
+// Nero's data dir and anything listed in the manager's RunnerRoots.
+// Only directories that actually have a proton script count; ones that don't yet (i.e. still extracting) get watched until they do.
+// The index is persisted to ~/.cache/nero-umu/runners.cache, so startup only stats the roots and runners instead of rescanning them,
+// and a QFileSystemWatcher keeps it current while Nero is open.
+// Lookups are safe from runner threads, but the index itself has to be created (and refreshed) on the GUI thread.
+class NeroRunnerIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static NeroRunnerIndex *Get();
+
+    // METHODS
+    QStringList GetNames();
+    QStringList GetRoots();
+    bool Contains(const QString &name);
+    NeroRunnerInfo Find(const QString &name);
+    // empty if there's no such runner.
+    QString GetPath(const QString &name);
+    // for prefixes whose runner went missing: the newest runner of the same flavor, or just the newest one if there's none.
+    QString FindReplacement(const QString &name);
+
+public slots:
+    void Refresh();
+
+signals:
+    void RunnersChanged();
+
+private:
+    explicit NeroRunnerIndex(QObject *parent);
+
+    struct Root {
+        QString path;
+        QString filter;         // Steam's common dir has games too, so only look at what's named like Proton there
+        qint64 modified = -1;
+        QStringList pending;    // dirs without a proton script (yet)
+        QList<NeroRunnerInfo> runners;
+    };
+
+    QList<Root> GetConfiguredRoots();
+    bool UpdateRoot(Root &);
+    NeroRunnerInfo ParseRunner(const QString &name, const QString &path, const qint64 &modified);
+    void Rewatch();
+    bool LoadCache();
+    void SaveCache();
+    static QString GetCachePath();
+
+    // GUI thread only
+    QList<Root> roots;
+    QFileSystemWatcher watcher;
+    QTimer refreshTimer;
+
+    // merged view of every root, first root to have a name wins.
+    QMap<QString, NeroRunnerInfo> runners;
+    QMutex runnersMutex;
+};
+
+#endif // NERORUNNERINDEX_H
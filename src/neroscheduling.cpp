@@ -0,0 +1,346 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    CPU Placement & Scheduling Priorities.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroscheduling.h"
+
+#include <QDir>
+#include <QFile>
+#include <QThread>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// not in glibc's headers, since it's only ever been a thing on -ck/MuQSS style kernels
+#define NERO_SCHED_ISO 4
+#define NERO_IOPRIO_WHO_PROCESS 1
+#define NERO_IOPRIO_VALUE(ioClass, level) (((ioClass) << 13) | (level))
+#define NERO_IOPRIO_CLASS_BE 2
+#define NERO_IOPRIO_CLASS_IDLE 3
+
+QMap<int, QList<int>> NeroScheduling::reserved;
+QMutex NeroScheduling::reservedMutex;
+thread_local bool NeroScheduling::threadPinned = false;
+
+static QString ReadSysFile(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) return QString();
+    return QString::fromLatin1(file.readAll()).trimmed();
+}
+
+QList<int> NeroScheduling::Policy::GetCpus() const
+{
+    QList<int> list;
+    for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        if(CPU_ISSET(cpu, &cpus)) list << cpu;
+    return list;
+}
+
+QList<int> NeroScheduling::ParseCpuList(const QString &cpuList)
+{
+    QList<int> cpus;
+    const QStringList ranges = cpuList.split(',', Qt::SkipEmptyParts);
+    for(const auto &range : ranges) {
+        const QStringList ends = range.trimmed().split('-');
+        bool firstOk = false, lastOk = true;
+        const int first = ends.first().toInt(&firstOk);
+        const int last = ends.count() > 1 ? ends.at(1).toInt(&lastOk) : first;
+        if(!firstOk || !lastOk || first < 0 || last >= CPU_SETSIZE) continue;
+
+        for(int cpu = first; cpu <= last; ++cpu)
+            if(!cpus.contains(cpu)) cpus << cpu;
+    }
+    std::sort(cpus.begin(), cpus.end());
+    return cpus;
+}
+
+QString NeroScheduling::CpuListString(const QList<int> &cpus)
+{
+    QStringList ranges;
+    for(int i = 0; i < cpus.count(); ++i) {
+        int end = i;
+        while(end+1 < cpus.count() && cpus.at(end+1) == cpus.at(end)+1) ++end;
+        ranges << (end > i ? QString("%1-%2").arg(cpus.at(i)).arg(cpus.at(end)) : QString::number(cpus.at(i)));
+        i = end;
+    }
+    return ranges.join(',');
+}
+
+QList<int> NeroScheduling::GetOnlineCpus()
+{
+    QList<int> cpus = ParseCpuList(ReadSysFile("/sys/devices/system/cpu/online"));
+    if(cpus.isEmpty())
+        for(int cpu = 0; cpu < QThread::idealThreadCount(); ++cpu) cpus << cpu;
+    return cpus;
+}
+
+QList<int> NeroScheduling::GetPerformanceCpus()
+{
+    // hybrid Intel chips split their cores into two PMUs, which is the most direct answer there is.
+    const QList<int> cores = ParseCpuList(ReadSysFile("/sys/devices/cpu_core/cpus"));
+    if(!cores.isEmpty()) return cores;
+
+    // otherwise go by how fast each core is allowed to go (capacity already accounts for that on ARM).
+    // Anything within 10% of the fastest counts, so preferred-core boost differences don't thin it down to one core.
+    const QList<int> online = GetOnlineCpus();
+    QMap<int, quint64> speeds;
+    quint64 fastest = 0;
+    for(const int &cpu : online) {
+        const QString cpuPath = QString("/sys/devices/system/cpu/cpu%1/").arg(cpu);
+        QString speed = ReadSysFile(cpuPath + "cpu_capacity");
+        if(speed.isEmpty()) speed = ReadSysFile(cpuPath + "cpufreq/cpuinfo_max_freq");
+        if(speed.isEmpty()) continue;
+        speeds.insert(cpu, speed.toULongLong());
+        fastest = qMax(fastest, speeds.value(cpu));
+    }
+    if(speeds.isEmpty()) return online;
+
+    QList<int> fast;
+    for(auto i = speeds.constBegin(); i != speeds.constEnd(); ++i)
+        if(i.value() * 10 >= fastest * 9) fast << i.key();
+    return fast;
+}
+
+QList<int> NeroScheduling::GetVCacheCpus()
+{
+    // every L3 there is, keyed by the cpus sharing it
+    QMap<QString, quint64> l3Sizes;
+    const QList<int> online = GetOnlineCpus();
+    for(const int &cpu : online) {
+        QDir cacheDir(QString("/sys/devices/system/cpu/cpu%1/cache").arg(cpu));
+        const QStringList indexes = cacheDir.entryList({ "index*" }, QDir::Dirs);
+        for(const auto &index : indexes) {
+            const QString indexPath = cacheDir.path() + '/' + index + '/';
+            if(ReadSysFile(indexPath + "level") != "3") continue;
+
+            QString size = ReadSysFile(indexPath + "size");
+            const quint64 scale = size.endsWith('M') ? 1024 : 1;
+            size.remove('K').remove('M');
+            l3Sizes.insert(ReadSysFile(indexPath + "shared_cpu_list"), size.toULongLong() * scale);
+        }
+    }
+
+    // one L3 for everyone, or all of them the same - either way, there's no V-cache half to pick out.
+    QString biggest;
+    bool allSame = true;
+    for(auto i = l3Sizes.constBegin(); i != l3Sizes.constEnd(); ++i) {
+        if(!biggest.isEmpty() && i.value() != l3Sizes.value(biggest)) allSame = false;
+        if(biggest.isEmpty() || i.value() > l3Sizes.value(biggest)) biggest = i.key();
+    }
+    if(l3Sizes.count() < 2 || allSame) return {};
+
+    return ParseCpuList(biggest);
+}
+
+QList<int> NeroScheduling::GetNoCore0Cpus()
+{
+    QList<int> core0 = ParseCpuList(ReadSysFile("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list"));
+    if(core0.isEmpty()) core0 << 0;
+
+    QList<int> cpus = GetOnlineCpus();
+    for(const int &cpu : std::as_const(core0))
+        cpus.removeAll(cpu);
+    return cpus;
+}
+
+NeroScheduling::Policy NeroScheduling::GetPolicy(const int &cpuSet, const QString &cpuList, const int &priority,
+                                                 const int &ioPriority, const bool &elevate)
+{
+    Policy policy;
+
+    QList<int> cpus;
+    QString from;
+    if(!cpuList.trimmed().isEmpty()) {
+        cpus = ParseCpuList(cpuList);
+        from = "custom list";
+    } else switch(cpuSet) {
+    case CpuSetPerformance:
+        cpus = GetPerformanceCpus();
+        from = "performance cores";
+        break;
+    case CpuSetVCache:
+        cpus = GetVCacheCpus();
+        from = "V-cache CCD";
+        break;
+    case CpuSetNoCore0:
+        cpus = GetNoCore0Cpus();
+        from = "all but core 0";
+        break;
+    default:
+        break;
+    }
+
+    if(!from.isEmpty()) {
+        const QList<int> online = GetOnlineCpus();
+        for(int i = cpus.count()-1; i >= 0; --i)
+            if(!online.contains(cpus.at(i))) cpus.removeAt(i);
+
+        if(cpus.isEmpty())
+            printf("No online CPUs match the %s on this system, running on all cores.\n", from.toLocal8Bit().constData());
+        // pinning to everything is the same as not pinning, minus the cost of doing it
+        else if(cpus.count() < online.count()) {
+            for(const int &cpu : std::as_const(cpus))
+                CPU_SET(cpu, &policy.cpus);
+            policy.pinned = true;
+            printf("Pinning to CPUs %s (%s)\n", CpuListString(cpus).toLocal8Bit().constData(), from.toLocal8Bit().constData());
+        }
+    }
+
+    switch(priority) {
+    case PriorityAboveNormal: policy.niceness = -5; break;
+    case PriorityHigh:        policy.niceness = -10; break;
+    case PriorityLow:         policy.niceness = 10; break;
+    default: break;
+    }
+
+    switch(ioPriority) {
+    case IoHigh: policy.ioPriority = NERO_IOPRIO_VALUE(NERO_IOPRIO_CLASS_BE, 0); break;
+    case IoLow:  policy.ioPriority = NERO_IOPRIO_VALUE(NERO_IOPRIO_CLASS_BE, 7); break;
+    case IoIdle: policy.ioPriority = NERO_IOPRIO_VALUE(NERO_IOPRIO_CLASS_IDLE, 0); break;
+    default: break;
+    }
+
+    policy.elevate = elevate;
+    return policy;
+}
+
+static bool Elevate(const pid_t &tid)
+{
+    // SCHED_ISO only exists on -ck style kernels; mainline rejects it, so fall back to the lowest realtime priority.
+    struct sched_param param = {};
+    if(sched_setscheduler(tid, NERO_SCHED_ISO, &param) == 0) return true;
+    param.sched_priority = 1;
+    return sched_setscheduler(tid, SCHED_RR, &param) == 0;
+}
+
+void NeroScheduling::ApplyToSelf(const Policy &policy)
+{
+    if(policy.pinned) sched_setaffinity(0, sizeof(policy.cpus), &policy.cpus);
+    if(policy.niceness != 0) setpriority(PRIO_PROCESS, 0, policy.niceness);
+    if(policy.ioPriority != 0) syscall(SYS_ioprio_set, NERO_IOPRIO_WHO_PROCESS, 0, policy.ioPriority);
+    if(policy.elevate) Elevate(0);
+}
+
+bool NeroScheduling::Apply(const Policy &policy, const qint64 &pid, const bool &report)
+{
+    if(policy.IsDefault()) return true;
+
+    // every one of these is per-thread as far as the kernel's concerned
+    const QStringList tasks = QDir(QString("/proc/%1/task").arg(pid)).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QStringList refused;
+    int error = 0;
+    for(const auto &task : tasks) {
+        const pid_t tid = task.toInt();
+        if(policy.pinned && sched_setaffinity(tid, sizeof(policy.cpus), &policy.cpus) != 0 && !refused.contains("affinity"))
+            refused << "affinity", error = errno;
+        if(policy.niceness != 0 && setpriority(PRIO_PROCESS, tid, policy.niceness) != 0 && !refused.contains("priority"))
+            refused << "priority", error = errno;
+        if(policy.ioPriority != 0 && syscall(SYS_ioprio_set, NERO_IOPRIO_WHO_PROCESS, tid, policy.ioPriority) != 0
+           && !refused.contains("I/O priority"))
+            refused << "I/O priority", error = errno;
+        if(policy.elevate && !Elevate(tid) && !refused.contains("realtime scheduling"))
+            refused << "realtime scheduling", error = errno;
+    }
+
+    // raising priority is the usual one, which needs CAP_SYS_NICE or a raised RLIMIT_NICE/RLIMIT_RTPRIO
+    if(report && !refused.isEmpty())
+        printf("Couldn't set %s for process %lld: %s\n", refused.join(", ").toLocal8Bit().constData(), pid, strerror(error));
+    return refused.isEmpty();
+}
+
+void NeroScheduling::ReserveCpus(const int &owner, const Policy &policy)
+{
+    if(!policy.pinned) return;
+
+    reservedMutex.lock();
+    reserved.insert(owner, policy.GetCpus());
+    reservedMutex.unlock();
+    PinThread();
+}
+
+void NeroScheduling::ReleaseCpus(const int &owner)
+{
+    reservedMutex.lock();
+    const bool had = reserved.remove(owner) > 0;
+    reservedMutex.unlock();
+    if(had) PinThread();
+}
+
+bool NeroScheduling::IsThreadPinned()
+{
+    return threadPinned;
+}
+
+void NeroScheduling::PinThread()
+{
+    const QList<int> online = GetOnlineCpus();
+    QList<int> allowed = online;
+
+    reservedMutex.lock();
+    for(const auto &cpus : std::as_const(reserved))
+        for(const int &cpu : cpus)
+            allowed.removeAll(cpu);
+    reservedMutex.unlock();
+
+    // games have every core between them, so there's nowhere better to be.
+    if(allowed.isEmpty()) allowed = online;
+    const bool pinned = allowed.count() < online.count();
+    if(!pinned && !threadPinned) return;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for(const int &cpu : std::as_const(allowed))
+        CPU_SET(cpu, &cpus);
+    if(sched_setaffinity(0, sizeof(cpus), &cpus) == 0) threadPinned = pinned;
+}
+
+/* Process */
+
+void NeroScheduledProcess::SetPolicy(const NeroScheduling::Policy &policy)
+{
+    this->policy = policy;
+
+    // whatever this thread's keeping away from isn't meant for the child.
+    if(!this->policy.pinned && NeroScheduling::IsThreadPinned()) {
+        const QList<int> online = NeroScheduling::GetOnlineCpus();
+        for(const int &cpu : online)
+            CPU_SET(cpu, &this->policy.cpus);
+        this->policy.pinned = true;
+    }
+    active = !this->policy.IsDefault();
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    if(active) {
+        const NeroScheduling::Policy childPolicy = this->policy;
+        setChildProcessModifier([childPolicy]() { NeroScheduling::ApplyToSelf(childPolicy); });
+    } else setChildProcessModifier(std::function<void()>());
+#endif
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+void NeroScheduledProcess::setupChildProcess()
+{
+    if(active) NeroScheduling::ApplyToSelf(policy);
+}
+#endif
@@ -0,0 +1,124 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    CPU Placement & Scheduling Priorities.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROSCHEDULING_H
+#define NEROSCHEDULING_H
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QProcess>
+#include <QString>
+
+#include <sched.h>
+
+// Where a launch's processes get to run, and how much they get to cut in line.
+// Affinity, niceness, I/O priority and scheduling class are all inherited across fork/exec (and by new threads),
+// so setting them on umu before it execs covers everything it spawns - there's no cgroup to set up or clean after.
+class NeroScheduling
+{
+public:
+    enum {
+        CpuSetAll = 0,
+        // P-cores on hybrid Intel chips, or the fastest cluster on anything else with mixed cores
+        CpuSetPerformance,
+        // the CCD with the biggest L3, i.e. the X3D half of a 7950X3D
+        CpuSetVCache,
+        // everything except the first core (and its SMT sibling), where most IRQs end up
+        CpuSetNoCore0
+    } CpuSet_e;
+
+    enum {
+        PriorityNormal = 0,
+        PriorityAboveNormal,
+        PriorityHigh,
+        PriorityLow
+    } Priority_e;
+
+    enum {
+        IoDefault = 0,
+        IoHigh,
+        IoLow,
+        IoIdle
+    } IoPriority_e;
+
+    // Everything here is plain old data, so it can be applied from a forked child without allocating.
+    struct Policy {
+        cpu_set_t cpus;
+        bool pinned = false;
+        int niceness = 0;
+        // ioprio_set value, 0 to leave as-is
+        int ioPriority = 0;
+        bool elevate = false;
+
+        Policy() { CPU_ZERO(&cpus); }
+        bool IsDefault() const { return !pinned && niceness == 0 && ioPriority == 0 && !elevate; }
+        QList<int> GetCpus() const;
+    };
+
+    // METHODS
+    // cpuList is a custom "0-7,16-23" style list, which wins over the preset when it's set.
+    static Policy GetPolicy(const int &cpuSet, const QString &cpuList, const int &priority,
+                            const int &ioPriority, const bool &elevate);
+    // all of pid's threads; report prints whatever the kernel refused.
+    static bool Apply(const Policy &, const qint64 &pid, const bool &report = true);
+    // the calling process only, for use between fork and exec - no allocations, no stdio.
+    static void ApplyToSelf(const Policy &);
+
+    // keeps the calling thread (i.e. the sessions thread, which does the sampling) off every owner's game cores.
+    static void ReserveCpus(const int &owner, const Policy &);
+    static void ReleaseCpus(const int &owner);
+    static bool IsThreadPinned();
+
+    static QList<int> ParseCpuList(const QString &);
+    static QString CpuListString(const QList<int> &);
+    static QList<int> GetOnlineCpus();
+    static QList<int> GetPerformanceCpus();
+    static QList<int> GetVCacheCpus();
+    static QList<int> GetNoCore0Cpus();
+
+private:
+    static void PinThread();
+
+    static QMap<int, QList<int>> reserved;
+    static QMutex reservedMutex;
+    static thread_local bool threadPinned;
+};
+
+// A QProcess that takes a scheduling policy with it across the fork, so that nothing it spawns ever runs without it.
+// If this is started from a pinned thread, a default policy puts the child back on every core.
+class NeroScheduledProcess : public QProcess
+{
+public:
+    explicit NeroScheduledProcess(QObject *parent = nullptr) : QProcess(parent) {}
+
+    void SetPolicy(const NeroScheduling::Policy &);
+    const NeroScheduling::Policy &GetPolicy() const { return policy; }
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+protected:
+    void setupChildProcess() override;
+#endif
+
+private:
+    NeroScheduling::Policy policy;
+    bool active = false;
+};
+
+#endif // NEROSCHEDULING_H
@@ -0,0 +1,413 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Launch Sessions Manager.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerosession.h"
+#include "nerofs.h"
+#include "nerolaunchpipeline.h"
+#include "neroprefixindex.h"
+#include "nerorunner.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QPointer>
+#include <QThreadPool>
+#include <QTimer>
+
+/* Session */
+
+NeroSession::NeroSession(const NeroSessionContext &context, const bool &prefixAlreadyRunning, const NeroLaunchTimings &timings)
+    : context(context), log(Logs::keepRuns, Logs::segmentSize), alreadyRunning(prefixAlreadyRunning)
+{
+    // as a child, the runner follows the session over to the sessions thread.
+    runner = new NeroRunner(context.prefix);
+    runner->setParent(this);
+    runner->timings = timings;
+    for(const auto &var : context.env) {
+        const int split = var.indexOf('=');
+        if(split > 0) runner->baseEnv.insert(var.left(split), var.mid(split+1));
+    }
+    connect(runner, &NeroRunner::StatusUpdate, this, [this](int status) { emit StatusUpdate(this->context.id, status); });
+}
+
+NeroSession::~NeroSession()
+{
+    // only happens if the app's quitting mid-stop, and the stop's bounded by its own deadline anyway.
+    while(stopInFlight)
+        QThread::msleep(10);
+}
+
+void NeroSession::Start()
+{
+    if(!context.IsShortcut()) return StartMain();
+
+    pipeline = new NeroLaunchPipeline(this);
+    umu = new NeroScheduledProcess(this);
+
+    const QString &script = context.profile.preRunScript;
+    if(!script.isEmpty()) {
+        if(context.profile.preRunBackground) RunDetached(script);
+        else {
+            pipeline->Add("prerun", {}, NeroLaunchPipeline::External);
+            RunScript(script, [this]() { pipeline->Complete("prerun"); });
+        }
+    }
+
+    runner->PrepareShortcut(*pipeline, context.profile, alreadyRunning, *umu, log, command, arguments);
+    connect(pipeline, &NeroLaunchPipeline::Finished, this, &NeroSession::StartMain);
+    pipeline->Run();
+}
+
+void NeroSession::RunScript(const QString &script, const std::function<void()> &next)
+{
+    if(script.isEmpty()) return next();
+
+    // scripts shouldn't be stuck wherever this thread's keeping itself
+    NeroScheduledProcess *process = new NeroScheduledProcess(this);
+    process->SetPolicy(NeroScheduling::Policy());
+    connect(process, &QProcess::readyRead, this, [process]() { printf("%s", process->readAll().constData()); });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, process, next]() {
+        printf("%s", process->readAll().constData());
+        process->deleteLater();
+        next();
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, process, next](QProcess::ProcessError error) {
+        // finished never comes for these
+        if(error != QProcess::FailedToStart) return;
+        printf("Couldn't start script %s\n", process->program().toLocal8Bit().constData());
+        process->deleteLater();
+        next();
+    });
+    process->start(script, QStringList());
+}
+
+void NeroSession::RunDetached(const QString &script)
+{
+    // these keep to wherever this thread's allowed to be, i.e. off of any running games' cores - which suits them.
+    if(!script.isEmpty() && !QProcess::startDetached(script, QStringList()))
+        printf("Couldn't start script %s\n", script.toLocal8Bit().constData());
+}
+
+void NeroSession::StartMain()
+{
+    // stopped while the pre-run script (or anything else) was still going
+    if(halted) {
+        log.Close();
+        return Done();
+    }
+
+    if(context.IsShortcut()) {
+        // whatever was left of the pre-run script after everything else was ready doesn't count towards the launch.
+        runner->timings.Skip();
+    } else {
+        umu = new NeroScheduledProcess(this);
+        runner->PrepareOnetime(context.path, alreadyRunning, context.args, *umu, log, command, arguments);
+    }
+
+    connect(umu, &QProcess::started, this, [this]() {
+        runner->runnerPid = umu->processId();
+        if(context.IsShortcut()) runner->timings.Mark(NeroLaunchTimings::ProcessStart);
+        // already set before exec, this is just to hear about anything the kernel refused.
+        NeroScheduling::Apply(runner->scheduling, runner->runnerPid);
+        // the sampler lives on this thread, and shouldn't be competing with the game for its cores.
+        NeroScheduling::ReserveCpus(context.id, runner->scheduling);
+        StartSampling();
+    });
+    connect(umu, &QProcess::readyRead, this, [this]() { runner->DrainOutput(*umu, log, protonStarted); });
+    connect(umu, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this](int exitCode) {
+        result = exitCode;
+        MainFinished();
+    });
+    connect(umu, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if(error != QProcess::FailedToStart) return;
+        printf("Couldn't start %s\n", umu->program().toLocal8Bit().constData());
+        result = -1;
+        MainFinished();
+    });
+
+    umu->start(command, arguments);
+}
+
+void NeroSession::MainFinished()
+{
+    if(mainDone) return;
+    mainDone = true;
+
+    if(sampleTimer != nullptr) sampleTimer->stop();
+    monitor.Stop();
+    NeroScheduling::ReleaseCpus(context.id);
+
+    runner->DrainOutput(*umu, log, protonStarted);
+    // umu doesn't always end on a newline, so grab any stragglers too.
+    while(!umu->atEnd()) {
+        const QByteArray output = umu->readLine();
+        printf("%s", output.constData());
+        log.Write(output);
+    }
+    log.Close();
+
+    // a stop's still going through the rest of the process tree, and needs the runner as-is until it's done.
+    if(!stopping) RunPostScript();
+}
+
+void NeroSession::RunPostScript()
+{
+    if(context.IsShortcut()) {
+        runner->FinishShortcut(context.profile);
+        // in case settings changed from manager - and detached, so the session's over as soon as the game is.
+        RunDetached(runner->GetProfile(context.hash).postRunScript);
+    } else runner->FinishCache();
+
+    Done();
+}
+
+void NeroSession::Done()
+{
+    if(finished) return;
+    finished = true;
+    emit Finished(context.id, result);
+}
+
+void NeroSession::StartSampling()
+{
+    const int interval = NeroFS::GetManagerValue(NeroConfig::Manager::resourceSampleInterval,
+                                                 NeroConfig::Manager::resourceSampleIntervalDefault).toInt();
+    if(interval <= 0) return;
+
+    // kept next to the run's log, where anyone looking into a bad run would already be.
+    monitor.Start(runner->sessionId, runner->runnerPid, NeroFS::GetManagerValue(NeroConfig::Manager::resourceSampleGpu, true).toBool(),
+                  NeroResourceMonitor::GetSeriesPath(runner->logPath));
+
+    sampleTimer = new QTimer(this);
+    sampleTimer->setInterval(qMax(interval, 250));
+    connect(sampleTimer, &QTimer::timeout, this, &NeroSession::TakeSample);
+    sampleTimer->start();
+}
+
+void NeroSession::TakeSample()
+{
+    emit Resources(context.id, monitor.Sample());
+
+    if(!runner->scheduling.IsDefault()) {
+        const QList<qint64> joined = monitor.TakeJoined();
+        for(const qint64 &pid : joined)
+            NeroScheduling::Apply(runner->scheduling, pid, false);
+    }
+
+    // the game comes first - if watching it costs more than half a percent of a core, look less often.
+    // only going by how it's done since the last slowdown, so one expensive stretch doesn't keep halving it all the way down.
+    if(monitor.GetRecentOverhead() > 0.004 && sampleTimer->interval() < 60*1000) {
+        sampleTimer->setInterval(sampleTimer->interval() * 2);
+        monitor.StartWindow();
+        printf("Resource sampling for %s slowed to every %d ms\n", context.name.toLocal8Bit().constData(), sampleTimer->interval());
+    }
+}
+
+void NeroSession::Stop(const bool &keepServer)
+{
+    if(halted || finished) return;
+    halted = true;
+
+    // nothing to stop yet (StartMain will see the halt), or nothing left to stop.
+    // shortcuts have their umu around while the pipeline's still getting it ready, it just isn't running yet.
+    if(umu == nullptr || umu->state() == QProcess::NotRunning || mainDone) return;
+
+    stopping = true;
+    emit StatusUpdate(context.id, NeroRunner::RunnerProtonStopping);
+
+    // waiting on the whole tree to go down can take up to the stop timeout,
+    // which every other session on this thread would be stuck behind.
+    NeroRunner *stopper = runner;
+    const QPointer<NeroSession> session(this);
+    stopInFlight = true;
+    QThreadPool::globalInstance()->start([this, session, stopper, keepServer]() {
+        stopper->StopProcess(keepServer);
+
+        // the destructor holds off until stopInFlight clears, but don't count on it if the session's already gone.
+        if(session.isNull()) {
+            stopInFlight = false;
+            return;
+        }
+        QMetaObject::invokeMethod(session, [this]() {
+            stopping = false;
+            emit StatusUpdate(context.id, NeroRunner::RunnerProtonStopped);
+            // umu itself should've gone down with the rest of them, but just in case.
+            if(!mainDone) umu->kill();
+            else RunPostScript();
+        }, Qt::QueuedConnection);
+        // if it's on its way out, this just gets dropped with the rest of its events.
+        stopInFlight = false;
+    });
+}
+
+/* Manager */
+
+NeroSessionManager *NeroSessionManager::Get()
+{
+    static QPointer<NeroSessionManager> instance;
+    if(instance.isNull()) instance = new NeroSessionManager(QCoreApplication::instance());
+    return instance;
+}
+
+NeroSessionManager::NeroSessionManager(QObject *parent) : QObject(parent)
+{
+    // samples come over from the sessions thread
+    qRegisterMetaType<NeroResourceSample>();
+
+    thread.setObjectName("NeroSessions");
+    thread.start();
+}
+
+NeroSessionManager::~NeroSessionManager()
+{
+    // sessions are cleaned up by the thread on its way out.
+    thread.quit();
+    thread.wait();
+}
+
+int NeroSessionManager::StartShortcut(const QString &prefix, const QString &hash, const QStringList &env)
+{
+    NeroRunner resolver(prefix);
+    NeroSessionContext context;
+    context.prefix = prefix;
+    context.hash = hash;
+    context.env = env;
+    context.profile = resolver.GetProfile(hash);
+    resolver.timings.Mark(NeroLaunchTimings::Settings);
+
+    if(context.profile.path.isEmpty() || !resolver.CanLaunch(context.profile)) return -1;
+
+    context.name = context.profile.name;
+    context.runner = context.profile.runner;
+
+    NeroPrefixIndex::Get()->SetLastPlayed(prefix);
+    return Start(context, resolver.timings);
+}
+
+int NeroSessionManager::StartOnetime(const QString &prefix, const QString &path, const QStringList &args)
+{
+    NeroSessionContext context;
+    context.prefix = prefix;
+    context.path = path;
+    context.args = args;
+    context.name = path.mid(path.lastIndexOf('/')+1);
+    NeroPrefixCfg *prefixCfg = NeroFS::GetPrefixCfg(prefix);
+    if(prefixCfg != nullptr) context.runner = prefixCfg->GetString("PrefixSettings", "CurrentRunner");
+
+    NeroPrefixIndex::Get()->SetLastPlayed(prefix);
+    return Start(context);
+}
+
+int NeroSessionManager::Start(NeroSessionContext &context, const NeroLaunchTimings &timings)
+{
+    context.id = nextId++;
+    context.prefixPath = NeroFS::GetPrefixesPath()->path() + '/' + context.prefix;
+    context.started = QDateTime::currentDateTime();
+
+    // only the first one into a prefix gets to set up its wineserver, the rest just attach to it.
+    NeroSession *session = new NeroSession(context, Count(context.prefix) > 0, timings);
+    session->moveToThread(&thread);
+    connect(&thread, &QThread::finished, session, &QObject::deleteLater);
+    connect(session, &NeroSession::StatusUpdate, this, &NeroSessionManager::SessionStatus);
+    connect(session, &NeroSession::Finished, this, &NeroSessionManager::Finish);
+    connect(session, &NeroSession::Resources, this, [this](const int &id, const NeroResourceSample &sample) {
+        if(!sessions.contains(id)) return;
+        resources.insert(id, sample);
+        emit SessionResources(id, sample);
+    });
+    sessions.insert(context.id, session);
+
+    printf("Starting session %d: %s in %s\n", context.id, context.name.toLocal8Bit().constData(), context.prefix.toLocal8Bit().constData());
+    QMetaObject::invokeMethod(session, &NeroSession::Start, Qt::QueuedConnection);
+
+    emit SessionStarted(context.id);
+    emit SessionsChanged();
+    return context.id;
+}
+
+void NeroSessionManager::Finish(const int &id, const int &result)
+{
+    NeroSession *session = sessions.take(id);
+    if(session == nullptr) return;
+    resources.remove(id);
+
+    const NeroSessionContext context = session->context;
+    printf("Session %d (%s) exited with code %d\n", id, context.name.toLocal8Bit().constData(), result);
+    session->deleteLater();
+
+    emit SessionFinished(context, result);
+    emit SessionsChanged();
+}
+
+void NeroSessionManager::Stop(const int &id, const bool &keepServer)
+{
+    NeroSession *session = sessions.value(id);
+    if(session == nullptr) return;
+
+    QMetaObject::invokeMethod(session, [session, keepServer]() { session->Stop(keepServer); }, Qt::QueuedConnection);
+}
+
+void NeroSessionManager::StopPrefix(const QString &prefix)
+{
+    // taking down the prefix's wineserver once would end them all, but the rest
+    // still need to know they were stopped (i.e. ones still in their pre-run script).
+    // (and since this is shutting down the whole prefix, don't leave a warm wineserver behind either)
+    for(auto i = sessions.constBegin(); i != sessions.constEnd(); ++i)
+        if(i.value()->context.prefix == prefix)
+            Stop(i.key(), false);
+}
+
+QList<NeroSessionContext> NeroSessionManager::GetSessions(const QString &prefix) const
+{
+    QList<NeroSessionContext> list;
+    for(const NeroSession *session : std::as_const(sessions))
+        if(prefix.isEmpty() || session->context.prefix == prefix)
+            list << session->context;
+    return list;
+}
+
+NeroSessionContext NeroSessionManager::GetSession(const int &id) const
+{
+    const NeroSession *session = sessions.value(id);
+    return session != nullptr ? session->context : NeroSessionContext();
+}
+
+int NeroSessionManager::FindShortcut(const QString &prefix, const QString &hash) const
+{
+    for(const NeroSession *session : std::as_const(sessions))
+        if(session->context.prefix == prefix && session->context.hash == hash)
+            return session->context.id;
+    return -1;
+}
+
+bool NeroSessionManager::GetResources(const int &id, NeroResourceSample &sample) const
+{
+    if(!resources.contains(id)) return false;
+    sample = resources.value(id);
+    return true;
+}
+
+int NeroSessionManager::Count(const QString &prefix) const
+{
+    if(prefix.isEmpty()) return sessions.count();
+
+    int count = 0;
+    for(const NeroSession *session : std::as_const(sessions))
+        if(session->context.prefix == prefix) ++count;
+    return count;
+}
@@ -0,0 +1,172 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Launch Sessions Manager.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROSESSION_H
+#define NEROSESSION_H
+
+#include "nerolog.h"
+#include "neroprofile.h"
+#include "neroresources.h"
+#include "neroscheduling.h"
+#include "nerotimings.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QThread>
+
+#include <atomic>
+#include <functional>
+
+class NeroLaunchPipeline;
+class NeroRunner;
+class QTimer;
+
+// Everything about one launch that's settled before it starts, and never changes afterwards.
+// Sessions carry their own prefix around, so nothing here cares what the manager has open in the meantime.
+struct NeroSessionContext {
+    int id = -1;
+    QString prefix;
+    QString prefixPath;
+    // empty for one-time runs
+    QString hash;
+    QString name;
+    // one-time runs only
+    QString path;
+    QStringList args;
+    QString runner;
+    // resolved up front for shortcuts, so the launch itself never has to touch the prefix's ini.
+    NeroLaunchProfile profile;
+    // KEY=VALUE pairs the launch starts from instead of Nero's own environment, if it's not empty (see NeroDaemon).
+    QStringList env;
+    QDateTime started;
+
+    bool IsShortcut() const { return !hash.isEmpty(); }
+};
+
+// One launch, from pre-run script to post-run script, driven entirely off of its processes' signals.
+// Shortcuts get ready through a NeroLaunchPipeline, so the pre-run script runs alongside everything else that has to happen first.
+// Lives on the session manager's thread alongside every other running session.
+class NeroSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    // timings picks up from wherever resolving the profile left off.
+    NeroSession(const NeroSessionContext &context, const bool &prefixAlreadyRunning,
+                const NeroLaunchTimings &timings = NeroLaunchTimings());
+    // waits on a stop that's still going, since that's using the runner from the thread pool.
+    ~NeroSession();
+
+    const NeroSessionContext context;
+
+public slots:
+    void Start();
+    // the blocking part of stopping (waiting on the process tree) is done off in the thread pool.
+    void Stop(const bool &keepServer);
+
+signals:
+    void StatusUpdate(const int &id, const int &status);
+    void Resources(const int &id, const NeroResourceSample &sample);
+    void Finished(const int &id, const int &result);
+
+private:
+    // pre-run scripts that have to finish first - next is called once the script's done, however that happens.
+    void RunScript(const QString &script, const std::function<void()> &next);
+    // background pre-run and post-run scripts, which nothing waits on.
+    static void RunDetached(const QString &script);
+    void StartMain();
+    void MainFinished();
+    void RunPostScript();
+    void Done();
+    // every ResourceSampleMs (0 to turn it off) while umu's up.
+    // Rescans also catch anything that joined the tree without inheriting the run's scheduling policy.
+    void StartSampling();
+    void TakeSample();
+
+    NeroRunner *runner;
+    NeroLaunchPipeline *pipeline = nullptr;
+    NeroScheduledProcess *umu = nullptr;
+    QString command;
+    QStringList arguments;
+    NeroLogWriter log;
+    NeroResourceMonitor monitor;
+    QTimer *sampleTimer = nullptr;
+    bool alreadyRunning;
+    bool protonStarted = false;
+    bool halted = false;
+    bool stopping = false;
+    // from the pool's side: whether StopProcess is still using the runner
+    std::atomic<bool> stopInFlight{false};
+    bool mainDone = false;
+    bool finished = false;
+    int result = 1;
+};
+
+// Owns the one thread every session's processes are multiplexed on, and the list of what's running where.
+// All of it is meant to be used from the GUI (or daemon's main) thread.
+class NeroSessionManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static NeroSessionManager *Get();
+
+    // returns the new session's id (never reused), or -1 if the shortcut doesn't exist or can't be launched.
+    int StartShortcut(const QString &prefix, const QString &hash, const QStringList &env = {});
+    int StartOnetime(const QString &prefix, const QString &path, const QStringList &args = {});
+    // keepServer = false takes the prefix's wineserver down too, and with it everything else running there.
+    void Stop(const int &id, const bool &keepServer = true);
+    void StopPrefix(const QString &prefix);
+
+    // in the order they were started; all prefixes if prefix is empty.
+    QList<NeroSessionContext> GetSessions(const QString &prefix = "") const;
+    NeroSessionContext GetSession(const int &id) const;
+    // id of that shortcut's session, or -1 if it's not running.
+    int FindShortcut(const QString &prefix, const QString &hash) const;
+    int Count(const QString &prefix = "") const;
+    // latest sample, if there's been one yet.
+    bool GetResources(const int &id, NeroResourceSample &sample) const;
+
+signals:
+    void SessionStarted(const int &id);
+    void SessionStatus(const int &id, const int &status);
+    void SessionResources(const int &id, const NeroResourceSample &sample);
+    // the session's already gone from the list by now, so its context comes along with it.
+    void SessionFinished(const NeroSessionContext &context, const int &result);
+    void SessionsChanged();
+
+private:
+    explicit NeroSessionManager(QObject *parent);
+    ~NeroSessionManager();
+
+    int Start(NeroSessionContext &, const NeroLaunchTimings &timings = NeroLaunchTimings());
+    void Finish(const int &id, const int &result);
+
+    QThread thread;
+    QMap<int, NeroSession*> sessions;
+    QHash<int, NeroResourceSample> resources;
+    int nextId = 1;
+};
+
+#endif // NEROSESSION_H
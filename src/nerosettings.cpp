@@ -0,0 +1,92 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Prefix & Shortcut Settings Schema.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerosettings.h"
+
+#include <QHash>
+
+int NeroSetting::Find(const QString &key)
+{
+    // function-local, so it's built once by whoever gets here first
+    static const QHash<QString, int> indexes = []() {
+        QHash<QString, int> built;
+        for(int i = 0; i < KeyCount; ++i)
+            built.insert(QString::fromLatin1(schema[i].key), i);
+        return built;
+    }();
+
+    return indexes.value(key, -1);
+}
+
+QStringList NeroSetting::GetKeys()
+{
+    QStringList keys;
+    for(const auto &def : schema)
+        keys << QString::fromLatin1(def.key);
+    return keys;
+}
+
+QVariant NeroSetting::GetDefault(const Key &key)
+{
+    switch(schema[key].type) {
+    case TypeBool: return static_cast<bool>(schema[key].defaultValue);
+    case TypeInt: return schema[key].defaultValue;
+    case TypeString: return QString();
+    case TypeStringList: return QStringList();
+    }
+    return QVariant();
+}
+
+QVariant NeroSetting::GetSeed(const Key &key)
+{
+    // an empty list would be written out as @Invalid(), which reads back as not set at all.
+    if(schema[key].type == TypeString || schema[key].type == TypeStringList) return QString("");
+    else return GetDefault(key);
+}
+
+bool NeroSetting::Check(const Key &key, QVariant &value)
+{
+    // nothing, or blank - i.e. "use the prefix's" for shortcuts
+    if(!value.isValid()) return true;
+    if(value.userType() == QMetaType::QString && value.toString().isEmpty()) return true;
+
+    const Def &def = schema[key];
+    switch(def.type) {
+    case TypeBool: {
+        if(value.userType() == QMetaType::Bool) return true;
+        const QString text = value.toString().trimmed().toLower();
+        if(text == "true" || text == "1") value = true;
+        else if(text == "false" || text == "0") value = false;
+        else return false;
+        return true;
+    }
+    case TypeInt: {
+        bool ok = false;
+        const int number = value.toInt(&ok);
+        if(!ok || number < def.min || number > def.max) return false;
+        value = number;
+        return true;
+    }
+    // anything in an ini is a valid string, and these get read back as whatever shape they were written in.
+    case TypeString:
+    case TypeStringList:
+        return true;
+    }
+    return false;
+}
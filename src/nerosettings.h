@@ -0,0 +1,198 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Prefix & Shortcut Settings Schema.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROSETTINGS_H
+#define NEROSETTINGS_H
+
+#include "neroconstants.h"
+#include "neroscheduling.h"
+
+#include <QStringList>
+#include <QVariant>
+
+// Every setting a prefix's nero-settings.ini can hold for the prefix itself or its shortcuts,
+// with what it is, where it can go and what values make sense for it.
+// NeroPrefixCfg keeps these in flat arrays indexed by Key, and checks values against it once as they're loaded -
+// so anything reading a setting only ever sees good values (or nothing at all).
+class NeroSetting
+{
+public:
+    enum Type {
+        TypeBool = 0,
+        TypeInt,
+        TypeString,
+        // ini lists with a single item come back as plain strings, so these can be either
+        TypeStringList
+    };
+
+    enum Scope {
+        ScopePrefix = 0x1,
+        ScopeShortcut = 0x2,
+        ScopeBoth = ScopePrefix | ScopeShortcut
+    };
+
+    // named after their ini keys on purpose, so grepping for one finds the other.
+    enum Key {
+        Name = 0,
+        Path,
+        Args,
+        IconKey,
+        CurrentRunner,
+        RuntimeUpdateOnLaunch,
+        WarmPrefix,
+        WindowsVersion,
+        Gamemode,
+        VKcapture,
+        Mangohud,
+        EnableNVAPI,
+        ScalingMode,
+        FSRcustomResW,
+        FSRcustomResH,
+        GamescopeOutResW,
+        GamescopeOutResH,
+        GamescopeWinResW,
+        GamescopeWinResH,
+        GamescopeScaler,
+        GamescopeFilter,
+        DLLoverrides,
+        IgnoreGlobalDLLs,
+        ForceiGPU,
+        LimitGLextensions,
+        DebugOutput,
+        FileSyncMode,
+        NoD8VK,
+        ForceWineD3D,
+        UseWayland,
+        UseHDR,
+        AllowHidraw,
+        UseXalia,
+        CustomEnvVars,
+        DiscordRPCinstalled,
+        LimitFPS,
+        PreRunScript,
+        PostRunScript,
+        PreRunInBackground,
+        CpuSet,
+        CpuList,
+        ProcessPriority,
+        IoPriority,
+        ElevateScheduling,
+        KeyCount
+    };
+
+    struct Def {
+        Key id;
+        const char *key;
+        Type type;
+        Scope scope;
+        // for bools and ints, and what new prefixes get seeded with; strings and lists are always empty by default
+        int defaultValue;
+        int min;
+        int max;
+        // written out to new prefixes (or shortcuts, for shortcut-only settings) so they're there to hand edit
+        bool seed;
+    };
+
+    // bump whenever a key is added, removed or has its type/range changed - binary prefix configs written
+    // for an older schema get carried over by key name instead of being read as-is.
+    static constexpr unsigned int schemaVersion = 1;
+
+    static constexpr Def schema[KeyCount] = {
+        { Name,                  "Name",                  TypeString,     ScopeBoth,     0, 0, 0, false },
+        { Path,                  "Path",                  TypeString,     ScopeShortcut, 0, 0, 0, false },
+        { Args,                  "Args",                  TypeStringList, ScopeShortcut, 0, 0, 0, false },
+        { IconKey,               "IconKey",               TypeString,     ScopeShortcut, 0, 0, 0, false },
+        { CurrentRunner,         "CurrentRunner",         TypeString,     ScopeBoth,     0, 0, 0, false },
+        { RuntimeUpdateOnLaunch, "RuntimeUpdateOnLaunch", TypeBool,       ScopeBoth,     true, 0, 1, true },
+        { WarmPrefix,            "WarmPrefix",            TypeBool,       ScopePrefix,   false, 0, 1, true },
+        { WindowsVersion,        "WindowsVersion",        TypeInt,        ScopeBoth,     NeroConstant::WinVer10,
+                                                                                         NeroConstant::WinVer2dot0, NeroConstant::WinVerCancer, true },
+        { Gamemode,              "Gamemode",              TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { VKcapture,             "VKcapture",             TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { Mangohud,              "Mangohud",              TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { EnableNVAPI,           "EnableNVAPI",           TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { ScalingMode,           "ScalingMode",           TypeInt,        ScopeBoth,     NeroConstant::ScalingNormal,
+                                                                                         NeroConstant::ScalingNormal, NeroConstant::ScalingGamescopeFullscreen, true },
+        // resolutions are typed in, and blank means native
+        { FSRcustomResW,         "FSRcustomResW",         TypeString,     ScopeBoth,     0, 0, 0, true },
+        { FSRcustomResH,         "FSRcustomResH",         TypeString,     ScopeBoth,     0, 0, 0, true },
+        { GamescopeOutResW,      "GamescopeOutResW",      TypeString,     ScopeBoth,     0, 0, 0, true },
+        { GamescopeOutResH,      "GamescopeOutResH",      TypeString,     ScopeBoth,     0, 0, 0, true },
+        { GamescopeWinResW,      "GamescopeWinResW",      TypeString,     ScopeBoth,     0, 0, 0, true },
+        { GamescopeWinResH,      "GamescopeWinResH",      TypeString,     ScopeBoth,     0, 0, 0, true },
+        { GamescopeScaler,       "GamescopeScaler",       TypeInt,        ScopeBoth,     NeroConstant::GSscalerAuto,
+                                                                                         NeroConstant::GSscalerAuto, NeroConstant::GSscalerStretch, true },
+        { GamescopeFilter,       "GamescopeFilter",       TypeInt,        ScopeBoth,     NeroConstant::GSfilterLinear,
+                                                                                         NeroConstant::GSfilterLinear, NeroConstant::GSfilterPixel, true },
+        { DLLoverrides,          "DLLoverrides",          TypeStringList, ScopeBoth,     0, 0, 0, true },
+        { IgnoreGlobalDLLs,      "IgnoreGlobalDLLs",      TypeBool,       ScopeShortcut, false, 0, 1, true },
+        { ForceiGPU,             "ForceiGPU",             TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { LimitGLextensions,     "LimitGLextensions",     TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { DebugOutput,           "DebugOutput",           TypeInt,        ScopeBoth,     NeroConstant::DebugDisabled,
+                                                                                         NeroConstant::DebugDisabled, NeroConstant::DebugFull, true },
+        { FileSyncMode,          "FileSyncMode",          TypeInt,        ScopeBoth,     NeroConstant::AutoSync,
+                                                                                         NeroConstant::NTsync, NeroConstant::AutoSync, true },
+        { NoD8VK,                "NoD8VK",                TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { ForceWineD3D,          "ForceWineD3D",          TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { UseWayland,            "UseWayland",            TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { UseHDR,                "UseHDR",                TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { AllowHidraw,           "AllowHidraw",           TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { UseXalia,              "UseXalia",              TypeBool,       ScopeBoth,     false, 0, 1, true },
+        { CustomEnvVars,         "CustomEnvVars",         TypeStringList, ScopePrefix,   0, 0, 0, true },
+        { DiscordRPCinstalled,   "DiscordRPCinstalled",   TypeBool,       ScopePrefix,   false, 0, 1, true },
+        // same cap as the settings window's spinbox
+        { LimitFPS,              "LimitFPS",              TypeInt,        ScopeShortcut, 0, 0, 999, true },
+        { PreRunScript,          "PreRunScript",          TypeString,     ScopeShortcut, 0, 0, 0, false },
+        { PostRunScript,         "PostRunScript",         TypeString,     ScopeShortcut, 0, 0, 0, false },
+        { PreRunInBackground,    "PreRunInBackground",    TypeBool,       ScopeShortcut, false, 0, 1, false },
+        { CpuSet,                "CpuSet",                TypeInt,        ScopeBoth,     NeroScheduling::CpuSetAll,
+                                                                                         NeroScheduling::CpuSetAll, NeroScheduling::CpuSetNoCore0, false },
+        { CpuList,               "CpuList",               TypeString,     ScopeBoth,     0, 0, 0, false },
+        { ProcessPriority,       "ProcessPriority",       TypeInt,        ScopeBoth,     NeroScheduling::PriorityNormal,
+                                                                                         NeroScheduling::PriorityNormal, NeroScheduling::PriorityLow, false },
+        { IoPriority,            "IoPriority",            TypeInt,        ScopeBoth,     NeroScheduling::IoDefault,
+                                                                                         NeroScheduling::IoDefault, NeroScheduling::IoIdle, false },
+        { ElevateScheduling,     "ElevateScheduling",     TypeBool,       ScopeBoth,     false, 0, 1, false },
+    };
+
+    // METHODS
+    static constexpr const Def &Get(const Key &key) { return schema[key]; }
+    static constexpr const char *GetKey(const Key &key) { return schema[key].key; }
+    // index into the schema for an ini key, or -1 for anything it doesn't cover.
+    static int Find(const QString &);
+    static QStringList GetKeys();
+    // what NeroPrefixCfg's typed getters fall back to when a setting isn't there.
+    static QVariant GetDefault(const Key &);
+    // what new prefixes/shortcuts get written, which for strings and lists is a blank string rather than nothing.
+    static QVariant GetSeed(const Key &);
+    // converts good ini text to the setting's own type, or returns false if it's no good at all.
+    // blank values are always fine, since that's how shortcuts fall back to their prefix.
+    static bool Check(const Key &, QVariant &);
+    // for the static_assert below, since the table's indexed by Key everywhere.
+    static constexpr bool InOrder()
+    {
+        for(int i = 0; i < KeyCount; ++i)
+            if(schema[i].id != i || schema[i].key == nullptr || schema[i].min > schema[i].max) return false;
+        return true;
+    }
+};
+
+static_assert(NeroSetting::InOrder(), "NeroSetting::schema has to list every Key, in the same order as the enum");
+
+#endif // NEROSETTINGS_H
@@ -0,0 +1,253 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Per-Game Shader Caches.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "neroshadercache.h"
+#include "nerofs.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QThreadPool>
+
+// caches for a GPU/driver combo that hasn't been used in this long are just taking up space.
+#define NERO_SHADER_CACHE_STALE_DAYS 30
+
+static QString ReadSysfs(const QString &path)
+{
+    QFile file(path);
+    if(file.open(QIODevice::ReadOnly)) return QString(file.readAll()).trimmed();
+    else return QString();
+}
+
+QString NeroShaderCache::GetGpuKey()
+{
+    // the hardware and drivers don't change while we're running, so only work this out once.
+    static const QString gpuKey = []() {
+        QStringList gpus;
+        const QStringList cards = QDir("/sys/class/drm").entryList({ "card*" }, QDir::Dirs | QDir::System | QDir::NoDotAndDotDot, QDir::Name);
+        for(const auto &card : cards) {
+            // connectors (card0-DP-1 and such) aren't GPUs
+            if(card.contains('-')) continue;
+            const QString vendor = ReadSysfs("/sys/class/drm/" + card + "/device/vendor").remove("0x");
+            const QString device = ReadSysfs("/sys/class/drm/" + card + "/device/device").remove("0x");
+            if(!vendor.isEmpty() && !gpus.contains(vendor + '_' + device))
+                gpus.append(vendor + '_' + device);
+        }
+
+        // Mesa doesn't expose its version anywhere cheap, but every update replaces the ICD manifests and the
+        // driver libraries they point to - so those files' sizes+mtimes work as a version stamp.
+        QCryptographicHash driverHash(QCryptographicHash::Sha1);
+        driverHash.addData(ReadSysfs("/sys/module/nvidia/version").toUtf8());
+        driverHash.addData(ReadSysfs("/sys/module/amdgpu/version").toUtf8());
+
+        for(const auto &icdDir : { "/usr/share/vulkan/icd.d", "/etc/vulkan/icd.d" }) {
+            const QFileInfoList icds = QDir(icdDir).entryInfoList({ "*.json" }, QDir::Files, QDir::Name);
+            for(const auto &icd : icds) {
+                driverHash.addData(QString("%1:%2:%3").arg(icd.fileName()).arg(icd.size()).arg(icd.lastModified().toSecsSinceEpoch()).toUtf8());
+
+                QFile icdFile(icd.filePath());
+                if(!icdFile.open(QIODevice::ReadOnly)) continue;
+                const QFileInfo library(QJsonDocument::fromJson(icdFile.readAll()).object().value("ICD").toObject().value("library_path").toString());
+                if(library.isAbsolute() && library.exists())
+                    driverHash.addData(QString("%1:%2").arg(library.size()).arg(library.lastModified().toSecsSinceEpoch()).toUtf8());
+            }
+        }
+
+        return (gpus.isEmpty() ? QString("unknown") : gpus.join('+')) + '-' + driverHash.result().toHex().left(12);
+    }();
+
+    return gpuKey;
+}
+
+QString NeroShaderCache::GetCachePath(const QString &prefixPath, const QString &cacheId)
+{
+    return QString("%1/.shaderCache/%2/%3").arg(prefixPath, cacheId.isEmpty() ? QString("default") : cacheId, GetGpuKey());
+}
+
+QString NeroShaderCache::GetSharedPath(const QString &shareKey)
+{
+    return QString("%1/nero-umu/shaders/%2/%3").arg(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation),
+                                                    shareKey, GetGpuKey());
+}
+
+QString NeroShaderCache::GetShareKey(const QString &gameId, const QString &exePath)
+{
+    // 0 is the "no id" default, i.e. everything without one
+    if(!gameId.isEmpty() && gameId != "0" && gameId != "umu-0")
+        return gameId;
+
+    const QFileInfo exe(exePath);
+    if(!exe.exists()) return QString();
+    else return QString("%1-%2").arg(exe.fileName()).arg(exe.size());
+}
+
+QString NeroShaderCache::Prepare(QProcessEnvironment &env, const QString &prefixPath, const QString &cacheId, const QString &shareKey)
+{
+    const QString cachePath = GetCachePath(prefixPath, cacheId);
+
+    if(!QDir(cachePath).exists()) {
+        if(!QDir().mkpath(cachePath)) {
+            printf("Shader cache directory not available! Not using cache...\n");
+            return QString();
+        }
+
+        PruneStale(QFileInfo(cachePath).path(), GetGpuKey());
+
+        // another prefix already did the compiling for this game on this driver, so start off where it left off.
+        if(!shareKey.isEmpty() && NeroFS::GetManagerValue("ShareShaderCaches", true).toBool() &&
+           QDir(GetSharedPath(shareKey)).exists() && CopyTree(GetSharedPath(shareKey), cachePath)) {
+            printf("Seeded shader cache from shared cache for %s\n", shareKey.toLocal8Bit().constData());
+            QSettings stats(GetStatsPath(cachePath), QSettings::IniFormat);
+            stats.setValue("Seeded", true);
+        }
+    }
+
+    // set every launch, not just when the cache was made - and whatever the user set for themselves wins.
+    auto insertIfUnset = [&env](const QString &var, const QString &value) {
+        if(!env.contains(var)) env.insert(var, value);
+    };
+    insertIfUnset("DXVK_STATE_CACHE_PATH", cachePath);
+    insertIfUnset("VKD3D_SHADER_CACHE_PATH", cachePath);
+    // Mesa (RADV/ANV/etc.) and NVIDIA keep the actual compiled pipelines, which is where most of the stutter is saved
+    insertIfUnset("MESA_SHADER_CACHE_DIR", cachePath);
+    insertIfUnset("__GL_SHADER_DISK_CACHE", "1");
+    insertIfUnset("__GL_SHADER_DISK_CACHE_PATH", cachePath);
+    insertIfUnset("__GL_SHADER_DISK_CACHE_SKIP_CLEANUP", "1");
+
+    return cachePath;
+}
+
+void NeroShaderCache::Finish(const QString &cachePath, const qint64 &sizeBefore, const QString &shareKey)
+{
+    if(cachePath.isEmpty() || !QDir(cachePath).exists()) return;
+
+    const qint64 size = GetSize(cachePath);
+
+    QSettings stats(GetStatsPath(cachePath), QSettings::IniFormat);
+    stats.setValue("Size", size);
+    stats.setValue("LastGrowth", size - sizeBefore);
+    stats.setValue("Runs", stats.value("Runs", 0).toInt() + 1);
+    stats.setValue("LastUsed", QDateTime::currentSecsSinceEpoch());
+    stats.sync();
+
+    printf("Shader cache: %.1f MiB, %s\n", size / 1048576.0,
+           size > sizeBefore ? QString("grew %1 KiB this run").arg((size - sizeBefore) / 1024).toLocal8Bit().constData()
+                             : "no new shaders this run");
+
+    if(shareKey.isEmpty() || !NeroFS::GetManagerValue("ShareShaderCaches", true).toBool()) return;
+
+    // big DXVK/vkd3d caches can take a good while to copy, and nothing's waiting on the shared copy -
+    // so the session can finish (and the next launch start) without it.
+    QThreadPool::globalInstance()->start([cachePath, size, shareKey]() { Publish(cachePath, size, shareKey); });
+}
+
+void NeroShaderCache::Publish(const QString &cachePath, const qint64 &size, const QString &shareKey)
+{
+    // only a cache that's further along than the shared one is worth handing out.
+    const QString sharedPath = GetSharedPath(shareKey);
+    if(size <= GetSize(sharedPath)) return;
+
+    // never write into the shared copy in place - another prefix could be seeding from it right now.
+    const QString suffix = QString(".%1-%2").arg(QCoreApplication::applicationPid()).arg(QDateTime::currentMSecsSinceEpoch());
+    QDir().mkpath(QFileInfo(sharedPath).path());
+    if(!CopyTree(cachePath, sharedPath + suffix)) {
+        QDir(sharedPath + suffix).removeRecursively();
+        return;
+    }
+    // stats belong to the prefix's cache, not the shared one
+    QFile::remove(GetStatsPath(sharedPath + suffix));
+
+    QDir().rename(sharedPath, sharedPath + suffix + ".old");
+    if(QDir().rename(sharedPath + suffix, sharedPath))
+        printf("Published shader cache for %s\n", shareKey.toLocal8Bit().constData());
+    else QDir(sharedPath + suffix).removeRecursively();
+    QDir(sharedPath + suffix + ".old").removeRecursively();
+}
+
+NeroShaderCache::Stats NeroShaderCache::GetStats(const QString &cachePath)
+{
+    Stats info;
+    if(!QFile::exists(GetStatsPath(cachePath))) {
+        info.size = GetSize(cachePath);
+        return info;
+    }
+
+    QSettings stats(GetStatsPath(cachePath), QSettings::IniFormat);
+    info.size = stats.value("Size", GetSize(cachePath)).toLongLong();
+    info.lastGrowth = stats.value("LastGrowth", -1).toLongLong();
+    info.runs = stats.value("Runs", 0).toInt();
+    info.seeded = stats.value("Seeded", false).toBool();
+    return info;
+}
+
+qint64 NeroShaderCache::GetSize(const QString &path)
+{
+    qint64 size = 0;
+    QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while(it.hasNext()) {
+        it.next();
+        if(it.fileName() != "nero-cache.stats")
+            size += it.fileInfo().size();
+    }
+    return size;
+}
+
+bool NeroShaderCache::CopyTree(const QString &source, const QString &target)
+{
+    if(!QDir().mkpath(target)) return false;
+
+    const QFileInfoList entries = QDir(source).entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
+    for(const auto &entry : entries) {
+        if(entry.isSymLink()) continue;
+        const QString targetPath = target + '/' + entry.fileName();
+
+        if(entry.isDir()) {
+            if(!CopyTree(entry.filePath(), targetPath)) return false;
+        } else {
+            QFile::remove(targetPath);
+            if(!QFile::copy(entry.filePath(), targetPath)) return false;
+        }
+    }
+
+    return true;
+}
+
+void NeroShaderCache::PruneStale(const QString &cacheIdPath, const QString &currentGpu)
+{
+    const qint64 cutoff = QDateTime::currentSecsSinceEpoch() - NERO_SHADER_CACHE_STALE_DAYS * 86400;
+    const QFileInfoList gpus = QDir(cacheIdPath).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    for(const auto &gpu : gpus) {
+        if(gpu.fileName() == currentGpu) continue;
+
+        const qint64 lastUsed = QSettings(GetStatsPath(gpu.filePath()), QSettings::IniFormat)
+                                    .value("LastUsed", gpu.lastModified().toSecsSinceEpoch()).toLongLong();
+        if(lastUsed < cutoff) {
+            printf("Removing shader cache for old driver %s\n", gpu.fileName().toLocal8Bit().constData());
+            QDir(gpu.filePath()).removeRecursively();
+        }
+    }
+}
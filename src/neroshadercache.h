@@ -0,0 +1,68 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Per-Game Shader Caches.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROSHADERCACHE_H
+#define NEROSHADERCACHE_H
+
+#include <QProcessEnvironment>
+#include <QString>
+
+// Every shortcut gets its own shader cache at <prefix>/.shaderCache/<hash>/<gpu>, where <gpu> is the GPU's
+// PCI ids plus a hash of the installed driver/ICD versions - so a driver update starts from a clean cache
+// instead of feeding DXVK/vkd3d/Mesa entries they'd just reject (or worse, stutter through validating).
+// Caches can also be shared between prefixes running the same game, through ~/.cache/nero-umu/shaders:
+// a new cache is seeded from the shared copy, and a run that grew the cache past it publishes its own back.
+// The shared copy is only ever replaced whole, never written to by a running game.
+class NeroShaderCache
+{
+public:
+    struct Stats {
+        qint64 size = 0;
+        // -1 if it's never been updated after a run
+        qint64 lastGrowth = -1;
+        int runs = 0;
+        bool seeded = false;
+    };
+
+    // METHODS
+    static QString GetGpuKey();
+    static QString GetCachePath(const QString &prefixPath, const QString &cacheId);
+    static QString GetSharedPath(const QString &shareKey);
+    // GAMEID if the user gave one, otherwise the executable's name + size - good enough to tell the same game
+    // installed in two prefixes apart from two different games.
+    static QString GetShareKey(const QString &gameId, const QString &exePath);
+
+    // makes sure the cache exists and points every cache var the user hasn't set themselves at it.
+    // Returns the cache's path, or empty if there isn't one to use.
+    static QString Prepare(QProcessEnvironment &env, const QString &prefixPath, const QString &cacheId, const QString &shareKey = "");
+    // records how much the cache grew this run, and publishes it to the shared copy if it's ahead (in the background).
+    static void Finish(const QString &cachePath, const qint64 &sizeBefore, const QString &shareKey = "");
+
+    static Stats GetStats(const QString &cachePath);
+    static qint64 GetSize(const QString &path);
+
+private:
+    // run off on the global thread pool by Finish, which QCoreApplication waits on before it goes away.
+    static void Publish(const QString &cachePath, const qint64 &size, const QString &shareKey);
+    static bool CopyTree(const QString &source, const QString &target);
+    static void PruneStale(const QString &cacheIdPath, const QString &currentGpu);
+    static QString GetStatsPath(const QString &cachePath) { return cachePath + "/nero-cache.stats"; }
+};
+
+#endif // NEROSHADERCACHE_H
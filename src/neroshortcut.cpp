@@ -44,15 +44,10 @@ NeroShortcutWizard::NeroShortcutWizard(QWidget *parent, const QString &newAppPat
 
     NeroIcoExtractor::CheckIcoCache(QDir(NeroFS::GetPrefixesPath()->path()+'/'+NeroFS::GetCurrentPrefix()));
 
-    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-    appIcon = NeroIcoExtractor::GetIcon(newAppPath);
-    QGuiApplication::restoreOverrideCursor();
-
-    if(!appIcon.isEmpty()) {
-        if(QPixmap(appIcon).height() < 48)
-            ui->appIcon->setIcon(QPixmap(appIcon).scaled(48,48,Qt::KeepAspectRatio,Qt::SmoothTransformation));
-        else ui->appIcon->setIcon(QPixmap(appIcon));
-    }
+    // the manager does the actual extracting once the shortcut's made, this is just for the preview.
+    appIcon = newAppPath;
+    LoadIconPreview(newAppPath);
+
     existingShortcuts.append(NeroFS::GetCurrentPrefixShortcuts());
     
     // set the shortcut name field to the exe name
@@ -64,12 +59,26 @@ NeroShortcutWizard::NeroShortcutWizard(QWidget *parent, const QString &newAppPat
 
 NeroShortcutWizard::~NeroShortcutWizard()
 {
-    QDir tempDir(QDir::tempPath()+"/nero-manager");
-    tempDir.removeRecursively();
-
     delete ui;
 }
 
+void NeroShortcutWizard::LoadIconPreview(const QString &iconSource)
+{
+    const unsigned int request = ++iconRequests;
+
+    NeroIcoExtractor::GetIconImageAsync(iconSource, this, [this, iconSource, request](const QImage &icon) {
+        // something else was picked while this one was still decoding
+        if(request != iconRequests) return;
+
+        if(!icon.isNull()) {
+            appIcon = iconSource;
+            if(icon.height() < 48)
+                ui->appIcon->setIcon(QPixmap::fromImage(icon.scaled(48,48,Qt::KeepAspectRatio,Qt::SmoothTransformation)));
+            else ui->appIcon->setIcon(QPixmap::fromImage(icon));
+        } else if(iconSource == appIcon) ui->appIcon->setIcon(QIcon::fromTheme("application-x-executable"));
+    });
+}
+
 
 void NeroShortcutWizard::on_shortcutName_textChanged(const QString &arg1)
 {
@@ -102,15 +111,8 @@ void NeroShortcutWizard::on_selectBox_clicked()
                                                   QFileDialog::DontResolveSymlinks);
 
     if(!newApp.isEmpty()) {
-        QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-        appIcon = NeroIcoExtractor::GetIcon(newApp);
-        QGuiApplication::restoreOverrideCursor();
-
-        if(!appIcon.isEmpty()) {
-            if(QPixmap(appIcon).height() < 48)
-                ui->appIcon->setIcon(QPixmap(appIcon).scaled(48,48,Qt::KeepAspectRatio,Qt::SmoothTransformation));
-            else ui->appIcon->setIcon(QPixmap(appIcon));
-        } else ui->appIcon->setIcon(QIcon::fromTheme("application-x-executable"));
+        appIcon = newApp;
+        LoadIconPreview(newApp);
 
         // if exe is inside of prefix, convert path to Windows path inside C:/
         if(newApp.startsWith(NeroFS::GetPrefixesPath()->canonicalPath()+'/'+NeroFS::GetCurrentPrefix()+"/drive_c"))
@@ -131,16 +133,8 @@ void NeroShortcutWizard::on_appIcon_clicked()
                                                    QFileDialog::DontResolveSymlinks);
 
     if(!newIcon.isEmpty()) {
-        QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-        newIcon = NeroIcoExtractor::GetIcon(newIcon);
-        QGuiApplication::restoreOverrideCursor();
-
-        if(!newIcon.isEmpty()) {
-            appIcon = newIcon;
-            if(QPixmap(appIcon).height() < 48)
-                ui->appIcon->setIcon(QPixmap(appIcon).scaled(48,48,Qt::KeepAspectRatio,Qt::SmoothTransformation));
-            else ui->appIcon->setIcon(QPixmap(appIcon));
-        }
+        // only takes over if it actually has an icon in it
+        LoadIconPreview(newIcon);
     }
 }
 
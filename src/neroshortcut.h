@@ -35,6 +35,7 @@ public:
     ~NeroShortcutWizard();
 
     QString appPath;
+    // file the icon gets pulled from (exe/dll/ico/png), not the icon itself.
     QString appIcon;
     QString shortcutName;
 
@@ -50,8 +51,8 @@ private slots:
 private:
     Ui::NeroShortcutWizard *ui;
 
-    QString GetIcoextract();
-    QString GetIcoutils();
+    void LoadIconPreview(const QString &);
+    unsigned int iconRequests = 0;
 
     QStringList existingShortcuts;
 };
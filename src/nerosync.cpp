@@ -0,0 +1,144 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Sync Primitive Probing.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerosync.h"
+#include "neroconstants.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+// same number on every architecture, but older headers won't have it yet
+#ifndef SYS_futex_waitv
+#define SYS_futex_waitv 449
+#endif
+
+// what Proton itself suggests for esync, and what most distros ship as the hard limit nowadays
+static constexpr rlim_t esyncFileLimit = 524288;
+
+const NeroSync::KernelSupport &NeroSync::GetKernel()
+{
+    // function-local, so the first launch on any thread probes it and everyone else just reads it.
+    static const KernelSupport kernel = Probe();
+    return kernel;
+}
+
+NeroSync::KernelSupport NeroSync::Probe()
+{
+    KernelSupport kernel;
+
+    // wine opens it the same way; missing module and wrong permissions both look like a failed open here.
+    const int ntsync = open("/dev/ntsync", O_RDONLY | O_CLOEXEC);
+    if(ntsync >= 0) {
+        kernel.ntsync = true;
+        close(ntsync);
+    }
+
+    // no futexes at all is always EINVAL where the syscall exists, and ENOSYS where it doesn't.
+    if(syscall(SYS_futex_waitv, nullptr, 0, 0, nullptr, 0) == 0 || errno != ENOSYS)
+        kernel.futexWaitv = true;
+
+    struct rlimit files;
+    if(getrlimit(RLIMIT_NOFILE, &files) == 0)
+        kernel.esyncLimit = files.rlim_max == RLIM_INFINITY || files.rlim_max >= esyncFileLimit;
+
+    struct utsname name;
+    if(uname(&name) == 0) kernel.release = QString::fromLocal8Bit(name.release);
+
+    printf("Kernel %s: ntsync %s, futex_waitv %s, esync file limit %s\n", kernel.release.toLocal8Bit().constData(),
+           kernel.ntsync ? "available" : "unavailable", kernel.futexWaitv ? "available" : "unavailable",
+           kernel.esyncLimit ? "ok" : "too low");
+    return kernel;
+}
+
+bool NeroSync::RunnerHasNtsync(const NeroRunnerInfo &runner)
+{
+    // GE-Proton10-9 was the first to have it
+    if(runner.features & NeroRunnerInfo::FeatureUnknown)
+        return runner.version.flavor == NeroRunnerVersion::GE && runner.version.IsAtLeast(10, 9);
+    return runner.features & NeroRunnerInfo::FeatureNtsync;
+}
+
+bool NeroSync::RunnerHasFsync(const NeroRunnerInfo &runner)
+{
+    // every Proton since 5.0 or so, and anything we couldn't make sense of is most likely newer than that.
+    if(runner.features & NeroRunnerInfo::FeatureUnknown)
+        return !runner.version.major || runner.version.IsAtLeast(5);
+    return runner.features & NeroRunnerInfo::FeatureFsync;
+}
+
+int NeroSync::Resolve(const int &syncMode, const NeroRunnerInfo &runner, QString *reason)
+{
+    const KernelSupport &kernel = GetKernel();
+    QString why;
+    int resolved;
+
+    switch(syncMode) {
+    case NeroConstant::Fsync:
+        resolved = NeroConstant::Fsync;
+        why = kernel.futexWaitv ? "forced" : "forced, but this kernel has no futex_waitv - Proton will fall back to esync";
+        break;
+    case NeroConstant::Esync:
+        resolved = NeroConstant::Esync;
+        why = kernel.esyncLimit ? "forced" : "forced, but the open files limit is too low for it to be reliable";
+        break;
+    case NeroConstant::NoSync:
+        resolved = NeroConstant::NoSync;
+        why = "forced";
+        break;
+    // the default mode predicts the same way as auto, it just leaves the fallbacks to Proton.
+    case NeroConstant::NTsync:
+    case NeroConstant::AutoSync:
+    default:
+        if(kernel.ntsync && RunnerHasNtsync(runner)) {
+            resolved = NeroConstant::NTsync;
+            why = "supported by both the kernel and runner";
+        } else {
+            why = !kernel.ntsync ? "no usable /dev/ntsync" : "runner doesn't support ntsync";
+            if(kernel.futexWaitv && RunnerHasFsync(runner)) {
+                resolved = NeroConstant::Fsync;
+            } else if(kernel.esyncLimit || syncMode == NeroConstant::NTsync) {
+                resolved = NeroConstant::Esync;
+                why += kernel.futexWaitv ? ", runner doesn't support fsync" : ", no futex_waitv";
+            } else {
+                resolved = NeroConstant::NoSync;
+                why += ", no fsync, and the open files limit is too low for esync";
+            }
+        }
+        break;
+    }
+
+    if(reason != nullptr) *reason = why;
+    return resolved;
+}
+
+QString NeroSync::GetName(const int &syncMode)
+{
+    switch(syncMode) {
+    case NeroConstant::NTsync: return "ntsync";
+    case NeroConstant::Fsync: return "fsync";
+    case NeroConstant::Esync: return "esync";
+    case NeroConstant::NoSync: return "wineserver";
+    case NeroConstant::AutoSync: return "auto";
+    default: return "unknown";
+    }
+}
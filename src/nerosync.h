@@ -0,0 +1,56 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Sync Primitive Probing.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROSYNC_H
+#define NEROSYNC_H
+
+#include "nerorunnerindex.h"
+
+#include <QString>
+
+// Works out which of ntsync/fsync/esync a launch can actually use, from what the kernel offers
+// and what the runner's proton script knows about.
+// The kernel side's only probed once per process - none of it changes short of a reboot (or a modprobe, for ntsync).
+class NeroSync
+{
+public:
+    struct KernelSupport {
+        // /dev/ntsync exists, and we're allowed to open it
+        bool ntsync = false;
+        // futex_waitv(2), which is what upstream-kernel fsync runs on (5.16+)
+        bool futexWaitv = false;
+        // esync wants an fd per sync object, so a low hard limit makes it fall over under load
+        bool esyncLimit = false;
+        QString release;
+    };
+
+    // METHODS
+    static const KernelSupport &GetKernel();
+    // one of the FileSyncModes besides AutoSync, i.e. what the runner's going to end up using for syncMode.
+    // reason gets a short explanation for the launch log.
+    static int Resolve(const int &syncMode, const NeroRunnerInfo &runner, QString *reason = nullptr);
+    static bool RunnerHasNtsync(const NeroRunnerInfo &);
+    static bool RunnerHasFsync(const NeroRunnerInfo &);
+    static QString GetName(const int &syncMode);
+
+private:
+    static KernelSupport Probe();
+};
+
+#endif // NEROSYNC_H
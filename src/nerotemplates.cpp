@@ -0,0 +1,283 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Golden Prefix Templates.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerotemplates.h"
+#include "nerofs.h"
+#include "nerowineserver.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/fs.h>
+
+// Nero's own per-prefix bits - a template shouldn't carry these, and a clone gets its own fresh ones.
+static const QStringList neroPrefixFiles = {
+    "nero-settings.ini",
+    ".launchprofiles.cache",
+    ".icoCache",
+    ".logs",
+    ".shaderCache",
+    ".warmserver"
+};
+
+QString NeroPrefixTemplates::GetTemplatesPath()
+{
+    // has to stay on the same filesystem as the prefixes, or reflinks can't work.
+    return NeroFS::GetPrefixesPath()->path() + "/.templates";
+}
+
+QStringList NeroPrefixTemplates::GetTemplates()
+{
+    QDir templatesDir(GetTemplatesPath());
+    QStringList templates = templatesDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name | QDir::IgnoreCase);
+
+    // half-saved ones (or ones someone just dropped in here) don't count.
+    for(int i = templates.count()-1; i >= 0; --i)
+        if(!templatesDir.exists(templates.at(i) + ".ini"))
+            templates.removeAt(i);
+
+    return templates;
+}
+
+NeroPrefixTemplates::Template NeroPrefixTemplates::GetTemplate(const QString &name)
+{
+    Template info;
+    if(!QFile::exists(GetTemplatesPath() + '/' + name + ".ini")) return info;
+
+    QSettings ini(GetTemplatesPath() + '/' + name + ".ini", QSettings::IniFormat);
+    info.name = name;
+    info.runner = ini.value("Template/Runner").toString();
+    info.verbs = ini.value("Template/Verbs").toStringList();
+    return info;
+}
+
+bool NeroPrefixTemplates::Remove(const QString &name)
+{
+    if(name.isEmpty()) return false;
+
+    QFile::remove(GetTemplatesPath() + '/' + name + ".ini");
+    return QDir(GetTemplatesPath() + '/' + name).removeRecursively();
+}
+
+bool NeroPrefixTemplates::CreateFrom(const QString &name, const QString &prefixPath)
+{
+    const QString templatePath = GetTemplatesPath() + '/' + name;
+    if(name.isEmpty() || !QDir(templatePath).exists()) {
+        printf("Template %s doesn't exist!\n", name.toLocal8Bit().constData());
+        return false;
+    }
+    if(QFileInfo::exists(prefixPath)) {
+        printf("Can't clone template into %s, it already exists!\n", prefixPath.toLocal8Bit().constData());
+        return false;
+    }
+
+    CloneStats stats;
+    const qint64 started = QDateTime::currentMSecsSinceEpoch();
+
+    if(!CloneTree(templatePath, prefixPath, templatePath, prefixPath, {}, stats)) {
+        printf("Couldn't clone template %s, cleaning up...\n", name.toLocal8Bit().constData());
+        QDir(prefixPath).removeRecursively();
+        return false;
+    }
+
+    printf("Cloned template %s in %lldms (%d reflinked, %d copied, %d symlinks)\n",
+           name.toLocal8Bit().constData(), QDateTime::currentMSecsSinceEpoch() - started,
+           stats.reflinked, stats.copied, stats.linked);
+    return true;
+}
+
+bool NeroPrefixTemplates::SaveAs(const QString &name, const QString &prefixPath, const QString &runner, const QStringList &verbs)
+{
+    if(name.isEmpty()) return false;
+
+    // wineserver only flushes the registry when it exits, and it lingers a bit after the last process does.
+    for(int i = 0; i < 100 && NeroWineserver::IsAlive(prefixPath); ++i)
+        QThread::msleep(100);
+    if(NeroWineserver::IsAlive(prefixPath))
+        printf("Wineserver for %s is still up, template registry might be a bit behind!\n", prefixPath.toLocal8Bit().constData());
+
+    QDir().mkpath(GetTemplatesPath());
+
+    // build it off to the side, so a failed save never clobbers a good template.
+    const QString templatePath = GetTemplatesPath() + '/' + name;
+    const QString stagingPath = templatePath + ".new";
+    QDir(stagingPath).removeRecursively();
+
+    CloneStats stats;
+    if(!CloneTree(prefixPath, stagingPath, prefixPath, stagingPath, neroPrefixFiles, stats)) {
+        printf("Couldn't save %s as template %s!\n", prefixPath.toLocal8Bit().constData(), name.toLocal8Bit().constData());
+        QDir(stagingPath).removeRecursively();
+        return false;
+    }
+
+    StripUserLinks(stagingPath);
+
+    QFile::remove(templatePath + ".ini");
+    QDir(templatePath).removeRecursively();
+    if(!QDir().rename(stagingPath, templatePath)) {
+        QDir(stagingPath).removeRecursively();
+        return false;
+    }
+
+    QSettings ini(templatePath + ".ini", QSettings::IniFormat);
+    ini.setValue("Template/Runner", runner);
+    ini.setValue("Template/Verbs", verbs);
+    ini.setValue("Template/Created", QDateTime::currentDateTime().toString(Qt::ISODate));
+    ini.sync();
+
+    printf("Saved template %s (%d reflinked, %d copied, %d symlinks)\n",
+           name.toLocal8Bit().constData(), stats.reflinked, stats.copied, stats.linked);
+    return ini.status() == QSettings::NoError;
+}
+
+bool NeroPrefixTemplates::CloneTree(const QString &source, const QString &target, const QString &sourceRoot, const QString &targetRoot,
+                                    const QStringList &skip, CloneStats &stats)
+{
+    if(!QDir().mkpath(target)) return false;
+    // prefixes are private to the user, and drive_c etc. expect to be writable regardless of what the source was
+    QFile::setPermissions(target, QFileInfo(source).permissions() | QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+    const QFileInfoList entries = QDir(source).entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+
+    for(const auto &entry : entries) {
+        if(skip.contains(entry.fileName())) continue;
+
+        const QString targetPath = target + '/' + entry.fileName();
+
+        if(entry.isSymLink()) {
+            // keep links as they were (dosdevices is all relative ones), other than absolute ones back into the source,
+            // which have to point into the new tree instead.
+            char buffer[PATH_MAX];
+            const ssize_t length = readlink(entry.filePath().toLocal8Bit().constData(), buffer, sizeof(buffer) - 1);
+            if(length < 0) return false;
+
+            QString linkTarget = QString::fromLocal8Bit(buffer, static_cast<int>(length));
+            if(linkTarget == sourceRoot || linkTarget.startsWith(sourceRoot + '/'))
+                linkTarget.replace(0, sourceRoot.length(), targetRoot);
+
+            if(symlink(linkTarget.toLocal8Bit().constData(), targetPath.toLocal8Bit().constData()) != 0) return false;
+            stats.linked++;
+        } else if(entry.isDir()) {
+            if(!CloneTree(entry.filePath(), targetPath, sourceRoot, targetRoot, {}, stats)) return false;
+        } else if(entry.isFile()) {
+            if(!CloneFile(entry.filePath(), targetPath, stats)) return false;
+        }
+        // sockets, fifos and the like have no business in a prefix, so those are just left behind.
+    }
+
+    return true;
+}
+
+bool NeroPrefixTemplates::CloneFile(const QString &source, const QString &target, CloneStats &stats)
+{
+    const int in = open(source.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+    if(in < 0) return false;
+
+    struct stat info;
+    if(fstat(in, &info) != 0) {
+        close(in);
+        return false;
+    }
+
+    const int out = open(target.toLocal8Bit().constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, (info.st_mode & 07777) | S_IWUSR);
+    if(out < 0) {
+        close(in);
+        return false;
+    }
+
+    bool ok = false;
+
+    // Same extents, no data copied, and the first write to either side gets its own copy.
+    // Hardlinks would be just as instant, but wine and Proton rewrite dlls/exes in place during upgrades and verb installs,
+    // so one prefix touching a shared file would silently change the template and every other prefix made from it.
+#ifdef FICLONE
+    if(ioctl(out, FICLONE, in) == 0) {
+        ok = true;
+        stats.reflinked++;
+    }
+#endif
+
+    if(!ok) {
+        // no reflinks here (ext4 and friends), so at least let the kernel do the copying.
+        off_t remaining = info.st_size;
+        ssize_t copied = 0;
+        while(remaining > 0 && (copied = copy_file_range(in, nullptr, out, nullptr, remaining, 0)) > 0)
+            remaining -= copied;
+
+        if(remaining > 0 && copied < 0) {
+            // old kernels, or something in between that doesn't support it - plain read/write it is.
+            if(lseek(in, 0, SEEK_SET) == 0 && ftruncate(out, 0) == 0 && lseek(out, 0, SEEK_SET) == 0) {
+                QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+                ssize_t readBytes;
+                remaining = info.st_size;
+                while(remaining > 0 && (readBytes = read(in, buffer.data(), buffer.size())) > 0) {
+                    if(write(out, buffer.constData(), readBytes) != readBytes) break;
+                    remaining -= readBytes;
+                }
+            }
+        }
+
+        ok = remaining <= 0;
+        if(ok) stats.copied++;
+    }
+
+    // Proton compares timestamps in its tracked files, so don't let every clone look freshly upgraded.
+    if(ok) {
+        const struct timespec times[2] = { info.st_atim, info.st_mtim };
+        futimens(out, times);
+    }
+
+    close(in);
+    if(close(out) != 0) ok = false;
+    return ok;
+}
+
+void NeroPrefixTemplates::StripUserLinks(const QString &prefixPath)
+{
+    // CreateUserLinks points these at the real home directories - those get redone per prefix when asked,
+    // and a template holding onto them would hand every clone access to home regardless of what the user picked.
+    const QStringList userDirs = { "Desktop", "Documents", "Downloads", "Music", "Pictures", "Videos" };
+    const QFileInfoList users = QDir(prefixPath + "/drive_c/users").entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    for(const auto &user : users) {
+        if(user.isSymLink()) continue;
+        for(const auto &dir : userDirs) {
+            const QFileInfo link(user.filePath() + '/' + dir);
+            if(link.isSymLink()) {
+                QFile::remove(link.filePath());
+                QDir(user.filePath()).mkdir(dir);
+            }
+        }
+    }
+}
+
+void NeroTemplateJob::run()
+{
+    if(mode == CreatePrefix)
+        result = NeroPrefixTemplates::CreateFrom(name, prefixPath);
+    else result = NeroPrefixTemplates::SaveAs(name, prefixPath, runner, verbs);
+}
@@ -0,0 +1,90 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Golden Prefix Templates.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROTEMPLATES_H
+#define NEROTEMPLATES_H
+
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+// A template is a finished prefix (runner + verbs + registry fixes) kept in <prefixes>/.templates/<name>,
+// with its details next to it in <name>.ini so that nothing Nero-specific ends up inside the clones.
+// New prefixes are cloned from one with FICLONE where the filesystem can share extents (btrfs, XFS, bcachefs),
+// and a plain kernel-side copy everywhere else - see CloneFile for why hardlinks aren't used.
+class NeroPrefixTemplates
+{
+public:
+    struct Template {
+        QString name;
+        QString runner;
+        QStringList verbs;
+    };
+
+    struct CloneStats {
+        int reflinked = 0;
+        int copied = 0;
+        int linked = 0;
+    };
+
+    // METHODS
+    static QString GetTemplatesPath();
+    static QStringList GetTemplates();
+    static Template GetTemplate(const QString &name);
+    static bool Remove(const QString &name);
+
+    // these walk the whole prefix, so keep them off the GUI thread (i.e. in a NeroTemplateJob).
+    static bool CreateFrom(const QString &name, const QString &prefixPath);
+    static bool SaveAs(const QString &name, const QString &prefixPath, const QString &runner, const QStringList &verbs);
+
+private:
+    static bool CloneTree(const QString &source, const QString &target, const QString &sourceRoot, const QString &targetRoot,
+                          const QStringList &skip, CloneStats &);
+    static bool CloneFile(const QString &source, const QString &target, CloneStats &);
+    static void StripUserLinks(const QString &prefixPath);
+};
+
+// Runs a template clone or save on its own thread; check GetResult() once finished fires.
+class NeroTemplateJob : public QThread
+{
+public:
+    enum Mode {
+        CreatePrefix,
+        SaveTemplate
+    };
+
+    NeroTemplateJob(const Mode &mode, const QString &name, const QString &prefixPath,
+                    const QString &runner = "", const QStringList &verbs = {})
+        : mode(mode), name(name), prefixPath(prefixPath), runner(runner), verbs(verbs) {}
+
+    bool GetResult() const { return result; }
+
+protected:
+    void run() override;
+
+private:
+    Mode mode;
+    QString name;
+    QString prefixPath;
+    QString runner;
+    QStringList verbs;
+    bool result = false;
+};
+
+#endif // NEROTEMPLATES_H
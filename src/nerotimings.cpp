@@ -0,0 +1,146 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Shortcut Launch Timings.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerotimings.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+
+// only the most recent runs matter for spotting regressions
+#define NERO_TIMINGS_MAX_RUNS 100
+
+NeroLaunchTimings::NeroLaunchTimings()
+{
+    std::fill(durations, durations + PhaseCount, -1);
+    clock.start();
+}
+
+void NeroLaunchTimings::Mark(const Phase &phase)
+{
+    if(Reached(phase)) return;
+
+    const qint64 now = clock.elapsed();
+    durations[phase] = now - lastMark;
+    lastMark = now;
+}
+
+qint64 NeroLaunchTimings::GetTotal() const
+{
+    if(!Reached(ExecutableStart)) return -1;
+
+    qint64 total = 0;
+    for(int i = 0; i < PhaseCount; ++i)
+        if(durations[i] >= 0) total += durations[i];
+    return total;
+}
+
+QString NeroLaunchTimings::PhaseName(const int &phase)
+{
+    switch(phase) {
+    case Settings:          return "Settings";
+    case Environment:       return "Environment";
+    case ProcessStart:      return "Process Start";
+    case RuntimeCheck:      return "Runtime Check";
+    case ProtonStart:       return "Proton Start";
+    case ExecutableStart:   return "Executable Start";
+    default:                return "Total";
+    }
+}
+
+bool NeroLaunchTimings::Save(const QString &historyPath) const
+{
+    // <epoch ms> <phase ms>... <tags>, tab-separated
+    QStringList fields = { QString::number(QDateTime::currentMSecsSinceEpoch()) };
+    for(int i = 0; i < PhaseCount; ++i)
+        fields.append(QString::number(durations[i]));
+    fields.append(tags.join(','));
+
+    QStringList runs;
+    QFile oldHistory(historyPath);
+    if(oldHistory.open(QIODevice::ReadOnly))
+        runs = QString::fromUtf8(oldHistory.readAll()).split('\n', Qt::SkipEmptyParts);
+    oldHistory.close();
+
+    runs.append(fields.join('\t'));
+    if(runs.count() > NERO_TIMINGS_MAX_RUNS)
+        runs = runs.mid(runs.count() - NERO_TIMINGS_MAX_RUNS);
+
+    QDir().mkpath(QFileInfo(historyPath).path());
+    QSaveFile history(historyPath);
+    if(!history.open(QIODevice::WriteOnly)) return false;
+    history.write(runs.join('\n').toUtf8() + '\n');
+    if(!history.commit()) {
+        printf("Couldn't write launch timings to %s\n", historyPath.toLocal8Bit().constData());
+        return false;
+    }
+    return true;
+}
+
+QList<NeroLaunchTimings::Stats> NeroLaunchTimings::GetStats(const QString &historyPath, const QStringList &tags)
+{
+    // last slot is the total
+    QList<QList<qint64>> samples;
+    for(int i = 0; i <= PhaseCount; ++i) samples.append({});
+
+    QFile history(historyPath);
+    if(history.open(QIODevice::ReadOnly)) {
+        const QStringList runs = QString::fromUtf8(history.readAll()).split('\n', Qt::SkipEmptyParts);
+        for(const auto &run : runs) {
+            const QStringList fields = run.split('\t');
+            if(fields.count() != PhaseCount + 2) continue;
+
+            const QStringList runTags = fields.last().split(',', Qt::SkipEmptyParts);
+            bool matches = true;
+            for(const auto &tag : tags)
+                if(!runTags.contains(tag)) { matches = false; break; }
+            if(!matches) continue;
+
+            qint64 total = 0;
+            for(int i = 0; i < PhaseCount; ++i) {
+                const qint64 duration = fields.at(i + 1).toLongLong();
+                if(duration < 0) continue;
+                samples[i].append(duration);
+                total += duration;
+            }
+            // runs that never got the game up aren't worth counting for the total
+            if(fields.at(ExecutableStart + 1).toLongLong() >= 0)
+                samples[PhaseCount].append(total);
+        }
+    }
+
+    QList<Stats> stats;
+    for(auto &phaseSamples : samples) {
+        Stats stat;
+        stat.samples = phaseSamples.count();
+        if(!phaseSamples.isEmpty()) {
+            stat.last = phaseSamples.last();
+            std::sort(phaseSamples.begin(), phaseSamples.end());
+            stat.median = phaseSamples.at(phaseSamples.count() / 2);
+            // nearest-rank
+            stat.p95 = phaseSamples.at(qMax(0, static_cast<int>((phaseSamples.count() * 95 + 99) / 100) - 1));
+        }
+        stats.append(stat);
+    }
+    return stats;
+}
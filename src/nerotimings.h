@@ -0,0 +1,80 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Shortcut Launch Timings.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROTIMINGS_H
+#define NEROTIMINGS_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// How long each step of getting a shortcut from "Play" to a running game took, on a monotonic clock.
+// Every phase is timed from the end of the one before it - if a phase never shows up in umu's output
+// (i.e. no runtime check when updates are off), its time just rolls into the next phase that does.
+// Runs are appended to <prefix>/.logs/<hash>.timings, one line per run.
+class NeroLaunchTimings
+{
+public:
+    enum Phase {
+        Settings = 0,       // resolving (or loading the cached) launch profile
+        Environment,        // building env & arguments from the profile
+        ProcessStart,       // waitForStarted
+        RuntimeCheck,       // umu checking/updating the Steam Runtime
+        ProtonStart,        // Proton's first words
+        ExecutableStart,    // Proton handing off to the game
+        PhaseCount
+    };
+
+    struct Stats {
+        qint64 last = -1;
+        qint64 median = -1;
+        qint64 p95 = -1;
+        int samples = 0;
+    };
+
+    NeroLaunchTimings();
+
+    // METHODS
+    // only the first mark of a phase counts.
+    void Mark(const Phase &);
+    // time since the last mark doesn't count towards anything (i.e. pre-run scripts)
+    void Skip() { lastMark = clock.elapsed(); }
+    bool Reached(const Phase &phase) const { return durations[phase] >= 0; }
+    qint64 GetDuration(const Phase &phase) const { return durations[phase]; }
+    // all phases together, or -1 if the game never got going.
+    qint64 GetTotal() const;
+    // things that are known to change launch times, saved alongside each run.
+    void AddTag(const QString &tag) { tags.append(tag); }
+    bool Save(const QString &historyPath) const;
+
+    static QString GetHistoryPath(const QString &prefixPath, const QString &hash)
+        { return QString("%1/.logs/%2.timings").arg(prefixPath, hash); }
+    static QString PhaseName(const int &);
+    // one entry per phase, plus the total at the end - only counting runs with all of tags, if any are given.
+    static QList<Stats> GetStats(const QString &historyPath, const QStringList &tags = {});
+
+private:
+    QElapsedTimer clock;
+    qint64 lastMark = 0;
+    qint64 durations[PhaseCount];
+    QStringList tags;
+};
+
+#endif // NEROTIMINGS_H
@@ -30,12 +30,23 @@
 #include "ui_nerotricks.h"
 #include "nerofs.h"
 
+#include <QApplication>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QMap>
 #include <QProcess>
 #include <QMessageBox>
 #include <QPushButton>
-#include <QThread>
+#include <QSaveFile>
 #include <QShortcut>
+#include <QStandardPaths>
+
+// bump the version whenever the parsing below changes, so stale catalogues get reparsed.
+#define NERO_VERBS_CACHE_MAGIC 0x4E565242
+#define NERO_VERBS_CACHE_VERSION 1
 
 NeroTricksWindow::NeroTricksWindow(QWidget *parent, const QString &runner)
     : QDialog(parent)
@@ -47,8 +58,7 @@ NeroTricksWindow::NeroTricksWindow(QWidget *parent, const QString &runner)
 	QShortcut *shortcutClose = new QShortcut(QKeySequence::Close, this);
 	connect(shortcutClose, &QShortcut::activated, this,&NeroTricksWindow::close);
 
-    if(winetricksAvailVerbs.isEmpty())
-        InitVerbs(runner);
+    InitVerbs(runner);
 
     for(int i = 0; i < winetricksAvailVerbs.count(); ++i) {
         verbSelector << new QCheckBox(winetricksAvailVerbs.at(i), this);
@@ -59,6 +69,7 @@ NeroTricksWindow::NeroTricksWindow(QWidget *parent, const QString &runner)
         ui->verbsList->addWidget(verbSelector.at(i), i, 0);
         ui->verbsList->addWidget(verbDesc.at(i), i, 1);
         verbIsSelected.insert(winetricksAvailVerbs.at(i), false);
+        verbSlots.insert(winetricksAvailVerbs.at(i), i);
         connect(verbSelector.at(i), &QCheckBox::stateChanged, this, &NeroTricksWindow::verbSelectors_stateChanged);
     }
 
@@ -80,88 +91,248 @@ NeroTricksWindow::~NeroTricksWindow()
 
 void NeroTricksWindow::InitVerbs(const QString &runner)
 {
-    if(winetricksAvailVerbs.isEmpty()) {
-        if(!NeroFS::GetWinetricks(runner).isEmpty()) {
-            QProcess winetricksList;
-            QMessageBox waitBox(QMessageBox::NoIcon, "Winetricks Loading", "Please wait...");
+    // only ever fill the window once, since the verb slots are tied to the widgets made from them.
+    if(!winetricksAvailVerbs.isEmpty()) return;
+
+    const QString winetricks = NeroFS::GetWinetricks(runner);
+    if(winetricks.isEmpty()) {
+        QMessageBox::critical(this,
+                              "No Winetricks!",
+                              "Winetricks doesn't seem to be installed!");
+        return;
+    }
 
-            winetricksList.start(NeroFS::GetWinetricks(runner), {"dlls", "list"});
-            waitBox.open();
-            waitBox.raise();
-            QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    const QString key = GetCatalogueKey(winetricks);
+    VerbCatalogue catalogue = catalogues.value(winetricks);
 
-            // don't use blocking function so that the dialog shows and the UI doesn't freeze.
-            while(winetricksList.state() != QProcess::NotRunning) {
-                QApplication::processEvents();
-                QThread::msleep(1);
-            }
+    if(catalogue.verbs.isEmpty())
+        LoadCatalogue(winetricks, catalogue);
 
-            if(winetricksList.exitCode() == 0) {
-                waitBox.setText("Organizing verbs...");
-
-                if(!winetricksAvailVerbs.isEmpty() && !winetricksDescriptions.isEmpty()) {
-                    winetricksAvailVerbs.clear();
-                    winetricksDescriptions.clear();
-                }
-
-                if(NeroFS::GetWinetricks(runner).contains("protontricks"))
-                    // read first line, which is boilerplate cd
-                    winetricksList.readLine();
-
-                // capture the rest of the verbs list output to organize.
-                QString winetricksOutput = winetricksList.readAllStandardOutput();
-                winetricksAvailVerbs << winetricksOutput.split("\n", Qt::SkipEmptyParts);
-
-                for(int i = 0; i < winetricksAvailVerbs.count(); ++i) {
-                    // The winetricks listing uses a several-spaces-long padding to separate name from description,
-                    // so use that as the split point to clean up both lists.
-                    winetricksDescriptions.append(winetricksAvailVerbs[i].mid(winetricksAvailVerbs[i].indexOf("       ")).trimmed());
-                    winetricksAvailVerbs[i] = winetricksAvailVerbs[i].left(winetricksAvailVerbs[i].indexOf("       "));
-
-                    // cleanup "downloadable/cached" bits.
-                    winetricksDescriptions[i].remove("[downloadable]");
-                    winetricksDescriptions[i].remove("[downloadable,cached]");
-
-                    // SLIGHTLY DIRTY HACK: add spaces in vcrun to clean up descriptions and allow proper wordwrap
-                    if(winetricksAvailVerbs.at(i).contains("vcrun")) {
-                        winetricksDescriptions[i].replace(',', ", ");
-                        // VisualC versions >=2012 need this to avoid extraneous spaces after commas (i.e. after "Microsoft").
-                        winetricksDescriptions[i].replace(",  ", ", ");
-                    }
-                }
-
-                // allfonts isn't in the DLLs list, so weh.
-                winetricksAvailVerbs.prepend("allfonts"), winetricksDescriptions.prepend("All fonts (various, 1998-2010) [Has a long install!]");
-
-                // filter out these entries, since they're either not needed, are built into, or wouldn't work with Proton
-                FilterTricks({"dxvk", "faudio", "galliumnine", "vkd3d"});
+    if(!catalogue.verbs.isEmpty()) {
+        // winetricks got updated since this was parsed - the old list is still good enough to show right now,
+        // and the next window to open will pick up the new one.
+        if(catalogue.key != key)
+            RefreshCatalogue(winetricks);
+    } else {
+        // nothing to go off of at all, so this one time we do have to wait on winetricks.
+        QProcess winetricksList;
+        QMessageBox waitBox(QMessageBox::NoIcon, "Winetricks Loading", "Please wait...");
+        QEventLoop waitLoop;
+
+        connect(&winetricksList, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), &waitLoop, &QEventLoop::quit);
+        connect(&winetricksList, &QProcess::errorOccurred, &waitLoop, &QEventLoop::quit);
+
+        winetricksList.start(winetricks, {"dlls", "list"});
+        waitBox.open();
+        waitBox.raise();
+        QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+
+        // spin an event loop rather than blocking, so that the dialog shows and the UI doesn't freeze.
+        if(winetricksList.waitForStarted() && winetricksList.state() != QProcess::NotRunning)
+            waitLoop.exec();
+
+        if(winetricksList.exitStatus() == QProcess::NormalExit && winetricksList.exitCode() == 0) {
+            waitBox.setText("Organizing verbs...");
+            if(ParseCatalogue(winetricksList.readAllStandardOutput(), winetricks.contains("protontricks"), catalogue)) {
+                catalogue.key = key;
+                SaveCatalogue(winetricks, catalogue);
             }
-            QGuiApplication::restoreOverrideCursor();
-        } else {
-            QMessageBox::critical(this,
-                                  "No Winetricks!",
-                                  "Winetricks doesn't seem to be installed!");
         }
+        QGuiApplication::restoreOverrideCursor();
+    }
+
+    catalogues.insert(winetricks, catalogue);
+    winetricksAvailVerbs = catalogue.verbs;
+    winetricksDescriptions = catalogue.descriptions;
+}
+
+QString NeroTricksWindow::GetCatalogueKey(const QString &winetricks)
+{
+    return NeroFS::GetFileKey(winetricks);
+}
+
+QString NeroTricksWindow::GetCataloguePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/nero-umu/winetricks-verbs.cache";
+}
+
+bool NeroTricksWindow::LoadCatalogue(const QString &winetricks, VerbCatalogue &catalogue)
+{
+    QFile cacheFile(GetCataloguePath());
+    if(!cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&cacheFile);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if(magic != NERO_VERBS_CACHE_MAGIC || version != NERO_VERBS_CACHE_VERSION) return false;
+
+    // keyed by winetricks path, since system winetricks and each runner's protonfixes copy can differ
+    QMap<QString, QStringList> keys, verbs, descriptions;
+    in >> keys >> verbs >> descriptions;
+    if(in.status() != QDataStream::Ok) {
+        printf("Winetricks verbs cache is corrupted, ignoring...\n");
+        return false;
+    }
+
+    if(!keys.contains(winetricks)) return false;
+
+    catalogue.key = keys.value(winetricks).value(0);
+    catalogue.verbs = verbs.value(winetricks);
+    catalogue.descriptions = descriptions.value(winetricks);
+    if(catalogue.verbs.count() != catalogue.descriptions.count()) {
+        catalogue = VerbCatalogue();
+        return false;
+    } else return !catalogue.verbs.isEmpty();
+}
+
+void NeroTricksWindow::SaveCatalogue(const QString &winetricks, const VerbCatalogue &catalogue)
+{
+    QMap<QString, QStringList> keys, verbs, descriptions;
+
+    // keep whatever other winetricks copies were already cached
+    QFile oldFile(GetCataloguePath());
+    if(oldFile.open(QIODevice::ReadOnly)) {
+        QDataStream in(&oldFile);
+        in.setVersion(QDataStream::Qt_5_15);
+
+        quint32 magic = 0, version = 0;
+        in >> magic >> version;
+        if(magic == NERO_VERBS_CACHE_MAGIC && version == NERO_VERBS_CACHE_VERSION) {
+            in >> keys >> verbs >> descriptions;
+            if(in.status() != QDataStream::Ok)
+                keys.clear(), verbs.clear(), descriptions.clear();
+        }
+        oldFile.close();
+    }
+
+    keys[winetricks] = QStringList{catalogue.key};
+    verbs[winetricks] = catalogue.verbs;
+    descriptions[winetricks] = catalogue.descriptions;
+
+    QDir().mkpath(QFileInfo(GetCataloguePath()).path());
+
+    QSaveFile cacheFile(GetCataloguePath());
+    if(cacheFile.open(QIODevice::WriteOnly)) {
+        QDataStream out(&cacheFile);
+        out.setVersion(QDataStream::Qt_5_15);
+        out << (quint32)NERO_VERBS_CACHE_MAGIC << (quint32)NERO_VERBS_CACHE_VERSION
+            << keys << verbs << descriptions;
+        if(!cacheFile.commit())
+            printf("Couldn't write winetricks verbs cache!\n");
+    }
+}
+
+bool NeroTricksWindow::ParseCatalogue(const QByteArray &output, const bool &protontricks, VerbCatalogue &catalogue)
+{
+    QStringList lines = QString(output).split("\n", Qt::SkipEmptyParts);
+
+    // first line is boilerplate cd
+    if(protontricks && !lines.isEmpty())
+        lines.removeFirst();
+
+    catalogue.verbs.clear();
+    catalogue.descriptions.clear();
+    catalogue.verbs.reserve(lines.count() + 1);
+    catalogue.descriptions.reserve(lines.count() + 1);
+
+    // allfonts isn't in the DLLs list, so weh.
+    catalogue.verbs.append("allfonts"), catalogue.descriptions.append("All fonts (various, 1998-2010) [Has a long install!]");
+
+    for(const auto &line : std::as_const(lines)) {
+        // The winetricks listing uses a several-spaces-long padding to separate name from description,
+        // so use that as the split point to clean up both lists.
+        const int split = line.indexOf("       ");
+        const QString verb = line.left(split);
+        QString description = line.mid(split).trimmed();
+
+        // cleanup "downloadable/cached" bits.
+        description.remove("[downloadable]");
+        description.remove("[downloadable,cached]");
+
+        // SLIGHTLY DIRTY HACK: add spaces in vcrun to clean up descriptions and allow proper wordwrap
+        if(verb.contains("vcrun")) {
+            description.replace(',', ", ");
+            // VisualC versions >=2012 need this to avoid extraneous spaces after commas (i.e. after "Microsoft").
+            description.replace(",  ", ", ");
+        }
+
+        catalogue.verbs.append(verb);
+        catalogue.descriptions.append(description);
     }
+
+    // filter out these entries, since they're either not needed, are built into, or wouldn't work with Proton
+    FilterTricks(catalogue, {"dxvk", "faudio", "galliumnine", "vkd3d"});
+
+    // just allfonts means winetricks didn't actually give us anything
+    return catalogue.verbs.count() > 1;
 }
 
-void NeroTricksWindow::FilterTricks(const QStringList filters)
+void NeroTricksWindow::RefreshCatalogue(const QString &winetricks)
 {
-    for(int i = 0; i < filters.length(); ++i) {
-        QStringList filterEntries = winetricksAvailVerbs.filter(filters.at(i));
-        int slot;
-        for(int e = 0; e < filterEntries.length(); ++e) {
-            slot = winetricksAvailVerbs.indexOf(filterEntries.at(e));
-            winetricksAvailVerbs.removeAt(slot);
-            winetricksDescriptions.removeAt(slot);
+    if(refreshesRunning.contains(winetricks)) return;
+    refreshesRunning.insert(winetricks);
+
+    // parented to the app rather than a window, so closing the dialog doesn't kill the refresh.
+    QProcess *winetricksList = new QProcess(qApp);
+
+    connect(winetricksList, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), qApp,
+            [winetricksList, winetricks](int exitCode, QProcess::ExitStatus status) {
+        VerbCatalogue catalogue;
+        if(status == QProcess::NormalExit && exitCode == 0 &&
+           ParseCatalogue(winetricksList->readAllStandardOutput(), winetricks.contains("protontricks"), catalogue)) {
+            catalogue.key = GetCatalogueKey(winetricks);
+            catalogues.insert(winetricks, catalogue);
+            SaveCatalogue(winetricks, catalogue);
+            printf("Refreshed winetricks verbs list from %s\n", winetricks.toLocal8Bit().constData());
+        } else printf("Couldn't refresh winetricks verbs list, keeping the old one.\n");
+
+        refreshesRunning.remove(winetricks);
+        winetricksList->deleteLater();
+    });
+
+    // finished never fires if winetricks couldn't even start
+    connect(winetricksList, &QProcess::errorOccurred, qApp, [winetricksList, winetricks](QProcess::ProcessError error) {
+        if(error == QProcess::FailedToStart) {
+            printf("Couldn't start winetricks to refresh verbs list!\n");
+            refreshesRunning.remove(winetricks);
+            winetricksList->deleteLater();
+        }
+    });
+
+    winetricksList->start(winetricks, {"dlls", "list"});
+}
+
+void NeroTricksWindow::FilterTricks(VerbCatalogue &catalogue, const QSet<QString> &filters)
+{
+    QStringList verbs, descriptions;
+    verbs.reserve(catalogue.verbs.count());
+    descriptions.reserve(catalogue.descriptions.count());
+
+    for(int i = 0; i < catalogue.verbs.count(); ++i) {
+        // match on the verb's base name, i.e. dxvk1103 -> dxvk, dxvk_nvapi0061 -> dxvk
+        QString base = catalogue.verbs.at(i);
+        while(!base.isEmpty() && base.back().isDigit())
+            base.chop(1);
+        base = base.section('_', 0, 0);
+
+        if(!filters.contains(base)) {
+            verbs.append(catalogue.verbs.at(i));
+            descriptions.append(catalogue.descriptions.at(i));
         }
     }
+
+    catalogue.verbs = verbs;
+    catalogue.descriptions = descriptions;
 }
 
 void NeroTricksWindow::AddTricks(const QStringList newTricks)
 {
-    for(int i = 0; i < newTricks.length(); ++i)
-        verbSelector.at(winetricksAvailVerbs.indexOf(newTricks.at(i)))->setCheckState(Qt::Checked);
+    for(const auto &trick : newTricks) {
+        const int slot = verbSlots.value(trick, -1);
+        if(slot >= 0) verbSelector.at(slot)->setCheckState(Qt::Checked);
+    }
 }
 
 void NeroTricksWindow::SetPreinstalledVerbs(const QStringList &installed)
@@ -169,7 +340,7 @@ void NeroTricksWindow::SetPreinstalledVerbs(const QStringList &installed)
     int slot;
     for(const auto &verb : installed) {
         // in case verb isn't in the list
-        slot = winetricksAvailVerbs.indexOf(verb);
+        slot = verbSlots.value(verb, -1);
         if(slot >= 0) {
             const QSignalBlocker blocker(verbSelector.at(slot));
             verbSelector.at(slot)->setCheckState(Qt::Checked);
@@ -186,7 +357,7 @@ void NeroTricksWindow::SetCheckedVerbs(const QStringList &checked)
     int slot;
     for(const auto &verb : checked) {
         // in case verb isn't in the list
-        slot = winetricksAvailVerbs.indexOf(verb);
+        slot = verbSlots.value(verb, -1);
         if(slot >= 0) verbSelector.at(slot)->setCheckState(Qt::Checked);
     }
 }
@@ -206,34 +377,18 @@ void NeroTricksWindow::verbSelectors_stateChanged(int arg1)
 
 void NeroTricksWindow::on_searchBox_textEdited(const QString &arg1)
 {
-    if(arg1.isEmpty()) {
-        winetricksFilter.empty();
-        for(int i = 0; i < winetricksAvailVerbs.length(); ++i) {
-            verbSelector.at(i)->setVisible(true), verbDesc.at(i)->setVisible(true);
-        }
-    } else {
-        winetricksFilter = winetricksAvailVerbs.filter(arg1, Qt::CaseInsensitive);
-
-        // is there a better way than hiding all elements and then unhiding what matches the filter?
-        for(int i = 0; i < winetricksAvailVerbs.count(); ++i) {
-            verbSelector.at(i)->setVisible(false), verbDesc.at(i)->setVisible(false);
-        }
-
-        int slot;
-        for(const auto &filter : std::as_const(winetricksFilter)) {
-            slot = winetricksAvailVerbs.indexOf(filter);
-            if(slot > -1)
-                verbSelector.at(slot)->setVisible(true), verbDesc.at(slot)->setVisible(true);
-        }
+    // one pass - anything matching (or everything, if the box was cleared) gets shown.
+    for(int i = 0; i < winetricksAvailVerbs.count(); ++i) {
+        const bool visible = arg1.isEmpty() || winetricksAvailVerbs.at(i).contains(arg1, Qt::CaseInsensitive);
+        verbSelector.at(i)->setVisible(visible), verbDesc.at(i)->setVisible(visible);
     }
 }
 
 void NeroTricksWindow::on_buttonBox_rejected()
 {
-    QStringList verbsToClean = verbIsSelected.keys(true);
-    if(!verbsToClean.isEmpty()) {
-        for(int i = 0; i < verbsToClean.length(); ++i)
-            verbSelector[winetricksAvailVerbs.indexOf(verbsToClean.at(i))]->setCheckState(Qt::Unchecked);
+    const QStringList verbsToClean = verbIsSelected.keys(true);
+    for(const auto &verb : verbsToClean) {
+        const int slot = verbSlots.value(verb, -1);
+        if(slot >= 0) verbSelector.at(slot)->setCheckState(Qt::Unchecked);
     }
 }
-
@@ -25,6 +25,7 @@
 #include <QCompleter>
 #include <QLabel>
 #include <QHash>
+#include <QSet>
 
 namespace Ui {
 class NeroTricksWindow;
@@ -61,12 +62,29 @@ private slots:
 private:
     Ui::NeroTricksWindow *ui;
 
-    void FilterTricks(const QStringList filters);
-
-    static inline QStringList winetricksAvailVerbs;
-    static inline QStringList winetricksDescriptions;
-
-    QStringList winetricksFilter;
+    struct VerbCatalogue {
+        // resolved winetricks path + mtime + size, since winetricks has no cheap version query
+        QString key;
+        QStringList verbs;
+        QStringList descriptions;
+    };
+
+    static QString GetCatalogueKey(const QString &winetricks);
+    static QString GetCataloguePath();
+    static bool LoadCatalogue(const QString &winetricks, VerbCatalogue &);
+    static void SaveCatalogue(const QString &winetricks, const VerbCatalogue &);
+    static bool ParseCatalogue(const QByteArray &output, const bool &protontricks, VerbCatalogue &);
+    static void RefreshCatalogue(const QString &winetricks);
+    static void FilterTricks(VerbCatalogue &, const QSet<QString> &filters);
+
+    // last parsed/loaded catalogue per winetricks path - windows take their own copy on creation,
+    // so a background refresh landing never shifts the slots out from under an open window.
+    static inline QHash<QString, VerbCatalogue> catalogues;
+    static inline QSet<QString> refreshesRunning;
+
+    QStringList winetricksAvailVerbs;
+    QStringList winetricksDescriptions;
+    QHash<QString, int> verbSlots;
 
     QList<QCheckBox*> verbSelector;
     QList<QLabel*> verbDesc;
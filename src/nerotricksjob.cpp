@@ -0,0 +1,115 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Background Winetricks Jobs.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerotricksjob.h"
+#include "nerodedup.h"
+#include "nerofs.h"
+#include "nerowineserver.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+
+NeroTricksJob::NeroTricksJob(const QString &prefixPath, const QString &runnerPath, const QStringList &verbs, const bool &cleanDotnet)
+    : prefixPath(prefixPath)
+{
+    umuPath = NeroFS::GetUmU();
+
+    env = QProcessEnvironment::systemEnvironment();
+    env.insert("WINEPREFIX", prefixPath);
+    // Only explicit set GAMEID when not already declared by user for (their) testing purposes
+    // See SeongGino/Nero-umu#66 for more info
+    if(!env.contains("GAMEID")) env.insert("GAMEID", "0");
+    env.insert("PROTONPATH", runnerPath);
+    // for Proton 10+. this shit gets real annoying
+    env.insert("PROTON_USE_XALIA", "0");
+    // winetricks verifies everything it downloads against its own checksums, so one cache for every prefix is fine.
+    if(!env.contains("W_CACHE")) {
+        QDir().mkpath(GetCachePath());
+        env.insert("W_CACHE", GetCachePath());
+    }
+
+    if(verbs.isEmpty()) {
+        // UMU is supposed to have "createprefix" action, but it doesn't actually do anything
+        // (on newer versions, it just runs explorer.exe pointed at nothing)
+        // we just need an easy scapegoat process that exits on its own without spawning a console window
+        steps.append({ QString("Creating prefix %1 using %2...").arg(QFileInfo(prefixPath).fileName(), QFileInfo(runnerPath).fileName()),
+                       { "reg", "/?" }, "", true });
+        return;
+    }
+
+    // NOTE: until https://github.com/Winetricks/winetricks/issues/2367 is resolved,
+    // delete two offending reg entries so that dotnet verbs don't erroneously exit.
+    if(cleanDotnet && !verbs.filter("dotnet").isEmpty()) {
+        printf(".NET verb detected, cleaning up registry keys before winetricks install...\n");
+        steps.append({ "Preparing prefix for .NET...", { "reg", "delete", "HKLM\\Software\\Wow6432Node\\Microsoft\\.NETFramework", "/f" }, "", false });
+        steps.append({ "Preparing prefix for .NET...", { "reg", "delete", "HKLM\\Software\\Wow6432Node\\Microsoft\\NET Framework Setup", "/f" }, "", false });
+    }
+
+    for(const auto &verb : verbs)
+        steps.append({ QString("Installing Winetricks verb %1...").arg(verb), { "winetricks", verb }, verb, true });
+}
+
+QString NeroTricksJob::GetCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/winetricks";
+}
+
+void NeroTricksJob::run()
+{
+    // verbs write straight into system32 and friends, which can't be shared with other prefixes while that happens.
+    NeroDedup::Unshare(prefixPath);
+
+    for(int i = 0; i < steps.count(); ++i) {
+        const Step &step = steps.at(i);
+        emit StepStarted(i, steps.count(), step.label);
+
+        QProcess umu;
+        umu.setProcessEnvironment(env);
+        umu.setProcessChannelMode(QProcess::MergedChannels);
+        umu.start(umuPath, step.args);
+
+        // blocking is fine here, we're not the GUI
+        while(umu.state() != QProcess::NotRunning) {
+            umu.waitForReadyRead(-1);
+            printf("%s", umu.readAll().constData());
+        }
+        printf("%s", umu.readAll().constData());
+
+        const bool failed = umu.exitStatus() != QProcess::NormalExit || umu.exitCode() != 0;
+        if(failed && step.required) {
+            exitCode = umu.exitStatus() == QProcess::NormalExit ? umu.exitCode() : -1;
+            if(!step.verb.isEmpty()) failedVerbs.append(step.verb);
+            printf("%s failed with exit code %d\n", step.args.join(' ').toLocal8Bit().constData(), exitCode);
+            // nothing else can go in if the prefix didn't even get made
+            if(step.verb.isEmpty()) break;
+        }
+
+        // the first step already had umu check the runtime, no need to do it again for every verb
+        if(!QProcessEnvironment::systemEnvironment().contains("UMU_RUNTIME_UPDATE"))
+            env.insert("UMU_RUNTIME_UPDATE", "0");
+    }
+
+    // whatever comes next (registry fixes, templates) wants the registry flushed to disk,
+    // which the prefix's wineserver only does once it's gone - it usually lingers for a few seconds.
+    const QString prefixPath = env.value("WINEPREFIX");
+    for(int i = 0; i < 100 && NeroWineserver::IsAlive(prefixPath); ++i)
+        QThread::msleep(100);
+}
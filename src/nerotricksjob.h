@@ -0,0 +1,68 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Background Winetricks Jobs.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROTRICKSJOB_H
+#define NEROTRICKSJOB_H
+
+#include <QList>
+#include <QProcessEnvironment>
+#include <QStringList>
+#include <QThread>
+
+// Creates a prefix and/or installs winetricks verbs into it on its own thread, one umu invocation per verb,
+// so the GUI stays responsive and can say exactly which verb is going (or which ones failed).
+// Verbs are installed in the order given - winetricks already pulls in each verb's own prerequisites.
+// Every job shares one W_CACHE, so installers that were downloaded for one prefix are reused for the next.
+class NeroTricksJob : public QThread
+{
+    Q_OBJECT
+
+public:
+    // everything's captured up front, since the job can't be asking NeroFS for things from its own thread.
+    NeroTricksJob(const QString &prefixPath, const QString &runnerPath, const QStringList &verbs, const bool &cleanDotnet);
+
+    // METHODS
+    int GetExitCode() const { return exitCode; }
+    QStringList GetFailedVerbs() const { return failedVerbs; }
+    static QString GetCachePath();
+
+signals:
+    void StepStarted(const int &index, const int &count, const QString &label);
+
+protected:
+    void run() override;
+
+private:
+    struct Step {
+        QString label;
+        QStringList args;
+        QString verb;
+        // failed cleanup steps shouldn't stop the verbs from installing
+        bool required = true;
+    };
+
+    QList<Step> steps;
+    QString prefixPath;
+    QString umuPath;
+    QProcessEnvironment env;
+    int exitCode = 0;
+    QStringList failedVerbs;
+};
+
+#endif // NEROTRICKSJOB_H
@@ -0,0 +1,201 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Persistent Prefix Wineserver.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nerowineserver.h"
+#include "nerorunner.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QThread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+QString NeroWineserver::GetWinePrefix(const QString &prefixPath)
+{
+    // Proton's actual WINEPREFIX is <compatdata>/pfx, which umu points back at the prefix itself
+    if(QFileInfo::exists(prefixPath + "/pfx")) return prefixPath + "/pfx";
+    else return prefixPath;
+}
+
+QString NeroWineserver::GetServerDir(const QString &prefixPath)
+{
+    // same naming Wine uses: /tmp/.wine-<uid>/server-<dev>-<inode> of the prefix dir
+    struct stat prefixStat;
+    if(stat(QFile::encodeName(GetWinePrefix(prefixPath)).constData(), &prefixStat) != 0) return "";
+
+    return QString("/tmp/.wine-%1/server-%2-%3").arg(getuid())
+                                                .arg(static_cast<qulonglong>(prefixStat.st_dev), 0, 16)
+                                                .arg(static_cast<qulonglong>(prefixStat.st_ino), 0, 16);
+}
+
+QString NeroWineserver::GetWineserver(const QString &runnerPath)
+{
+    // newer Protons use files/, older ones use dist/
+    for(const auto &dir : { "/files/bin/wineserver", "/dist/bin/wineserver" })
+        if(QFileInfo(runnerPath + dir).isExecutable()) return runnerPath + dir;
+    return "";
+}
+
+bool NeroWineserver::IsAlive(const QString &prefixPath)
+{
+    const QString serverDir = GetServerDir(prefixPath);
+    if(serverDir.isEmpty()) return false;
+
+    // a live wineserver always holds a write lock on this - just ask about it, don't take it.
+    const int fd = open(QFile::encodeName(serverDir + "/lock").constData(), O_RDWR);
+    if(fd < 0) return false;
+
+    struct flock lock = {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = 0;
+    lock.l_len = 0;
+    const bool alive = fcntl(fd, F_GETLK, &lock) == 0 && lock.l_type != F_UNLCK;
+
+    close(fd);
+    return alive;
+}
+
+bool NeroWineserver::IsPersistent(const QString &prefixPath)
+{
+    return QFile::exists(GetMarkerPath(prefixPath));
+}
+
+QProcessEnvironment NeroWineserver::GetSyncEnv(const QProcessEnvironment &launchEnv)
+{
+    // same translation the proton script does from its PROTON_* switches to what wine actually reads,
+    // since a server only takes clients that were started with the same sync mode it was.
+    QProcessEnvironment syncEnv;
+    syncEnv.insert("WINEESYNC", launchEnv.contains(CliArgs::Proton::Sync::noEsync) ? "0" : "1");
+    syncEnv.insert("WINEFSYNC", launchEnv.contains(CliArgs::Proton::Sync::noFsync) ? "0" : "1");
+    if(launchEnv.contains(CliArgs::Proton::Sync::noNtSync)) syncEnv.insert("WINENTSYNC", "0");
+    else if(launchEnv.contains(CliArgs::Proton::Sync::ntSync)) syncEnv.insert("WINENTSYNC", "1");
+    return syncEnv;
+}
+
+QString NeroWineserver::GetSyncKey(const QProcessEnvironment &syncEnv)
+{
+    QStringList key;
+    for(const auto &var : { "WINEESYNC", "WINEFSYNC", "WINENTSYNC" })
+        key << QString("%1=%2").arg(var, syncEnv.value(var, "default"));
+    return key.join(' ');
+}
+
+bool NeroWineserver::ReadMarker(const QString &prefixPath, QString &runnerPath, QString &syncKey)
+{
+    QFile marker(GetMarkerPath(prefixPath));
+    if(!marker.open(QIODevice::ReadOnly)) return false;
+
+    // runner path on the first line, sync mode on the second (markers from before that just don't have one)
+    const QStringList lines = QString::fromUtf8(marker.readAll()).split('\n');
+    runnerPath = lines.at(0);
+    syncKey = lines.value(1);
+    return true;
+}
+
+bool NeroWineserver::StartPersistent(const QString &prefixPath, const QString &runnerPath, const QProcessEnvironment &syncEnv)
+{
+    // first-time prefixes need Proton to set them up properly first
+    if(!QFile::exists(GetWinePrefix(prefixPath) + "/system.reg")) return false;
+
+    const QString wineserver = GetWineserver(runnerPath);
+    if(wineserver.isEmpty()) {
+        printf("Couldn't find wineserver for %s, not keeping prefix warm.\n", runnerPath.toLocal8Bit().constData());
+        return false;
+    }
+
+    QProcess server;
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("WINEPREFIX", GetWinePrefix(prefixPath));
+    // whatever the launch would've had from the user's own env gets overridden here too, same as Proton does
+    const QStringList syncVars = syncEnv.keys();
+    for(const auto &var : syncVars)
+        env.insert(var, syncEnv.value(var));
+    server.setProcessEnvironment(env);
+    server.setProgram(wineserver);
+    server.setArguments({ "-p" });
+    if(!server.startDetached()) return false;
+
+    // remember which runner and sync mode this belongs to, since clients that differ in either can't talk to it.
+    QFile marker(GetMarkerPath(prefixPath));
+    if(marker.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        marker.write(QString(runnerPath + '\n' + GetSyncKey(syncEnv)).toUtf8());
+
+    // it's usually up in a few ms, but don't hold up the launch forever if it isn't
+    QElapsedTimer timer;
+    timer.start();
+    while(!IsAlive(prefixPath) && timer.elapsed() < 2000)
+        QThread::msleep(20);
+
+    printf("Started persistent wineserver for %s\n", prefixPath.toLocal8Bit().constData());
+    return IsAlive(prefixPath);
+}
+
+void NeroWineserver::Shutdown(const QString &prefixPath)
+{
+    QString runnerPath, syncKey;
+    if(!ReadMarker(prefixPath, runnerPath, syncKey)) return;
+    QFile::remove(GetMarkerPath(prefixPath));
+
+    if(Kill(prefixPath, runnerPath))
+        printf("Stopped persistent wineserver for %s\n", prefixPath.toLocal8Bit().constData());
+}
+
+bool NeroWineserver::Kill(const QString &prefixPath, const QString &runnerPath, const int &signal)
+{
+    if(!IsAlive(prefixPath)) return false;
+
+    const QString wineserver = GetWineserver(runnerPath);
+    if(wineserver.isEmpty()) return false;
+
+    QProcess killer;
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("WINEPREFIX", GetWinePrefix(prefixPath));
+    killer.setProcessEnvironment(env);
+    killer.start(wineserver, { signal > 0 ? "-k" + QString::number(signal) : "-k" });
+    // this only sends the signals, so it's never long
+    return killer.waitForFinished(1000) && killer.exitCode() == 0;
+}
+
+bool NeroWineserver::Prepare(const QString &prefixPath, const QString &runnerPath, const QProcessEnvironment &syncEnv,
+                             const bool &warm, const bool &prefixAlreadyRunning)
+{
+    if(!warm) {
+        // left over from when this prefix was warm - a persistent server would keep waitforexitandrun waiting forever.
+        if(!prefixAlreadyRunning && IsPersistent(prefixPath)) Shutdown(prefixPath);
+        return prefixAlreadyRunning;
+    }
+
+    if(IsAlive(prefixPath)) {
+        QString serverRunner, serverSync;
+        if(!ReadMarker(prefixPath, serverRunner, serverSync)) return true;
+
+        // server from a different runner or sync mode can't be attached to, so it has to be replaced.
+        if(serverRunner == runnerPath && serverSync == GetSyncKey(syncEnv)) return true;
+        if(prefixAlreadyRunning) return true;
+        Shutdown(prefixPath);
+    }
+
+    return StartPersistent(prefixPath, runnerPath, syncEnv);
+}
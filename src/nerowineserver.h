@@ -0,0 +1,57 @@
+/*  Nero Launcher: A very basic Bottles-like manager using UMU.
+    Persistent Prefix Wineserver.
+
+    Copyright (C) 2024 That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NEROWINESERVER_H
+#define NEROWINESERVER_H
+
+#include <QProcessEnvironment>
+#include <QString>
+
+// "Warm prefix" support: keeps a persistent (-p) wineserver resident for a prefix,
+// so launches after the first can attach with Proton's "run" verb and skip a good chunk of startup.
+// Liveness is checked against the server's own lock file rather than anything Nero keeps track of,
+// so a wineserver started by anything else (another Nero, Steam, a terminal) counts too.
+class NeroWineserver
+{
+public:
+    // METHODS
+    static bool IsAlive(const QString &prefixPath);
+    // sorts out the prefix's server before a launch; returns whether the launch should attach to a running one.
+    // syncEnv is GetSyncEnv() of the launch's final environment, so the server gets started in the same sync mode as its clients.
+    static bool Prepare(const QString &prefixPath, const QString &runnerPath, const QProcessEnvironment &syncEnv,
+                        const bool &warm, const bool &prefixAlreadyRunning);
+    static bool StartPersistent(const QString &prefixPath, const QString &runnerPath, const QProcessEnvironment &syncEnv);
+    // the WINE*SYNC vars Proton will set for a launch with this environment.
+    static QProcessEnvironment GetSyncEnv(const QProcessEnvironment &launchEnv);
+    // only touches servers that Nero made persistent; anything else goes away on its own once its apps are done.
+    static void Shutdown(const QString &prefixPath);
+    static bool IsPersistent(const QString &prefixPath);
+    // straight to the prefix's wineserver, no umu or runtime container in between. 0 is wineserver's own SIGINT-then-SIGKILL.
+    static bool Kill(const QString &prefixPath, const QString &runnerPath, const int &signal = 0);
+
+private:
+    static QString GetWinePrefix(const QString &prefixPath);
+    static QString GetServerDir(const QString &prefixPath);
+    static QString GetWineserver(const QString &runnerPath);
+    static QString GetMarkerPath(const QString &prefixPath) { return prefixPath + "/.warmserver"; }
+    static QString GetSyncKey(const QProcessEnvironment &syncEnv);
+    static bool ReadMarker(const QString &prefixPath, QString &runnerPath, QString &syncKey);
+};
+
+#endif // NEROWINESERVER_H
@@ -20,9 +20,12 @@
 #include "nerowizard.h"
 #include "ui_nerowizard.h"
 #include "nerofs.h"
+#include "nerorunnerindex.h"
+#include "nerotemplates.h"
 
 #include <QMessageBox>
 #include <QPushButton>
+#include <QSignalBlocker>
 #include <QAction>
 #include <QShortcut>
 
@@ -42,6 +45,26 @@ NeroPrefixWizard::NeroPrefixWizard(QWidget *parent)
     currentPrefixes = NeroFS::GetPrefixes();
     ui->protonRunnerBox->addItems(*NeroFS::GetAvailableProtons());
     ui->protonRunnerBox->setCurrentIndex(0);
+    protonRunner = ui->protonRunnerBox->currentText();
+    connect(NeroRunnerIndex::Get(), &NeroRunnerIndex::RunnersChanged, this, [this]() {
+        const QString current = ui->protonRunnerBox->currentText();
+        {
+            const QSignalBlocker blocker(ui->protonRunnerBox);
+            ui->protonRunnerBox->clear();
+            ui->protonRunnerBox->addItems(*NeroFS::GetAvailableProtons());
+        }
+        const int index = ui->protonRunnerBox->findText(current);
+        ui->protonRunnerBox->setCurrentIndex(index >= 0 ? index : 0);
+        protonRunner = ui->protonRunnerBox->currentText();
+        // a template's runner that went away can't be held to anymore
+        if(index < 0) ui->protonRunnerBox->setEnabled(true);
+    });
+
+    // set up after the runner box, since picking a template changes it
+    ui->templateBox->addItem("None (Build From Scratch)");
+    ui->templateBox->addItems(NeroPrefixTemplates::GetTemplates());
+    ui->templateBox->setEnabled(ui->templateBox->count() > 1);
+    templateTip = ui->templateBox->toolTip();
 
     boldFont.setPointSize(11);
     boldFont.setBold(true);
@@ -254,6 +277,35 @@ void NeroPrefixWizard::SetXactTricks()
     } else verbsToInstall = prevVerbs;
 }
 
+void NeroPrefixWizard::on_protonRunnerBox_currentIndexChanged(int index)
+{
+    // by name, since the runners list can change under us while the wizard's open
+    protonRunner = ui->protonRunnerBox->itemText(index);
+}
+
+void NeroPrefixWizard::on_templateBox_currentIndexChanged(int index)
+{
+    if(index <= 0) {
+        templateName.clear();
+        ui->protonRunnerBox->setEnabled(true);
+        ui->templateBox->setToolTip(templateTip);
+        return;
+    }
+
+    const NeroPrefixTemplates::Template base = NeroPrefixTemplates::GetTemplate(ui->templateBox->itemText(index));
+    templateName = base.name;
+
+    // the clone's already been set up by this runner, so stick with it if it's still around
+    const int runner = ui->protonRunnerBox->findText(base.runner);
+    if(runner >= 0) {
+        ui->protonRunnerBox->setCurrentIndex(runner);
+        ui->protonRunnerBox->setEnabled(false);
+    } else ui->protonRunnerBox->setEnabled(true);
+
+    ui->templateBox->setToolTip(QString("Runner: %1\nVerbs: %2").arg(runner >= 0 ? base.runner : base.runner + " (not installed!)",
+                                                                        base.verbs.isEmpty() ? "None" : base.verbs.join(", ")));
+}
+
 void NeroPrefixWizard::on_symlinksCheckbox_stateChanged(int arg1)
 {
     userSymlinks = arg1;
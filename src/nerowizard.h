@@ -37,8 +37,10 @@ public:
     ~NeroPrefixWizard();
 
     bool userSymlinks = false;
-    int protonRunner;
+    bool saveAsTemplate = false;
+    QString protonRunner;
     QString prefixName;
+    QString templateName;
     QStringList verbsToInstall;
     QStringList prevVerbs;
     QStringList currentPrefixes;
@@ -46,7 +48,11 @@ public:
 private slots:
     void on_symlinksCheckbox_stateChanged(int arg1);
 
-    void on_protonRunnerBox_currentIndexChanged(int index) { protonRunner = index; }
+    void on_protonRunnerBox_currentIndexChanged(int index);
+
+    void on_templateBox_currentIndexChanged(int index);
+
+    void on_saveTemplateCheckbox_stateChanged(int arg1) { saveAsTemplate = arg1; }
 
     void on_prefixNameInput_textChanged(const QString &arg1);
 
@@ -67,6 +73,8 @@ private:
 
     QList<QAction*> winetricksPresets;
 
+    QString templateTip;
+
     QFont boldFont;
     QFont normFont;
 };